@@ -0,0 +1,42 @@
+# coding=utf-8
+''' 通过 ticos_thingmodel_gen.py 生成基准测试使用的合成物模型 '''
+import os, sys, json, argparse
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'scripts', 'codegen'))
+import ticos_thingmodel_gen as gen
+
+SCHEMAS = ['boolean', 'integer', 'float', 'string']
+
+''' getter 返回有代表性的值, 默认生成的 return 0 会让字符串字段被省略、数值编码退化为 "0" '''
+BENCH_VALUES = {
+    'bool':         'true',
+    'int':          '123456',
+    'float':        '3.14159f',
+    'const char*':  '"bench value"',
+}
+
+''' 字符串字段声明的长度上限, 用于计算缓冲区大小 '''
+STRING_MAX_LENGTH = 16
+
+def bench_getter(_key, _id, _type):
+    return ' {\n    return %s;\n}\n' % BENCH_VALUES[_type]
+
+def bench_thingmodel(fields):
+    ''' 遥测、属性和命令各 fields 个字段, 类型依次轮换 '''
+    contents = []
+    for kind, prefix in (('Telemetry', 'tele'), ('Property', 'prop'), ('Command', 'cmd')):
+        for i in range(fields):
+            item = { '@type': kind, 'name': '%s_%05d' % (prefix, i), 'schema': SCHEMAS[i % len(SCHEMAS)] }
+            if item['schema'] == 'string':
+                item['maxLength'] = STRING_MAX_LENGTH
+            contents.append(item)
+    return [{ 'contents': contents }]
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='ticos benchmark thing model generator')
+    parser.add_argument('--fields', type=int, required=True, help='number of fields per telemetry/property/command')
+    parser.add_argument('--to', type=str, default='.', help='target directory')
+    parser.add_argument('--serializers', action='store_true', help='generate specialized report serializers')
+    args = parser.parse_args()
+    gen.gen_func_body_getter = bench_getter
+    gen.generate(json.dumps(bench_thingmodel(args.fields)), args.to, commands=True, serializers=args.serializers)
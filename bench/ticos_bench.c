@@ -0,0 +1,226 @@
+/*************************************************************************
+  * @file ticos_bench.c
+  * @brief 上报和下发热路径的基准测试
+  * @note  与 gen_bench_model.py 生成的合成物模型链接, 上报数据由桩函数捕获而不经过网络。
+  *        每项测试输出一行 JSON, 便于在不同版本之间比较:
+  *        {"fields":N,"path":"...","iterations":N,"ns_per_op":F,"allocs_per_op":F,"peak_heap":N,"bytes":N}
+  *        用法: ticos_bench_<N> [每项测试的运行时长(毫秒), 默认 200]
+  ************************************************************************/
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ticos_api.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_json_writer.h"
+
+void ticos_command_receive(const char *dat, int len);
+void ticos_property_receive(const char *dat, int len);
+
+/*
+ * 通过链接选项 --wrap 拦截 SDK 的堆内存操作, 统计申请次数和堆内存峰值
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static long m_allocs = 0;
+static long m_heap = 0;
+static long m_heap_peak = 0;
+
+static void *ticos_bench_track(void *ptr)
+{
+    if (ptr) {
+        m_allocs++;
+        m_heap += malloc_usable_size(ptr);
+        if (m_heap > m_heap_peak)
+            m_heap_peak = m_heap;
+    }
+    return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    return ticos_bench_track(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    return ticos_bench_track(__real_calloc(n, size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (ptr)
+        m_heap -= malloc_usable_size(ptr);
+    return ticos_bench_track(__real_realloc(ptr, size));
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr)
+        m_heap -= malloc_usable_size(ptr);
+    __real_free(ptr);
+}
+
+/*
+ * 捕获上报数据的 HAL 桩函数
+ */
+static char *m_capture;
+static int m_capture_size;
+static int m_capture_len;
+
+int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    memcpy(m_capture, data, len < m_capture_size ? len : m_capture_size);
+    m_capture_len = len;
+    return 0;
+}
+
+int ticos_hal_mqtt_subscribe(const char *topic, int qos)
+{
+    return 0;
+}
+
+int ticos_hal_mqtt_start(const char *url, int port, const char *client_id, const char *user_name, const char *passwd)
+{
+    return 0;
+}
+
+void ticos_hal_mqtt_stop()
+{
+}
+
+static char *m_desired;
+static int m_desired_len;
+static char *m_command;
+static int m_command_len;
+
+// 下发数据: 每个字段一个成员, 值的类型与字段类型一致
+static int ticos_bench_payload(char *buf, int size, int cnt, const char *(*id)(int), ticos_val_type_t (*type)(int))
+{
+    ticos_json_writer_t w;
+
+    ticos_json_writer_init(&w, buf, size);
+    ticos_json_object_begin(&w);
+    for (int i = 0; i < cnt; i++) {
+        switch (type(i)) {
+        case TICOS_VAL_TYPE_BOOLEAN:
+            ticos_json_add_bool(&w, id(i), 1);
+            break;
+        case TICOS_VAL_TYPE_INTEGER:
+            ticos_json_add_number(&w, id(i), 42);
+            break;
+        case TICOS_VAL_TYPE_FLOAT:
+            ticos_json_add_number(&w, id(i), 2.5);
+            break;
+        default:
+            ticos_json_add_string(&w, id(i), "bench value");
+            break;
+        }
+    }
+    ticos_json_object_end(&w);
+    return ticos_json_writer_finish(&w);
+}
+
+static const char *property_id(int i) { return ticos_property_tab[i].id; }
+static ticos_val_type_t property_type(int i) { return ticos_property_tab[i].type; }
+static const char *command_id(int i) { return ticos_command_tab[i].id; }
+static ticos_val_type_t command_type(int i) { return ticos_command_tab[i].type; }
+
+static int bench_property_report(void)
+{
+    ticos_property_report();
+    return m_capture_len;
+}
+
+static int bench_telemetry_report(void)
+{
+    ticos_telemetry_report();
+    return m_capture_len;
+}
+
+static int bench_property_receive(void)
+{
+    ticos_property_receive(m_desired, m_desired_len);
+    return m_desired_len;
+}
+
+static int bench_command_receive(void)
+{
+    ticos_command_receive(m_command, m_command_len);
+    return m_command_len;
+}
+
+static double ticos_bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int ticos_bench_loop(int (*fn)(void), long iterations, double *elapsed_ns)
+{
+    int bytes = 0;
+    double start = ticos_bench_now_ns();
+    for (long i = 0; i < iterations; i++)
+        bytes = fn();
+    *elapsed_ns = ticos_bench_now_ns() - start;
+    return bytes;
+}
+
+static void ticos_bench_run(const char *path, int (*fn)(void), double budget_ns)
+{
+    long iterations = 1;
+    double elapsed;
+
+    // 预热, 同时估算达到运行时长所需的迭代次数
+    for (;;) {
+        ticos_bench_loop(fn, iterations, &elapsed);
+        if (elapsed >= budget_ns / 10 || iterations >= (1L << 30))
+            break;
+        iterations *= 2;
+    }
+    if (elapsed > 0 && budget_ns / elapsed * iterations > iterations)
+        iterations = budget_ns / elapsed * iterations;
+
+    long heap_base = m_heap;
+    m_allocs = 0;
+    m_heap_peak = m_heap;
+    int bytes = ticos_bench_loop(fn, iterations, &elapsed);
+    printf("{\"fields\":%d,\"path\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.1f,"
+           "\"allocs_per_op\":%.2f,\"peak_heap\":%ld,\"bytes\":%d}\n",
+           TICOS_BENCH_FIELDS, path, iterations, elapsed / iterations,
+           (double)m_allocs / iterations, m_heap_peak - heap_base, bytes);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    double budget_ns = (argc > 1 ? atof(argv[1]) : 200) * 1e6;
+    int size = 64 + TICOS_BENCH_FIELDS * 48;
+
+    // 大物模型的上报数据远超默认的上报缓冲区
+    ticos_set_report_buffer(malloc(size), size);
+    m_capture_size = size;
+    m_capture = malloc(size);
+    m_desired = malloc(size);
+    m_command = malloc(size);
+    m_desired_len = ticos_bench_payload(m_desired, size, ticos_property_cnt, property_id, property_type);
+    m_command_len = ticos_bench_payload(m_command, size, ticos_command_cnt, command_id, command_type);
+    if (m_desired_len < 0 || m_command_len < 0) {
+        fprintf(stderr, "payload buffer too small\n");
+        return 1;
+    }
+
+    ticos_cloud_start("BENCH", "bench", "bench");
+    ticos_bench_run("property_report", bench_property_report, budget_ns);
+    ticos_bench_run("telemetry_report", bench_telemetry_report, budget_ns);
+    ticos_bench_run("property_receive", bench_property_receive, budget_ns);
+    ticos_bench_run("command_receive", bench_command_receive, budget_ns);
+    ticos_cloud_stop();
+    return 0;
+}
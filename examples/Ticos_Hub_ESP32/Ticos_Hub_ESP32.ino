@@ -57,10 +57,14 @@ void setup()
   initializeTime();
   // 建立和 Ticos Cloud 的连接
   ticos_cloud_start(PRODUCT_ID, DEVICE_ID, DEVICE_SECRET);
+  // 按键按下和抬起各上报一次, 200ms 内的多次上报合并为一条消息
+  ticos_set_report_window(200);
 }
 
 void loop()
 {
   // 扫描按键，处理应用的业务逻辑
   key_scan();
+  // 发送合并窗口结束后被推迟的上报和到期的周期上报
+  ticos_report_poll();
 }
@@ -9,6 +9,7 @@
   ************************************************************************/
 
 #include "ticos_thingmodel.h"
+#include "ticos_thingmodel_op.h"
 #include "user_app.h"
 
 int ticos_telemetry_pressure()
@@ -72,10 +73,16 @@ int ticos_command_temperature(float temperature)
     return 0;
 }
 
+static const ticos_report_filter_t ticos_telemetry_pressure_filter = { 2.0f, 0.0f, 0, 60000 };
+
+static const ticos_report_filter_t ticos_telemetry_temperature_filter = { 0.5f, 0.0f, 1000, 60000 };
+
+static const ticos_report_filter_t ticos_telemetry_oxygen_filter = { 0.0f, 1.0f, 0, 60000 };
+
 const ticos_telemetry_info_t ticos_telemetry_tab[] = {
-    {"pressure", TICOS_VAL_TYPE_INTEGER, ticos_telemetry_pressure},
-    {"temperature", TICOS_VAL_TYPE_FLOAT, ticos_telemetry_temperature},
-    {"oxygen", TICOS_VAL_TYPE_FLOAT, ticos_telemetry_oxygen},
+    {"pressure", TICOS_VAL_TYPE_INTEGER, ticos_telemetry_pressure, &ticos_telemetry_pressure_filter},
+    {"temperature", TICOS_VAL_TYPE_FLOAT, ticos_telemetry_temperature, &ticos_telemetry_temperature_filter, 5000},
+    {"oxygen", TICOS_VAL_TYPE_FLOAT, ticos_telemetry_oxygen, &ticos_telemetry_oxygen_filter},
     {"warn_info", TICOS_VAL_TYPE_STRING, ticos_telemetry_warn_info},
 };
 
@@ -90,6 +97,54 @@ const ticos_command_info_t ticos_command_tab[] = {
     {"temperature", TICOS_VAL_TYPE_FLOAT, ticos_command_temperature},
 };
 
+static const int ticos_property_index_disp[] = {
+    -2, 2, 0,
+};
+
+static const ticos_index_slot_t ticos_property_index_slots[] = {
+    { TICOS_PROPERTY_switch, 6 },
+    { TICOS_PROPERTY_DebugInfo, 9 },
+    { TICOS_PROPERTY_light, 5 },
+};
+
+const ticos_thingmodel_index_t ticos_property_index = { ticos_property_index_disp, ticos_property_index_slots, 3 };
+
+static const int ticos_command_index_disp[] = {
+    -2, -1,
+};
+
+static const ticos_index_slot_t ticos_command_index_slots[] = {
+    { TICOS_COMMAND_oxygen, 6 },
+    { TICOS_COMMAND_temperature, 11 },
+};
+
+const ticos_thingmodel_index_t ticos_command_index = { ticos_command_index_disp, ticos_command_index_slots, 2 };
+
+const uint32_t ticos_thingmodel_hash = 0x4da03cda;
+
+void ticos_thingmodel_serialize_property(ticos_client_t *client, ticos_json_writer_t *w)
+{
+    ticos_value_t val;
+
+    val.type = TICOS_VAL_TYPE_BOOLEAN;
+    val.v.i = ticos_property_switch_send();
+    ticos_property_cache_update(client, TICOS_PROPERTY_switch, &val);
+    ticos_json_key_raw(w, "\"switch\":", 9);
+    ticos_json_bool(w, val.v.i);
+    val.type = TICOS_VAL_TYPE_INTEGER;
+    val.v.i = ticos_property_light_send();
+    ticos_property_cache_update(client, TICOS_PROPERTY_light, &val);
+    ticos_json_key_raw(w, "\"light\":", 8);
+    ticos_json_int(w, val.v.i);
+    val.type = TICOS_VAL_TYPE_STRING;
+    val.v.s = ticos_property_DebugInfo_send();
+    if (val.v.s) {
+        ticos_property_cache_update(client, TICOS_PROPERTY_DebugInfo, &val);
+        ticos_json_key_raw(w, "\"DebugInfo\":", 12);
+        ticos_json_string(w, val.v.s);
+    }
+}
+
 const int ticos_telemetry_cnt = TICOS_TELEMETRY_MAX;
 const int ticos_property_cnt = TICOS_PROPERTY_MAX;
 const int ticos_command_cnt = TICOS_COMMAND_MAX;
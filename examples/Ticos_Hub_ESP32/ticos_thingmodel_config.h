@@ -0,0 +1,25 @@
+/************************************************************************
+  * @file ticos_thingmodel_config.h
+  * @brief 按物模型计算的 SDK 缓冲区大小
+  * @date 2026-10-17 00:09:46
+  * @note 此文件为自动生成，请不要更改文件内容。
+  *       以 TICOS_STATIC_MEMORY 编译且此文件在 SDK 的包含路径中时，SDK 以这里的最坏情况作为缓冲区大小
+  ***********************************************************************/
+
+#pragma once
+
+/** 全量遥测上报的最大字节数, JSON 和 CBOR 取较大者 */
+#define TICOS_THINGMODEL_TELEMETRY_MAX 289
+
+/** 全量属性上报的最大字节数, JSON 和 CBOR 取较大者 */
+#define TICOS_THINGMODEL_PROPERTY_MAX 244
+
+/** 只含一个样本的批量遥测上报的最大字节数 */
+#define TICOS_THINGMODEL_SAMPLE_MAX 329
+
+/** 上报缓冲区的大小, 取以上各项的最大值 */
+#define TICOS_THINGMODEL_REPORT_MAX 329
+
+/** 云端下发的属性和命令字符串的最大长度, 含结尾的 '\0' */
+#define TICOS_THINGMODEL_STRING_MAX 33
+
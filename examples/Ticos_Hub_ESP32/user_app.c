@@ -50,7 +50,7 @@ void key_scan()
           key_process = 0;
           switch_state = 0;
           // 上报按键状态
-          ticos_property_report();
+          ticos_property_report_changed();
         }
     }
 }
@@ -83,7 +83,7 @@ static void user_key_cb(int key, void *user_data)
         led_light = 1;
     }
     led_ctl(led_light);
-    ticos_property_report();
+    ticos_property_report_changed();
 }
 
 void user_init()
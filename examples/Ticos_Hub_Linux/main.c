@@ -0,0 +1,135 @@
+/*************************************************************************
+  * @file main.c Linux 主机示例
+  * 在进程内启动测试 broker, SDK 通过 Linux HAL 连接到该 broker,
+  * 完成属性/遥测上报以及属性/命令下发的完整流程。
+  * 上报通过异步接口放入发送队列, 由 SDK 的发送线程编码和发送; 下发的命令由命令线程池执行。
+  * 物模型代码复用 Ticos_Hub_ESP32 示例, 板级接口在此模拟。
+  ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "ticos_api.h"
+#include "ticos_hal_linux.h"
+#include "ticos_mqtt_broker.h"
+#include "user_app.h"
+
+#define PRODUCT_ID      "BOB45WX7H4"
+#define DEVICE_ID       "TEST002"
+#define DEVICE_SECRET   "7rjQAIYU7DPULJo8YlppEg=="
+
+static int switch_state = 0;
+static int led_light = 0;
+
+void board_init()
+{
+}
+
+void led_ctl(int status)
+{
+    printf("led: %d\n", status);
+}
+
+void set_key_cb(key_cb_t cb, void *user_data)
+{
+}
+
+void key_scan()
+{
+}
+
+int get_led_light()
+{
+    return led_light;
+}
+
+void set_led_light(int light)
+{
+    led_light = light;
+    led_ctl(led_light);
+}
+
+int get_switch_state()
+{
+    return switch_state;
+}
+
+void user_init()
+{
+    board_init();
+}
+
+static volatile int m_reported = 0;
+
+// broker 收到设备上报的消息
+static void on_device_publish(const char *topic, const char *data, int len, void *user_data)
+{
+    printf("cloud <- [%s] %.*s\n", topic, len, data);
+    m_reported++;
+}
+
+static void on_ticos_event(void *user_data, ticos_evt_t event)
+{
+    printf("ticos event: %s\n", event == TICOS_EVENT_CONNECT ? "connect" : "disconnect");
+}
+
+static int subscribed(void)
+{
+    return ticos_broker_subscriptions() >= 2;
+}
+
+static int synced(void)
+{
+    return m_reported >= 3 && led_light == 1;
+}
+
+// 等待条件成立, 超时返回 0
+static int wait_until(int (*cond)(void), int timeout_ms)
+{
+    for (; !cond() && timeout_ms > 0; timeout_ms -= 10)
+        usleep(10000);
+    return cond();
+}
+
+int main()
+{
+    int port = ticos_broker_start(0);
+    if (port < 0)
+        return 1;
+    ticos_broker_set_hook(on_device_publish, NULL);
+
+    user_init();
+    set_ticos_event_cb(on_ticos_event, NULL);
+    ticos_hal_mqtt_set_server("127.0.0.1", port);
+    ticos_sender_start();
+    ticos_command_pool_start(2);
+    ticos_cloud_start(PRODUCT_ID, DEVICE_ID, DEVICE_SECRET);
+    if (!wait_until(subscribed, 5000)) {
+        printf("subscribe timeout\n");
+        return 1;
+    }
+
+    // 设备上报
+    switch_state = 1;
+    if (ticos_property_report_async() != TICOS_SEND_OK || ticos_telemetry_report_async() != TICOS_SEND_OK) {
+        printf("send queue full\n");
+        return 1;
+    }
+
+    // 云端下发属性和命令
+    const char *desired = "{\"light\":1}";
+    const char *command = "{\"$id\":\"1\",\"oxygen\":20.5}";
+    ticos_broker_publish("devices/" DEVICE_ID "/twin/desired", desired, strlen(desired));
+    ticos_broker_publish("devices/" DEVICE_ID "/commands/request", command, strlen(command));
+
+    int ok = wait_until(synced, 5000);
+    ticos_command_pool_stop();
+    ticos_sender_stop();
+    ticos_cloud_stop();
+    ticos_broker_stop();
+#if TICOS_TRACE
+    printf("trace records: %d\n", ticos_trace_dump("ticos_trace.json"));
+#endif
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
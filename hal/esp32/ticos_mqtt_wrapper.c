@@ -39,7 +39,7 @@ int ticos_hal_mqtt_subscribe(const char *topic, int qos)
  * @note  当使用mqtt client连接云端成功后，会产生MQTT_EVENT_CONNECTED事件，
  * 此时用户需要调用ticos_mqtt_subscribe()订阅和云端通信相关的topic
  * 当client从云端接收到数据后，会产生MQTT_EVENT_DATA事件，
- * 此时用户需要回调ticos_msg_recv()将数据传给sdk进行处理
+ * 此时用户需要回调ticos_msg_recv_fragment()将数据传给sdk进行处理
  */
 static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
 {
@@ -53,8 +53,11 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
       ticos_event_notify(TICOS_EVENT_DISCONNECT);
       break;
     case MQTT_EVENT_DATA:
-      printf("MQTT event MQTT_EVENT_DATA: [topic]:%s, [data]%s\r\n", event->topic, event->data);
-      ticos_msg_recv(event->topic, event->data, event->data_len);
+      // 大消息分多次 MQTT_EVENT_DATA 给出, 只有第一个分片带 topic; topic 和数据都不以 '\0' 结尾
+      if (!event->current_data_offset)
+        printf("MQTT event MQTT_EVENT_DATA: [topic]:%.*s, [len]%d\r\n", event->topic_len, event->topic, event->total_data_len);
+      ticos_msg_recv_fragment(event->topic, event->topic_len, event->data, event->data_len,
+                              event->current_data_offset, event->total_data_len);
       break;
     default:
       printf("mqtt event: id = %d\n", event->event_id);
@@ -0,0 +1,41 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_hal_linux.h
+ * @brief Linux 平台 HAL 的扩展接口
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  指定 mqtt 服务器地址, 覆盖 ticos_cloud_start() 使用的默认地址
+ * @note   需要在 ticos_cloud_start() 之前调用, 常用于连接本地的测试 broker
+ * @param host 服务器主机名或 IP 地址, 传入 NULL 时恢复默认地址
+ * @param port 服务器端口
+ * @return void
+ */
+void ticos_hal_mqtt_set_server(const char *host, int port);
+
+/**
+ * @brief  查询 mqtt 客户端是否已连接到服务器
+ * @return 1 代表已连接, 0 代表未连接
+ */
+int ticos_hal_mqtt_connected(void);
+
+/**
+ * @brief  将跟踪记录导出为 Chrome/Perfetto 的 trace JSON
+ * @note   需要开启 TICOS_TRACE. 导出的文件可在 chrome://tracing 或 ui.perfetto.dev 中打开,
+ *         查看上报和下发各环节在各线程中的耗时分布
+ * @param path 输出文件的路径
+ * @return 导出的记录数, 打开文件失败时返回 -1
+ */
+int ticos_trace_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
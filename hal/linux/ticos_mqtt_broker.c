@@ -0,0 +1,372 @@
+#define _GNU_SOURCE
+#include "ticos_mqtt_broker.h"
+#include "ticos_mqtt_packet.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TICOS_BROKER_CLIENTS    8
+#define TICOS_BROKER_SUBS       8
+#define TICOS_BROKER_TOPIC_MAX  256
+#define TICOS_BROKER_RX_SIZE    8192
+
+// epoll 事件的标识: 0 为退出通知, 1 为监听 socket, 其余为客户端下标 + 2
+#define TICOS_BROKER_EV_WAKE    0
+#define TICOS_BROKER_EV_LISTEN  1
+
+typedef struct {
+    int fd;
+    int rx_len;
+    int sub_cnt;
+    char subs[TICOS_BROKER_SUBS][TICOS_BROKER_TOPIC_MAX + 1];
+    uint8_t sub_qos[TICOS_BROKER_SUBS];
+    uint8_t rx[TICOS_BROKER_RX_SIZE + 1];
+} ticos_broker_client_t;
+
+static ticos_broker_client_t m_clients[TICOS_BROKER_CLIENTS];
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;  // 保护客户端的订阅和发送
+static pthread_t m_thread;
+static int m_running = 0;
+static int m_listen = -1;
+static int m_epfd = -1;
+static int m_wake = -1;
+static uint16_t m_packet_id = 0;
+static ticos_broker_hook_t m_hook = NULL;
+static void *m_hook_data = NULL;
+
+static int ticos_broker_match(const char *filter, const char *topic)
+{
+    while (*filter) {
+        if (*filter == '#')
+            return 1;
+        if (*filter == '+') {
+            while (*topic && *topic != '/')
+                topic++;
+            filter++;
+            continue;
+        }
+        if (*filter != *topic)
+            return 0;
+        filter++;
+        topic++;
+    }
+    return !*topic;
+}
+
+// 调用者需持有 m_lock
+static void ticos_broker_send(ticos_broker_client_t *c, struct iovec *iov, int cnt)
+{
+    if (c->fd >= 0 && ticos_mqtt_send(c->fd, iov, cnt))
+        shutdown(c->fd, SHUT_RDWR);
+}
+
+static void ticos_broker_reply(ticos_broker_client_t *c, uint8_t *buf, int len)
+{
+    struct iovec iov = { buf, len };
+    pthread_mutex_lock(&m_lock);
+    ticos_broker_send(c, &iov, 1);
+    pthread_mutex_unlock(&m_lock);
+}
+
+int ticos_broker_publish(const char *topic, const char *data, int len)
+{
+    uint8_t hdr[TICOS_MQTT_FIXED_HDR_MAX + 2 + TICOS_BROKER_TOPIC_MAX + 2];
+    int topic_len = strlen(topic);
+    int cnt = 0;
+
+    if (topic_len > TICOS_BROKER_TOPIC_MAX)
+        return 0;
+    pthread_mutex_lock(&m_lock);
+    for (int i = 0; i < TICOS_BROKER_CLIENTS; i++) {
+        ticos_broker_client_t *c = &m_clients[i];
+        for (int j = 0; c->fd >= 0 && j < c->sub_cnt; j++) {
+            if (!ticos_broker_match(c->subs[j], topic))
+                continue;
+            int qos = c->sub_qos[j];
+            int n = ticos_mqtt_put_header(hdr, TICOS_MQTT_PUBLISH | qos << 1, 2 + topic_len + (qos ? 2 : 0) + len);
+            n += ticos_mqtt_put_string(hdr + n, topic, topic_len);
+            if (qos) {
+                if (++m_packet_id == 0)
+                    m_packet_id = 1;
+                n += ticos_mqtt_put_u16(hdr + n, m_packet_id);
+            }
+            struct iovec iov[2] = { { hdr, n }, { (void *)data, len } };
+            ticos_broker_send(c, iov, 2);
+            cnt++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+    return cnt;
+}
+
+int ticos_broker_subscriptions(void)
+{
+    int cnt = 0;
+    pthread_mutex_lock(&m_lock);
+    for (int i = 0; i < TICOS_BROKER_CLIENTS; i++) {
+        if (m_clients[i].fd >= 0)
+            cnt += m_clients[i].sub_cnt;
+    }
+    pthread_mutex_unlock(&m_lock);
+    return cnt;
+}
+
+void ticos_broker_set_hook(ticos_broker_hook_t hook, void *user_data)
+{
+    pthread_mutex_lock(&m_lock);
+    m_hook = hook;
+    m_hook_data = user_data;
+    pthread_mutex_unlock(&m_lock);
+}
+
+static int ticos_broker_subscribe(ticos_broker_client_t *c, uint8_t *body, int body_len)
+{
+    uint8_t ack[TICOS_MQTT_FIXED_HDR_MAX + 2 + TICOS_BROKER_SUBS];
+    int granted = 0;
+    int off = 2;
+
+    if (body_len < 2)
+        return -1;
+    uint8_t *codes = ack + 4;
+    while (off + 2 < body_len && granted < TICOS_BROKER_SUBS) {
+        int len = ticos_mqtt_get_u16(body + off);
+        if (off + 2 + len >= body_len)
+            return -1;
+        int qos = body[off + 2 + len] > 1 ? 1 : body[off + 2 + len];
+        pthread_mutex_lock(&m_lock);
+        if (len <= TICOS_BROKER_TOPIC_MAX && c->sub_cnt < TICOS_BROKER_SUBS) {
+            memcpy(c->subs[c->sub_cnt], body + off + 2, len);
+            c->subs[c->sub_cnt][len] = '\0';
+            c->sub_qos[c->sub_cnt++] = qos;
+            codes[granted++] = qos;
+        } else {
+            codes[granted++] = 0x80;
+        }
+        pthread_mutex_unlock(&m_lock);
+        off += 2 + len + 1;
+    }
+    ticos_mqtt_put_header(ack, TICOS_MQTT_SUBACK, 2 + granted);
+    memcpy(ack + 2, body, 2);
+    ticos_broker_reply(c, ack, 4 + granted);
+    return 0;
+}
+
+static int ticos_broker_on_publish(ticos_broker_client_t *c, uint8_t *pkt, uint8_t *body, int body_len)
+{
+    char topic[TICOS_BROKER_TOPIC_MAX + 1];
+    int qos = (pkt[0] >> 1) & 3;
+
+    if (body_len < 2)
+        return -1;
+    int topic_len = ticos_mqtt_get_u16(body);
+    int off = 2 + topic_len + (qos ? 2 : 0);
+    if (off > body_len || qos > 1 || topic_len > TICOS_BROKER_TOPIC_MAX)
+        return -1;
+    memcpy(topic, body + 2, topic_len);
+    topic[topic_len] = '\0';
+
+    uint8_t *payload = body + off;
+    int payload_len = body_len - off;
+    uint8_t saved = payload[payload_len];
+    payload[payload_len] = '\0';
+    pthread_mutex_lock(&m_lock);
+    ticos_broker_hook_t hook = m_hook;
+    void *hook_data = m_hook_data;
+    pthread_mutex_unlock(&m_lock);
+    if (hook)
+        hook(topic, (const char *)payload, payload_len, hook_data);
+    payload[payload_len] = saved;
+    ticos_broker_publish(topic, (const char *)payload, payload_len);
+
+    if (qos) {
+        uint8_t ack[4] = { TICOS_MQTT_PUBACK, 2 };
+        memcpy(ack + 2, body + 2 + topic_len, 2);
+        ticos_broker_reply(c, ack, sizeof(ack));
+    }
+    return 0;
+}
+
+static int ticos_broker_handle(ticos_broker_client_t *c, uint8_t *pkt, int hdr_len, int len)
+{
+    uint8_t *body = pkt + hdr_len;
+    int body_len = len - hdr_len;
+
+    switch (pkt[0] & 0xf0) {
+    case TICOS_MQTT_CONNECT: {
+        uint8_t ack[4] = { TICOS_MQTT_CONNACK, 2, 0, 0 };
+        ticos_broker_reply(c, ack, sizeof(ack));
+        break;
+    }
+    case TICOS_MQTT_SUBSCRIBE & 0xf0:
+        return ticos_broker_subscribe(c, body, body_len);
+    case TICOS_MQTT_PUBLISH:
+        return ticos_broker_on_publish(c, pkt, body, body_len);
+    case TICOS_MQTT_PINGREQ: {
+        uint8_t resp[2] = { TICOS_MQTT_PINGRESP, 0 };
+        ticos_broker_reply(c, resp, sizeof(resp));
+        break;
+    }
+    case TICOS_MQTT_DISCONNECT:
+        return -1;
+    default:
+        break;
+    }
+    return 0;
+}
+
+static void ticos_broker_close(ticos_broker_client_t *c)
+{
+    pthread_mutex_lock(&m_lock);
+    epoll_ctl(m_epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->sub_cnt = 0;
+    pthread_mutex_unlock(&m_lock);
+}
+
+static int ticos_broker_read(ticos_broker_client_t *c)
+{
+    ssize_t n = recv(c->fd, c->rx + c->rx_len, TICOS_BROKER_RX_SIZE - c->rx_len, 0);
+    int off = 0;
+
+    if (n < 0 && (errno == EINTR || errno == EAGAIN))
+        return 0;
+    if (n <= 0)
+        return -1;
+    c->rx_len += n;
+    for (;;) {
+        int hdr_len;
+        int len = ticos_mqtt_frame(c->rx + off, c->rx_len - off, &hdr_len);
+        if (len < 0)
+            return -1;
+        if (!len)
+            break;
+        if (ticos_broker_handle(c, c->rx + off, hdr_len, len))
+            return -1;
+        off += len;
+    }
+    memmove(c->rx, c->rx + off, c->rx_len - off);
+    c->rx_len -= off;
+    return c->rx_len == TICOS_BROKER_RX_SIZE ? -1 : 0;
+}
+
+static void ticos_broker_accept(void)
+{
+    int fd = accept4(m_listen, NULL, NULL, SOCK_CLOEXEC);
+    int one = 1;
+
+    if (fd < 0)
+        return;
+    for (int i = 0; i < TICOS_BROKER_CLIENTS; i++) {
+        ticos_broker_client_t *c = &m_clients[i];
+        if (c->fd >= 0)
+            continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_mutex_lock(&m_lock);
+        c->fd = fd;
+        c->rx_len = 0;
+        c->sub_cnt = 0;
+        pthread_mutex_unlock(&m_lock);
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i + 2 };
+        epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev);
+        return;
+    }
+    close(fd);
+}
+
+static void *ticos_broker_loop(void *arg)
+{
+    struct epoll_event events[TICOS_BROKER_CLIENTS + 2];
+
+    for (;;) {
+        int n = epoll_wait(m_epfd, events, TICOS_BROKER_CLIENTS + 2, -1);
+        for (int i = 0; i < n; i++) {
+            uint32_t id = events[i].data.u32;
+            if (id == TICOS_BROKER_EV_WAKE)
+                return NULL;
+            if (id == TICOS_BROKER_EV_LISTEN) {
+                ticos_broker_accept();
+                continue;
+            }
+            ticos_broker_client_t *c = &m_clients[id - 2];
+            if (c->fd >= 0 && ticos_broker_read(c))
+                ticos_broker_close(c);
+        }
+    }
+    return NULL;
+}
+
+int ticos_broker_start(int port)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+
+    if (m_running)
+        return -1;
+    for (int i = 0; i < TICOS_BROKER_CLIENTS; i++)
+        m_clients[i].fd = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    m_listen = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_CLOEXEC);
+    if (m_listen < 0 || m_epfd < 0 || m_wake < 0)
+        goto fail;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(m_listen, (struct sockaddr *)&addr, sizeof(addr)) || listen(m_listen, TICOS_BROKER_CLIENTS) ||
+        getsockname(m_listen, (struct sockaddr *)&addr, &addr_len))
+        goto fail;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = TICOS_BROKER_EV_WAKE };
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_wake, &ev);
+    ev.data.u32 = TICOS_BROKER_EV_LISTEN;
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_listen, &ev);
+    if (pthread_create(&m_thread, NULL, ticos_broker_loop, NULL))
+        goto fail;
+    m_running = 1;
+    return ntohs(addr.sin_port);
+
+fail:
+    perror("ticos broker");
+    if (m_listen >= 0)
+        close(m_listen);
+    if (m_epfd >= 0)
+        close(m_epfd);
+    if (m_wake >= 0)
+        close(m_wake);
+    m_listen = m_epfd = m_wake = -1;
+    return -1;
+}
+
+void ticos_broker_stop(void)
+{
+    uint64_t one = 1;
+
+    if (!m_running)
+        return;
+    if (write(m_wake, &one, sizeof(one)) < 0)
+        perror("eventfd");
+    pthread_join(m_thread, NULL);
+    for (int i = 0; i < TICOS_BROKER_CLIENTS; i++) {
+        if (m_clients[i].fd >= 0)
+            ticos_broker_close(&m_clients[i]);
+    }
+    close(m_listen);
+    close(m_epfd);
+    close(m_wake);
+    m_listen = m_epfd = m_wake = -1;
+    m_running = 0;
+}
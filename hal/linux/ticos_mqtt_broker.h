@@ -0,0 +1,60 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_mqtt_broker.h
+ * @brief 进程内的最小 MQTT 3.1.1 broker, 用于在 Linux 主机上端到端地测试 SDK
+ *
+ * 只实现 SDK 用到的报文: CONNECT, PUBLISH(QoS 0/1), SUBSCRIBE, PINGREQ 和 DISCONNECT,
+ * 支持 '+' 和 '#' 通配符订阅。不保存 retain 消息和离线会话, 也不做鉴权。
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  客户端发布消息时的回调, 在 broker 线程中调用
+ * @param topic 消息的 topic
+ * @param data 消息内容
+ * @param len 消息长度
+ * @param user_data 用户数据
+ */
+typedef void (*ticos_broker_hook_t)(const char *topic, const char *data, int len, void *user_data);
+
+/**
+ * @brief  在本机回环地址上启动 broker
+ * @param port 监听端口, 0 表示由系统分配
+ * @return 实际监听的端口, 失败时返回 -1
+ */
+int ticos_broker_start(int port);
+
+/**
+ * @brief  停止 broker 并断开所有客户端
+ * @return void
+ */
+void ticos_broker_stop(void);
+
+/**
+ * @brief  设置客户端发布消息时的回调
+ * @return void
+ */
+void ticos_broker_set_hook(ticos_broker_hook_t hook, void *user_data);
+
+/**
+ * @brief  模拟云端, 向订阅了 topic 的客户端下发消息
+ * @return 收到消息的客户端数量
+ */
+int ticos_broker_publish(const char *topic, const char *data, int len);
+
+/**
+ * @brief  获取已完成订阅的 topic 总数, 用于等待客户端就绪
+ * @return 所有客户端的订阅数之和
+ */
+int ticos_broker_subscriptions(void);
+
+#ifdef __cplusplus
+}
+#endif
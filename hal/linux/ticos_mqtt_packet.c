@@ -0,0 +1,68 @@
+#include "ticos_mqtt_packet.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+int ticos_mqtt_put_header(uint8_t *buf, uint8_t type, int remaining)
+{
+    int n = 0;
+
+    buf[n++] = type;
+    do {
+        uint8_t b = remaining & 0x7f;
+        remaining >>= 7;
+        buf[n++] = remaining ? (b | 0x80) : b;
+    } while (remaining && n < TICOS_MQTT_FIXED_HDR_MAX);
+    return n;
+}
+
+int ticos_mqtt_put_string(uint8_t *buf, const char *str, int len)
+{
+    ticos_mqtt_put_u16(buf, len);
+    memcpy(buf + 2, str, len);
+    return len + 2;
+}
+
+int ticos_mqtt_frame(const uint8_t *buf, int avail, int *hdr_len)
+{
+    int remaining = 0;
+
+    for (int i = 1; i < TICOS_MQTT_FIXED_HDR_MAX; i++) {
+        if (i >= avail)
+            return 0;
+        remaining |= (buf[i] & 0x7f) << (7 * (i - 1));
+        if (!(buf[i] & 0x80)) {
+            *hdr_len = i + 1;
+            return avail >= i + 1 + remaining ? i + 1 + remaining : 0;
+        }
+    }
+    return -1;
+}
+
+int ticos_mqtt_send(int fd, struct iovec *iov, int cnt)
+{
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = cnt;
+    while (msg.msg_iovlen > 0) {
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        // 跳过已发送的部分
+        while (msg.msg_iovlen > 0 && (size_t)n >= msg.msg_iov->iov_len) {
+            n -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + n;
+            msg.msg_iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
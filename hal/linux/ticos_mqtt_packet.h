@@ -0,0 +1,75 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_mqtt_packet.h
+ * @brief MQTT 3.1.1 报文编解码工具, 供 Linux 平台的客户端和测试 broker 共用
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TICOS_MQTT_CONNECT      0x10
+#define TICOS_MQTT_CONNACK      0x20
+#define TICOS_MQTT_PUBLISH      0x30
+#define TICOS_MQTT_PUBACK       0x40
+#define TICOS_MQTT_SUBSCRIBE    0x82
+#define TICOS_MQTT_SUBACK       0x90
+#define TICOS_MQTT_PINGREQ      0xc0
+#define TICOS_MQTT_PINGRESP     0xd0
+#define TICOS_MQTT_DISCONNECT   0xe0
+
+/** 固定报头的最大长度: 1 字节类型 + 最多 4 字节剩余长度 */
+#define TICOS_MQTT_FIXED_HDR_MAX 5
+
+/**
+ * @brief  写入固定报头
+ * @param buf 输出缓冲区, 至少 TICOS_MQTT_FIXED_HDR_MAX 字节
+ * @param type 报文类型及标志位
+ * @param remaining 剩余长度
+ * @return 写入的字节数
+ */
+int ticos_mqtt_put_header(uint8_t *buf, uint8_t type, int remaining);
+
+/**
+ * @brief  写入 2 字节长度前缀的字符串
+ * @return 写入的字节数
+ */
+int ticos_mqtt_put_string(uint8_t *buf, const char *str, int len);
+
+static inline int ticos_mqtt_put_u16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = val >> 8;
+    buf[1] = val & 0xff;
+    return 2;
+}
+
+static inline uint16_t ticos_mqtt_get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] << 8 | buf[1]);
+}
+
+/**
+ * @brief  从接收缓冲区中划分出一个完整的报文
+ * @param buf 接收到的数据
+ * @param avail 数据长度
+ * @param hdr_len 输出固定报头的长度
+ * @return 报文总长度, 数据不完整时返回 0, 格式错误时返回 -1
+ */
+int ticos_mqtt_frame(const uint8_t *buf, int avail, int *hdr_len);
+
+/**
+ * @brief  发送所有数据, 处理部分写入和 EINTR
+ * @return 0 代表成功, 其他值代表连接已断开
+ */
+int ticos_mqtt_send(int fd, struct iovec *iov, int cnt);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,554 @@
+#include <ticos_api.h>
+#include "ticos_hal_linux.h"
+#include "ticos_mqtt_packet.h"
+#include "ticos_time.h"
+#include <errno.h>
+#include <limits.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TICOS_HAL_KEEPALIVE     30      // 心跳间隔(秒)
+#define TICOS_HAL_RECONNECT_MS  1000    // 断线重连间隔(毫秒)
+#define TICOS_HAL_RX_SIZE       4096    // 接收缓冲区大小, 更长的 PUBLISH 报文的内容按分片交给 sdk
+#define TICOS_HAL_TOPIC_MAX     256
+
+static pthread_t m_thread;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;  // 保护 socket 的发送和连接状态
+static int m_running = 0;
+static int m_epfd = -1;
+static int m_wake = -1;     // 用于通知 I/O 线程退出
+static int m_sock = -1;
+static int m_connected = 0;
+static uint16_t m_packet_id = 0;
+static int64_t m_last_send = 0;
+static int64_t m_last_recv = 0;
+
+static char m_host[128];
+static int m_port;
+static char m_server_host[128];
+static int m_server_port;
+static char m_client_id[128];
+static char m_user[128];
+static char m_passwd[128];
+
+static uint8_t m_rx[TICOS_HAL_RX_SIZE + 1];    // 多出的 1 字节用于在消息内容后补 '\0'
+static int m_rx_len = 0;
+
+// 正在按分片接收的 PUBLISH 报文
+static int m_frag_left = 0;     // 尚未收到的内容长度
+static int m_frag_offset = 0;
+static int m_frag_total = 0;
+static int m_frag_qos = 0;
+static uint16_t m_frag_id = 0;
+
+void ticos_hal_mqtt_set_server(const char *host, int port)
+{
+    snprintf(m_server_host, sizeof(m_server_host), "%s", host ? host : "");
+    m_server_port = port;
+}
+
+int ticos_hal_mqtt_connected(void)
+{
+    pthread_mutex_lock(&m_lock);
+    int connected = m_connected;
+    pthread_mutex_unlock(&m_lock);
+    return connected;
+}
+
+// 调用者需持有 m_lock
+static int ticos_hal_send(struct iovec *iov, int cnt)
+{
+    if (m_sock < 0)
+        return -1;
+    if (ticos_mqtt_send(m_sock, iov, cnt)) {
+        // 由 I/O 线程发现连接断开后统一处理
+        shutdown(m_sock, SHUT_RDWR);
+        return -1;
+    }
+    m_last_send = ticos_uptime_ms();
+    return 0;
+}
+
+static int ticos_hal_send_packet(uint8_t *buf, int len)
+{
+    struct iovec iov = { buf, len };
+    pthread_mutex_lock(&m_lock);
+    int ret = ticos_hal_send(&iov, 1);
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+}
+
+static uint16_t ticos_hal_next_id(void)
+{
+    if (++m_packet_id == 0)
+        m_packet_id = 1;
+    return m_packet_id;
+}
+
+// 生成 PUBLISH 报文的固定报头、topic 和报文 id, 调用者需持有 m_lock; 返回报头长度, id 输出报文 id
+static int ticos_hal_publish_header(uint8_t *hdr, const char *topic, int topic_len, int len, int qos, int retain,
+                                    int *id)
+{
+    int n = ticos_mqtt_put_header(hdr, TICOS_MQTT_PUBLISH | qos << 1 | (retain ? 1 : 0),
+                                  2 + topic_len + (qos ? 2 : 0) + len);
+    n += ticos_mqtt_put_string(hdr + n, topic, topic_len);
+    *id = 0;
+    if (qos) {
+        *id = ticos_hal_next_id();
+        n += ticos_mqtt_put_u16(hdr + n, *id);
+    }
+    return n;
+}
+
+/**
+ * @brief mqtt客户端向云端推送数据的接口
+ * @note  ticos sdk会调用此接口，完成数据的上传。仅支持 QoS 0 和 QoS 1, QoS 1 的消息不做超时重发
+ * @param topic 上报信息的topic
+ * @param data 上报的数据内容
+ * @param len  上报的数据长度
+ * @param qos  通信质量
+ * @param retain retain flag
+ * @return QoS 1 时返回消息 id, QoS 0 时返回 0, 失败时返回 -1
+ */
+int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    uint8_t hdr[TICOS_MQTT_FIXED_HDR_MAX + 2 + TICOS_HAL_TOPIC_MAX + 2];
+    int topic_len = strlen(topic);
+    int ret;
+
+    if (topic_len > TICOS_HAL_TOPIC_MAX || qos < 0 || qos > 1)
+        return -1;
+    pthread_mutex_lock(&m_lock);
+    if (!m_connected) {
+        pthread_mutex_unlock(&m_lock);
+        return -1;
+    }
+    int n = ticos_hal_publish_header(hdr, topic, topic_len, len, qos, retain, &ret);
+    struct iovec iov[2] = { { hdr, n }, { (void *)data, len } };
+    if (ticos_hal_send(iov, 2))
+        ret = -1;
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+}
+
+static int m_stream_left = -1;      // 分块发布中尚未写入的消息内容字节数, -1 代表没有进行中的分块发布
+static int m_stream_failed = 0;
+
+/**
+ * @brief 开始分块发布一条消息
+ * @note  ticos sdk 发送超出上报缓冲区的流式字段时调用此接口, 之后以 ticos_hal_mqtt_publish_write() 写入恰好 len 字节的
+ *        消息内容, 最后调用 ticos_hal_mqtt_publish_end()。期间持有发送锁, 其他线程的发布等待本消息发送完毕
+ * @param topic 上报信息的topic
+ * @param len  消息内容的总长度
+ * @param qos  通信质量
+ * @param retain retain flag
+ * @return 与 ticos_hal_mqtt_publish() 相同, 失败时无需调用 ticos_hal_mqtt_publish_end()
+ */
+int ticos_hal_mqtt_publish_begin(const char *topic, int len, int qos, int retain)
+{
+    uint8_t hdr[TICOS_MQTT_FIXED_HDR_MAX + 2 + TICOS_HAL_TOPIC_MAX + 2];
+    int topic_len = strlen(topic);
+    int ret;
+
+    if (topic_len > TICOS_HAL_TOPIC_MAX || qos < 0 || qos > 1 || len < 0)
+        return -1;
+    pthread_mutex_lock(&m_lock);
+    if (!m_connected) {
+        pthread_mutex_unlock(&m_lock);
+        return -1;
+    }
+    struct iovec iov = { hdr, ticos_hal_publish_header(hdr, topic, topic_len, len, qos, retain, &ret) };
+    if (ticos_hal_send(&iov, 1)) {
+        pthread_mutex_unlock(&m_lock);
+        return -1;
+    }
+    m_stream_left = len;
+    m_stream_failed = 0;
+    return ret;
+}
+
+/**
+ * @brief 写入分块发布的一段消息内容
+ * @return 0 for success, -1 for fail.
+ */
+int ticos_hal_mqtt_publish_write(const void *data, int len)
+{
+    struct iovec iov = { (void *)data, len };
+
+    if (m_stream_left < 0 || m_stream_failed)
+        return -1;
+    if (len > m_stream_left || ticos_hal_send(&iov, 1)) {
+        m_stream_failed = 1;
+        return -1;
+    }
+    m_stream_left -= len;
+    return 0;
+}
+
+/**
+ * @brief 结束分块发布
+ * @note  写入失败或内容不足声明的长度时报文已不完整, 断开连接后由 I/O 线程重连
+ * @return 0 for success, -1 for fail.
+ */
+int ticos_hal_mqtt_publish_end(void)
+{
+    if (m_stream_left < 0)
+        return -1;
+    int ret = m_stream_failed || m_stream_left ? -1 : 0;
+    if (ret && m_sock >= 0)
+        shutdown(m_sock, SHUT_RDWR);
+    m_stream_left = -1;
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+}
+
+/**
+ * @brief mqtt客户端订阅云端topic接口
+ * @note  ticos sdk会调用此接口，完成指定topic的订阅
+ * @param topic 需要订阅的topic
+ * @param qos  通信质量
+ * @return 0 for success, other for fail.
+ */
+int ticos_hal_mqtt_subscribe(const char *topic, int qos)
+{
+    uint8_t buf[TICOS_MQTT_FIXED_HDR_MAX + 2 + 2 + TICOS_HAL_TOPIC_MAX + 1];
+    int topic_len = strlen(topic);
+    int ret;
+
+    if (topic_len > TICOS_HAL_TOPIC_MAX)
+        return -1;
+    pthread_mutex_lock(&m_lock);
+    int n = ticos_mqtt_put_header(buf, TICOS_MQTT_SUBSCRIBE, 2 + 2 + topic_len + 1);
+    n += ticos_mqtt_put_u16(buf + n, ticos_hal_next_id());
+    n += ticos_mqtt_put_string(buf + n, topic, topic_len);
+    buf[n++] = qos;
+    struct iovec iov = { buf, n };
+    ret = m_connected ? ticos_hal_send(&iov, 1) : -1;
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+}
+
+static int ticos_hal_connect(void)
+{
+    struct addrinfo hints, *res, *ai;
+    char port[8];
+    int fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%d", m_port);
+    if (getaddrinfo(m_host, port, &hints, &res))
+        return -1;
+    for (ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        if (!connect(fd, ai->ai_addr, ai->ai_addrlen))
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    uint8_t buf[TICOS_MQTT_FIXED_HDR_MAX + 10 + 3 * (2 + 128)];
+    int id_len = strlen(m_client_id);
+    int user_len = strlen(m_user);
+    int passwd_len = user_len ? strlen(m_passwd) : 0;
+    uint8_t flags = 0x02 | (user_len ? 0x80 : 0) | (passwd_len ? 0x40 : 0);   // clean session
+    int n = ticos_mqtt_put_header(buf, TICOS_MQTT_CONNECT, 10 + 2 + id_len +
+                                  (user_len ? 2 + user_len : 0) + (passwd_len ? 2 + passwd_len : 0));
+    n += ticos_mqtt_put_string(buf + n, "MQTT", 4);
+    buf[n++] = 4;   // 协议版本 3.1.1
+    buf[n++] = flags;
+    n += ticos_mqtt_put_u16(buf + n, TICOS_HAL_KEEPALIVE);
+    n += ticos_mqtt_put_string(buf + n, m_client_id, id_len);
+    if (user_len)
+        n += ticos_mqtt_put_string(buf + n, m_user, user_len);
+    if (passwd_len)
+        n += ticos_mqtt_put_string(buf + n, m_passwd, passwd_len);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev);
+    pthread_mutex_lock(&m_lock);
+    m_sock = fd;
+    m_rx_len = 0;
+    m_frag_left = 0;
+    m_last_recv = ticos_uptime_ms();
+    pthread_mutex_unlock(&m_lock);
+    return ticos_hal_send_packet(buf, n);
+}
+
+static void ticos_hal_disconnect(void)
+{
+    pthread_mutex_lock(&m_lock);
+    int connected = m_connected;
+    m_connected = 0;
+    if (m_sock >= 0) {
+        epoll_ctl(m_epfd, EPOLL_CTL_DEL, m_sock, NULL);
+        close(m_sock);
+        m_sock = -1;
+    }
+    pthread_mutex_unlock(&m_lock);
+    if (connected)
+        ticos_event_notify(TICOS_EVENT_DISCONNECT);
+}
+
+/**
+ * @brief 处理服务器发来的一个完整报文
+ * @note  连接成功后通知 sdk 并订阅相关 topic, 收到消息后调用 ticos_msg_recv_topic() 将数据传给 sdk 处理,
+ *        超出接收缓冲区的消息由 ticos_hal_fragment_begin() 按分片处理
+ */
+static int ticos_hal_handle(uint8_t *pkt, int hdr_len, int len)
+{
+    uint8_t *body = pkt + hdr_len;
+    int body_len = len - hdr_len;
+
+    switch (pkt[0] & 0xf0) {
+    case TICOS_MQTT_CONNACK:
+        if (body_len < 2 || body[1] != 0) {
+            printf("MQTT connection refused, code %d\n", body_len < 2 ? -1 : body[1]);
+            return -1;
+        }
+        pthread_mutex_lock(&m_lock);
+        m_connected = 1;
+        pthread_mutex_unlock(&m_lock);
+        ticos_event_notify(TICOS_EVENT_CONNECT);
+        ticos_mqtt_subscribe();
+        break;
+    case TICOS_MQTT_PUBLISH: {
+        int qos = (pkt[0] >> 1) & 3;
+        if (body_len < 2)
+            return -1;
+        int topic_len = ticos_mqtt_get_u16(body);
+        int off = 2 + topic_len + (qos ? 2 : 0);
+        if (off > body_len || qos > 1)
+            return -1;
+        // 在消息内容后临时补 '\0', 兼容按字符串处理数据的上层代码
+        uint8_t *payload = body + off;
+        int payload_len = body_len - off;
+        uint8_t saved = payload[payload_len];
+        payload[payload_len] = '\0';
+        ticos_msg_recv_topic((const char *)body + 2, topic_len, (const char *)payload, payload_len);
+        payload[payload_len] = saved;
+        if (qos) {
+            uint8_t ack[4] = { TICOS_MQTT_PUBACK, 2 };
+            ticos_mqtt_put_u16(ack + 2, ticos_mqtt_get_u16(body + 2 + topic_len));
+            ticos_hal_send_packet(ack, sizeof(ack));
+        }
+        break;
+    }
+    default:
+        // PUBACK, SUBACK, PINGRESP 无需处理
+        break;
+    }
+    return 0;
+}
+
+// 将接收缓冲区开头的数据作为当前 PUBLISH 报文的下一个分片交给 sdk, 返回使用的字节数
+static int ticos_hal_fragment(const char *topic, int topic_len, int avail)
+{
+    int len = avail < m_frag_left ? avail : m_frag_left;
+
+    ticos_msg_recv_fragment(topic, topic_len, (const char *)m_rx + m_rx_len - avail, len, m_frag_offset, m_frag_total);
+    m_frag_offset += len;
+    m_frag_left -= len;
+    if (!m_frag_left && m_frag_qos) {
+        uint8_t ack[4] = { TICOS_MQTT_PUBACK, 2 };
+        ticos_mqtt_put_u16(ack + 2, m_frag_id);
+        ticos_hal_send_packet(ack, sizeof(ack));
+    }
+    return len;
+}
+
+/**
+ * @brief 接收缓冲区已满时开始按分片接收开头的报文
+ * @note  只有 PUBLISH 报文可以超出接收缓冲区, 其报文头和 topic 须能放入缓冲区
+ */
+static int ticos_hal_fragment_begin(void)
+{
+    int hdr_len;
+    // 报文头已完整, 按足够长的数据取得报文总长度
+    int len = ticos_mqtt_frame(m_rx, INT_MAX, &hdr_len);
+    int qos = (m_rx[0] >> 1) & 3;
+
+    if (len <= 0 || (m_rx[0] & 0xf0) != TICOS_MQTT_PUBLISH || qos > 1 || hdr_len + 2 > m_rx_len)
+        return -1;
+    uint8_t *body = m_rx + hdr_len;
+    int topic_len = ticos_mqtt_get_u16(body);
+    int off = hdr_len + 2 + topic_len + (qos ? 2 : 0);
+    if (off > m_rx_len)
+        return -1;
+    m_frag_qos = qos;
+    m_frag_id = qos ? ticos_mqtt_get_u16(body + 2 + topic_len) : 0;
+    m_frag_total = len - off;
+    m_frag_left = m_frag_total;
+    m_frag_offset = 0;
+    ticos_hal_fragment((const char *)body + 2, topic_len, m_rx_len - off);
+    m_rx_len = 0;
+    return 0;
+}
+
+static int ticos_hal_read(void)
+{
+    ssize_t n = recv(m_sock, m_rx + m_rx_len, TICOS_HAL_RX_SIZE - m_rx_len, 0);
+    int off = 0;
+
+    if (n < 0 && (errno == EINTR || errno == EAGAIN))
+        return 0;
+    if (n <= 0)
+        return -1;
+    m_rx_len += n;
+    m_last_recv = ticos_uptime_ms();
+    if (m_frag_left)
+        off = ticos_hal_fragment(NULL, 0, m_rx_len);
+    for (; !m_frag_left;) {
+        int hdr_len;
+        int len = ticos_mqtt_frame(m_rx + off, m_rx_len - off, &hdr_len);
+        if (len < 0)
+            return -1;
+        if (!len)
+            break;
+        if (ticos_hal_handle(m_rx + off, hdr_len, len))
+            return -1;
+        off += len;
+    }
+    memmove(m_rx, m_rx + off, m_rx_len - off);
+    m_rx_len -= off;
+    // 报文超出接收缓冲区大小
+    if (m_rx_len == TICOS_HAL_RX_SIZE)
+        return ticos_hal_fragment_begin();
+    return 0;
+}
+
+static void *ticos_hal_loop(void *arg)
+{
+    struct epoll_event events[2];
+    int64_t retry_at = 0;
+
+    for (;;) {
+        int64_t now = ticos_uptime_ms();
+        int timeout = 1000;
+
+        // 发送线程、命令工作线程等也会更新 m_last_send
+        pthread_mutex_lock(&m_lock);
+        int64_t last_send = m_last_send;
+        pthread_mutex_unlock(&m_lock);
+
+        if (m_sock < 0) {
+            if (now >= retry_at && ticos_hal_connect()) {
+                ticos_hal_disconnect();
+                retry_at = now + TICOS_HAL_RECONNECT_MS;
+            }
+            if (m_sock < 0)
+                timeout = retry_at - now;
+        } else if (now - m_last_recv >= TICOS_HAL_KEEPALIVE * 1500) {
+            // 超过 1.5 倍心跳间隔没有收到任何数据, 认为连接已断开
+            ticos_hal_disconnect();
+            retry_at = now + TICOS_HAL_RECONNECT_MS;
+            continue;
+        } else if (now - last_send >= TICOS_HAL_KEEPALIVE * 500) {
+            uint8_t ping[2] = { TICOS_MQTT_PINGREQ, 0 };
+            ticos_hal_send_packet(ping, sizeof(ping));
+        }
+
+        int n = epoll_wait(m_epfd, events, 2, timeout);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == m_wake)
+                return NULL;
+            if (events[i].data.fd == m_sock && ticos_hal_read()) {
+                ticos_hal_disconnect();
+                retry_at = ticos_uptime_ms() + TICOS_HAL_RECONNECT_MS;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void ticos_hal_parse_url(const char *url, int port)
+{
+    const char *host = strstr(url, "://");
+    host = host ? host + 3 : url;
+    size_t n = strcspn(host, ":/");
+    if (n >= sizeof(m_host))
+        n = sizeof(m_host) - 1;
+    memcpy(m_host, host, n);
+    m_host[n] = '\0';
+    m_port = host[n] == ':' ? atoi(host + n + 1) : port;
+}
+
+/**
+ * @brief 启动平台相关的mqtt服务
+ * @note  创建 I/O 线程连接服务器, 连接断开后自动重连。ticos sdk会调用此接口连接到云端
+ */
+int ticos_hal_mqtt_start(const char *url, int port, const char *client_id, const char *user_name, const char *passwd)
+{
+    if (m_running)
+        return 1;
+    if (m_server_host[0]) {
+        snprintf(m_host, sizeof(m_host), "%s", m_server_host);
+        m_port = m_server_port;
+    } else {
+        ticos_hal_parse_url(url, port);
+    }
+    snprintf(m_client_id, sizeof(m_client_id), "%s", client_id);
+    snprintf(m_user, sizeof(m_user), "%s", user_name ? user_name : "");
+    snprintf(m_passwd, sizeof(m_passwd), "%s", passwd ? passwd : "");
+
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_CLOEXEC);
+    if (m_epfd < 0 || m_wake < 0)
+        goto fail;
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = m_wake };
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_wake, &ev);
+    if (pthread_create(&m_thread, NULL, ticos_hal_loop, NULL))
+        goto fail;
+    m_running = 1;
+    printf("MQTT client started\n");
+    return 0;
+
+fail:
+    printf("Failed creating mqtt client\n");
+    if (m_epfd >= 0)
+        close(m_epfd);
+    if (m_wake >= 0)
+        close(m_wake);
+    m_epfd = m_wake = -1;
+    return 1;
+}
+
+/**
+ * @brief 停止平台相关的mqtt服务
+ * @note  该函数停止mqtt客户端与云端的连接。ticos sdk停止时会调用此接口
+ */
+void ticos_hal_mqtt_stop()
+{
+    uint64_t one = 1;
+    uint8_t disconnect[2] = { TICOS_MQTT_DISCONNECT, 0 };
+
+    if (!m_running)
+        return;
+    if (write(m_wake, &one, sizeof(one)) < 0)
+        perror("eventfd");
+    pthread_join(m_thread, NULL);
+    if (ticos_hal_mqtt_connected())
+        ticos_hal_send_packet(disconnect, sizeof(disconnect));
+    ticos_hal_disconnect();
+    close(m_epfd);
+    close(m_wake);
+    m_epfd = m_wake = -1;
+    m_running = 0;
+}
@@ -0,0 +1,55 @@
+#include "ticos_hal_linux.h"
+#include "ticos_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TICOS_TRACE_DUMP_THREADS 256
+
+/*
+ * 输出 Chrome trace event 格式: {"traceEvents":[{"name":..,"ph":"B","ts":微秒,"pid":1,"tid":..,"args":{"arg":..}},...]},
+ * 时间以时间戳最早的一条记录为起点, 起点之后 32 位时间戳回绕也能正确换算。
+ * 多个线程的记录按写入顺序排列, 时间戳不一定递增, 起点取与第一条记录相差最多的更早时间戳
+ * 最早的开始记录被覆盖后, 其对应的结束记录没有配对, 直接丢弃
+ */
+int ticos_trace_dump(const char *path)
+{
+    ticos_trace_record_t *records = malloc(sizeof(*records) * TICOS_TRACE_RECORDS);
+    static int depth[TICOS_TRACE_DUMP_THREADS];
+    FILE *fp;
+    int cnt;
+
+    if (!records)
+        return -1;
+    cnt = ticos_trace_read(records, TICOS_TRACE_RECORDS);
+    fp = fopen(path, "w");
+    if (!fp) {
+        free(records);
+        return -1;
+    }
+    for (int i = 0; i < TICOS_TRACE_DUMP_THREADS; i++)
+        depth[i] = 0;
+    uint32_t base = cnt ? records[0].ts_us : 0;
+    for (int i = 1; i < cnt; i++) {
+        if ((int32_t)(records[i].ts_us - base) < 0)
+            base = records[i].ts_us;
+    }
+    fprintf(fp, "{\"traceEvents\":[");
+    int first = 1;
+    for (int i = 0; i < cnt; i++) {
+        const ticos_trace_record_t *r = &records[i];
+        int *d = &depth[r->tid % TICOS_TRACE_DUMP_THREADS];
+        if (r->phase == 'E' && !*d)
+            continue;
+        *d += r->phase == 'B' ? 1 : -1;
+        uint32_t ts = r->ts_us - base;
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":%u", first ? "" : ",",
+                ticos_trace_name(r->id), r->phase, (unsigned int)ts, (unsigned int)r->tid);
+        if (r->phase == 'B')
+            fprintf(fp, ",\"args\":{\"arg\":%u}", (unsigned int)r->arg);
+        fprintf(fp, "}");
+        first = 0;
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    free(records);
+    return fclose(fp) ? -1 : cnt;
+}
@@ -41,7 +41,7 @@ int ticos_hal_mqtt_subscribe(const char *topic, int qos)
  * @note  当使用连接云端成功后，会产生MQTT_EVENT_CONNECTED事件，
  *        此时用户需要调用ticos_mqtt_subscribe()订阅和云端通信相关的topic
  *        当client从云端接收到数据后，会产生MQTT_EVENT_DATA事件，
- *        此时用户需要回调ticos_msg_recv()将数据传给sdk进行处理
+ *        此时用户需要回调ticos_msg_recv_topic()将数据传给sdk进行处理
  */
 #if 0
 static void mqtt_event_handler(mqtt_event_handle_t event)
@@ -53,7 +53,7 @@ static void mqtt_event_handler(mqtt_event_handle_t event)
       break;
     case MQTT_EVENT_DATA:
       printf("MQTT event MQTT_EVENT_DATA");
-      ticos_msg_recv(event->topic, event->data, event->data_len);
+      ticos_msg_recv_topic(event->topic, event->topic_len, event->data, event->data_len);
       break;
     default:
       printf("mqtt event: id = %d\n", event->event_id);
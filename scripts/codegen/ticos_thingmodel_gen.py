@@ -21,7 +21,8 @@ iot_type_map = {
     "string" :  "const char*",
     "Enum"   :  "int",   # TODO 是否可以映射short类型?
     "timestamp":"time_t",
-    "duration" :"time_t"
+    "duration" :"time_t",
+    "blob"     :"const void*"
 }
 
 def schema_to_c_type(t):
@@ -36,6 +37,27 @@ def gen_iot_val_type(t):
         t = t[TYPE]
     return 'TICOS_VAL_TYPE_' + t.upper()
 
+STREAM_TYPES = ('TICOS_VAL_TYPE_STREAM', 'TICOS_VAL_TYPE_BLOB')
+
+def gen_item_val_type(item):
+    ''' 返回字段的 TICOS_VAL_TYPE, 声明了 "stream": true 的字符串字段为分块读取的流式字段 '''
+    _e = gen_iot_val_type(item[SCHEMA])
+    if _e == 'TICOS_VAL_TYPE_STRING' and item.get('stream'):
+        return 'TICOS_VAL_TYPE_STREAM'
+    return _e
+
+def is_stream(item):
+    return gen_item_val_type(item) in STREAM_TYPES
+
+def check_stream(item):
+    ''' 流式字段只能由设备上报, 且每次单独上报, 不能用于命令, 也不能声明上报过滤条件和周期 '''
+    if not is_stream(item):
+        return
+    if item[TYPE] == CMMD:
+        raise Exception('命令 %s 不能使用流式字段' % item[NAME])
+    if has_filter(item) or 'period' in item:
+        raise Exception('流式字段 %s 不能声明上报过滤条件和周期' % item[NAME])
+
 def gen_func_name_getter(_key, _id):
     return ' ticos_' + _key + '_' + _id + '_send'
 
@@ -45,6 +67,10 @@ def gen_func_name_setter(_key, _id):
 def gen_func_head_getter(_key, _id, _type):
     return '\n' + _type + gen_func_name_getter(_key, _id) + '(void)'
 
+def gen_func_head_stream(_key, _id):
+    ''' 流式字段的 getter 与 ticos_stream_read_t 一致, 从 offset 处读取至多 size 字节 '''
+    return '\nint' + gen_func_name_getter(_key, _id) + '(size_t offset, void *buf, int size)'
+
 def gen_func_head_setter(_key, _id, _type):
     return '\nint ' + gen_func_name_setter(_key, _id) + '(' + _type + ' ' + _id + '_)'
 
@@ -64,7 +90,9 @@ def gen_func_decs(item, need_getter, need_setter):
     _k = item[TYPE]
     _i = item[NAME]
     _t = schema_to_c_type(item[SCHEMA])
-    if need_getter:
+    if need_getter and is_stream(item):
+        decs += gen_func_head_stream(_k, _i) + ';'
+    elif need_getter:
         decs += gen_func_head_getter(_k, _i, _t) + ';'
     if need_setter:
         decs += gen_func_head_setter(_k, _i, _t) + ';'
@@ -77,26 +105,61 @@ def gen_func_defs(item, need_getter, need_setter):
     _i = item[NAME]
     _t = schema_to_c_type(item[SCHEMA])
     if need_getter:
-        head = gen_func_head_getter(_k, _i, _t)
+        head = gen_func_head_stream(_k, _i) if is_stream(item) else gen_func_head_getter(_k, _i, _t)
         defs += head + gen_func_body_getter(_k, _i, _t)
     if need_setter:
         head = gen_func_head_setter(_k, _i, _t)
         defs += head + gen_func_body_setter(_k, _i, _t)
     return defs
 
+''' 物模型json中字段的上报过滤条件 到 ticos_report_filter_t 成员的对应关系, 按成员顺序排列 '''
+FILTER_KEYS = [
+    ('deadband',        float),     # 绝对死区
+    ('deadbandPercent', float),     # 相对死区(百分比)
+    ('minInterval',     int),       # 最小上报间隔(毫秒)
+    ('maxInterval',     int),       # 最大上报间隔(毫秒)
+]
+
+def has_filter(item):
+    return any(k in item for k, _ in FILTER_KEYS)
+
+def gen_filter_name(item):
+    return 'ticos_' + item[TYPE] + '_' + item[NAME] + '_filter'
+
+def gen_filter(item):
+    ''' 根据物模型json内容返回字段的上报过滤条件定义, 字段未声明过滤条件时返回空字符串 '''
+    if not has_filter(item):
+        return ''
+    vals = []
+    for k, t in FILTER_KEYS:
+        v = item.get(k, 0)
+        if type(v) not in (int, float) or v < 0:
+            raise Exception('字段 %s 的 %s 须为非负数' % (item[NAME], k))
+        vals.append(repr(float(v)) + 'f' if t == float else str(int(v)))
+    return '\nstatic const ticos_report_filter_t %s = { %s };\n' % (gen_filter_name(item), ', '.join(vals))
+
 def gen_table(item, need_getter, need_setter):
     ''' 根据物模型json内容返回对应的方法表成员注册 '''
     _k = item[TYPE]
     _i = item[NAME]
-    _t = item[SCHEMA]
-    _e = gen_iot_val_type(_t)
+    _e = gen_item_val_type(item)
     getter = gen_func_name_getter(_k, _i)
     setter = gen_func_name_setter(_k, _i)
+    _f = ', &' + gen_filter_name(item) if need_getter and has_filter(item) else ''
+    # 遥测的周期上报间隔(毫秒)紧跟在过滤条件之后, 未声明过滤条件时以 NULL 占位
+    if _k == TELE and 'period' in item:
+        _p = item['period']
+        if type(_p) != int or _p < 0:
+            raise Exception('字段 %s 的 period 须为非负整数' % _i)
+        _f = (_f or ', NULL') + ', ' + str(_p)
+    # 流式字段只能上报, 属性的 recv 函数以 NULL 占位
+    if need_getter and is_stream(item):
+        return '\n    { \"%s\", %s, %s%s },' %(_i, _e, getter, ', NULL' if _k == PROP else '')
     if need_getter:
         if need_setter:
-            return '\n    { \"%s\", %s, %s, %s },' %(_i, _e, getter, setter)
+            return '\n    { \"%s\", %s, %s, %s%s },' %(_i, _e, getter, setter, _f)
         else:
-            return '\n    { \"%s\", %s, %s },' %(_i, _e, getter)
+            return '\n    { \"%s\", %s, %s%s },' %(_i, _e, getter, _f)
     else:
         return '\n    { \"%s\", %s, %s },' %(_i, _e, setter)
 
@@ -112,8 +175,210 @@ def gen_public_vars(item):
     _t = schema_to_c_type(item[SCHEMA])
     return  _t + ' ' + _k + '_' + _i + ';'
 
-def gen_iot(date_time, tmpl_dir, thingmodel, to='.'):
-    ''' 根据物模型json文件返回对应的物模型接口文件 '''
+FNV_PRIME = 0x01000193
+
+def fnv_hash(seed, key):
+    ''' 字段名哈希函数，须与 src/ticos_thingmodel_index.c 中的 ticos_hash() 保持一致 '''
+    h = seed if seed else FNV_PRIME
+    for c in key.encode('utf-8'):
+        h = ((h * FNV_PRIME) ^ c) & 0xffffffff
+    # 末尾再混合一次，使低位也能均匀分布
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & 0xffffffff
+    h ^= h >> 16
+    return h
+
+def gen_perfect_hash(keys):
+    ''' 为字段名列表生成最小完美哈希(hash and displace)，返回 (位移表, 槽位表) '''
+    n = len(keys)
+    if len(set(keys)) != n:
+        raise Exception('物模型中存在重名的字段')
+    buckets = [[] for _ in range(n)]
+    for i, k in enumerate(keys):
+        buckets[fnv_hash(0, k) % n].append(i)
+
+    disp = [0] * n
+    slots = [None] * n
+    # 先放置冲突多的桶，为每个桶寻找一个使其所有字段都落在空槽位上的种子
+    for b in sorted(range(n), key=lambda b: -len(buckets[b])):
+        items = buckets[b]
+        if len(items) <= 1:
+            break
+        d = 1
+        while True:
+            placed = []
+            for i in items:
+                s = fnv_hash(d, keys[i]) % n
+                if slots[s] is not None or s in placed:
+                    break
+                placed.append(s)
+            else:
+                break
+            d += 1
+        for i, s in zip(items, placed):
+            slots[s] = i
+        disp[b] = d
+
+    # 只有一个字段的桶直接指定槽位
+    free = [s for s in range(n) if slots[s] is None]
+    for b in range(n):
+        if len(buckets[b]) == 1:
+            s = free.pop()
+            slots[s] = buckets[b][0]
+            disp[b] = -s - 1
+    return disp, slots
+
+def gen_index(_key, items):
+    ''' 根据物模型字段列表返回对应的字段名哈希表 '''
+    name = 'ticos_' + _key + '_index'
+    names = [item[NAME] for item in items]
+    if not names:
+        return '\nconst ticos_thingmodel_index_t %s = { 0 };\n' % name
+    disp, slots = gen_perfect_hash(names)
+    code = '\nstatic const int %s_disp[] = {' % name
+    for i in range(0, len(disp), 16):
+        code += '\n    ' + ' '.join('%d,' % d for d in disp[i:i + 16])
+    code += '\n};\n'
+    code += '\nstatic const ticos_index_slot_t %s_slots[] = {' % name
+    for i in slots:
+        code += '\n    { TICOS_%s_%s, %d },' % (_key.upper(), names[i], len(names[i].encode('utf-8')))
+    code += '\n};\n'
+    code += '\nconst ticos_thingmodel_index_t %s = { %s_disp, %s_slots, %d };\n' % (name, name, name, len(names))
+    return code
+
+def gen_key_fragment(_id):
+    ''' 返回字段名片段 "name": 对应的 c 字符串常量及其字节数 '''
+    import json
+    frag = json.dumps(_id, ensure_ascii=False) + ':'
+    literal = '"' + ''.join('\\' + c if c in '"\\' else c for c in frag) + '"'
+    return literal, len(frag.encode('utf-8'))
+
+SERIALIZE_VALUE = {
+    'TICOS_VAL_TYPE_BOOLEAN': ('i', 'ticos_json_bool(w, %s);'),
+    'TICOS_VAL_TYPE_INTEGER': ('i', 'ticos_json_int(w, %s);'),
+    'TICOS_VAL_TYPE_FLOAT':   ('f', 'ticos_json_float(w, %s);'),
+    'TICOS_VAL_TYPE_STRING':  ('s', 'ticos_json_string(w, %s);'),
+}
+
+def gen_serializer(_key, items):
+    ''' 生成全量上报使用的专用 JSON 编码函数：字段名片段预先编码，直接调用有类型的 getter，
+        输出与 SDK 逐字段编码的结果一致；属性同时更新 SDK 的属性上报缓存。
+        有字段声明了上报过滤条件时不生成, 由 SDK 逐字段过滤和编码 '''
+    if any(has_filter(item) for item in items):
+        return ''
+    cache = _key == PROP
+    args = 'ticos_client_t *client, ticos_json_writer_t *w' if cache else 'ticos_json_writer_t *w'
+    code = '\nvoid ticos_thingmodel_serialize_%s(%s)\n{' % (_key, args)
+    if cache and items:
+        code += '\n    ticos_value_t val;\n'
+    for item in items:
+        if is_stream(item):
+            continue
+        _i = item[NAME]
+        _e = gen_iot_val_type(item[SCHEMA])
+        frag, frag_len = gen_key_fragment(_i)
+        key = 'ticos_json_key_raw(w, %s, %d);' % (frag, frag_len)
+        member, put = SERIALIZE_VALUE.get(_e, ('i', None))
+        getter = gen_func_name_getter(item[TYPE], _i).strip() + '()' if put else '0'
+        if not cache:
+            if member == 's':
+                code += '\n    {\n        const char *s = %s;\n        if (s) {\n            %s\n            %s\n        }\n    }' % (getter, key, put % 's')
+            else:
+                code += '\n    %s\n    %s' % (key, put % getter if put else 'ticos_json_null(w);')
+            continue
+        update = 'ticos_property_cache_update(client, TICOS_PROPERTY_%s, &val);' % _i
+        code += '\n    val.type = %s;\n    val.v.%s = %s;' % (_e, member, getter)
+        if member == 's':
+            code += '\n    if (val.v.s) {\n        %s\n        %s\n        %s\n    }' % (update, key, put % 'val.v.s')
+        else:
+            code += '\n    %s\n    %s\n    %s' % (update, key, put % ('val.v.' + member) if put else 'ticos_json_null(w);')
+    code += '\n}\n'
+    return code
+
+def gen_thingmodel_hash(items):
+    ''' 物模型哈希值：按字段在各方法表中的顺序对 类别:字段名:类型 求哈希，CBOR 上报时据此校验双方的物模型版本 '''
+    canon = ';'.join('%s:%s:%s' % (item[TYPE], item[NAME], gen_item_val_type(item)) for item in items)
+    return '\nconst uint32_t ticos_thingmodel_hash = 0x%08x;\n' % fnv_hash(0, canon)
+
+''' 各类型字段值编码后的最大字节数 (JSON 文本, CBOR), 字符串按长度另算, 其余类型编码为 null '''
+VALUE_MAX = {
+    'TICOS_VAL_TYPE_BOOLEAN': (5, 1),       # false
+    'TICOS_VAL_TYPE_INTEGER': (11, 5),      # -2147483648
+    'TICOS_VAL_TYPE_FLOAT':   (16, 5),      # ticos_ftoa() 的最长输出, 如 -100000000000000
+}
+NULL_MAX = (4, 1)
+INT64_TEXT_MAX = 20                         # 批量上报样本中的 ts
+STRING_MAX_DEFAULT = 255
+BATCH_ENVELOPE = len('{"samples":[') + len(']}')
+
+def string_bound(item):
+    ''' 字符串字段的最大字节数(UTF-8), 取自字段或 schema 中的 maxLength, 未声明时按默认值计算 '''
+    schema = item[SCHEMA]
+    n = item.get('maxLength', schema.get('maxLength') if type(schema) == type({}) else None)
+    if n is None:
+        return STRING_MAX_DEFAULT
+    if type(n) != int or n < 0:
+        raise Exception('字段 %s 的 maxLength 须为非负整数' % item[NAME])
+    return n
+
+def cbor_head_len(n):
+    ''' CBOR 数据项首部的字节数 '''
+    return 1 if n < 24 else 2 if n < 0x100 else 3 if n < 0x10000 else 5
+
+def value_max(item):
+    ''' 返回字段值编码后的最大字节数 (JSON, CBOR), JSON 字符串按每个字节都转义为 \\u00XX 计算 '''
+    _e = gen_iot_val_type(item[SCHEMA])
+    if _e == 'TICOS_VAL_TYPE_STRING':
+        n = string_bound(item)
+        return 2 + 6 * n, cbor_head_len(n) + n
+    return VALUE_MAX.get(_e, NULL_MAX)
+
+def json_object_max(items, head=0):
+    ''' 全部字段都上报时 JSON 对象的最大字节数, 含结尾的 '\\0'; head 为字段之前已有成员的长度 '''
+    size = 2 + head + 1
+    for i, item in enumerate(items):
+        size += gen_key_fragment(item[NAME])[1] + value_max(item)[0] + (1 if i or head else 0)
+    return size
+
+def cbor_map_max(items):
+    ''' 全部字段都上报时 CBOR 数据的最大字节数: 自描述标签, 不定长 map, 物模型哈希, 以下标为键的字段 '''
+    size = 3 + 1 + 1 + 5 + 1
+    for i, item in enumerate(items):
+        size += cbor_head_len(i) + value_max(item)[1]
+    return size
+
+def gen_payload_sizes(teles, props, cmmds):
+    ''' 按物模型计算各类上报数据和下发字符串的最坏情况, 返回宏定义和 (名称, 大小) 列表;
+        流式字段不在这些上报中, 单独上报时超出上报缓冲区的部分分块发送 '''
+    teles = [item for item in teles if not is_stream(item)]
+    props = [item for item in props if not is_stream(item)]
+    tele = max(json_object_max(teles), cbor_map_max(teles))
+    prop = max(json_object_max(props), cbor_map_max(props))
+    sample = BATCH_ENVELOPE + json_object_max(teles, len('"ts":') + INT64_TEXT_MAX)
+    strings = [item for item in teles + props + cmmds if gen_iot_val_type(item[SCHEMA]) == 'TICOS_VAL_TYPE_STRING']
+    unbounded = [item[NAME] for item in strings if 'maxLength' not in item and
+                 not (type(item[SCHEMA]) == type({}) and 'maxLength' in item[SCHEMA])]
+    if unbounded:
+        print('警告: %d 个字符串字段未声明 maxLength, 按 %d 字节计算缓冲区大小: %s%s' %
+              (len(unbounded), STRING_MAX_DEFAULT, ', '.join(unbounded[:8]), ' ...' if len(unbounded) > 8 else ''))
+    recv = [string_bound(item) for item in strings if item[TYPE] != TELE]
+    sizes = [
+        ('TICOS_THINGMODEL_TELEMETRY_MAX', tele, '全量遥测上报的最大字节数, JSON 和 CBOR 取较大者'),
+        ('TICOS_THINGMODEL_PROPERTY_MAX', prop, '全量属性上报的最大字节数, JSON 和 CBOR 取较大者'),
+        ('TICOS_THINGMODEL_SAMPLE_MAX', sample, '只含一个样本的批量遥测上报的最大字节数'),
+        ('TICOS_THINGMODEL_REPORT_MAX', max(tele, prop, sample), '上报缓冲区的大小, 取以上各项的最大值'),
+        ('TICOS_THINGMODEL_STRING_MAX', max(recv, default=0) + 1, '云端下发的属性和命令字符串的最大长度, 含结尾的 \'\\0\''),
+    ]
+    code = ''
+    for name, size, desc in sizes:
+        code += '\n/** %s */\n#define %s %d\n' % (desc, name, size)
+    return code, sizes
+
+def gen_iot(date_time, tmpl_dir, thingmodel, to='.', commands=False, serializers=False):
+    ''' 根据物模型json文件返回对应的物模型接口文件, commands 为 True 时同时生成命令处理函数,
+        serializers 为 True 时同时生成遥测和属性的专用编码函数 '''
     import json
 
     raw = None
@@ -132,28 +397,40 @@ def gen_iot(date_time, tmpl_dir, thingmodel, to='.'):
     cmmd_enum = ''
 
     func_defs = ''
+    filters = ''
     tele_tabs = ''
     prop_tabs = ''
     cmmd_tabs = ''
 
+    teles = []
+    props = []
+    cmmds = []
+
     for item in raw[0]['contents']:
         item[TYPE] = item[TYPE].lower()
         _type = item[TYPE]
+        check_stream(item)
         if _type == TELE:
             func_decs += gen_func_decs(item, True, False)
             func_defs += gen_func_defs(item, True, False)
+            filters += gen_filter(item)
             tele_tabs += gen_table(item, True, False)
             tele_enum += gen_enum(item)
+            teles.append(item)
         elif _type == PROP:
-            func_decs += gen_func_decs(item, True, True)
-            func_defs += gen_func_defs(item, True, True)
-            prop_tabs += gen_table(item, True, True)
+            need_setter = not is_stream(item)
+            func_decs += gen_func_decs(item, True, need_setter)
+            func_defs += gen_func_defs(item, True, need_setter)
+            filters += gen_filter(item)
+            prop_tabs += gen_table(item, True, need_setter)
             prop_enum += gen_enum(item)
-        #elif _type == CMMD:
-        #    func_decs += gen_func_decs(item, False, True)
-        #    func_defs += gen_func_defs(item, False, True)
-        #    cmmd_tabs += gen_table(item, False, True)
-        #    cmmd_enum += gen_enum(item)
+            props.append(item)
+        elif _type == CMMD and commands:
+            func_decs += gen_func_decs(item, False, True)
+            func_defs += gen_func_defs(item, False, True)
+            cmmd_tabs += gen_table(item, False, True)
+            cmmd_enum += gen_enum(item)
+            cmmds.append(item)
     tele_enum += gen_enum({ TYPE:TELE, NAME:'MAX'}) + '\n'
     prop_enum += gen_enum({ TYPE:PROP, NAME:'MAX'}) + '\n'
     cmmd_enum += gen_enum({ TYPE:CMMD, NAME:'MAX'}) + '\n'
@@ -164,9 +441,15 @@ def gen_iot(date_time, tmpl_dir, thingmodel, to='.'):
         dot_c_lines.append(tmpl.substitute(
                     DATE_TIME = date_time,
                     FUNC_DEFS = func_defs,
+                    REPORT_FILTERS = filters,
                     TELEMETRY_TABS = tele_tabs,
                     PROPERTY_TABS = prop_tabs,
-                    COMMAND_TABS = cmmd_tabs))
+                    COMMAND_TABS = cmmd_tabs,
+                    PROPERTY_INDEX = gen_index(PROP, props),
+                    COMMAND_INDEX = gen_index(CMMD, cmmds),
+                    THINGMODEL_HASH = gen_thingmodel_hash(teles + props + cmmds),
+                    SERIALIZER_INCLUDES = '\n#include "ticos_thingmodel_op.h"' if serializers else '',
+                    SERIALIZERS = gen_serializer(TELE, teles) + gen_serializer(PROP, props) if serializers else ''))
     with open(to + '/ticos_thingmodel.c', 'w', encoding='utf-8') as f:
         f.writelines(dot_c_lines)
 
@@ -183,18 +466,30 @@ def gen_iot(date_time, tmpl_dir, thingmodel, to='.'):
     with open(to + '/ticos_thingmodel.h', 'w', encoding='utf-8') as f:
         f.writelines(dot_h_lines)
 
-def generate(thingmodel='', to='.'):
+    # 全静态内存模式下 SDK 按这些大小分配缓冲区, 生成时一并输出, 便于评估内存占用
+    payload_sizes, sizes = gen_payload_sizes(teles, props, cmmds)
+    with open(tmpl_dir + 'iot_config_h', 'r', encoding='utf-8') as f:
+        tmpl = Template(f.read())
+        config_h = tmpl.substitute(DATE_TIME = date_time, PAYLOAD_SIZES = payload_sizes)
+    with open(to + '/ticos_thingmodel_config.h', 'w', encoding='utf-8') as f:
+        f.write(config_h)
+    for name, size, _ in sizes:
+        print('%-32s %d' % (name, size))
+
+def generate(thingmodel='', to='.', commands=False, serializers=False):
     date_time = datetime.now().strftime('%Y-%m-%d %H:%M:%S')
     py_dir = os.path.dirname(os.path.abspath(__file__))
     tmpl_dir = py_dir + '/templates/'
 
     if not thingmodel:
         raise Exception('请指定物模型json')
-    gen_iot(date_time, tmpl_dir, thingmodel, to)
+    gen_iot(date_time, tmpl_dir, thingmodel, to, commands, serializers)
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='ticos_thingmodel_gen')
     parser.add_argument('--thingmodel', type=str, default='', help='json file|data of thing model')
     parser.add_argument('--to', type=str, default='.', help='target directory')
+    parser.add_argument('--commands', action='store_true', help='generate command handlers as well')
+    parser.add_argument('--serializers', action='store_true', help='generate specialized report serializers')
     args = parser.parse_args()
-    generate(args.thingmodel, args.to)
+    generate(args.thingmodel, args.to, args.commands, args.serializers)
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -39,6 +41,15 @@ void ticos_cloud_stop();
  */
 int ticos_property_report(void);
 
+/**
+ * @brief  只上报值发生变化的物模型属性到云端
+ * @note   SDK 会缓存每个属性最近一次成功上报的值, 此接口只上报与缓存值不同的属性, 没有变化时不发送任何消息。
+ *         连接成功(TICOS_EVENT_CONNECT)后缓存会被清空, 下一次调用将上报全部属性。
+ *         物模型中声明了死区或上报间隔的属性改为按其过滤条件判断是否上报
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_property_report_changed(void);
+
 /**
  * @brief  上报单个属性值到云端
  * @note   此接口会上报用户在ti_thingmodel.h里面定义的属性值到云端
@@ -49,7 +60,8 @@ int ticos_property_report_by_index(int index);
 
 /**
  * @brief  上报遥测到云端
- * @note   此接口会上报用户在ti_thingmodel.c里面定义的遥测到云端
+ * @note   此接口会上报用户在ti_thingmodel.c里面定义的遥测到云端。物模型中声明了死区或上报间隔的遥测,
+ *         变化未超出死区或未到最小间隔时不上报, 超过最大间隔时总是上报; 所有遥测都被过滤时不发送任何消息
  * @return 0 代表成功，其他值代表错误
  */
 int ticos_telemetry_report(void);
@@ -62,6 +74,362 @@ int ticos_telemetry_report(void);
  */
 int ticos_telemetry_report_by_index(int index);
 
+/**
+ * @brief  采集一次遥测样本并缓存, 暂不上报
+ * @note   样本带有采集时的 UTC 时间戳(毫秒), 编码后存入环形缓存, 缓存满时丢弃最早的样本。
+ *         满足批量上报策略时, 缓存的样本会被打包为一条消息上报到遥测 topic, 格式为:
+ *         {"samples":[{"ts":1668300000000,"pressure":1023,...},...]}
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_telemetry_sample(void);
+
+/**
+ * @brief  立即上报所有缓存的遥测样本
+ * @note   样本超出单条消息的大小限制时会拆分为多条消息; 上报失败的样本保留在缓存中
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_telemetry_flush(void);
+
+/**
+ * @brief  检查缓存的遥测样本是否已超过最大缓存时长, 超过时立即上报
+ * @note   设置了 max_age_ms 策略时, 用户需要周期性地调用此接口
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_telemetry_batch_poll(void);
+
+/**
+ * @brief  设置遥测批量上报策略, 任一条件满足时即打包上报
+ * @param max_samples 缓存的样本数达到此值时上报, 0 表示不限制
+ * @param max_bytes 单条批量消息的最大字节数, 0 表示只受上报缓冲区大小限制
+ * @param max_age_ms 最早的样本缓存超过此时长(毫秒)时上报, 0 表示不限制
+ * @return void
+ */
+void ticos_telemetry_batch_policy(int max_samples, int max_bytes, int max_age_ms);
+
+/**
+ * @brief  设置上报合并窗口
+ * @note   需要开启 TICOS_COALESCE_FIELDS. 同一设备的属性(或遥测)上报在上一次发送后的窗口期内不会立即发送,
+ *         窗口内的多次上报请求合并为一条消息, 其中包含这些请求涉及的所有字段, 窗口结束后由 ticos_report_poll()
+ *         或发送线程发出; 窗口外的第一次请求仍立即发送。被合并的请求返回 0
+ * @param window_ms 窗口时长(毫秒), 0 表示不合并
+ * @return void
+ */
+void ticos_set_report_window(int window_ms);
+
+/**
+ * 限速的 topic 类别
+ */
+typedef enum {
+    TICOS_TOPIC_PROPERTY,   // 属性上报
+    TICOS_TOPIC_TELEMETRY,  // 遥测上报
+    TICOS_TOPIC_CLASS_MAX,
+} ticos_topic_class_t;
+
+/**
+ * @brief  设置一类 topic 的上报速率限制
+ * @note   需要开启 TICOS_COALESCE_FIELDS. 以令牌桶按消息条数和字节数分别限速, 令牌不足时上报请求与上报合并窗口一样
+ *         被合并, 待令牌补充后由 ticos_report_poll() 或发送线程发出, 因此突发的上报不会丢失, 只会合并为更少的消息。
+ *         字节数在消息编码后才扣除, 允许透支, 超出突发量的单条消息不会一直等待
+ * @param cls topic 类别
+ * @param msgs_per_sec 每秒最多发送的消息条数, 0 表示不限制
+ * @param bytes_per_sec 每秒最多发送的字节数, 0 表示不限制
+ * @param burst_msgs 可连续发送的消息条数, 0 表示与 msgs_per_sec 相同
+ * @param burst_bytes 可连续发送的字节数, 0 表示与 bytes_per_sec 相同
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_set_rate_limit(ticos_topic_class_t cls, int msgs_per_sec, int bytes_per_sec, int burst_msgs, int burst_bytes);
+
+/**
+ * @brief  设置遥测的周期上报间隔
+ * @note   需要开启 TICOS_SCHEDULE_FIELDS. 设置覆盖物模型中为该遥测声明的 period。周期上报的遥测由时间轮定时采集,
+ *         同一 tick 到期的遥测合并为一条消息, 每个周期都会上报, 不经过物模型中声明的过滤条件; 到期的上报由 ticos_report_poll()
+ *         或发送线程发出。可在 ticos_cloud_start() 之前或之后调用
+ * @param index 遥测的下标
+ * @param period_ms 上报周期(毫秒), 0 表示恢复使用物模型中声明的周期, 负数表示不周期上报
+ * @return 0 代表成功, 下标超出遥测数量或 TICOS_SCHEDULE_FIELDS 时返回 -1
+ */
+int ticos_telemetry_set_period(int index, int period_ms);
+
+/**
+ * @brief  发送重新连接后的全量属性上报, 以及已到期的合并上报、周期上报和运行统计
+ * @note   重新连接后需要调用一次此接口同步属性; 设置了上报合并窗口、速率限制、周期上报或运行统计的自动上报时,
+ *         用户需要周期性地调用此接口; 发送线程启动后由发送线程处理, 不应再调用此接口
+ * @return 本次发送的全量属性上报、合并上报、周期上报和运行统计数
+ */
+int ticos_report_poll(void);
+
+/**
+ * @brief  计算距离下一次需要调用 ticos_report_poll() 的时间
+ * @note   主循环可据此休眠, 休眠期间发起的上报请求或修改的上报周期可能使下一次到期时间提前
+ * @return 需要等待的毫秒数, 0 代表已有到期的上报, -1 代表没有被推迟或周期上报的字段, 也没有开启运行统计的自动上报
+ */
+int ticos_report_next_ms(void);
+
+/**
+ * 异步上报请求的入队结果
+ */
+typedef enum {
+    TICOS_SEND_OK = 0,      // 已放入发送队列
+    TICOS_SEND_FULL,        // 发送队列已满, 请求未入队, 调用者可稍后重试或放弃本次上报
+    TICOS_SEND_ERROR,       // 参数错误或未开启异步上报
+} ticos_send_status_t;
+
+/**
+ * @brief  启动发送线程
+ * @note   需要开启 TICOS_SEND_QUEUE_SIZE. 发送线程依次取出异步上报请求, 调用物模型的 getter 函数编码后发送,
+ *         上报数据的编码和 ticos_hal_mqtt_publish() 都在发送线程中执行; 启动后不应再在其他线程中调用同步的上报接口,
+ *         以免与发送线程同时使用上报缓冲区
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_sender_start(void);
+
+/**
+ * @brief  停止发送线程
+ * @note   发送完队列中已有的请求后才返回
+ * @return void
+ */
+void ticos_sender_stop(void);
+
+/**
+ * @brief  获取发送队列中尚未处理的请求数
+ * @return 请求数
+ */
+int ticos_send_pending(void);
+
+/**
+ * @brief  异步上报接口, 与同名的同步接口(去掉 _async 后缀)一致, 只是将请求放入发送队列后立即返回
+ * @note   可在任意线程或任务中并发调用, 入队不加锁, 队列满时不阻塞而是返回 TICOS_SEND_FULL。
+ *         属性和遥测的值在发送线程处理请求时才读取; 发送线程未启动时请求保留在队列中, 启动后再发送
+ * @return 入队结果
+ */
+ticos_send_status_t ticos_property_report_async(void);
+ticos_send_status_t ticos_property_report_changed_async(void);
+ticos_send_status_t ticos_property_report_by_index_async(int index);
+ticos_send_status_t ticos_telemetry_report_async(void);
+ticos_send_status_t ticos_telemetry_report_by_index_async(int index);
+
+/**
+ * 命令执行结果码: 命令处理函数的返回值原样回复云端, 以下负值由 SDK 使用
+ */
+#define TICOS_COMMAND_TIMEOUT   (-408)  // 超过时限仍未执行或未执行完
+#define TICOS_COMMAND_TOO_LARGE (-413)  // 字符串参数超出 TICOS_RECV_STRING_MAX
+#define TICOS_COMMAND_BUSY      (-429)  // 超出命令的并发数或任务队列已满, 未执行
+
+/**
+ * @brief  启动命令线程池
+ * @note   需要开启 TICOS_COMMAND_QUEUE_SIZE. 启动后云端下发的命令放入任务队列, 由工作线程执行,
+ *         命令处理函数可能在多个线程中同时执行; 未启动时命令在 MQTT 接收线程中直接执行。
+ *         命令请求中带有 "$id" 字段时, 每条命令执行完成后向 devices/{设备 ID}/commands/response 回复:
+ *         {"$id":"请求 id","command":"命令名","code":处理函数的返回值}
+ * @param workers 工作线程数, 不能超过 TICOS_COMMAND_WORKERS_MAX
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_command_pool_start(int workers);
+
+/**
+ * @brief  停止命令线程池
+ * @note   执行完任务队列中已有的命令后才返回
+ * @return void
+ */
+void ticos_command_pool_stop(void);
+
+/**
+ * @brief  设置命令的最大并发数和超时时长
+ * @note   超出并发数的命令不执行, 直接回复 TICOS_COMMAND_BUSY; 超过时限仍未开始执行的命令不再执行,
+ *         执行完成时已超时的命令回复 TICOS_COMMAND_TIMEOUT。需要在收到命令之前设置
+ * @param index 命令在 ticos_command_t 中的下标
+ * @param max_concurrent 最大并发数, 0 表示不限制
+ * @param timeout_ms 从收到命令起的时限(毫秒), 0 表示不限时
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_command_set_limit(int index, int max_concurrent, int timeout_ms);
+
+/**
+ * @brief  重发离线期间缓存的消息
+ * @note   连接恢复时 SDK 会自动开始重发, 受重发速率限制未发完的消息需要用户周期性地调用此接口继续发送
+ * @return 本次发送的消息条数
+ */
+int ticos_offline_poll(void);
+
+/**
+ * @brief  获取离线队列中待重发的消息条数
+ * @return 待重发的消息条数
+ */
+int ticos_offline_pending(void);
+
+/**
+ * @brief  设置离线消息的重发速率
+ * @param msgs_per_sec 每秒最多重发的消息条数, 0 表示不限制
+ * @return void
+ */
+void ticos_offline_set_rate(int msgs_per_sec);
+
+/**
+ * @brief  设置离线消息的持久化日志文件
+ * @note   需要开启 TICOS_OFFLINE_LOG. 设置后离线消息追加写入此文件而非内存队列, 设备重启后仍可继续重发;
+ *         消息在发送成功后才从日志中移除, 掉电时可能重复发送
+ * @param path 日志文件路径, 传入 NULL 时关闭日志
+ * @param max_size 日志文件的最大字节数, 超出时丢弃新的消息, 0 表示不限制
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_offline_set_log(const char *path, long max_size);
+
+/**
+ * @brief  设置属性和遥测上报使用的缓冲区
+ * @note   TICOS_JSON_STREAM 为 1 时上报数据直接编码到此缓冲区中, 不再申请堆内存; 遥测批量上报也使用此缓冲区打包样本。
+ *         缓冲区在 SDK 使用期间必须保持有效, 且不能被多个上报同时使用
+ * @param buf 用户提供的缓冲区, 为 NULL 时恢复使用 SDK 内置的 TICOS_REPORT_BUF_SIZE 大小的缓冲区
+ * @param size 缓冲区大小
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_set_report_buffer(char *buf, int size);
+
+/**
+ * 属性和遥测上报数据的编码格式
+ */
+typedef enum {
+    TICOS_PAYLOAD_JSON,     // JSON, 以字段名为键
+    TICOS_PAYLOAD_CBOR,     // CBOR, 以字段下标为键, 并携带物模型哈希值
+} ticos_payload_format_t;
+
+/**
+ * @brief  设置属性和遥测上报数据的编码格式
+ * @note   CBOR 格式需要 TICOS_CBOR 置为 1, 且云端产品已开启 CBOR 编码; 数据直接编码到上报缓冲区中。
+ *         遥测批量上报仍使用 JSON。下发数据的格式由 SDK 根据数据内容自动识别, 与此设置无关
+ * @param format 编码格式
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_set_payload_format(ticos_payload_format_t format);
+
+/**
+ * SDK 申请堆内存使用的分配器
+ */
+typedef struct {
+    void *(*malloc_fn)(size_t size);
+    void (*free_fn)(void *ptr);
+} ticos_allocator_t;
+
+/**
+ * @brief  设置 SDK 使用的内存分配器
+ * @note   设置后 SDK 通过 cJSON_InitHooks() 接管 cJSON 的内存分配, 应用自身对 cJSON 的调用也会使用此分配器;
+ *         需要在 ticos_cloud_start() 之前调用
+ * @param alloc 分配器, 为 NULL 时恢复使用 malloc/free
+ * @return 0 代表成功，其他值代表错误; 开启 TICOS_STATIC_MEMORY 时不使用堆内存, 总是返回 -1
+ */
+int ticos_set_allocator(const ticos_allocator_t *alloc);
+
+/**
+ * @brief  设置单次操作使用的内存池
+ * @note   每次上报或处理下发数据期间的临时内存从内存池中顺序分配, 操作结束后整体释放;
+ *         内存池不足时改用 ticos_set_allocator() 设置的分配器, 开启 TICOS_STATIC_MEMORY 时分配失败。
+ *         同一时刻只有一个线程的操作使用内存池, 内存池被占用时其他线程的操作改用分配器; 有操作进行时设置失败
+ * @param buf 内存池, 为 NULL 时关闭内存池; 起始地址未按 8 字节对齐时跳过开头的几个字节
+ * @param size 内存池大小
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_set_arena(void *buf, size_t size);
+
+/**
+ * 内存池的使用统计
+ */
+typedef struct {
+    size_t size;            // 内存池大小
+    size_t peak;            // 单次操作的最大用量
+    unsigned int ops;       // 使用了内存池的操作数
+    unsigned int allocs;    // 从内存池分配的次数
+    unsigned int fallbacks; // 内存池不足或被其他线程占用, 改用分配器的次数
+} ticos_arena_stats_t;
+
+/**
+ * @brief  获取内存池的使用统计, 可据此确定设备需要预留的内存大小
+ * @param stats 输出的统计数据
+ * @param reset 为 1 时读取后清零统计数据
+ * @return void
+ */
+void ticos_get_arena_stats(ticos_arena_stats_t *stats, int reset);
+
+/**
+ * 运行统计中按 topic 区分的消息类别
+ */
+typedef enum {
+    TICOS_METRIC_PROPERTY,      // 属性上报
+    TICOS_METRIC_TELEMETRY,     // 遥测上报, 含批量上报和运行统计的自动上报
+    TICOS_METRIC_RESPONSE,      // 命令执行结果的回复
+    TICOS_METRIC_DESIRED,       // 下发的期望属性
+    TICOS_METRIC_COMMAND,       // 下发的命令
+    TICOS_METRIC_TOPIC_MAX,
+} ticos_metric_topic_t;
+
+/**
+ * 运行统计中记录耗时的环节
+ */
+typedef enum {
+    TICOS_METRIC_SERIALIZE,     // 上报数据的编码, 含 getter 函数的执行
+    TICOS_METRIC_PARSE,         // 下发数据的解析和分发, 含 recv 函数和直接执行的命令处理函数
+    TICOS_METRIC_PUBLISH,       // 发布一条消息, 即 ticos_hal_mqtt_publish() 或存入离线队列
+    TICOS_METRIC_STAGE_MAX,
+} ticos_metric_stage_t;
+
+/** 耗时直方图的桶数: 第 i 个桶记录 [2^i, 2^(i+1)) 微秒的样本, 第 0 个桶含 0, 最后一个桶含所有更长的样本 */
+#define TICOS_METRIC_BUCKETS 16
+
+/**
+ * 一类消息的收发统计
+ */
+typedef struct {
+    unsigned int msgs;          // 消息条数
+    unsigned int bytes;         // 字节数
+    unsigned int errors;        // 上报为发布失败的条数, 下发为格式错误、物模型哈希值不符或版本过期而整条丢弃的条数
+} ticos_metric_traffic_t;
+
+/**
+ * 一个环节的耗时统计, 单位为微秒
+ */
+typedef struct {
+    unsigned int count;
+    unsigned int total_us;      // 总耗时, 超出 32 位时回绕, 可定期读取并清零
+    unsigned int max_us;
+    unsigned int buckets[TICOS_METRIC_BUCKETS];
+} ticos_metric_hist_t;
+
+/**
+ * SDK 的运行统计
+ */
+typedef struct {
+    ticos_metric_traffic_t traffic[TICOS_METRIC_TOPIC_MAX];     // 按 ticos_metric_topic_t 区分
+    ticos_metric_hist_t latency[TICOS_METRIC_STAGE_MAX];        // 按 ticos_metric_stage_t 区分
+    unsigned int send_queue;            // 发送队列中的请求数
+    unsigned int send_queue_peak;       // 发送队列中请求数的最大值
+    unsigned int send_full;             // 发送队列已满而被拒绝的异步上报请求数
+    unsigned int command_queue;         // 命令任务队列中的命令数
+    unsigned int command_queue_peak;    // 命令任务队列中命令数的最大值
+    unsigned int command_rejected;      // 因并发数超限、任务队列已满或参数过长而被拒绝的命令数
+    unsigned int offline_pending;       // 离线队列中待重发的消息数
+    unsigned int rejected_keys;         // 下发数据中未定义或类型不符而被忽略的字段数
+    unsigned int heap_blocks;           // 内存池不足时从分配器申请、尚未释放的内存块数
+    unsigned int heap_blocks_peak;      // 上述内存块数的最大值
+    size_t arena_peak;                  // 内存池单次操作的最大用量, 见 ticos_get_arena_stats()
+} ticos_metrics_t;
+
+/**
+ * @brief  获取 SDK 的运行统计
+ * @note   需要开启 TICOS_METRICS. 统计在各热点路径上以原子加法累计, 不加锁也不申请内存;
+ *         读取时逐项取值, 与其他线程并发时各项之间不保证是同一时刻的值
+ * @param metrics 输出的统计数据
+ * @param reset 为 1 时读取后清零计数、耗时和最大值, 当前的队列深度和内存块数不受影响
+ * @return 0 代表成功, 未开启 TICOS_METRICS 时返回 -1
+ */
+int ticos_get_metrics(ticos_metrics_t *metrics, int reset);
+
+/**
+ * @brief  设置运行统计的自动上报周期
+ * @note   需要开启 TICOS_METRICS. 开启后按周期以 {"$metrics":{...}} 的格式在默认设备(未启动时为任一已启动的设备)的遥测 topic
+ *         上报累计的统计, 上报不清零统计; 由 ticos_report_poll() 或发送线程发出
+ * @param interval_ms 上报周期(毫秒), 0 表示不自动上报
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_metrics_set_report(int interval_ms);
+
 /**
  * @brief  订阅ticos cloud需要处理的topic
  * @note   此接口需要在mqtt客户端连接上的时候调用，监听云端下发的消息
@@ -72,13 +440,39 @@ int ticos_mqtt_subscribe(void);
 /**
  * @brief  云端下发数据数据解析
  * @note   此接口处理云端下发的数据，然后根据topic解析接收到的命令或属性
- * @param topic 接收到的topic
+ * @param topic 接收到的topic, 须以 '\0' 结尾
  * @param dat 接收到的数据指针
  * @param len 接收到的数据长度
  * @return void
  */
 void ticos_msg_recv(const char *topic, const char *dat, int len);
 
+/**
+ * @brief  云端下发数据数据解析, topic 由长度指定
+ * @note   适用于 topic 不以 '\0' 结尾的 mqtt client(如 ESP-IDF 的 esp_mqtt_event_t::topic)
+ * @param topic 接收到的topic
+ * @param topic_len topic 的长度
+ * @param dat 接收到的数据指针
+ * @param len 接收到的数据长度
+ * @return void
+ */
+void ticos_msg_recv_topic(const char *topic, int topic_len, const char *dat, int len);
+
+/**
+ * @brief  云端下发数据分片解析
+ * @note   适用于按分片给出大消息的 mqtt client(如 ESP-IDF 的 MQTT_EVENT_DATA), 分片须按顺序给出;
+ *         JSON 消息逐个分片增量解析, 不需要缓存整条消息, 最后一个分片到达且整条消息格式正确时才分发;
+ *         CBOR 消息拼接后处理, 长度不能超过 TICOS_RECV_FRAGMENT_SIZE; 完整到达的消息与 ticos_msg_recv_topic() 相同
+ * @param topic 接收到的topic, 只在第一个分片(offset 为 0)时使用
+ * @param topic_len topic 的长度
+ * @param dat 分片数据指针
+ * @param len 分片数据长度
+ * @param offset 分片在消息中的位置
+ * @param total 消息的总长度
+ * @return void
+ */
+void ticos_msg_recv_fragment(const char *topic, int topic_len, const char *dat, int len, int offset, int total);
+
 typedef enum {
     TICOS_EVENT_CONNECT,
     TICOS_EVENT_DISCONNECT,
@@ -97,7 +491,7 @@ void set_ticos_event_cb(ticos_event_cb_t evt_cb, void *user_data);
 
 /**
  * @brief  云端事件通知函数
- * @note   当cloud产生相关的事件时, 会调用此函数
+ * @note   当cloud产生相关的事件时, 会调用此函数; TICOS_EVENT_CONNECT 之后由 ticos_report_poll() 全量上报一次属性
  * @param evt 相关事件
  * @return void
  */
@@ -0,0 +1,348 @@
+#include "ticos_cbor.h"
+#include <math.h>
+#include <string.h>
+
+#define TICOS_CBOR_MAX_DEPTH 32
+
+// 主类型
+#define CBOR_UINT       0
+#define CBOR_NEGINT     1
+#define CBOR_BYTES      2
+#define CBOR_TEXT       3
+#define CBOR_ARRAY      4
+#define CBOR_MAP        5
+#define CBOR_TAG        6
+#define CBOR_SIMPLE     7
+
+#define CBOR_FALSE      0xf4
+#define CBOR_TRUE       0xf5
+#define CBOR_NULL_BYTE  0xf6
+#define CBOR_FLOAT32    0xfa
+#define CBOR_BREAK      0xff
+#define CBOR_INDEF      31
+
+static void ticos_cbor_put(ticos_cbor_writer_t *w, const void *dat, int n)
+{
+    if (w->overflow)
+        return;
+    if (w->len + n > w->size) {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->buf + w->len, dat, n);
+    w->len += n;
+}
+
+static void ticos_cbor_head(ticos_cbor_writer_t *w, int major, uint64_t val)
+{
+    unsigned char head[9];
+    int n;
+
+    head[0] = major << 5;
+    if (val < 24) {
+        head[0] |= val;
+        n = 1;
+    } else if (val <= 0xff) {
+        head[0] |= 24;
+        n = 2;
+    } else if (val <= 0xffff) {
+        head[0] |= 25;
+        n = 3;
+    } else if (val <= 0xffffffff) {
+        head[0] |= 26;
+        n = 5;
+    } else {
+        head[0] |= 27;
+        n = 9;
+    }
+    // 参数按大端序写在首字节之后
+    for (int i = n - 1; i > 0; i--, val >>= 8)
+        head[i] = val & 0xff;
+    ticos_cbor_put(w, head, n);
+}
+
+void ticos_cbor_writer_init(ticos_cbor_writer_t *w, void *buf, int size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = 0;
+}
+
+int ticos_cbor_writer_finish(ticos_cbor_writer_t *w)
+{
+    return w->overflow ? -1 : w->len;
+}
+
+void ticos_cbor_self_describe(ticos_cbor_writer_t *w)
+{
+    ticos_cbor_head(w, CBOR_TAG, 55799);
+}
+
+void ticos_cbor_map_begin(ticos_cbor_writer_t *w)
+{
+    unsigned char b = CBOR_MAP << 5 | CBOR_INDEF;
+    ticos_cbor_put(w, &b, 1);
+}
+
+void ticos_cbor_map_end(ticos_cbor_writer_t *w)
+{
+    unsigned char b = CBOR_BREAK;
+    ticos_cbor_put(w, &b, 1);
+}
+
+void ticos_cbor_int(ticos_cbor_writer_t *w, int64_t val)
+{
+    if (val >= 0)
+        ticos_cbor_head(w, CBOR_UINT, val);
+    else
+        ticos_cbor_head(w, CBOR_NEGINT, -1 - val);
+}
+
+void ticos_cbor_bool(ticos_cbor_writer_t *w, int val)
+{
+    unsigned char b = val ? CBOR_TRUE : CBOR_FALSE;
+    ticos_cbor_put(w, &b, 1);
+}
+
+void ticos_cbor_float(ticos_cbor_writer_t *w, float val)
+{
+    unsigned char b[5];
+    uint32_t bits;
+
+    memcpy(&bits, &val, sizeof(bits));
+    b[0] = CBOR_FLOAT32;
+    b[1] = bits >> 24;
+    b[2] = bits >> 16;
+    b[3] = bits >> 8;
+    b[4] = bits;
+    ticos_cbor_put(w, b, sizeof(b));
+}
+
+void ticos_cbor_string(ticos_cbor_writer_t *w, const char *val)
+{
+    int len = strlen(val);
+    ticos_cbor_head(w, CBOR_TEXT, len);
+    ticos_cbor_put(w, val, len);
+}
+
+void ticos_cbor_string_head(ticos_cbor_writer_t *w, uint64_t len, int binary)
+{
+    ticos_cbor_head(w, binary ? CBOR_BYTES : CBOR_TEXT, len);
+}
+
+void ticos_cbor_null(ticos_cbor_writer_t *w)
+{
+    unsigned char b = CBOR_NULL_BYTE;
+    ticos_cbor_put(w, &b, 1);
+}
+
+/*
+ * 读取数据项的首部, 返回主类型, 参数写入 val; 不定长数据项的 val 为 -1
+ */
+static int ticos_cbor_read_head(ticos_cbor_reader_t *r, uint64_t *val, int *info)
+{
+    if (r->pos >= r->len)
+        return -1;
+    int major = r->buf[r->pos] >> 5;
+    int n;
+
+    *info = r->buf[r->pos++] & 0x1f;
+    if (*info < 24) {
+        *val = *info;
+        return major;
+    }
+    if (*info == CBOR_INDEF) {
+        // 只有字符串、数组、map 和 break 可以不定长
+        if (major == CBOR_UINT || major == CBOR_NEGINT || major == CBOR_TAG)
+            return -1;
+        *val = (uint64_t)-1;
+        return major;
+    }
+    if (*info > 27)
+        return -1;
+    n = 1 << (*info - 24);
+    if (r->len - r->pos < n)
+        return -1;
+    *val = 0;
+    for (int i = 0; i < n; i++)
+        *val = *val << 8 | r->buf[r->pos++];
+    return major;
+}
+
+static double ticos_cbor_half(uint16_t h)
+{
+    int exp = (h >> 10) & 0x1f;
+    int mant = h & 0x3ff;
+    double val;
+
+    if (exp == 0)
+        val = mant / 16777216.0;        // mant * 2^-24
+    else if (exp != 31)
+        val = (mant + 1024) / 1024.0 * (exp > 15 ? (double)(1 << (exp - 15)) : 1.0 / (1 << (15 - exp)));
+    else
+        val = mant ? NAN : INFINITY;
+    return (h & 0x8000) ? -val : val;
+}
+
+static int ticos_cbor_read_item(ticos_cbor_reader_t *r, ticos_cbor_item_t *item, int depth);
+
+// 跳过 cnt 个数据项, cnt 为 -1 时跳过到 break 为止; map 中的 break 只能出现在键值对之后
+static int ticos_cbor_skip_items(ticos_cbor_reader_t *r, uint64_t cnt, int depth, int pairs)
+{
+    ticos_cbor_item_t item;
+
+    for (uint64_t i = 0; cnt == (uint64_t)-1 || i < cnt; i++) {
+        if (cnt == (uint64_t)-1 && r->pos < r->len && r->buf[r->pos] == CBOR_BREAK) {
+            r->pos++;
+            return pairs && (i & 1) ? -1 : 0;
+        }
+        if (ticos_cbor_read_item(r, &item, depth))
+            return -1;
+    }
+    return 0;
+}
+
+// 跳过不定长字符串的各个分段
+static int ticos_cbor_skip_chunks(ticos_cbor_reader_t *r, int major)
+{
+    uint64_t len;
+    int info;
+
+    for (;;) {
+        if (r->pos < r->len && r->buf[r->pos] == CBOR_BREAK) {
+            r->pos++;
+            return 0;
+        }
+        if (ticos_cbor_read_head(r, &len, &info) != major || info == CBOR_INDEF ||
+            len > (uint64_t)(r->len - r->pos))
+            return -1;
+        r->pos += len;
+    }
+}
+
+static int ticos_cbor_read_item(ticos_cbor_reader_t *r, ticos_cbor_item_t *item, int depth)
+{
+    uint64_t val;
+    int info;
+
+    if (depth > TICOS_CBOR_MAX_DEPTH)
+        return -1;
+    int major = ticos_cbor_read_head(r, &val, &info);
+    item->type = TICOS_CBOR_OTHER;
+    switch (major) {
+    // 超出 int64 范围的整数取最接近的值
+    case CBOR_UINT:
+        item->type = TICOS_CBOR_INT;
+        item->i = val > INT64_MAX ? INT64_MAX : (int64_t)val;
+        return 0;
+    case CBOR_NEGINT:
+        item->type = TICOS_CBOR_INT;
+        item->i = val > INT64_MAX ? INT64_MIN : -1 - (int64_t)val;
+        return 0;
+    case CBOR_BYTES:
+    case CBOR_TEXT:
+        if (info == CBOR_INDEF)
+            return ticos_cbor_skip_chunks(r, major);
+        if (val > (uint64_t)(r->len - r->pos))
+            return -1;
+        if (major == CBOR_TEXT) {
+            item->type = TICOS_CBOR_STRING;
+            item->start = r->pos;
+            item->len = (int)val;
+        }
+        r->pos += val;
+        return 0;
+    case CBOR_ARRAY:
+    case CBOR_MAP:
+        // 每个数据项至少占 1 字节, 成员数超出剩余长度的容器必然不完整
+        if (info != CBOR_INDEF && val > (uint64_t)(r->len - r->pos))
+            return -1;
+        if (major == CBOR_ARRAY)
+            return ticos_cbor_skip_items(r, val, depth + 1, 0);
+        return ticos_cbor_skip_items(r, val == (uint64_t)-1 ? val : val * 2, depth + 1, 1);
+    case CBOR_TAG:
+        // 标签只修饰其后的数据项, 按数据项本身处理
+        return ticos_cbor_read_item(r, item, depth + 1);
+    case CBOR_SIMPLE:
+        if (info == 20 || info == 21) {
+            item->type = TICOS_CBOR_BOOL;
+            item->i = info == 21;
+        } else if (info == 22) {
+            item->type = TICOS_CBOR_NULL;
+        } else if (info == 25) {
+            item->type = TICOS_CBOR_FLOAT;
+            item->f = ticos_cbor_half(val);
+        } else if (info == 26) {
+            uint32_t bits = val;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            item->type = TICOS_CBOR_FLOAT;
+            item->f = f;
+        } else if (info == 27) {
+            memcpy(&item->f, &val, sizeof(item->f));
+            item->type = TICOS_CBOR_FLOAT;
+        } else if (info == CBOR_INDEF) {
+            // 多余的 break
+            return -1;
+        }
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+int ticos_cbor_detect(const void *dat, int len)
+{
+    const unsigned char *p = dat;
+    // self-describe 标签 0xd9d9f7 或 map 首字节
+    return len > 0 && ((p[0] == 0xd9 && len >= 3 && p[1] == 0xd9 && p[2] == 0xf7) || (p[0] >> 5) == CBOR_MAP);
+}
+
+int ticos_cbor_map_enter(ticos_cbor_reader_t *r, const void *dat, int len)
+{
+    uint64_t val;
+    int info;
+    int major;
+
+    r->buf = dat;
+    r->len = len;
+    r->pos = 0;
+    while ((major = ticos_cbor_read_head(r, &val, &info)) == CBOR_TAG)
+        ;
+    if (major != CBOR_MAP)
+        return -1;
+    if (val != (uint64_t)-1 && val > (uint64_t)len)
+        return -1;
+    r->remaining = val == (uint64_t)-1 ? -1 : (int)val;
+    return 0;
+}
+
+int ticos_cbor_map_next(ticos_cbor_reader_t *r, ticos_cbor_item_t *key, ticos_cbor_item_t *val)
+{
+    if (r->remaining == 0)
+        return 0;
+    if (r->remaining < 0 && r->pos < r->len && r->buf[r->pos] == CBOR_BREAK) {
+        r->pos++;
+        r->remaining = 0;
+        return 0;
+    }
+    if (ticos_cbor_read_item(r, key, 1) || ticos_cbor_read_item(r, val, 1))
+        return -1;
+    if (r->remaining > 0)
+        r->remaining--;
+    return 1;
+}
+
+int ticos_cbor_check_map(const void *dat, int len)
+{
+    ticos_cbor_reader_t r;
+    ticos_cbor_item_t key, val;
+    int ret;
+
+    if (ticos_cbor_map_enter(&r, dat, len))
+        return -1;
+    while ((ret = ticos_cbor_map_next(&r, &key, &val)) > 0)
+        ;
+    return ret < 0 || r.pos != len ? -1 : 0;
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_cbor.h
+ * @brief CBOR (RFC 8949) 编解码器
+ *
+ * 只实现物模型数据用到的子集: 整数、浮点数、布尔值、null、文本字符串和 map,
+ * 编码直接写入调用者提供的缓冲区, 解码直接在接收缓冲区上进行, 均不申请堆内存。
+ *
+ * 物模型数据编码为一个 map, 以字段在方法表中的下标(即生成的 TICOS_PROPERTY_* 等枚举值)作为键,
+ * 键 -1 为物模型哈希值, 供云端确认双方使用相同版本的物模型。数据前带有 self-describe 标签 55799,
+ * 可据此与 JSON 数据区分。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** 物模型哈希值在 map 中的键 */
+#define TICOS_CBOR_KEY_HASH (-1)
+
+typedef struct {
+    unsigned char *buf;
+    int size;
+    int len;
+    int overflow;
+} ticos_cbor_writer_t;
+
+void ticos_cbor_writer_init(ticos_cbor_writer_t *w, void *buf, int size);
+
+/**
+ * @brief  结束编码
+ * @return 输出数据的长度, 缓冲区不足时返回 -1
+ */
+int ticos_cbor_writer_finish(ticos_cbor_writer_t *w);
+
+/** 写入 self-describe 标签, 标识后续数据为 CBOR */
+void ticos_cbor_self_describe(ticos_cbor_writer_t *w);
+/** 开始一个不定长 map, 以 ticos_cbor_map_end() 结束 */
+void ticos_cbor_map_begin(ticos_cbor_writer_t *w);
+void ticos_cbor_map_end(ticos_cbor_writer_t *w);
+void ticos_cbor_int(ticos_cbor_writer_t *w, int64_t val);
+void ticos_cbor_bool(ticos_cbor_writer_t *w, int val);
+void ticos_cbor_float(ticos_cbor_writer_t *w, float val);
+void ticos_cbor_string(ticos_cbor_writer_t *w, const char *val);
+/** 写入长度为 len 的文本串(binary 为 0)或字节串的首部, 内容由调用者随后输出 */
+void ticos_cbor_string_head(ticos_cbor_writer_t *w, uint64_t len, int binary);
+void ticos_cbor_null(ticos_cbor_writer_t *w);
+
+typedef enum {
+    TICOS_CBOR_NONE,
+    TICOS_CBOR_INT,
+    TICOS_CBOR_FLOAT,
+    TICOS_CBOR_BOOL,
+    TICOS_CBOR_NULL,
+    TICOS_CBOR_STRING,
+    TICOS_CBOR_OTHER,   // 数组、map、字节串等, 解码时整体跳过
+} ticos_cbor_type_t;
+
+typedef struct {
+    ticos_cbor_type_t type;
+    int64_t i;          // INT, BOOL
+    double f;           // FLOAT
+    int start;          // STRING 在原数据中的位置
+    int len;            // STRING 的长度
+} ticos_cbor_item_t;
+
+typedef struct {
+    const unsigned char *buf;
+    int len;
+    int pos;
+    int remaining;      // 定长 map 剩余的成员数, 不定长 map 为 -1
+} ticos_cbor_reader_t;
+
+/**
+ * @brief  判断数据是否为 CBOR 编码
+ * @return 1 代表是, 0 代表不是
+ */
+int ticos_cbor_detect(const void *dat, int len);
+
+/**
+ * @brief  进入顶层 map, 跳过其前面的标签
+ * @return 0 代表成功, 数据不是 map 时返回 -1
+ */
+int ticos_cbor_map_enter(ticos_cbor_reader_t *r, const void *dat, int len);
+
+/**
+ * @brief  读取 map 的下一个成员
+ * @return 1 代表读到一个成员, 0 代表 map 已结束, -1 代表数据格式错误
+ */
+int ticos_cbor_map_next(ticos_cbor_reader_t *r, ticos_cbor_item_t *key, ticos_cbor_item_t *val);
+
+/**
+ * @brief  检查数据是否为格式正确的 CBOR map
+ * @return 0 代表格式正确, 其他值代表错误
+ */
+int ticos_cbor_check_map(const void *dat, int len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_client.h
+ * @brief 多设备上下文接口
+ *
+ * 网关等需要在一个进程中代理多个设备的场景下, 每个设备使用一个 ticos_client_t 上下文,
+ * 其中保存该设备的身份信息、topic、物模型、回调、属性上报缓存、上报过滤状态和期望属性缓存。上下文由调用者分配,
+ * 每个设备占用固定大小的内存, SDK 不为设备申请堆内存。
+ *
+ * 所有设备共用 HAL 提供的一条 MQTT 连接: 第一个启动的设备的身份信息用于建立连接,
+ * 连接成功后 SDK 为每个已启动的设备订阅其下发 topic(或只订阅一次通配符 topic, 见 ticos_client_set_wildcard()),
+ * 下发消息经 topic 路由表(ticos_route.h)分发给对应的设备。
+ * 物模型的 getter 和 recv 函数中可调用 ticos_client_current() 获取正在处理的设备。
+ *
+ * 不带上下文参数的接口(ticos_cloud_start() 等)操作默认设备, 默认设备使用全局的物模型方法表。
+ * 遥测批量上报只支持默认设备; 离线缓存按连接共享, 消息中带有各自的 topic。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_route.h"
+#include "ticos_thingmodel_type.h"
+#include "ticos_timer.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 属性上报缓存、上报过滤状态和期望属性缓存中的一个值。字符串只缓存其长度和 32 位哈希值:
+ * 长度相同且哈希值碰撞的两个不同字符串会被当作未改变(概率约为 2^-32), 必须送达的字符串属性可按下标直接上报
+ */
+typedef union {
+    int i;
+    float f;
+    struct {
+        uint32_t len;
+        uint32_t hash;
+    } s;
+} ticos_value_cache_t;
+
+/** 以位图记录待上报字段时位图的位数, 合并上报和周期上报共用同一种位图 */
+#define TICOS_FIELD_BITS (TICOS_COALESCE_FIELDS > TICOS_SCHEDULE_FIELDS ? TICOS_COALESCE_FIELDS : TICOS_SCHEDULE_FIELDS)
+
+#if TICOS_FILTER_FIELDS > 0
+/**
+ * 声明了上报过滤条件的字段最近一次上报的值和时间
+ */
+typedef struct {
+    ticos_value_cache_t value;
+    uint32_t time;              // 上报时 ticos_uptime_ms() 的低 32 位
+} ticos_filter_state_t;
+#endif
+
+#if TICOS_COALESCE_FIELDS > 0
+/**
+ * 一类上报的合并状态, 记录窗口期内或受限期间被推迟的上报请求
+ */
+typedef struct {
+    int64_t last;               // 上次发送的时间(ticos_uptime_ms), 从未发送时为 0
+    unsigned char pending;      // 有被推迟的请求
+    unsigned char all;          // 合并为全量上报
+    unsigned char changed;      // 合并为变化上报
+    unsigned char dirty[(TICOS_FIELD_BITS + 7) / 8];    // 单独上报的字段
+} ticos_coalesce_t;
+#endif
+
+/**
+ * 设备上下文, 成员由 SDK 维护, 用户不应直接修改
+ */
+typedef struct ticos_client_s {
+    const ticos_thingmodel_t *model;
+    char client_id[TICOS_DEVICE_ID_MAX];
+    char device_id[TICOS_DEVICE_ID_MAX];
+    char device_secret[TICOS_DEVICE_SECRET_MAX];
+    char command_request_topic[TICOS_TOPIC_MAX];
+    char command_response_topic[TICOS_TOPIC_MAX];
+    char property_desired_topic[TICOS_TOPIC_MAX];
+    char property_report_topic[TICOS_TOPIC_MAX];
+    char telemetry_topic[TICOS_TOPIC_MAX];
+    ticos_route_t command_route;
+    ticos_route_t desired_route;
+    ticos_event_cb_t evt_cb;
+    void *user_data;
+    ticos_payload_format_t payload_format;
+#if TICOS_PROPERTY_CACHE_SIZE > 0
+    ticos_value_cache_t property_cache[TICOS_PROPERTY_CACHE_SIZE];
+    unsigned char property_cached[(TICOS_PROPERTY_CACHE_SIZE + 7) / 8];
+#endif
+#if TICOS_DESIRED_CACHE_SIZE > 0
+    ticos_value_cache_t desired_cache[TICOS_DESIRED_CACHE_SIZE];   // 设备已应用或已上报的属性值
+    unsigned char desired_cached[(TICOS_DESIRED_CACHE_SIZE + 7) / 8];
+#endif
+    int64_t desired_version;        // 已处理的期望属性文档的 $version, 0 表示尚未收到
+    int resync;                     // 重新连接后尚未发出全量属性上报, 由 ticos_report_poll() 发出
+#if TICOS_FILTER_FIELDS > 0
+    ticos_filter_state_t filter[TICOS_TOPIC_CLASS_MAX][TICOS_FILTER_FIELDS];          // 按 ticos_topic_class_t 区分
+    unsigned char filtered[TICOS_TOPIC_CLASS_MAX][(TICOS_FILTER_FIELDS + 7) / 8];   // 已记录上报值的字段
+#endif
+#if TICOS_COALESCE_FIELDS > 0
+    ticos_coalesce_t coalesce[TICOS_TOPIC_CLASS_MAX];   // 按 ticos_topic_class_t 区分
+#endif
+#if TICOS_SCHEDULE_FIELDS > 0
+    ticos_timer_t schedule_timer[TICOS_SCHEDULE_FIELDS];        // 遥测的周期上报定时器
+    int schedule_period[TICOS_SCHEDULE_FIELDS];                 // 运行时设置的周期(毫秒), 0 表示使用物模型中的周期, 负数表示关闭
+    unsigned char schedule_due[(TICOS_FIELD_BITS + 7) / 8];     // 已到期待上报的字段
+    struct ticos_client_s *schedule_next;                       // 有字段到期的设备链表
+    int schedule_queued;
+#endif
+    struct ticos_client_s *next;    // 已启动设备的链表
+    int started;
+} ticos_client_t;
+
+/**
+ * @brief  初始化设备上下文
+ * @param client 设备上下文
+ * @param model 设备使用的物模型, 为 NULL 时使用全局的物模型方法表
+ * @param product_id 产品 ID
+ * @param device_id 设备 ID
+ * @param device_secret 设备密钥
+ * @return 0 代表成功, 身份信息或 topic 超出缓冲区大小时返回 -1
+ */
+int ticos_client_init(ticos_client_t *client, const ticos_thingmodel_t *model,
+                      const char *product_id, const char *device_id, const char *device_secret);
+
+/**
+ * @brief  启动设备
+ * @note   没有已启动的设备时, 以此设备的身份信息启动 MQTT 连接; 否则加入已有的连接,
+ *         已连接时立即订阅此设备的下发 topic
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_client_start(ticos_client_t *client);
+
+/**
+ * @brief  停止设备, 之后不再向此设备分发下发消息
+ * @note   最后一个设备停止时断开 MQTT 连接
+ * @return void
+ */
+void ticos_client_stop(ticos_client_t *client);
+
+/**
+ * @brief  设置设备的事件处理函数
+ * @return void
+ */
+void ticos_client_set_event_cb(ticos_client_t *client, ticos_event_cb_t evt_cb, void *user_data);
+
+/**
+ * @brief  获取设备的用户数据, 即 ticos_client_set_event_cb() 传入的 user_data
+ */
+void *ticos_client_user_data(const ticos_client_t *client);
+
+/**
+ * @brief  设置是否以通配符 topic 订阅所有设备的下发消息
+ * @note   开启后连接成功时只订阅 "devices/+/twin/desired" 和 "devices/+/commands/request" 两个 topic,
+ *         之后启动的设备无需再订阅, 适用于代理大量子设备且服务端允许通配符订阅的网关;
+ *         需要在 ticos_cloud_start() 或第一个 ticos_client_start() 之前调用
+ * @param enable 1 代表开启, 0 代表按设备分别订阅(默认)
+ * @return void
+ */
+void ticos_client_set_wildcard(int enable);
+
+/**
+ * @brief  获取正在处理上报或下发的设备
+ * @note   在物模型的 getter 和 recv 函数中调用, 用于区分共用同一物模型的多个设备
+ * @return 设备上下文, 不在上报或下发过程中时返回默认设备
+ */
+ticos_client_t *ticos_client_current(void);
+
+/**
+ * @brief  获取默认设备, 即不带上下文参数的接口所操作的设备
+ */
+ticos_client_t *ticos_client_default(void);
+
+/*
+ * 以下接口与 ticos_api.h 中的同名接口(去掉 client_ 部分)一致, 只是操作指定的设备
+ */
+int ticos_client_property_report(ticos_client_t *client);
+int ticos_client_property_report_changed(ticos_client_t *client);
+int ticos_client_property_report_by_index(ticos_client_t *client, int index);
+int ticos_client_telemetry_report(ticos_client_t *client);
+int ticos_client_telemetry_report_by_index(ticos_client_t *client, int index);
+int ticos_client_set_payload_format(ticos_client_t *client, ticos_payload_format_t format);
+int ticos_client_telemetry_set_period(ticos_client_t *client, int index, int period_ms);
+
+/**
+ * @brief  设置物模型中命令的最大并发数和超时时长, 见 ticos_command_set_limit()
+ * @note   限制对共用此物模型的所有设备生效
+ * @param model 物模型, 为 NULL 时使用全局的物模型方法表
+ */
+int ticos_thingmodel_set_command_limit(const ticos_thingmodel_t *model, int index, int max_concurrent, int timeout_ms);
+
+/**
+ * 异步上报请求的类型
+ */
+typedef enum {
+    TICOS_REPORT_PROPERTY,          // ticos_client_property_report()
+    TICOS_REPORT_PROPERTY_CHANGED,  // ticos_client_property_report_changed()
+    TICOS_REPORT_PROPERTY_INDEX,    // ticos_client_property_report_by_index()
+    TICOS_REPORT_TELEMETRY,         // ticos_client_telemetry_report()
+    TICOS_REPORT_TELEMETRY_INDEX,   // ticos_client_telemetry_report_by_index()
+} ticos_report_t;
+
+/**
+ * @brief  将设备的上报请求放入发送队列, 由发送线程执行, 见 ticos_property_report_async()
+ * @note   请求处理前设备上下文须保持有效; 处理时设备已停止的请求会被丢弃
+ * @param client 设备上下文
+ * @param report 上报请求的类型
+ * @param index 上报单个字段时字段的下标, 其他类型忽略此参数
+ * @return 入队结果
+ */
+ticos_send_status_t ticos_client_report_async(ticos_client_t *client, ticos_report_t report, int index);
+
+#ifdef __cplusplus
+}
+#endif
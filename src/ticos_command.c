@@ -0,0 +1,310 @@
+#include "ticos_api.h"
+#include "ticos_command.h"
+#include "ticos_config.h"
+#include "ticos_json_writer.h"
+#include "ticos_metrics.h"
+#include "ticos_time.h"
+#include <stdint.h>
+#include <string.h>
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+#include "ticos_queue.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#if TICOS_COMMAND_QUEUE_SIZE & (TICOS_COMMAND_QUEUE_SIZE - 1)
+#error "TICOS_COMMAND_QUEUE_SIZE must be a power of 2"
+#endif
+
+/*
+ * 单独设置了并发数和超时的命令, 以方法表中的表项区分, 共用同一物模型的设备共享限制
+ */
+typedef struct {
+    const ticos_command_info_t *command;    // 为 NULL 时未使用
+    int max_concurrent;                     // 0 表示不限制
+    int timeout_ms;                         // 0 表示不限时
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+    atomic_int running;
+#else
+    int running;
+#endif
+} ticos_command_limit_t;
+
+static ticos_command_limit_t m_limits[TICOS_COMMAND_LIMITS];
+
+static ticos_command_limit_t *ticos_command_limit_find(const ticos_command_info_t *command)
+{
+    for (int i = 0; i < TICOS_COMMAND_LIMITS && m_limits[i].command; i++) {
+        if (m_limits[i].command == command)
+            return &m_limits[i];
+    }
+    return NULL;
+}
+
+int ticos_thingmodel_set_command_limit(const ticos_thingmodel_t *model, int index, int max_concurrent, int timeout_ms)
+{
+    if (!model)
+        model = ticos_client_default()->model;
+    if (index < 0 || index >= model->command_cnt || max_concurrent < 0 || timeout_ms < 0)
+        return -1;
+
+    const ticos_command_info_t *command = &model->command_tab[index];
+    ticos_command_limit_t *limit = ticos_command_limit_find(command);
+    for (int i = 0; !limit && i < TICOS_COMMAND_LIMITS; i++) {
+        if (!m_limits[i].command)
+            limit = &m_limits[i];
+    }
+    if (!limit)
+        return -1;
+    limit->max_concurrent = max_concurrent;
+    limit->timeout_ms = timeout_ms;
+    limit->command = command;
+    return 0;
+}
+
+int ticos_command_set_limit(int index, int max_concurrent, int timeout_ms)
+{
+    return ticos_thingmodel_set_command_limit(NULL, index, max_concurrent, timeout_ms);
+}
+
+// 占用一个并发名额, 已达上限时返回 -1
+static int ticos_command_limit_acquire(ticos_command_limit_t *limit)
+{
+    if (!limit || !limit->max_concurrent)
+        return 0;
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+    if (atomic_fetch_add(&limit->running, 1) < limit->max_concurrent)
+        return 0;
+    atomic_fetch_sub(&limit->running, 1);
+    return -1;
+#else
+    if (limit->running >= limit->max_concurrent)
+        return -1;
+    limit->running++;
+    return 0;
+#endif
+}
+
+static void ticos_command_limit_release(ticos_command_limit_t *limit)
+{
+    if (!limit || !limit->max_concurrent)
+        return;
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+    atomic_fetch_sub(&limit->running, 1);
+#else
+    limit->running--;
+#endif
+}
+
+/*
+ * 回复格式: {"$id":"请求 id","command":"命令名","code":处理函数的返回值}
+ * 回复在栈上编码, 发布时与其他线程的上报一样持有上报锁, 离线队列不会被同时修改;
+ * 处理函数中的同步上报由上报接口自行加锁
+ */
+static void ticos_command_respond(ticos_client_t *client, int index, const char *rid, int code)
+{
+    char buf[TICOS_COMMAND_ID_MAX + 128];
+    ticos_json_writer_t w;
+
+    if (!rid[0] || !client->started)
+        return;
+    ticos_json_writer_init(&w, buf, sizeof(buf));
+    ticos_json_object_begin(&w);
+    ticos_json_add_string(&w, TICOS_COMMAND_ID_KEY, rid);
+    ticos_json_add_string(&w, "command", client->model->command_tab[index].id);
+    ticos_json_add_int(&w, "code", code);
+    ticos_json_object_end(&w);
+    int len = ticos_json_writer_finish(&w);
+    if (len <= 0)
+        return;
+    ticos_report_lock();
+    ticos_metrics_publish(TICOS_METRIC_RESPONSE, client->command_response_topic, buf, len, 1, 0);
+    ticos_report_unlock();
+}
+
+// 处理函数无法被中断, 超过时限才完成的命令也按超时回复, 因为云端此时已不再等待结果
+static void ticos_command_run(ticos_client_t *client, int index, const ticos_value_t *val, const char *rid,
+                              int64_t deadline, ticos_command_limit_t *limit)
+{
+    int ret = TICOS_COMMAND_TIMEOUT;
+
+    if (!deadline || ticos_uptime_ms() <= deadline) {
+        ret = ticos_client_command_execute(client, index, val);
+        if (deadline && ticos_uptime_ms() > deadline)
+            ret = TICOS_COMMAND_TIMEOUT;
+    }
+    ticos_command_limit_release(limit);
+    ticos_command_respond(client, index, rid, ret);
+}
+
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+
+#if TICOS_COMMAND_WORKERS_MAX < 1
+#error "TICOS_COMMAND_WORKERS_MAX must be at least 1"
+#endif
+
+typedef struct {
+    ticos_client_t *client;
+    ticos_command_limit_t *limit;
+    int64_t deadline;
+    int index;
+    ticos_value_t val;                  // 字符串参数指向 str
+    char rid[TICOS_COMMAND_ID_MAX];
+    char str[TICOS_RECV_STRING_MAX];
+} ticos_command_job_t;
+
+static uint64_t ticos_command_buf[TICOS_QUEUE_BUF_SIZE(TICOS_COMMAND_QUEUE_SIZE, sizeof(ticos_command_job_t)) / 8];
+static ticos_queue_t m_queue;
+
+static pthread_t m_workers[TICOS_COMMAND_WORKERS_MAX];
+static int m_worker_cnt = 0;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;  // 只用于工作线程的休眠和唤醒
+static pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int m_running = 0;
+static atomic_int m_idle = 0;       // 即将休眠的工作线程数, 接收线程只在有空闲线程时才需要唤醒
+
+static void *ticos_command_worker(void *arg)
+{
+    ticos_command_job_t job;
+
+    for (;;) {
+        if (!ticos_queue_pop(&m_queue, &job)) {
+            if (job.val.type == TICOS_VAL_TYPE_STRING)
+                job.val.v.s = job.str;
+            ticos_command_run(job.client, job.index, &job.val, job.rid, job.deadline, job.limit);
+            continue;
+        }
+        // 停止时先执行完已入队的命令
+        if (!atomic_load(&m_running))
+            break;
+        pthread_mutex_lock(&m_lock);
+        atomic_fetch_add(&m_idle, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ticos_queue_empty(&m_queue) && atomic_load(&m_running))
+            pthread_cond_wait(&m_cond, &m_lock);
+        atomic_fetch_sub(&m_idle, 1);
+        pthread_mutex_unlock(&m_lock);
+    }
+    return NULL;
+}
+
+int ticos_command_pool_start(int workers)
+{
+    pthread_attr_t attr;
+    size_t stack = TICOS_COMMAND_STACK_SIZE;
+
+    if (workers < 1 || workers > TICOS_COMMAND_WORKERS_MAX)
+        return -1;
+    if (atomic_load(&m_running))
+        return 0;
+    ticos_queue_init(&m_queue, ticos_command_buf, TICOS_COMMAND_QUEUE_SIZE, sizeof(ticos_command_job_t));
+#ifdef PTHREAD_STACK_MIN
+    if (stack < PTHREAD_STACK_MIN)
+        stack = PTHREAD_STACK_MIN;
+#endif
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack);
+    atomic_store(&m_running, 1);
+    for (m_worker_cnt = 0; m_worker_cnt < workers; m_worker_cnt++) {
+        if (pthread_create(&m_workers[m_worker_cnt], &attr, ticos_command_worker, NULL))
+            break;
+    }
+    pthread_attr_destroy(&attr);
+    if (!m_worker_cnt) {
+        atomic_store(&m_running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void ticos_command_pool_stop(void)
+{
+    if (!atomic_load(&m_running))
+        return;
+    atomic_store(&m_running, 0);
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+    for (int i = 0; i < m_worker_cnt; i++)
+        pthread_join(m_workers[i], NULL);
+    m_worker_cnt = 0;
+}
+
+// 复制命令参数后入队, 队列满或字符串参数过长时返回非 0 的结果码
+static int ticos_command_enqueue(ticos_client_t *client, int index, const ticos_value_t *val, const char *rid,
+                                 int64_t deadline, ticos_command_limit_t *limit)
+{
+    ticos_command_job_t job;
+
+    job.client = client;
+    job.limit = limit;
+    job.deadline = deadline;
+    job.index = index;
+    job.val = *val;
+    if (val->type == TICOS_VAL_TYPE_STRING) {
+        size_t len = strlen(val->v.s);
+        if (len >= sizeof(job.str))
+            return TICOS_COMMAND_TOO_LARGE;
+        memcpy(job.str, val->v.s, len + 1);
+    }
+    strcpy(job.rid, rid);
+    if (ticos_queue_push(&m_queue, &job))
+        return TICOS_COMMAND_BUSY;
+    ticos_metrics_queue(TICOS_METRIC_COMMAND_QUEUE, ticos_queue_count(&m_queue));
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&m_idle)) {
+        pthread_mutex_lock(&m_lock);
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_lock);
+    }
+    return 0;
+}
+
+int ticos_command_pending(void)
+{
+    return atomic_load(&m_running) ? (int)ticos_queue_count(&m_queue) : 0;
+}
+
+#else
+
+int ticos_command_pool_start(int workers)
+{
+    return -1;
+}
+
+void ticos_command_pool_stop(void)
+{
+}
+
+int ticos_command_pending(void)
+{
+    return 0;
+}
+
+#endif
+
+void ticos_command_submit(ticos_client_t *client, int index, const ticos_value_t *val, const char *rid)
+{
+    ticos_command_limit_t *limit = ticos_command_limit_find(&client->model->command_tab[index]);
+    int timeout_ms = limit ? limit->timeout_ms : TICOS_COMMAND_TIMEOUT_MS;
+    int64_t deadline = timeout_ms > 0 ? ticos_uptime_ms() + timeout_ms : 0;
+
+    if (ticos_command_limit_acquire(limit)) {
+        ticos_metrics_count(TICOS_METRIC_COMMAND_REJECTED);
+        ticos_command_respond(client, index, rid, TICOS_COMMAND_BUSY);
+        return;
+    }
+#if TICOS_COMMAND_QUEUE_SIZE > 0
+    if (atomic_load(&m_running)) {
+        int ret = ticos_command_enqueue(client, index, val, rid, deadline, limit);
+        if (ret) {
+            ticos_metrics_count(TICOS_METRIC_COMMAND_REJECTED);
+            ticos_command_limit_release(limit);
+            ticos_command_respond(client, index, rid, ret);
+        }
+        return;
+    }
+#endif
+    ticos_command_run(client, index, val, rid, deadline, limit);
+}
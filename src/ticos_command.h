@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ticos_client.h"
+#include "ticos_thingmodel_op.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** 命令请求中携带请求 id 的字段名, 命令的执行结果以此 id 回复 */
+#define TICOS_COMMAND_ID_KEY        "$id"
+#define TICOS_COMMAND_ID_KEY_LEN    3
+
+/** 期望属性文档中携带版本号的字段名 */
+#define TICOS_DESIRED_VERSION_KEY       "$version"
+#define TICOS_DESIRED_VERSION_KEY_LEN   8
+
+/**
+ * @brief  处理设备的一条下发命令
+ * @note   命令线程池已启动时放入任务队列由工作线程执行, 否则在调用者的线程中直接执行;
+ *         请求带有 id 时, 执行结果发布到设备的 commands/response topic
+ * @param client 设备上下文
+ * @param index 命令在方法表中的下标
+ * @param val 命令参数, 字符串参数在入队时复制
+ * @param rid 请求 id, 为空字符串时不回复
+ * @return void
+ */
+void ticos_command_submit(ticos_client_t *client, int index, const ticos_value_t *val, const char *rid);
+
+/**
+ * @brief  获取命令任务队列中尚未执行的命令数
+ * @return 命令数, 命令线程池未启动时返回 0
+ */
+int ticos_command_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,335 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_config.h
+ * @brief Ticos SDK 编译配置项
+ *
+ * 以下配置项均可在编译选项或工程配置中预先定义，以覆盖此处的默认值。
+ */
+
+#pragma once
+
+/**
+ * @brief 全静态内存模式
+ * @note  置为 1 时上报和下发固定使用流式编码器和原地解析器, SDK 运行期间不再申请堆内存, 内存池不足时操作失败;
+ *        ticos_thingmodel_gen.py 生成的 ticos_thingmodel_config.h 在包含路径中时, 上报缓冲区和下发字符串的大小
+ *        默认取物模型的最坏情况, 编译时输出各静态缓冲区的大小。不能与 TICOS_OFFLINE_LOG 同时开启
+ */
+#ifndef TICOS_STATIC_MEMORY
+#define TICOS_STATIC_MEMORY 0
+#endif
+
+#if TICOS_STATIC_MEMORY
+#if defined(__has_include)
+#if __has_include("ticos_thingmodel_config.h")
+#include "ticos_thingmodel_config.h"
+#endif
+#endif
+#ifndef TICOS_JSON_STREAM
+#define TICOS_JSON_STREAM 1
+#endif
+#ifndef TICOS_JSON_TOKENIZER
+#define TICOS_JSON_TOKENIZER 1
+#endif
+#if defined(TICOS_THINGMODEL_REPORT_MAX) && !defined(TICOS_REPORT_BUF_SIZE)
+#define TICOS_REPORT_BUF_SIZE TICOS_THINGMODEL_REPORT_MAX
+#endif
+#if defined(TICOS_THINGMODEL_STRING_MAX) && !defined(TICOS_RECV_STRING_MAX)
+#define TICOS_RECV_STRING_MAX TICOS_THINGMODEL_STRING_MAX
+#endif
+#endif
+
+/**
+ * @brief 使用流式 JSON 编码器生成上报数据
+ * @note  置为 1 时，属性和遥测上报直接写入固定缓冲区，上报路径上不再申请堆内存；
+ *        置为 0 时沿用 cJSON 构建上报数据。两种方式生成的数据内容完全一致
+ */
+#ifndef TICOS_JSON_STREAM
+#define TICOS_JSON_STREAM 0
+#endif
+
+/**
+ * @brief SDK 内置上报缓冲区的大小(字节)
+ * @note  在 TICOS_JSON_STREAM 为 1 时用于编码上报数据，遥测批量上报也使用此缓冲区打包样本，
+ *        数据超出此长度时上报失败。也可通过 ticos_set_report_buffer() 改用用户提供的缓冲区
+ */
+#ifndef TICOS_REPORT_BUF_SIZE
+#define TICOS_REPORT_BUF_SIZE 1024
+#endif
+
+/**
+ * @brief 流式字段每次读取的字节数
+ * @note  TICOS_VAL_TYPE_STREAM 和 TICOS_VAL_TYPE_BLOB 类型的字段上报时, SDK 以此大小的栈上缓冲区分块读取字段内容,
+ *        编码后的数据经上报缓冲区分块发送, 字段内容的长度不受上报缓冲区大小的限制
+ */
+#ifndef TICOS_STREAM_CHUNK_SIZE
+#define TICOS_STREAM_CHUNK_SIZE 256
+#endif
+
+/**
+ * @brief 使用原地 JSON 解析器处理云端下发的命令和属性
+ * @note  置为 1 时，直接在接收缓冲区上解析数据，严格遵守数据长度且不申请堆内存；
+ *        置为 0 时沿用 cJSON 解析, 同样只解析数据长度内的字节
+ */
+#ifndef TICOS_JSON_TOKENIZER
+#define TICOS_JSON_TOKENIZER 0
+#endif
+
+/**
+ * @brief 云端下发的字符串值的最大长度(字节, 含结尾的 '\0')
+ * @note  在 TICOS_JSON_TOKENIZER 为 1 时和处理分片到达的消息时使用，超出此长度的字符串值会被丢弃
+ */
+#ifndef TICOS_RECV_STRING_MAX
+#define TICOS_RECV_STRING_MAX 256
+#endif
+
+/**
+ * @brief 分片到达的下发消息中暂存已解码字段的缓冲区大小(字节)
+ * @note  以 ticos_msg_recv_fragment() 分片送入的 JSON 消息由增量解析器逐个分片解析, 不拼接整条消息,
+ *        解码后的字段值暂存于此, 整条消息格式正确时再依次分发; 字段值超出此大小时整条消息被丢弃。
+ *        分片到达的 CBOR 消息拼接到此缓冲区中处理, 超出此大小时被丢弃。置为 0 时丢弃所有分片到达的消息
+ */
+#ifndef TICOS_RECV_FRAGMENT_SIZE
+#define TICOS_RECV_FRAGMENT_SIZE 1024
+#endif
+
+/**
+ * @brief 属性上报缓存可容纳的属性个数
+ * @note  SDK 为每个属性缓存最近一次成功上报的值，ticos_property_report_changed() 据此只上报值发生变化的属性。
+ *        下标超出此数量的属性每次都会上报；置为 0 时关闭缓存，ticos_property_report_changed() 等同于全量上报。
+ *        字符串属性只缓存长度和 32 位哈希值, 长度相同且哈希碰撞的新值(概率约为 2^-32)会被当作未改变
+ */
+#ifndef TICOS_PROPERTY_CACHE_SIZE
+#define TICOS_PROPERTY_CACHE_SIZE 32
+#endif
+
+/**
+ * @brief 期望属性缓存可容纳的属性个数
+ * @note  SDK 为每个属性缓存设备已应用(recv 函数返回 0)或已上报的值, 云端下发的期望属性与缓存值相同时不再调用 recv 函数。
+ *        下标超出此数量的属性每次都会调用; 置为 0 时关闭缓存, 只按 $version 丢弃过期的期望属性文档。
+ *        字符串属性与属性上报缓存一样只缓存长度和 32 位哈希值, 长度相同且哈希碰撞的新值(概率约为 2^-32)不会调用 recv 函数
+ */
+#ifndef TICOS_DESIRED_CACHE_SIZE
+#define TICOS_DESIRED_CACHE_SIZE 32
+#endif
+
+/**
+ * @brief 上报过滤状态可容纳的字段个数
+ * @note  物模型中声明了死区或上报间隔的字段, SDK 为每个设备记录其最近一次上报的值和时间, 遥测和属性分别计数,
+ *        下标超出此数量的字段不做过滤。置为 0 时忽略物模型中的过滤条件
+ */
+#ifndef TICOS_FILTER_FIELDS
+#define TICOS_FILTER_FIELDS 16
+#endif
+
+/**
+ * @brief 遥测批量上报的样本缓存大小(字节)
+ * @note  ticos_telemetry_sample() 采集的样本编码后存入此环形缓存，缓存满时丢弃最早的样本；默认 0 即关闭批量上报，
+ *        需要批量上报时设置缓存大小(如 2048)
+ */
+#ifndef TICOS_TELEMETRY_BATCH_SIZE
+#define TICOS_TELEMETRY_BATCH_SIZE 0
+#endif
+
+/** @brief 批量上报默认策略: 缓存的样本数达到此值时发送，0 表示不限制 */
+#ifndef TICOS_TELEMETRY_BATCH_MAX_SAMPLES
+#define TICOS_TELEMETRY_BATCH_MAX_SAMPLES 10
+#endif
+
+/** @brief 批量上报默认策略: 单条批量消息的最大字节数，0 表示只受上报缓冲区大小限制 */
+#ifndef TICOS_TELEMETRY_BATCH_MAX_BYTES
+#define TICOS_TELEMETRY_BATCH_MAX_BYTES 0
+#endif
+
+/** @brief 批量上报默认策略: 最早的样本缓存超过此时长(毫秒)时发送，0 表示不限制 */
+#ifndef TICOS_TELEMETRY_BATCH_MAX_AGE_MS
+#define TICOS_TELEMETRY_BATCH_MAX_AGE_MS 0
+#endif
+
+/**
+ * @brief 离线消息队列的大小(字节)
+ * @note  未连接或发送失败时，上报消息存入此环形缓存，连接恢复后按先后顺序重发，缓存满时丢弃最早的消息；
+ *        单条消息不能超过 TICOS_OFFLINE_MSG_MAX。置为 0 时关闭内存离线队列
+ */
+#ifndef TICOS_OFFLINE_QUEUE_SIZE
+#define TICOS_OFFLINE_QUEUE_SIZE 0
+#endif
+
+/**
+ * @brief 可缓存的单条离线消息的最大长度(字节)
+ * @note  重发时消息读入同样大小的专用缓冲区，不占用上报缓冲区；开启离线队列或文件日志时才分配
+ */
+#ifndef TICOS_OFFLINE_MSG_MAX
+#define TICOS_OFFLINE_MSG_MAX TICOS_REPORT_BUF_SIZE
+#endif
+
+/**
+ * @brief 支持将离线消息写入文件
+ * @note  置为 1 时可调用 ticos_offline_set_log() 指定日志文件，需要平台提供 stdio 文件接口
+ */
+#ifndef TICOS_OFFLINE_LOG
+#define TICOS_OFFLINE_LOG 0
+#endif
+
+/** @brief 离线消息默认的重发速率(条/秒)，0 表示不限制 */
+#ifndef TICOS_OFFLINE_REPLAY_RATE
+#define TICOS_OFFLINE_REPLAY_RATE 10
+#endif
+
+/**
+ * @brief SDK 内置内存池的大小(字节)
+ * @note  大于 0 时，每次上报或处理下发数据期间 cJSON 的临时内存从此内存池中顺序分配，操作结束后整体释放；
+ *        置为 0 时不使用内置内存池，也可调用 ticos_set_arena() 提供内存池。多个线程同时操作时只有一个操作使用内存池，其余改用分配器
+ */
+#ifndef TICOS_ARENA_SIZE
+#define TICOS_ARENA_SIZE 0
+#endif
+
+/**
+ * @brief 支持 CBOR 编码
+ * @note  置为 1 时可调用 ticos_set_payload_format() 将属性和遥测以 CBOR 编码上报，并自动识别云端下发的 CBOR 数据
+ */
+#ifndef TICOS_CBOR
+#define TICOS_CBOR 0
+#endif
+
+/**
+ * @brief 设备上下文中身份信息和 topic 缓冲区的大小(字节)
+ * @note  每个 ticos_client_t 上下文按这些大小占用固定的内存, 代理大量子设备的网关可按实际长度调小;
+ *        TICOS_DEVICE_ID_MAX 同时是 MQTT client id("设备 ID@@@产品 ID")的缓冲区大小
+ */
+#ifndef TICOS_DEVICE_ID_MAX
+#define TICOS_DEVICE_ID_MAX 128
+#endif
+
+#ifndef TICOS_DEVICE_SECRET_MAX
+#define TICOS_DEVICE_SECRET_MAX 64
+#endif
+
+#ifndef TICOS_TOPIC_MAX
+#define TICOS_TOPIC_MAX 128
+#endif
+
+/**
+ * @brief 下发 topic 路由表初始的哈希桶数量, 须为 2 的幂
+ * @note  每个已启动的设备占用两条路由, 路由多于桶数时从分配器申请加倍的桶数组, 使查找时间与设备数量无关;
+ *        开启 TICOS_STATIC_MEMORY 时桶数不再增长, 代理大量子设备的网关应将其调大到与路由数量相当
+ */
+#ifndef TICOS_ROUTE_BUCKETS
+#define TICOS_ROUTE_BUCKETS 16
+#endif
+
+/**
+ * @brief 多线程调用保护
+ * @note  置为 1 时上报缓冲区、属性上报缓存、期望属性缓存、过滤状态、批量采样缓存和离线队列由一把可重入的上报锁保护,
+ *        MQTT 接收线程、发送线程、命令工作线程和应用线程可以同时调用 SDK; 需要平台提供 pthread 和 C11 线程局部存储。
+ *        只在单个线程中调用 SDK 的平台可置为 0 去掉加锁的开销, 此时不能开启异步上报和命令线程池
+ */
+#ifndef TICOS_THREAD_SAFE
+#define TICOS_THREAD_SAFE 1
+#endif
+
+/**
+ * @brief 异步上报队列可容纳的请求数, 须为 2 的幂
+ * @note  大于 0 时可调用 ticos_sender_start() 启动发送线程, ticos_property_report_async() 等接口将上报请求放入无锁队列后立即返回,
+ *        由发送线程统一编码和发送; 需要平台提供 pthread 和 C11 原子操作。置为 0 时关闭异步上报
+ */
+#ifndef TICOS_SEND_QUEUE_SIZE
+#define TICOS_SEND_QUEUE_SIZE 0
+#endif
+
+/** @brief 发送线程的栈大小(字节), 物模型的 getter 函数在发送线程中执行 */
+#ifndef TICOS_SEND_STACK_SIZE
+#define TICOS_SEND_STACK_SIZE 8192
+#endif
+
+/**
+ * @brief 命令线程池的任务队列可容纳的命令数, 须为 2 的幂
+ * @note  大于 0 时可调用 ticos_command_pool_start() 启动工作线程, 云端下发的命令放入无锁队列后由工作线程执行,
+ *        耗时的命令不再阻塞 MQTT 接收线程; 需要平台提供 pthread 和 C11 原子操作。置为 0 时命令在 MQTT 接收线程中直接执行
+ */
+#ifndef TICOS_COMMAND_QUEUE_SIZE
+#define TICOS_COMMAND_QUEUE_SIZE 0
+#endif
+
+/** @brief 命令线程池的最大工作线程数 */
+#ifndef TICOS_COMMAND_WORKERS_MAX
+#define TICOS_COMMAND_WORKERS_MAX 4
+#endif
+
+/** @brief 工作线程的栈大小(字节) */
+#ifndef TICOS_COMMAND_STACK_SIZE
+#define TICOS_COMMAND_STACK_SIZE 8192
+#endif
+
+/** @brief 命令请求 id 的最大长度(字节, 含结尾的 '\0'), 超出时不回复执行结果 */
+#ifndef TICOS_COMMAND_ID_MAX
+#define TICOS_COMMAND_ID_MAX 64
+#endif
+
+/** @brief 命令默认的超时时长(毫秒), 0 表示不限时 */
+#ifndef TICOS_COMMAND_TIMEOUT_MS
+#define TICOS_COMMAND_TIMEOUT_MS 0
+#endif
+
+/** @brief 可通过 ticos_command_set_limit() 单独设置并发数和超时的命令数 */
+#ifndef TICOS_COMMAND_LIMITS
+#define TICOS_COMMAND_LIMITS 8
+#endif
+
+/**
+ * @brief 上报合并时以位图记录的字段数
+ * @note  设置了上报合并窗口或速率限制时, 被合并的单字段上报请求记录在每个设备的位图中, 下标超出此数量的字段
+ *        的请求合并为全量上报。置为 0 时关闭上报合并和速率限制
+ */
+#ifndef TICOS_COALESCE_FIELDS
+#define TICOS_COALESCE_FIELDS 32
+#endif
+
+/** @brief 默认的上报合并窗口(毫秒), 0 表示不合并 */
+#ifndef TICOS_REPORT_WINDOW_MS
+#define TICOS_REPORT_WINDOW_MS 0
+#endif
+
+/**
+ * @brief 可周期上报的遥测个数
+ * @note  物模型中声明了 period 或调用 ticos_telemetry_set_period() 设置了周期的遥测由时间轮定时采集, 同一 tick 到期的字段
+ *        合并为一条消息, 由 ticos_report_poll() 或发送线程发出; 每个设备为每个字段占用一个定时器。
+ *        下标超出此数量的遥测不能周期上报, 置为 0 时关闭周期上报
+ */
+#ifndef TICOS_SCHEDULE_FIELDS
+#define TICOS_SCHEDULE_FIELDS 16
+#endif
+
+/** @brief 周期上报时间轮的 tick(毫秒), 上报周期按 tick 向上取整 */
+#ifndef TICOS_TIMER_TICK_MS
+#define TICOS_TIMER_TICK_MS 10
+#endif
+
+/**
+ * @brief 是否开启运行统计
+ * @note  开启后在上报、下发、发送队列和命令队列等热点路径上以原子加法累计消息数、字节数、耗时直方图和队列深度,
+ *        由 ticos_get_metrics() 读取。置为 0 时统计接口为空函数
+ */
+#ifndef TICOS_METRICS
+#define TICOS_METRICS 1
+#endif
+
+/** @brief 运行统计默认的自动上报周期(毫秒), 0 表示不自动上报 */
+#ifndef TICOS_METRICS_REPORT_MS
+#define TICOS_METRICS_REPORT_MS 0
+#endif
+
+/**
+ * @brief 是否编译跟踪点
+ * @note  开启后上报、下发各环节的开始和结束以定长记录写入无锁环形缓冲区, 可用 ticos_trace_read() 读出,
+ *        Linux 平台可用 ticos_trace_dump() 导出为 Chrome/Perfetto 的 trace JSON。关闭时跟踪点不产生任何代码
+ */
+#ifndef TICOS_TRACE
+#define TICOS_TRACE 0
+#endif
+
+/** @brief 跟踪记录环形缓冲区可容纳的记录数, 须为 2 的幂, 写满后覆盖最早的记录 */
+#ifndef TICOS_TRACE_RECORDS
+#define TICOS_TRACE_RECORDS 1024
+#endif
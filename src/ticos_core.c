@@ -1,67 +1,314 @@
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_schedule.h"
+#include "ticos_trace.h"
+#include "ticos_thingmodel_op.h"
 
 int ticos_hal_mqtt_start(const char *url, int port, const char *client_id, const char *user_name, const char *passwd);
 void ticos_hal_mqtt_stop();
 int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain);
 int ticos_hal_mqtt_subscribe(const char *topic, int qos);
 
-static char ticos_client_id[128];
-static char ticos_device_id[128];
-static char ticos_device_secret[64];
-static char ticos_command_request_topic[128];
-static char ticos_property_desired_topic[128];
-char ticos_property_report_topic[128];
-char ticos_telemery_topic[128];
+// 全局物模型方法表由生成的物模型代码提供, 只使用自定义物模型的网关程序可以没有这些符号
+extern const ticos_telemetry_info_t ticos_telemetry_tab[] __attribute__((weak));
+extern const ticos_property_info_t ticos_property_tab[] __attribute__((weak));
+extern const ticos_command_info_t ticos_command_tab[] __attribute__((weak));
+extern const int ticos_telemetry_cnt __attribute__((weak));
+extern const int ticos_property_cnt __attribute__((weak));
+extern const int ticos_command_cnt __attribute__((weak));
+// 旧版本生成的物模型代码中没有哈希表, 此时退化为逐个比较字段名
+extern const ticos_thingmodel_index_t ticos_property_index __attribute__((weak));
+extern const ticos_thingmodel_index_t ticos_command_index __attribute__((weak));
+// 旧版本生成的物模型代码中没有物模型哈希值, 此时上报的哈希值为 0
+extern const uint32_t ticos_thingmodel_hash __attribute__((weak));
+// 以 --serializers 选项生成的物模型代码中才有专用编码函数
+extern void ticos_thingmodel_serialize_telemetry(ticos_json_writer_t *w) __attribute__((weak));
+extern void ticos_thingmodel_serialize_property(ticos_client_t *client, ticos_json_writer_t *w) __attribute__((weak));
+
+static ticos_thingmodel_t m_default_model;
+static ticos_client_t m_default_client;
+static ticos_client_t *m_clients = NULL;    // 已启动的设备, 与路由表一起由路由锁保护
+static int m_connected = 0;
+static int m_wildcard = 0;
+static ticos_route_t *m_fragment_route = NULL;  // 正在分片接收的消息的路由
+
+static const ticos_thingmodel_t *ticos_default_model(void)
+{
+    ticos_thingmodel_t *model = &m_default_model;
+
+    model->telemetry_tab = ticos_telemetry_tab;
+    model->telemetry_cnt = &ticos_telemetry_cnt ? ticos_telemetry_cnt : 0;
+    model->property_tab = ticos_property_tab;
+    model->property_cnt = &ticos_property_cnt ? ticos_property_cnt : 0;
+    model->command_tab = ticos_command_tab;
+    model->command_cnt = &ticos_command_cnt ? ticos_command_cnt : 0;
+    model->property_index = &ticos_property_index;
+    model->command_index = &ticos_command_index;
+    model->hash = &ticos_thingmodel_hash ? ticos_thingmodel_hash : 0;
+    model->serialize_telemetry = ticos_thingmodel_serialize_telemetry;
+    model->serialize_property = ticos_thingmodel_serialize_property;
+    return model;
+}
+
+ticos_client_t *ticos_client_default(void)
+{
+    if (!m_default_client.model)
+        m_default_client.model = ticos_default_model();
+    return &m_default_client;
+}
+
+// 格式化到固定大小的缓冲区, 超出时返回 -1
+static int ticos_format(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return n < 0 || (size_t)n >= size ? -1 : 0;
+}
+
+static int ticos_client_identity(ticos_client_t *client, const char *product_id, const char *device_id, const char *device_secret)
+{
+    int ret = 0;
+
+    ret |= ticos_format(client->client_id, sizeof(client->client_id), "%s@@@%s", device_id, product_id);
+    ret |= ticos_format(client->device_id, sizeof(client->device_id), "%s", device_id);
+    ret |= ticos_format(client->device_secret, sizeof(client->device_secret), "%s", device_secret);
+    ret |= ticos_format(client->command_request_topic, sizeof(client->command_request_topic), "devices/%s/commands/request", device_id);
+    ret |= ticos_format(client->command_response_topic, sizeof(client->command_response_topic), "devices/%s/commands/response", device_id);
+    ret |= ticos_format(client->property_desired_topic, sizeof(client->property_desired_topic), "devices/%s/twin/desired", device_id);
+    ret |= ticos_format(client->property_report_topic, sizeof(client->property_report_topic), "devices/%s/twin/reported", device_id);
+    ret |= ticos_format(client->telemetry_topic, sizeof(client->telemetry_topic), "devices/%s/telemetry", device_id);
+    return ret;
+}
+
+int ticos_client_init(ticos_client_t *client, const ticos_thingmodel_t *model,
+                      const char *product_id, const char *device_id, const char *device_secret)
+{
+    memset(client, 0, sizeof(*client));
+    client->model = model ? model : ticos_default_model();
+    return ticos_client_identity(client, product_id, device_id, device_secret);
+}
+
+static int ticos_client_subscribe(ticos_client_t *client)
+{
+    int ret = ticos_hal_mqtt_subscribe(client->property_desired_topic, 1);
+    if (!ret)
+        return ticos_hal_mqtt_subscribe(client->command_request_topic, 1);
+    return ret;
+}
+
+static void ticos_client_on_command(void *user, const char *topic, int topic_len, const char *dat, int len)
+{
+    ticos_client_command_receive(user, dat, len);
+}
+
+static void ticos_client_on_desired(void *user, const char *topic, int topic_len, const char *dat, int len)
+{
+    ticos_client_property_receive(user, dat, len);
+}
+
+static void ticos_client_on_command_fragment(void *user, const char *dat, int len, int offset, int total)
+{
+    ticos_client_receive_fragment(user, 1, dat, len, offset, total);
+}
+
+static void ticos_client_on_desired_fragment(void *user, const char *dat, int len, int offset, int total)
+{
+    ticos_client_receive_fragment(user, 0, dat, len, offset, total);
+}
+
+void ticos_client_set_wildcard(int enable)
+{
+    m_wildcard = enable;
+}
+
+ticos_client_t *ticos_client_list(void)
+{
+    return m_clients;
+}
+
+static void ticos_client_unlink(ticos_client_t *client)
+{
+    ticos_route_lock();
+    for (ticos_client_t **p = &m_clients; *p; p = &(*p)->next) {
+        if (*p == client) {
+            *p = client->next;
+            break;
+        }
+    }
+    if (m_fragment_route == &client->command_route || m_fragment_route == &client->desired_route)
+        m_fragment_route = NULL;
+    ticos_route_remove(&client->command_route);
+    ticos_route_remove(&client->desired_route);
+    ticos_schedule_stop(client);
+    client->next = NULL;
+    client->started = 0;
+    ticos_route_unlock();
+}
+
+int ticos_client_start(ticos_client_t *client)
+{
+    ticos_route_lock();
+    if (client->started) {
+        ticos_route_unlock();
+        return 0;
+    }
+
+    int first = !m_clients;
+    client->next = m_clients;
+    client->started = 1;
+    m_clients = client;
+    ticos_route_add(&client->command_route, client->command_request_topic, ticos_client_on_command, client);
+    ticos_route_add(&client->desired_route, client->property_desired_topic, ticos_client_on_desired, client);
+    client->command_route.fragment = ticos_client_on_command_fragment;
+    client->desired_route.fragment = ticos_client_on_desired_fragment;
+    ticos_schedule_start(client);
+    int subscribe = m_connected && !m_wildcard;
+    ticos_route_unlock();
+    // MQTT 线程连接成功后需获取路由锁通知设备, 启动连接时不能持有路由锁
+    if (first) {
+        int ret = ticos_hal_mqtt_start("mqtt://hub.ticos.cn", 1883, client->client_id, client->device_id, client->device_secret);
+        if (ret)
+            ticos_client_unlink(client);
+        return ret;
+    }
+    // 加入已建立的连接, 未连接时在连接成功后统一订阅
+    return subscribe ? ticos_client_subscribe(client) : 0;
+}
+
+void ticos_client_stop(ticos_client_t *client)
+{
+    ticos_route_lock();
+    int last = client->started && m_clients == client && !client->next;
+    ticos_route_unlock();
+    // 最后一个设备停止时断开连接, 先断开以便其收到断开事件; 断开时会等待 MQTT 线程退出, 不能持有路由锁
+    if (last)
+        ticos_hal_mqtt_stop();
+    ticos_client_unlink(client);
+}
+
+void ticos_client_set_event_cb(ticos_client_t *client, ticos_event_cb_t evt_cb, void *user_data)
+{
+    client->evt_cb = evt_cb;
+    client->user_data = user_data;
+}
+
+void *ticos_client_user_data(const ticos_client_t *client)
+{
+    return client->user_data;
+}
 
 int ticos_cloud_start(const char* product_id, const char* device_id, const char *device_secret)
 {
-    sprintf(ticos_client_id, "%s@@@%s", device_id, product_id);
-    sprintf(ticos_device_id, "%s", device_id);
-    sprintf(ticos_device_secret, "%s", device_secret);
-    sprintf(ticos_command_request_topic, "devices/%s/commands/request", device_id);
-    sprintf(ticos_property_desired_topic, "devices/%s/twin/desired", device_id);
-    sprintf(ticos_property_report_topic, "devices/%s/twin/reported", device_id);
-    sprintf(ticos_telemery_topic, "devices/%s/telemetry", device_id);
+    ticos_client_t *client = ticos_client_default();
 
-    return ticos_hal_mqtt_start("mqtt://hub.ticos.cn", 1883, ticos_client_id, ticos_device_id, ticos_device_secret);
+    // 路由引用了设备的 topic, 修改身份信息前先移除
+    if (client->started)
+        ticos_client_unlink(client);
+    // 保留启动前设置的事件回调和上报格式
+    if (ticos_client_identity(client, product_id, device_id, device_secret))
+        return -1;
+    return ticos_client_start(client);
 }
 
 void ticos_cloud_stop()
 {
     ticos_hal_mqtt_stop();
+    ticos_route_lock();
+    while (m_clients)
+        ticos_client_unlink(m_clients);
+    ticos_route_unlock();
 }
 
 int ticos_mqtt_subscribe()
 {
-    int ret = ticos_hal_mqtt_subscribe(ticos_property_desired_topic, 1);
-    if (!ret)
-        return ticos_hal_mqtt_subscribe(ticos_command_request_topic, 1);
+    if (m_wildcard) {
+        int ret = ticos_hal_mqtt_subscribe("devices/+/twin/desired", 1);
+        if (!ret)
+            return ticos_hal_mqtt_subscribe("devices/+/commands/request", 1);
+        return ret;
+    }
+    int ret = 0;
+    ticos_route_lock();
+    for (ticos_client_t *client = m_clients; client && !ret; client = client->next)
+        ret = ticos_client_subscribe(client);
+    ticos_route_unlock();
     return ret;
 }
 
-void ticos_command_receive(const char *dat, int len);
-void ticos_property_receive(const char *dat, int len);
-void ticos_msg_recv(const char *topic, const char *dat, int len)
+void ticos_msg_recv_topic(const char *topic, int topic_len, const char *dat, int len)
 {
-    if (!strncmp(topic, ticos_command_request_topic, strlen(ticos_command_request_topic))) {
-        ticos_command_receive(dat, len);
-    } else if (!strncmp(topic, ticos_property_desired_topic, strlen(ticos_property_desired_topic))) {
-        ticos_property_receive(dat, len);
+    TICOS_TRACE_BEGIN(TICOS_TRACE_RECV, len);
+    ticos_route_dispatch(topic, topic_len, dat, len);
+    TICOS_TRACE_END(TICOS_TRACE_RECV);
+}
+
+void ticos_msg_recv_fragment(const char *topic, int topic_len, const char *dat, int len, int offset, int total)
+{
+    if (!offset && len >= total) {
+        ticos_msg_recv_topic(topic, topic_len, dat, len);
+        return;
+    }
+    // 后续分片不带 topic, 交给第一个分片找到的路由; 路由在分片之间被移除时丢弃剩余分片
+    ticos_route_lock();
+    if (!offset)
+        m_fragment_route = ticos_route_find(topic, topic_len);
+    if (!m_fragment_route) {
+        ticos_route_unlock();
+        return;
     }
+    TICOS_TRACE_BEGIN(TICOS_TRACE_RECV, len);
+    if (m_fragment_route->fragment)
+        m_fragment_route->fragment(m_fragment_route->user, dat, len, offset, total);
+    if (offset + len >= total)
+        m_fragment_route = NULL;
+    TICOS_TRACE_END(TICOS_TRACE_RECV);
+    ticos_route_unlock();
+}
+
+void ticos_msg_recv(const char *topic, const char *dat, int len)
+{
+    ticos_msg_recv_topic(topic, strlen(topic), dat, len);
 }
 
-static ticos_event_cb_t m_ticos_evt_cb = NULL;
-static void *m_ticos_user_data = NULL;
 void set_ticos_event_cb(ticos_event_cb_t evt_cb, void *user_data)
 {
-    m_ticos_evt_cb = evt_cb;
-    m_ticos_user_data = user_data;
+    ticos_client_set_event_cb(ticos_client_default(), evt_cb, user_data);
 }
 
 void ticos_event_notify(ticos_evt_t evt)
 {
-    if (m_ticos_evt_cb)
-        m_ticos_evt_cb(m_ticos_user_data, evt);
+    ticos_client_t *next;
+
+    // 回调期间持有路由锁, 其他线程停止的设备在通知结束后才移出链表
+    ticos_route_lock();
+    m_connected = evt == TICOS_EVENT_CONNECT;
+    // 重新连接后云端的属性可能已经过期, 需要全量同步一次, 声明了过滤条件的字段也各上报一次;
+    // 云端可能重新下发同一版本的期望属性, 不应将其丢弃
+    // 发送线程可能正在编码, 清除缓存需持有上报锁; 全量上报由 ticos_report_poll() 发出, 断开时不再发出
+    ticos_report_lock();
+    for (ticos_client_t *client = m_clients; client; client = client->next) {
+        client->resync = evt == TICOS_EVENT_CONNECT;
+        if (evt != TICOS_EVENT_CONNECT)
+            continue;
+        ticos_property_cache_reset(client);
+        ticos_report_filter_reset(client);
+        ticos_desired_reset(client);
+    }
+    ticos_report_unlock();
+    if (evt == TICOS_EVENT_CONNECT)
+        ticos_sender_notify();
+    ticos_offline_event(evt);
+    // 回调中可能停止设备, 需先取出下一个设备
+    for (ticos_client_t *client = m_clients; client; client = next) {
+        next = client->next;
+        if (client->evt_cb)
+            client->evt_cb(client->user_data, evt);
+    }
+    ticos_route_unlock();
 }
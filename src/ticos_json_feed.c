@@ -0,0 +1,364 @@
+#include "ticos_json_feed.h"
+#include <string.h>
+
+// 顶层对象加上 ticos_json_check_object() 允许的 32 层嵌套
+#define TICOS_JSON_FEED_MAX_DEPTH 33
+
+enum {
+    FEED_START,         // 等待顶层对象的 '{'
+    FEED_OBJECT_FIRST,  // '{' 之后, 成员名或 '}'
+    FEED_ARRAY_FIRST,   // '[' 之后, 值或 ']'
+    FEED_KEY,           // ',' 之后的成员名
+    FEED_COLON,
+    FEED_VALUE,
+    FEED_NEXT,          // 值之后, ',' 或容器结束
+    FEED_STRING,
+    FEED_ESCAPE,        // '\' 之后
+    FEED_HEX,           // \u 之后的十六进制数字
+    FEED_LOW_SLASH,     // 高代理项之后, 低代理项的 '\'
+    FEED_LOW_U,         // 高代理项之后, 低代理项的 'u'
+    FEED_MINUS,         // 数字的 '-' 之后
+    FEED_ZERO,          // 整数部分为 0
+    FEED_INT,
+    FEED_DOT,           // '.' 之后
+    FEED_FRAC,
+    FEED_EXP_MARK,      // 'e' 之后
+    FEED_EXP_SIGN,      // 指数的符号之后
+    FEED_EXP,
+    FEED_LITERAL,
+    FEED_DONE,
+    FEED_ERROR,
+};
+
+static const char *const ticos_json_literals[] = { "true", "false", "null" };
+
+// 顶层成员名和值解码到缓冲区中, 嵌套容器中的内容只检查格式
+static void ticos_json_feed_put(ticos_json_feed_t *p, const char *s, int n)
+{
+    if (p->depth != 1 || p->len < 0)
+        return;
+    if (p->len + n >= p->size) {
+        p->len = -1;
+        return;
+    }
+    memcpy(p->buf + p->len, s, n);
+    p->len += n;
+}
+
+static void ticos_json_feed_scalar(ticos_json_feed_t *p, ticos_json_type_t type, int key)
+{
+    p->type = type;
+    p->key = key;
+    p->len = 0;
+}
+
+static void ticos_json_feed_emit(ticos_json_feed_t *p)
+{
+    if (p->depth != 1)
+        return;
+    if (p->len >= 0)
+        p->buf[p->len] = '\0';
+    p->cb(p->user, p->key, p->type, p->len >= 0 ? p->buf : "", p->len);
+}
+
+// 码点以 UTF-8 写入
+static void ticos_json_feed_utf8(ticos_json_feed_t *p, uint32_t cp)
+{
+    char out[4];
+    int n;
+
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        out[0] = (char)(0xF0 | (cp >> 18));
+        out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    ticos_json_feed_put(p, out, n);
+}
+
+// \u 转义的四位十六进制读完后解码, 高代理项须紧跟低代理项, 高代理项暂存在 cp 的高 16 位
+static int ticos_json_feed_codepoint(ticos_json_feed_t *p)
+{
+    uint32_t hi = p->cp >> 16;
+    uint32_t cp = p->cp & 0xFFFF;
+
+    if (hi) {
+        if (cp < 0xDC00 || cp > 0xDFFF)
+            return -1;
+        ticos_json_feed_utf8(p, 0x10000 + (((hi & 0x3FF) << 10) | (cp & 0x3FF)));
+        return FEED_STRING;
+    }
+    if (cp >= 0xDC00 && cp <= 0xDFFF)
+        return -1;
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        p->cp = cp << 16;
+        return FEED_LOW_SLASH;
+    }
+    ticos_json_feed_utf8(p, cp);
+    return FEED_STRING;
+}
+
+static int ticos_json_feed_escape(ticos_json_feed_t *p, char c)
+{
+    char out;
+
+    switch (c) {
+    case '\"': out = '\"'; break;
+    case '\\': out = '\\'; break;
+    case '/':  out = '/'; break;
+    case 'b':  out = '\b'; break;
+    case 'f':  out = '\f'; break;
+    case 'n':  out = '\n'; break;
+    case 'r':  out = '\r'; break;
+    case 't':  out = '\t'; break;
+    case 'u':
+        p->hex = 4;
+        p->cp = 0;
+        return FEED_HEX;
+    default:
+        return -1;
+    }
+    ticos_json_feed_put(p, &out, 1);
+    return FEED_STRING;
+}
+
+static int ticos_json_feed_open(ticos_json_feed_t *p, char c)
+{
+    if (p->depth >= TICOS_JSON_FEED_MAX_DEPTH)
+        return -1;
+    if (c == '{')
+        p->objects |= (uint64_t)1 << p->depth;
+    else
+        p->objects &= ~((uint64_t)1 << p->depth);
+    p->depth++;
+    return c == '{' ? FEED_OBJECT_FIRST : FEED_ARRAY_FIRST;
+}
+
+static int ticos_json_feed_close(ticos_json_feed_t *p, char c)
+{
+    int object = (p->objects >> (p->depth - 1)) & 1;
+
+    if (c != (object ? '}' : ']'))
+        return -1;
+    if (--p->depth == 0)
+        return FEED_DONE;
+    // 顶层成员的值为对象或数组时, 结束后只给出类型
+    if (p->depth == 1) {
+        ticos_json_feed_scalar(p, object ? TICOS_JSON_OBJECT : TICOS_JSON_ARRAY, 0);
+        ticos_json_feed_emit(p);
+    }
+    return FEED_NEXT;
+}
+
+// 值的第一个字符
+static int ticos_json_feed_value(ticos_json_feed_t *p, char c)
+{
+    switch (c) {
+    case '{':
+    case '[':
+        return ticos_json_feed_open(p, c);
+    case '\"':
+        ticos_json_feed_scalar(p, TICOS_JSON_STRING, 0);
+        return FEED_STRING;
+    case 't':
+    case 'f':
+    case 'n':
+        ticos_json_feed_scalar(p, c == 't' ? TICOS_JSON_TRUE : c == 'f' ? TICOS_JSON_FALSE : TICOS_JSON_NULL, 0);
+        ticos_json_feed_put(p, &c, 1);
+        p->lit = 1;
+        return FEED_LITERAL;
+    case '-':
+        ticos_json_feed_scalar(p, TICOS_JSON_NUMBER, 0);
+        ticos_json_feed_put(p, &c, 1);
+        return FEED_MINUS;
+    default:
+        if (c < '0' || c > '9')
+            return -1;
+        ticos_json_feed_scalar(p, TICOS_JSON_NUMBER, 0);
+        ticos_json_feed_put(p, &c, 1);
+        return c == '0' ? FEED_ZERO : FEED_INT;
+    }
+}
+
+/*
+ * 数字中的下一个字符, 返回新的状态; 返回 FEED_NEXT 代表数字已在此字符之前结束, 该字符需重新处理
+ */
+static int ticos_json_feed_number(ticos_json_feed_t *p, char c)
+{
+    int digit = c >= '0' && c <= '9';
+    int state = p->state;
+
+    switch (state) {
+    case FEED_MINUS:
+        state = !digit ? -1 : c == '0' ? FEED_ZERO : FEED_INT;
+        break;
+    case FEED_ZERO:
+    case FEED_INT:
+        if (digit && state == FEED_INT)
+            break;
+        state = c == '.' ? FEED_DOT : c == 'e' || c == 'E' ? FEED_EXP_MARK : FEED_NEXT;
+        break;
+    case FEED_DOT:
+        state = digit ? FEED_FRAC : -1;
+        break;
+    case FEED_FRAC:
+        if (!digit)
+            state = c == 'e' || c == 'E' ? FEED_EXP_MARK : FEED_NEXT;
+        break;
+    case FEED_EXP_MARK:
+        state = digit ? FEED_EXP : c == '+' || c == '-' ? FEED_EXP_SIGN : -1;
+        break;
+    case FEED_EXP_SIGN:
+        state = digit ? FEED_EXP : -1;
+        break;
+    case FEED_EXP:
+        if (!digit)
+            state = FEED_NEXT;
+        break;
+    }
+    if (state == FEED_NEXT)
+        ticos_json_feed_emit(p);
+    else if (state >= 0)
+        ticos_json_feed_put(p, &c, 1);
+    return state;
+}
+
+static int ticos_json_feed_hex(ticos_json_feed_t *p, char c)
+{
+    uint32_t v;
+
+    if (c >= '0' && c <= '9')
+        v = c - '0';
+    else if (c >= 'a' && c <= 'f')
+        v = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+        v = c - 'A' + 10;
+    else
+        return -1;
+    p->cp = (p->cp & 0xFFFF0000) | (((p->cp & 0xFFF) << 4) | v);
+    return --p->hex ? FEED_HEX : ticos_json_feed_codepoint(p);
+}
+
+void ticos_json_feed_init(ticos_json_feed_t *p, char *buf, int size, ticos_json_feed_cb_t cb, void *user)
+{
+    memset(p, 0, sizeof(*p));
+    p->cb = cb;
+    p->user = user;
+    p->buf = buf;
+    p->size = size;
+    p->state = FEED_START;
+}
+
+int ticos_json_feed(ticos_json_feed_t *p, const char *dat, int len)
+{
+    int i = 0;
+
+    while (i < len && p->state != FEED_ERROR) {
+        char c = dat[i];
+        int state = p->state;
+        int ws = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+
+        // 字符串和数字之外的空白直接跳过
+        if (ws && (state < FEED_STRING || state == FEED_DONE)) {
+            i++;
+            continue;
+        }
+        switch (state) {
+        case FEED_START:
+            state = c == '{' ? ticos_json_feed_open(p, c) : -1;
+            break;
+        case FEED_OBJECT_FIRST:
+        case FEED_KEY:
+            if (c == '}' && state == FEED_OBJECT_FIRST) {
+                state = ticos_json_feed_close(p, c);
+            } else if (c == '\"') {
+                ticos_json_feed_scalar(p, TICOS_JSON_STRING, 1);
+                state = FEED_STRING;
+            } else {
+                state = -1;
+            }
+            break;
+        case FEED_COLON:
+            state = c == ':' ? FEED_VALUE : -1;
+            break;
+        case FEED_ARRAY_FIRST:
+            state = c == ']' ? ticos_json_feed_close(p, c) : ticos_json_feed_value(p, c);
+            break;
+        case FEED_VALUE:
+            state = ticos_json_feed_value(p, c);
+            break;
+        case FEED_NEXT:
+            if (c == ',')
+                state = (p->objects >> (p->depth - 1)) & 1 ? FEED_KEY : FEED_VALUE;
+            else
+                state = ticos_json_feed_close(p, c);
+            break;
+        case FEED_STRING:
+            if (c == '\"') {
+                ticos_json_feed_emit(p);
+                state = p->key ? FEED_COLON : FEED_NEXT;
+            } else if (c == '\\') {
+                state = FEED_ESCAPE;
+            } else if ((unsigned char)c < 0x20) {
+                state = -1;
+            } else {
+                ticos_json_feed_put(p, &c, 1);
+            }
+            break;
+        case FEED_ESCAPE:
+            state = ticos_json_feed_escape(p, c);
+            break;
+        case FEED_HEX:
+            state = ticos_json_feed_hex(p, c);
+            break;
+        case FEED_LOW_SLASH:
+            state = c == '\\' ? FEED_LOW_U : -1;
+            break;
+        case FEED_LOW_U:
+            p->hex = 4;
+            state = c == 'u' ? FEED_HEX : -1;
+            break;
+        case FEED_LITERAL: {
+            const char *lit = ticos_json_literals[p->type - TICOS_JSON_TRUE];
+            if (c != lit[p->lit]) {
+                state = -1;
+                break;
+            }
+            ticos_json_feed_put(p, &c, 1);
+            if (!lit[++p->lit]) {
+                ticos_json_feed_emit(p);
+                state = FEED_NEXT;
+            }
+            break;
+        }
+        case FEED_DONE:
+            // 顶层对象之后只允许空白
+            state = -1;
+            break;
+        default:
+            state = ticos_json_feed_number(p, c);
+            // 数字在此字符之前结束, 按值之后的状态重新处理
+            if (state == FEED_NEXT) {
+                p->state = FEED_NEXT;
+                continue;
+            }
+            break;
+        }
+        p->state = state < 0 ? FEED_ERROR : state;
+        i++;
+    }
+    return p->state == FEED_ERROR ? -1 : p->state == FEED_DONE ? 1 : 0;
+}
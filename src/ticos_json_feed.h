@@ -0,0 +1,69 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_json_feed.h
+ * @brief 增量 JSON 解析器
+ *
+ * 数据可分成任意多段依次送入, 解析状态保存在解析器中, 不需要拼接出完整的数据。
+ * 只给出顶层对象的成员: 成员名和标量值解码到调用者提供的缓冲区后以回调给出,
+ * 对象或数组值只检查格式, 不保存内容。语法与 ticos_json_check_object() 一致。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "ticos_json_reader.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 顶层对象成员的回调
+ * @param key 1 代表成员名, 0 代表成员值
+ * @param type 成员名为 TICOS_JSON_STRING; 对象或数组值只给出类型
+ * @param str 解码后的字符串或数字的原文, 以 '\0' 结尾
+ * @param len str 的长度, 超出缓冲区时为 -1
+ */
+typedef void (*ticos_json_feed_cb_t)(void *user, int key, ticos_json_type_t type, const char *str, int len);
+
+typedef struct {
+    ticos_json_feed_cb_t cb;
+    void *user;
+    char *buf;              // 顶层成员名和标量值的解码缓冲区
+    int size;
+    int len;                // 缓冲区中已解码的字节数, 超出缓冲区时为 -1
+    uint8_t state;
+    uint8_t next;           // 字符串、数字或字面量结束后的状态
+    uint8_t depth;          // 容器的嵌套层数, 顶层对象为 1
+    uint8_t key;            // 正在解码的字符串是成员名
+    uint8_t hex;            // \u 转义中还需读取的十六进制位数
+    uint8_t lit;            // 字面量中已匹配的字节数
+    ticos_json_type_t type; // 正在解析的标量值的类型
+    uint32_t cp;            // \u 转义中的码点
+    uint64_t objects;       // 每层容器是否为对象, 第 i 位对应第 i + 1 层
+} ticos_json_feed_t;
+
+/**
+ * @brief  初始化解析器
+ * @param buf 解码缓冲区, 长度超出 size - 1 的成员名和标量值以 len 为 -1 给出
+ * @param size 解码缓冲区大小
+ * @param cb 成员回调
+ * @param user 传给回调的用户数据
+ * @return void
+ */
+void ticos_json_feed_init(ticos_json_feed_t *p, char *buf, int size, ticos_json_feed_cb_t cb, void *user);
+
+/**
+ * @brief  送入下一段数据
+ * @note   顶层对象结束后只允许空白, 其他数据视为格式错误
+ * @param dat 数据, 不要求以 '\0' 结尾
+ * @param len 数据长度
+ * @return 1 代表顶层对象已结束, 0 代表需要更多数据, -1 代表数据格式错误
+ */
+int ticos_json_feed(ticos_json_feed_t *p, const char *dat, int len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,372 @@
+#include "ticos_json_reader.h"
+#include "ticos_number.h"
+#include <string.h>
+
+#define TICOS_JSON_MAX_DEPTH    32
+
+static int ticos_json_scan_value(ticos_json_reader_t *r, ticos_json_tok_t *tok, int depth);
+
+static void ticos_json_skip_ws(ticos_json_reader_t *r)
+{
+    while (r->pos < r->len) {
+        char c = r->js[r->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+            break;
+        r->pos++;
+    }
+}
+
+static int ticos_json_peek(ticos_json_reader_t *r)
+{
+    ticos_json_skip_ws(r);
+    if (r->pos >= r->len)
+        return -1;
+    return (unsigned char)r->js[r->pos];
+}
+
+static int ticos_json_hex4(const char *p, const char *end, unsigned int *out)
+{
+    unsigned int v = 0;
+    if (end - p < 4)
+        return -1;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9')
+            v |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v |= c - 'A' + 10;
+        else
+            return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/*
+ * 从 *p 处解码一个字符(可能是转义序列), 结果以 UTF-8 写入 out.
+ * 返回写入的字节数, 格式错误时返回 -1
+ */
+static int ticos_json_decode_char(const char **p, const char *end, char out[4])
+{
+    const char *s = *p;
+    unsigned int cp;
+
+    if (*s != '\\') {
+        out[0] = *s;
+        *p = s + 1;
+        return 1;
+    }
+    if (end - s < 2)
+        return -1;
+    switch (s[1]) {
+    case '\"': out[0] = '\"'; break;
+    case '\\': out[0] = '\\'; break;
+    case '/':  out[0] = '/'; break;
+    case 'b':  out[0] = '\b'; break;
+    case 'f':  out[0] = '\f'; break;
+    case 'n':  out[0] = '\n'; break;
+    case 'r':  out[0] = '\r'; break;
+    case 't':  out[0] = '\t'; break;
+    case 'u':
+        if (ticos_json_hex4(s + 2, end, &cp))
+            return -1;
+        s += 6;
+        if (cp >= 0xDC00 && cp <= 0xDFFF)
+            return -1;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            unsigned int lo;
+            if (end - s < 6 || s[0] != '\\' || s[1] != 'u' || ticos_json_hex4(s + 2, end, &lo))
+                return -1;
+            if (lo < 0xDC00 || lo > 0xDFFF)
+                return -1;
+            cp = 0x10000 + (((cp & 0x3FF) << 10) | (lo & 0x3FF));
+            s += 6;
+        }
+        *p = s;
+        if (cp < 0x80) {
+            out[0] = (char)cp;
+            return 1;
+        } else if (cp < 0x800) {
+            out[0] = (char)(0xC0 | (cp >> 6));
+            out[1] = (char)(0x80 | (cp & 0x3F));
+            return 2;
+        } else if (cp < 0x10000) {
+            out[0] = (char)(0xE0 | (cp >> 12));
+            out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+            out[2] = (char)(0x80 | (cp & 0x3F));
+            return 3;
+        }
+        out[0] = (char)(0xF0 | (cp >> 18));
+        out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    default:
+        return -1;
+    }
+    *p = s + 2;
+    return 1;
+}
+
+static int ticos_json_scan_string(ticos_json_reader_t *r, ticos_json_tok_t *tok)
+{
+    int pos = r->pos + 1;
+
+    while (pos < r->len) {
+        char c = r->js[pos];
+        if (c == '\"') {
+            tok->type = TICOS_JSON_STRING;
+            tok->start = r->pos + 1;
+            tok->end = pos;
+            r->pos = pos + 1;
+            return 0;
+        }
+        if (c == '\\') {
+            const char *p = r->js + pos;
+            char tmp[4];
+            if (ticos_json_decode_char(&p, r->js + r->len, tmp) < 0)
+                return -1;
+            pos = p - r->js;
+        } else if ((unsigned char)c < 0x20) {
+            // 字符串中的控制字符必须转义
+            return -1;
+        } else {
+            pos++;
+        }
+    }
+    return -1;
+}
+
+static int ticos_json_is_digit(ticos_json_reader_t *r)
+{
+    return r->pos < r->len && r->js[r->pos] >= '0' && r->js[r->pos] <= '9';
+}
+
+static int ticos_json_scan_number(ticos_json_reader_t *r, ticos_json_tok_t *tok)
+{
+    int start = r->pos;
+
+    if (r->js[r->pos] == '-')
+        r->pos++;
+    if (!ticos_json_is_digit(r))
+        return -1;
+    if (r->js[r->pos] == '0') {
+        r->pos++;
+    } else {
+        while (ticos_json_is_digit(r))
+            r->pos++;
+    }
+    if (r->pos < r->len && r->js[r->pos] == '.') {
+        r->pos++;
+        if (!ticos_json_is_digit(r))
+            return -1;
+        while (ticos_json_is_digit(r))
+            r->pos++;
+    }
+    if (r->pos < r->len && (r->js[r->pos] == 'e' || r->js[r->pos] == 'E')) {
+        r->pos++;
+        if (r->pos < r->len && (r->js[r->pos] == '+' || r->js[r->pos] == '-'))
+            r->pos++;
+        if (!ticos_json_is_digit(r))
+            return -1;
+        while (ticos_json_is_digit(r))
+            r->pos++;
+    }
+    tok->type = TICOS_JSON_NUMBER;
+    tok->start = start;
+    tok->end = r->pos;
+    return 0;
+}
+
+static int ticos_json_scan_literal(ticos_json_reader_t *r, ticos_json_tok_t *tok,
+                                   const char *lit, ticos_json_type_t type)
+{
+    int n = strlen(lit);
+    if (r->len - r->pos < n || memcmp(r->js + r->pos, lit, n))
+        return -1;
+    tok->type = type;
+    tok->start = r->pos;
+    tok->end = r->pos + n;
+    r->pos += n;
+    return 0;
+}
+
+static int ticos_json_scan_container(ticos_json_reader_t *r, ticos_json_tok_t *tok, int depth)
+{
+    char close = r->js[r->pos] == '{' ? '}' : ']';
+    int start = r->pos;
+    ticos_json_tok_t item;
+
+    if (depth > TICOS_JSON_MAX_DEPTH)
+        return -1;
+    r->pos++;
+    if (ticos_json_peek(r) == close) {
+        r->pos++;
+    } else {
+        for (;;) {
+            if (close == '}') {
+                if (ticos_json_peek(r) != '\"' || ticos_json_scan_string(r, &item))
+                    return -1;
+                if (ticos_json_peek(r) != ':')
+                    return -1;
+                r->pos++;
+            }
+            if (ticos_json_scan_value(r, &item, depth + 1))
+                return -1;
+            int c = ticos_json_peek(r);
+            r->pos++;
+            if (c == close)
+                break;
+            if (c != ',')
+                return -1;
+        }
+    }
+    tok->type = close == '}' ? TICOS_JSON_OBJECT : TICOS_JSON_ARRAY;
+    tok->start = start;
+    tok->end = r->pos;
+    return 0;
+}
+
+static int ticos_json_scan_value(ticos_json_reader_t *r, ticos_json_tok_t *tok, int depth)
+{
+    switch (ticos_json_peek(r)) {
+    case '{':
+    case '[':
+        return ticos_json_scan_container(r, tok, depth);
+    case '\"':
+        return ticos_json_scan_string(r, tok);
+    case 't':
+        return ticos_json_scan_literal(r, tok, "true", TICOS_JSON_TRUE);
+    case 'f':
+        return ticos_json_scan_literal(r, tok, "false", TICOS_JSON_FALSE);
+    case 'n':
+        return ticos_json_scan_literal(r, tok, "null", TICOS_JSON_NULL);
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return ticos_json_scan_number(r, tok);
+    default:
+        return -1;
+    }
+}
+
+void ticos_json_reader_init(ticos_json_reader_t *r, const char *js, int len)
+{
+    r->js = js;
+    r->len = (js && len > 0) ? len : 0;
+    r->pos = 0;
+    r->count = 0;
+}
+
+int ticos_json_object_enter(ticos_json_reader_t *r)
+{
+    if (ticos_json_peek(r) != '{')
+        return -1;
+    r->pos++;
+    r->count = 0;
+    return 0;
+}
+
+int ticos_json_object_next(ticos_json_reader_t *r, ticos_json_tok_t *key, ticos_json_tok_t *val)
+{
+    int c;
+
+    if (r->count < 0)
+        return 0;
+    c = ticos_json_peek(r);
+    if (c == '}') {
+        r->pos++;
+        r->count = -1;
+        return 0;
+    }
+    if (r->count > 0) {
+        if (c != ',')
+            return -1;
+        r->pos++;
+        c = ticos_json_peek(r);
+    }
+    if (c != '\"' || ticos_json_scan_string(r, key))
+        return -1;
+    if (ticos_json_peek(r) != ':')
+        return -1;
+    r->pos++;
+    if (ticos_json_scan_value(r, val, 1))
+        return -1;
+    r->count++;
+    return 1;
+}
+
+int ticos_json_check_object(const char *js, int len)
+{
+    ticos_json_reader_t r;
+    ticos_json_tok_t key, val;
+    int ret;
+
+    ticos_json_reader_init(&r, js, len);
+    if (ticos_json_object_enter(&r))
+        return -1;
+    while ((ret = ticos_json_object_next(&r, &key, &val)) > 0)
+        ;
+    if (!ret && ticos_json_peek(&r) >= 0)
+        return -1;
+    return ret;
+}
+
+int ticos_json_tok_equal(const char *js, const ticos_json_tok_t *tok, const char *str)
+{
+    const char *p = js + tok->start;
+    const char *end = js + tok->end;
+
+    while (p < end) {
+        char tmp[4];
+        int n = ticos_json_decode_char(&p, end, tmp);
+        if (n < 0 || strncmp(str, tmp, n))
+            return 0;
+        str += n;
+    }
+    return *str == '\0';
+}
+
+int ticos_json_tok_string(const char *js, const ticos_json_tok_t *tok, char *buf, int size)
+{
+    const char *p = js + tok->start;
+    const char *end = js + tok->end;
+    int len = 0;
+
+    if (tok->type != TICOS_JSON_STRING || size <= 0)
+        return -1;
+    while (p < end) {
+        char tmp[4];
+        int n = ticos_json_decode_char(&p, end, tmp);
+        if (n < 0 || len + n >= size)
+            return -1;
+        memcpy(buf + len, tmp, n);
+        len += n;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+int ticos_json_tok_number(const char *js, const ticos_json_tok_t *tok, double *val)
+{
+    if (tok->type != TICOS_JSON_NUMBER)
+        return -1;
+    return ticos_atod(js + tok->start, tok->end - tok->start, val);
+}
+
+int ticos_json_tok_float(const char *js, const ticos_json_tok_t *tok, float *val)
+{
+    if (tok->type != TICOS_JSON_NUMBER)
+        return -1;
+    return ticos_atof(js + tok->start, tok->end - tok->start, val);
+}
+
+int ticos_json_tok_int(const char *js, const ticos_json_tok_t *tok, int64_t *val)
+{
+    if (tok->type != TICOS_JSON_NUMBER)
+        return -1;
+    return ticos_atoi(js + tok->start, tok->end - tok->start, val);
+}
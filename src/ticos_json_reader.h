@@ -0,0 +1,118 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_json_reader.h
+ * @brief 原地 JSON 解析器
+ *
+ * 直接在接收缓冲区上逐个遍历 JSON 对象的成员，严格遵守数据长度，
+ * 不要求数据以 '\0' 结尾，也不申请任何堆内存。
+ * 解析结果以 token 的形式给出，token 只记录值在原数据中的位置。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum {
+    TICOS_JSON_NONE,
+    TICOS_JSON_OBJECT,
+    TICOS_JSON_ARRAY,
+    TICOS_JSON_STRING,
+    TICOS_JSON_NUMBER,
+    TICOS_JSON_TRUE,
+    TICOS_JSON_FALSE,
+    TICOS_JSON_NULL,
+} ticos_json_type_t;
+
+typedef struct {
+    ticos_json_type_t type;
+    int start;  // 值的起始位置, 字符串不含引号
+    int end;    // 值的结束位置(不含)
+} ticos_json_tok_t;
+
+typedef struct {
+    const char *js;
+    int len;
+    int pos;
+    int count;  // 已读取的成员数, 对象结束后为 -1
+} ticos_json_reader_t;
+
+/**
+ * @brief  初始化解析器
+ * @param r 解析器
+ * @param js 待解析的数据, 不要求以 '\0' 结尾
+ * @param len 数据长度
+ * @return void
+ */
+void ticos_json_reader_init(ticos_json_reader_t *r, const char *js, int len);
+
+/**
+ * @brief  进入顶层对象
+ * @param r 解析器
+ * @return 0 代表成功, 数据不是 JSON 对象时返回 -1
+ */
+int ticos_json_object_enter(ticos_json_reader_t *r);
+
+/**
+ * @brief  读取对象的下一个成员
+ * @note   成员的值为对象或数组时, 会整体跳过, val 给出其范围
+ * @param r 解析器
+ * @param key 成员名
+ * @param val 成员值
+ * @return 1 代表读到一个成员, 0 代表对象已结束, -1 代表数据格式错误
+ */
+int ticos_json_object_next(ticos_json_reader_t *r, ticos_json_tok_t *key, ticos_json_tok_t *val);
+
+/**
+ * @brief  检查数据是否为格式正确的 JSON 对象
+ * @note   对象之后只允许空白
+ * @param js 待检查的数据
+ * @param len 数据长度
+ * @return 0 代表格式正确, 其他值代表错误
+ */
+int ticos_json_check_object(const char *js, int len);
+
+/**
+ * @brief  判断字符串 token 是否与给定的字符串相等
+ * @return 1 代表相等, 0 代表不相等
+ */
+int ticos_json_tok_equal(const char *js, const ticos_json_tok_t *tok, const char *str);
+
+/**
+ * @brief  解码字符串 token, 处理其中的转义字符
+ * @param buf 输出缓冲区, 输出以 '\0' 结尾
+ * @param size 输出缓冲区大小
+ * @return 解码后字符串的长度, 缓冲区不足或格式错误时返回 -1
+ */
+int ticos_json_tok_string(const char *js, const ticos_json_tok_t *tok, char *buf, int size);
+
+/**
+ * @brief  解码数字 token
+ * @param val 输出的数值
+ * @return 0 代表成功, 其他值代表错误
+ */
+int ticos_json_tok_number(const char *js, const ticos_json_tok_t *tok, double *val);
+
+/**
+ * @brief  解码数字 token 为 float
+ * @note   直接舍入到 float, 与先解码为 double 再转换相比不会因两次舍入产生误差
+ * @param val 输出的数值
+ * @return 0 代表成功, 其他值代表错误
+ */
+int ticos_json_tok_float(const char *js, const ticos_json_tok_t *tok, float *val);
+
+/**
+ * @brief  解码整数 token, 不经过浮点运算
+ * @param val 输出的数值
+ * @return 0 代表成功, token 带有小数点或指数、或超出 int64_t 范围时返回 -1
+ */
+int ticos_json_tok_int(const char *js, const ticos_json_tok_t *tok, int64_t *val);
+
+#ifdef __cplusplus
+}
+#endif
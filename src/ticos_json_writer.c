@@ -0,0 +1,212 @@
+#include "ticos_json_writer.h"
+#include "ticos_number.h"
+#include <string.h>
+#include <math.h>
+
+static void ticos_json_put(ticos_json_writer_t *w, const char *s, int n)
+{
+    if (w->overflow)
+        return;
+    if (w->len + n >= w->size) {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void ticos_json_putc(ticos_json_writer_t *w, char c)
+{
+    ticos_json_put(w, &c, 1);
+}
+
+static void ticos_json_sep(ticos_json_writer_t *w)
+{
+    if (w->need_comma)
+        ticos_json_putc(w, ',');
+}
+
+int ticos_json_escape(unsigned char c, char *esc)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    if (c >= 32 && c != '\"' && c != '\\')
+        return 0;
+    esc[0] = '\\';
+    switch (c) {
+    case '\"': esc[1] = '\"'; break;
+    case '\\': esc[1] = '\\'; break;
+    case '\b': esc[1] = 'b'; break;
+    case '\f': esc[1] = 'f'; break;
+    case '\n': esc[1] = 'n'; break;
+    case '\r': esc[1] = 'r'; break;
+    case '\t': esc[1] = 't'; break;
+    default:
+        esc[1] = 'u';
+        esc[2] = '0';
+        esc[3] = '0';
+        esc[4] = hex[c >> 4];
+        esc[5] = hex[c & 0xf];
+        return 6;
+    }
+    return 2;
+}
+
+static void ticos_json_quoted(ticos_json_writer_t *w, const char *s)
+{
+    const char *run = s;
+
+    ticos_json_putc(w, '\"');
+    for (; *s; s++) {
+        char esc[6];
+        int n = ticos_json_escape((unsigned char)*s, esc);
+        if (!n)
+            continue;
+        ticos_json_put(w, run, s - run);
+        run = s + 1;
+        ticos_json_put(w, esc, n);
+    }
+    ticos_json_put(w, run, s - run);
+    ticos_json_putc(w, '\"');
+}
+
+void ticos_json_writer_init(ticos_json_writer_t *w, char *buf, int size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->need_comma = 0;
+    w->overflow = (!buf || size <= 0);
+}
+
+int ticos_json_writer_finish(ticos_json_writer_t *w)
+{
+    if (w->overflow)
+        return -1;
+    w->buf[w->len] = '\0';
+    return w->len;
+}
+
+void ticos_json_object_begin(ticos_json_writer_t *w)
+{
+    ticos_json_sep(w);
+    ticos_json_putc(w, '{');
+    w->need_comma = 0;
+}
+
+void ticos_json_object_end(ticos_json_writer_t *w)
+{
+    ticos_json_putc(w, '}');
+    w->need_comma = 1;
+}
+
+void ticos_json_key(ticos_json_writer_t *w, const char *key)
+{
+    ticos_json_sep(w);
+    ticos_json_quoted(w, key);
+    ticos_json_putc(w, ':');
+    w->need_comma = 0;
+}
+
+void ticos_json_key_raw(ticos_json_writer_t *w, const char *frag, int len)
+{
+    ticos_json_sep(w);
+    ticos_json_put(w, frag, len);
+    w->need_comma = 0;
+}
+
+void ticos_json_bool(ticos_json_writer_t *w, int val)
+{
+    ticos_json_sep(w);
+    if (val)
+        ticos_json_put(w, "true", 4);
+    else
+        ticos_json_put(w, "false", 5);
+    w->need_comma = 1;
+}
+
+/*
+ * 与 cJSON 一致, NaN 和无穷大输出为 null
+ */
+void ticos_json_number(ticos_json_writer_t *w, double val)
+{
+    char num[TICOS_NUMBER_MAX];
+
+    ticos_json_sep(w);
+    w->need_comma = 1;
+    if (isnan(val) || isinf(val))
+        ticos_json_put(w, "null", 4);
+    else
+        ticos_json_put(w, num, ticos_dtoa(val, num));
+}
+
+void ticos_json_float(ticos_json_writer_t *w, float val)
+{
+    char num[TICOS_NUMBER_MAX];
+
+    ticos_json_sep(w);
+    w->need_comma = 1;
+    if (isnan(val) || isinf(val))
+        ticos_json_put(w, "null", 4);
+    else
+        ticos_json_put(w, num, ticos_ftoa(val, num));
+}
+
+void ticos_json_int(ticos_json_writer_t *w, int64_t val)
+{
+    char num[TICOS_NUMBER_MAX];
+
+    ticos_json_sep(w);
+    w->need_comma = 1;
+    ticos_json_put(w, num, ticos_itoa(val, num));
+}
+
+void ticos_json_string(ticos_json_writer_t *w, const char *val)
+{
+    ticos_json_sep(w);
+    ticos_json_quoted(w, val ? val : "");
+    w->need_comma = 1;
+}
+
+void ticos_json_null(ticos_json_writer_t *w)
+{
+    ticos_json_sep(w);
+    ticos_json_put(w, "null", 4);
+    w->need_comma = 1;
+}
+
+void ticos_json_add_bool(ticos_json_writer_t *w, const char *key, int val)
+{
+    ticos_json_key(w, key);
+    ticos_json_bool(w, val);
+}
+
+void ticos_json_add_number(ticos_json_writer_t *w, const char *key, double val)
+{
+    ticos_json_key(w, key);
+    ticos_json_number(w, val);
+}
+
+void ticos_json_add_int(ticos_json_writer_t *w, const char *key, int64_t val)
+{
+    ticos_json_key(w, key);
+    ticos_json_int(w, val);
+}
+
+void ticos_json_add_float(ticos_json_writer_t *w, const char *key, float val)
+{
+    ticos_json_key(w, key);
+    ticos_json_float(w, val);
+}
+
+void ticos_json_add_string(ticos_json_writer_t *w, const char *key, const char *val)
+{
+    ticos_json_key(w, key);
+    ticos_json_string(w, val);
+}
+
+void ticos_json_add_null(ticos_json_writer_t *w, const char *key)
+{
+    ticos_json_key(w, key);
+    ticos_json_null(w);
+}
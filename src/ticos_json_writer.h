@@ -0,0 +1,88 @@
+// Copyright (c) Tiwater Technology Ltd. All rights reserved.
+// SPDX-License-Identifier: MIT
+/**
+ * @file ticos_json_writer.h
+ * @brief 流式 JSON 编码器
+ *
+ * 将 JSON 数据直接写入调用者提供的固定缓冲区，不申请任何堆内存。
+ * 数值以 ticos_number.h 中能精确还原原值的最短文本输出, 其余内容与 cJSON_PrintUnformatted() 的输出逐字节一致。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct ticos_json_writer_s {
+    char *buf;      // 输出缓冲区
+    int size;       // 输出缓冲区大小
+    int len;        // 已写入的长度, 不含结尾的 '\0'
+    int need_comma; // 下一个值之前是否需要写入 ','
+    int overflow;   // 缓冲区是否已溢出
+} ticos_json_writer_t;
+
+/**
+ * @brief  初始化编码器
+ * @param w 编码器
+ * @param buf 输出缓冲区
+ * @param size 输出缓冲区大小
+ * @return void
+ */
+void ticos_json_writer_init(ticos_json_writer_t *w, char *buf, int size);
+
+/**
+ * @brief  结束编码, 并在输出末尾写入 '\0'
+ * @param w 编码器
+ * @return 输出数据的长度, 缓冲区不足时返回 -1
+ */
+int ticos_json_writer_finish(ticos_json_writer_t *w);
+
+void ticos_json_object_begin(ticos_json_writer_t *w);
+void ticos_json_object_end(ticos_json_writer_t *w);
+void ticos_json_key(ticos_json_writer_t *w, const char *key);
+
+/**
+ * @brief  写入预先编码好的字段名片段
+ * @note   供生成的专用编码函数使用, 片段已包含引号、转义和结尾的 ':', 如 "\"light\":"
+ * @param w 编码器
+ * @param frag 字段名片段
+ * @param len 片段长度
+ * @return void
+ */
+void ticos_json_key_raw(ticos_json_writer_t *w, const char *frag, int len);
+
+void ticos_json_bool(ticos_json_writer_t *w, int val);
+void ticos_json_number(ticos_json_writer_t *w, double val);
+void ticos_json_int(ticos_json_writer_t *w, int64_t val);
+
+/**
+ * @brief  写入 float 值
+ * @note   按 float 的精度输出最短文本, 比提升为 double 后调用 ticos_json_number() 更短, 如 22.4f 输出为 22.4
+ * @return void
+ */
+void ticos_json_float(ticos_json_writer_t *w, float val);
+void ticos_json_string(ticos_json_writer_t *w, const char *val);
+void ticos_json_null(ticos_json_writer_t *w);
+
+void ticos_json_add_bool(ticos_json_writer_t *w, const char *key, int val);
+void ticos_json_add_number(ticos_json_writer_t *w, const char *key, double val);
+void ticos_json_add_int(ticos_json_writer_t *w, const char *key, int64_t val);
+void ticos_json_add_float(ticos_json_writer_t *w, const char *key, float val);
+void ticos_json_add_string(ticos_json_writer_t *w, const char *key, const char *val);
+void ticos_json_add_null(ticos_json_writer_t *w, const char *key);
+
+/**
+ * @brief  求一个字节在 JSON 字符串中的转义序列
+ * @param c 字节, UTF-8 多字节字符的各字节不需要转义
+ * @param esc 输出转义序列, 至少 6 字节
+ * @return 转义序列的长度, 不需要转义时返回 0
+ */
+int ticos_json_escape(unsigned char c, char *esc);
+
+#ifdef __cplusplus
+}
+#endif
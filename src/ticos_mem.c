@@ -0,0 +1,217 @@
+#include "ticos_api.h"
+#include "ticos_mem.h"
+#include "ticos_config.h"
+#include "ticos_metrics.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if TICOS_STATIC_MEMORY
+#if !TICOS_JSON_STREAM || !TICOS_JSON_TOKENIZER || TICOS_OFFLINE_LOG
+#error "TICOS_STATIC_MEMORY requires TICOS_JSON_STREAM and TICOS_JSON_TOKENIZER, and cannot be used with TICOS_OFFLINE_LOG"
+#endif
+// 编译时输出各静态缓冲区的大小(字节)
+#define TICOS_STR_(x) #x
+#define TICOS_STR(x) TICOS_STR_(x)
+#pragma message("TICOS_STATIC_MEMORY: report buffer " TICOS_STR(TICOS_REPORT_BUF_SIZE) \
+                ", recv string " TICOS_STR(TICOS_RECV_STRING_MAX) \
+                ", recv fragment " TICOS_STR(TICOS_RECV_FRAGMENT_SIZE) \
+                ", telemetry batch " TICOS_STR(TICOS_TELEMETRY_BATCH_SIZE) \
+                ", offline queue " TICOS_STR(TICOS_OFFLINE_QUEUE_SIZE) \
+                ", offline msg " TICOS_STR(TICOS_OFFLINE_MSG_MAX) \
+                ", arena " TICOS_STR(TICOS_ARENA_SIZE))
+#endif
+
+#if !TICOS_JSON_STREAM || !TICOS_JSON_TOKENIZER
+#include "cJSON.h"
+#endif
+
+#if TICOS_THREAD_SAFE
+#include <pthread.h>
+#define TICOS_THREAD_LOCAL _Thread_local
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;  // 保护内存池的归属和统计数据
+#define ticos_arena_lock() pthread_mutex_lock(&m_lock)
+#define ticos_arena_unlock() pthread_mutex_unlock(&m_lock)
+#else
+#define TICOS_THREAD_LOCAL
+#define ticos_arena_lock()
+#define ticos_arena_unlock()
+#endif
+
+#define TICOS_ARENA_ALIGN 8
+
+typedef struct {
+    unsigned char *buf;
+    size_t size;
+    int busy;           // 内存池已被某个线程的操作占用
+    ticos_arena_stats_t stats;
+} ticos_arena_t;
+
+/*
+ * 单次操作的状态按线程保存: 最外层操作开始时占用空闲的内存池, 结束时释放。
+ * 内存池被其他线程占用时本次操作改用分配器, 因此 used/last 只由占用内存池的线程修改
+ */
+typedef struct {
+    int depth;          // 操作的嵌套层数
+    int owner;          // 本线程占用了内存池
+    size_t used;
+    size_t last;        // 最近一次分配的位置, 释放最近一次分配的内存时可直接回退
+    size_t peak;
+    unsigned int allocs;
+    unsigned int fallbacks;
+} ticos_arena_op_t;
+
+#if TICOS_ARENA_SIZE > 0
+static uint64_t ticos_arena_buf[(TICOS_ARENA_SIZE + 7) / 8];
+static ticos_arena_t m_arena = { (unsigned char *)ticos_arena_buf, sizeof(ticos_arena_buf), 0, { sizeof(ticos_arena_buf) } };
+#else
+static ticos_arena_t m_arena;
+#endif
+static TICOS_THREAD_LOCAL ticos_arena_op_t m_op;
+
+#if TICOS_STATIC_MEMORY
+// 不使用堆内存, 内存池不足时分配失败
+static ticos_allocator_t m_alloc;
+#else
+static ticos_allocator_t m_alloc = { malloc, free };
+#endif
+
+static int ticos_in_arena(const void *ptr)
+{
+    return m_arena.buf && (const unsigned char *)ptr >= m_arena.buf &&
+           (const unsigned char *)ptr < m_arena.buf + m_arena.size;
+}
+
+void *ticos_malloc(size_t size)
+{
+    if (m_op.owner) {
+        size_t off = (m_op.used + TICOS_ARENA_ALIGN - 1) & ~(size_t)(TICOS_ARENA_ALIGN - 1);
+        if (off <= m_arena.size && size <= m_arena.size - off) {
+            m_op.last = off;
+            m_op.used = off + size;
+            if (m_op.used > m_op.peak)
+                m_op.peak = m_op.used;
+            m_op.allocs++;
+            return m_arena.buf + off;
+        }
+        m_op.fallbacks++;
+    } else if (m_op.depth > 0 && m_arena.buf) {
+        m_op.fallbacks++;
+    }
+    return ticos_heap_malloc(size);
+}
+
+void *ticos_heap_malloc(size_t size)
+{
+    if (!m_alloc.malloc_fn)
+        return NULL;
+    void *ptr = m_alloc.malloc_fn(size);
+    if (ptr)
+        ticos_metrics_heap(1);
+    return ptr;
+}
+
+void ticos_free(void *ptr)
+{
+    if (!ticos_in_arena(ptr)) {
+        if (ptr && m_alloc.free_fn) {
+            m_alloc.free_fn(ptr);
+            ticos_metrics_heap(-1);
+        }
+        return;
+    }
+    // 内存池中的内存在操作结束时统一释放, 只回退本线程最近一次的分配
+    if (m_op.owner && (unsigned char *)ptr == m_arena.buf + m_op.last)
+        m_op.used = m_op.last;
+}
+
+static void ticos_mem_hooks(void);
+
+void ticos_mem_begin(void)
+{
+    if (m_op.depth++ > 0)
+        return;
+    ticos_arena_lock();
+#if TICOS_ARENA_SIZE > 0
+    // 内置内存池无需用户设置, 首次使用时接管 cJSON 的内存分配
+    static int hooked = 0;
+    if (!hooked) {
+        ticos_mem_hooks();
+        hooked = 1;
+    }
+#endif
+    if (m_arena.buf && !m_arena.busy) {
+        m_arena.busy = 1;
+        m_op.owner = 1;
+    }
+    ticos_arena_unlock();
+}
+
+void ticos_mem_end(void)
+{
+    if (m_op.depth <= 0 || --m_op.depth > 0)
+        return;
+    ticos_arena_lock();
+    if (m_op.owner) {
+        if (m_op.used)
+            m_arena.stats.ops++;
+        m_arena.busy = 0;
+    }
+    if (m_op.peak > m_arena.stats.peak)
+        m_arena.stats.peak = m_op.peak;
+    m_arena.stats.allocs += m_op.allocs;
+    m_arena.stats.fallbacks += m_op.fallbacks;
+    ticos_arena_unlock();
+    memset(&m_op, 0, sizeof(m_op));
+}
+
+static void ticos_mem_hooks(void)
+{
+#if !TICOS_JSON_STREAM || !TICOS_JSON_TOKENIZER
+    cJSON_Hooks hooks = { ticos_malloc, ticos_free };
+    cJSON_InitHooks(&hooks);
+#endif
+}
+
+int ticos_set_allocator(const ticos_allocator_t *alloc)
+{
+#if TICOS_STATIC_MEMORY
+    return -1;
+#else
+    if (alloc && (!alloc->malloc_fn || !alloc->free_fn))
+        return -1;
+    m_alloc.malloc_fn = alloc ? alloc->malloc_fn : malloc;
+    m_alloc.free_fn = alloc ? alloc->free_fn : free;
+    ticos_mem_hooks();
+    return 0;
+#endif
+}
+
+int ticos_set_arena(void *buf, size_t size)
+{
+    ticos_arena_lock();
+    if (m_arena.busy || m_op.depth > 0) {
+        ticos_arena_unlock();
+        return -1;
+    }
+    // 起始地址按 TICOS_ARENA_ALIGN 对齐, 分配出的内存都是对齐的
+    size_t pad = buf ? (TICOS_ARENA_ALIGN - (uintptr_t)buf % TICOS_ARENA_ALIGN) % TICOS_ARENA_ALIGN : 0;
+    m_arena.buf = buf && size > pad ? (unsigned char *)buf + pad : NULL;
+    m_arena.size = m_arena.buf ? size - pad : 0;
+    memset(&m_arena.stats, 0, sizeof(m_arena.stats));
+    m_arena.stats.size = m_arena.size;
+    ticos_mem_hooks();
+    ticos_arena_unlock();
+    return 0;
+}
+
+void ticos_get_arena_stats(ticos_arena_stats_t *stats, int reset)
+{
+    ticos_arena_lock();
+    *stats = m_arena.stats;
+    if (reset) {
+        memset(&m_arena.stats, 0, sizeof(m_arena.stats));
+        m_arena.stats.size = m_arena.size;
+    }
+    ticos_arena_unlock();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  申请内存, 操作期间优先从内存池分配
+ * @return 内存指针, 失败时返回 NULL
+ */
+void *ticos_malloc(size_t size);
+
+/**
+ * @brief  从分配器申请内存, 不使用内存池, 用于操作结束后仍需保留的数据
+ * @return 内存指针, 失败时返回 NULL; 开启 TICOS_STATIC_MEMORY 时总是返回 NULL
+ */
+void *ticos_heap_malloc(size_t size);
+
+/**
+ * @brief  释放 ticos_malloc() 或 ticos_heap_malloc() 申请的内存
+ * @return void
+ */
+void ticos_free(void *ptr);
+
+/**
+ * @brief  开始一次上报或下发处理操作, 可以嵌套
+ * @return void
+ */
+void ticos_mem_begin(void);
+
+/**
+ * @brief  结束操作, 最外层的操作结束时整体释放内存池
+ * @return void
+ */
+void ticos_mem_end(void);
+
+#ifdef __cplusplus
+}
+#endif
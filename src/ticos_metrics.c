@@ -0,0 +1,318 @@
+#include "ticos_metrics.h"
+#include "ticos_client.h"
+#include "ticos_command.h"
+#include "ticos_config.h"
+#include "ticos_json_writer.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_time.h"
+#include "ticos_trace.h"
+#include <string.h>
+
+#if TICOS_METRICS
+
+#include <stdatomic.h>
+
+/*
+ * 统计在多个线程中更新(发送线程、MQTT 接收线程、命令工作线程), 每项都是独立的 relaxed 原子变量,
+ * 更新时只做一次原子加法或比较交换, 不加锁也不申请内存
+ */
+typedef struct {
+    atomic_uint msgs;
+    atomic_uint bytes;
+    atomic_uint errors;
+} ticos_traffic_counter_t;
+
+typedef struct {
+    atomic_uint count;
+    atomic_uint total_us;
+    atomic_uint max_us;
+    atomic_uint buckets[TICOS_METRIC_BUCKETS];
+} ticos_hist_counter_t;
+
+static ticos_traffic_counter_t m_traffic[TICOS_METRIC_TOPIC_MAX];
+static ticos_hist_counter_t m_latency[TICOS_METRIC_STAGE_MAX];
+static atomic_uint m_counters[TICOS_METRIC_COUNTER_MAX];
+static atomic_uint m_queue_peak[TICOS_METRIC_QUEUE_MAX];
+static atomic_int m_heap_blocks;
+static atomic_uint m_heap_peak;
+
+// 自动上报只在调用 ticos_report_poll() 的线程中处理
+static int m_report_ms = TICOS_METRICS_REPORT_MS;
+static int64_t m_report_next = 0;   // 下一次自动上报的时间, 0 表示尚未开始计时
+
+static void ticos_metrics_add(atomic_uint *c, unsigned int v)
+{
+    atomic_fetch_add_explicit(c, v, memory_order_relaxed);
+}
+
+static void ticos_metrics_max(atomic_uint *c, unsigned int v)
+{
+    unsigned int cur = atomic_load_explicit(c, memory_order_relaxed);
+
+    while (v > cur && !atomic_compare_exchange_weak_explicit(c, &cur, v, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+static unsigned int ticos_metrics_read(atomic_uint *c, int reset)
+{
+    if (reset)
+        return atomic_exchange_explicit(c, 0, memory_order_relaxed);
+    return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+uint32_t ticos_metrics_clock(void)
+{
+    return (uint32_t)ticos_uptime_us();
+}
+
+void ticos_metrics_latency(ticos_metric_stage_t stage, uint32_t start)
+{
+    ticos_hist_counter_t *h = &m_latency[stage];
+    uint32_t us = ticos_metrics_clock() - start;
+    int b = 0;
+
+    for (uint32_t v = us >> 1; v && b < TICOS_METRIC_BUCKETS - 1; v >>= 1)
+        b++;
+    ticos_metrics_add(&h->count, 1);
+    ticos_metrics_add(&h->total_us, us);
+    ticos_metrics_max(&h->max_us, us);
+    ticos_metrics_add(&h->buckets[b], 1);
+}
+
+void ticos_metrics_traffic(ticos_metric_topic_t topic, int len, int failed)
+{
+    ticos_traffic_counter_t *t = &m_traffic[topic];
+
+    ticos_metrics_add(&t->msgs, 1);
+    ticos_metrics_add(&t->bytes, len > 0 ? len : 0);
+    if (failed)
+        ticos_metrics_add(&t->errors, 1);
+}
+
+int ticos_metrics_publish(ticos_metric_topic_t topic, const char *t, const char *data, int len, int qos, int retain)
+{
+    uint32_t start = ticos_metrics_clock();
+    TICOS_TRACE_BEGIN(TICOS_TRACE_PUBLISH, len);
+    int ret = ticos_publish(t, data, len, qos, retain);
+    TICOS_TRACE_END(TICOS_TRACE_PUBLISH);
+
+    ticos_metrics_latency(TICOS_METRIC_PUBLISH, start);
+    ticos_metrics_traffic(topic, len, ret < 0);
+    return ret;
+}
+
+void ticos_metrics_count(ticos_metric_counter_t counter)
+{
+    ticos_metrics_add(&m_counters[counter], 1);
+}
+
+void ticos_metrics_queue(ticos_metric_queue_t queue, unsigned int depth)
+{
+    ticos_metrics_max(&m_queue_peak[queue], depth);
+}
+
+void ticos_metrics_heap(int delta)
+{
+    int blocks = atomic_fetch_add_explicit(&m_heap_blocks, delta, memory_order_relaxed) + delta;
+
+    if (blocks > 0)
+        ticos_metrics_max(&m_heap_peak, blocks);
+}
+
+int ticos_get_metrics(ticos_metrics_t *metrics, int reset)
+{
+    ticos_arena_stats_t arena;
+    int blocks = atomic_load_explicit(&m_heap_blocks, memory_order_relaxed);
+
+    memset(metrics, 0, sizeof(*metrics));
+    for (int i = 0; i < TICOS_METRIC_TOPIC_MAX; i++) {
+        metrics->traffic[i].msgs = ticos_metrics_read(&m_traffic[i].msgs, reset);
+        metrics->traffic[i].bytes = ticos_metrics_read(&m_traffic[i].bytes, reset);
+        metrics->traffic[i].errors = ticos_metrics_read(&m_traffic[i].errors, reset);
+    }
+    for (int i = 0; i < TICOS_METRIC_STAGE_MAX; i++) {
+        metrics->latency[i].count = ticos_metrics_read(&m_latency[i].count, reset);
+        metrics->latency[i].total_us = ticos_metrics_read(&m_latency[i].total_us, reset);
+        metrics->latency[i].max_us = ticos_metrics_read(&m_latency[i].max_us, reset);
+        for (int b = 0; b < TICOS_METRIC_BUCKETS; b++)
+            metrics->latency[i].buckets[b] = ticos_metrics_read(&m_latency[i].buckets[b], reset);
+    }
+    metrics->send_queue = ticos_send_pending();
+    metrics->send_queue_peak = ticos_metrics_read(&m_queue_peak[TICOS_METRIC_SEND_QUEUE], reset);
+    metrics->send_full = ticos_metrics_read(&m_counters[TICOS_METRIC_SEND_FULL], reset);
+    metrics->command_queue = ticos_command_pending();
+    metrics->command_queue_peak = ticos_metrics_read(&m_queue_peak[TICOS_METRIC_COMMAND_QUEUE], reset);
+    metrics->command_rejected = ticos_metrics_read(&m_counters[TICOS_METRIC_COMMAND_REJECTED], reset);
+    metrics->offline_pending = ticos_offline_pending();
+    metrics->rejected_keys = ticos_metrics_read(&m_counters[TICOS_METRIC_REJECTED_KEY], reset);
+    metrics->heap_blocks = blocks > 0 ? blocks : 0;
+    metrics->heap_blocks_peak = ticos_metrics_read(&m_heap_peak, reset);
+    ticos_get_arena_stats(&arena, 0);
+    metrics->arena_peak = arena.peak;
+    return 0;
+}
+
+// 直方图中累计达到 pct% 样本的桶的上界(微秒), 不超过最大耗时
+static unsigned int ticos_metrics_percentile(const ticos_metric_hist_t *h, int pct)
+{
+    unsigned int need = (unsigned int)(((uint64_t)h->count * pct + 99) / 100);
+    unsigned int sum = 0;
+
+    for (int b = 0; b < TICOS_METRIC_BUCKETS - 1; b++) {
+        sum += h->buckets[b];
+        if (sum >= need)
+            return (2u << b) < h->max_us ? 2u << b : h->max_us;
+    }
+    return h->max_us;
+}
+
+static const char *const m_topic_names[TICOS_METRIC_TOPIC_MAX] = {
+    "property", "telemetry", "response", "desired", "command",
+};
+
+static const char *const m_stage_names[TICOS_METRIC_STAGE_MAX] = {
+    "serialize", "parse", "publish",
+};
+
+/*
+ * 上报格式: {"$metrics":{"uptime":秒,"property":{"msgs":..,"bytes":..,"errors":..},...,
+ *           "serialize":{"count":..,"avg_us":..,"p99_us":..,"max_us":..},...,"send_queue":..,...}}
+ */
+static int ticos_metrics_report(void)
+{
+    ticos_client_t *client = ticos_client_default();
+    ticos_metrics_t m;
+    ticos_json_writer_t w;
+    int size;
+    char *buf = ticos_report_buffer(&size);
+
+    if (!client->started)
+        client = ticos_client_list();
+    if (!client)
+        return -1;
+    ticos_get_metrics(&m, 0);
+    ticos_json_writer_init(&w, buf, size);
+    ticos_json_object_begin(&w);
+    ticos_json_key(&w, "$metrics");
+    ticos_json_object_begin(&w);
+    ticos_json_add_int(&w, "uptime", ticos_uptime_ms() / 1000);
+    for (int i = 0; i < TICOS_METRIC_TOPIC_MAX; i++) {
+        ticos_json_key(&w, m_topic_names[i]);
+        ticos_json_object_begin(&w);
+        ticos_json_add_int(&w, "msgs", m.traffic[i].msgs);
+        ticos_json_add_int(&w, "bytes", m.traffic[i].bytes);
+        ticos_json_add_int(&w, "errors", m.traffic[i].errors);
+        ticos_json_object_end(&w);
+    }
+    for (int i = 0; i < TICOS_METRIC_STAGE_MAX; i++) {
+        const ticos_metric_hist_t *h = &m.latency[i];
+        ticos_json_key(&w, m_stage_names[i]);
+        ticos_json_object_begin(&w);
+        ticos_json_add_int(&w, "count", h->count);
+        ticos_json_add_int(&w, "avg_us", h->count ? h->total_us / h->count : 0);
+        ticos_json_add_int(&w, "p99_us", h->count ? ticos_metrics_percentile(h, 99) : 0);
+        ticos_json_add_int(&w, "max_us", h->max_us);
+        ticos_json_object_end(&w);
+    }
+    ticos_json_add_int(&w, "send_queue", m.send_queue);
+    ticos_json_add_int(&w, "send_queue_peak", m.send_queue_peak);
+    ticos_json_add_int(&w, "send_full", m.send_full);
+    ticos_json_add_int(&w, "command_queue", m.command_queue);
+    ticos_json_add_int(&w, "command_queue_peak", m.command_queue_peak);
+    ticos_json_add_int(&w, "command_rejected", m.command_rejected);
+    ticos_json_add_int(&w, "offline_pending", m.offline_pending);
+    ticos_json_add_int(&w, "rejected_keys", m.rejected_keys);
+    ticos_json_add_int(&w, "heap_blocks_peak", m.heap_blocks_peak);
+    ticos_json_add_int(&w, "arena_peak", m.arena_peak);
+    ticos_json_object_end(&w);
+    ticos_json_object_end(&w);
+    int len = ticos_json_writer_finish(&w);
+    if (len < 0)
+        return -1;
+    return ticos_metrics_publish(TICOS_METRIC_TELEMETRY, client->telemetry_topic, buf, len, 1, 0);
+}
+
+int ticos_metrics_set_report(int interval_ms)
+{
+    if (interval_ms < 0)
+        return -1;
+    m_report_ms = interval_ms;
+    m_report_next = 0;
+    ticos_sender_notify();
+    return 0;
+}
+
+int ticos_metrics_poll(int64_t now)
+{
+    if (!m_report_ms)
+        return 0;
+    if (!m_report_next)
+        m_report_next = now + m_report_ms;
+    if (now < m_report_next)
+        return 0;
+    m_report_next = now + m_report_ms;
+    return ticos_metrics_report() < 0 ? 0 : 1;
+}
+
+int ticos_metrics_next_ms(int64_t now)
+{
+    if (!m_report_ms)
+        return -1;
+    if (!m_report_next)
+        m_report_next = now + m_report_ms;
+    return m_report_next > now ? (int)(m_report_next - now) : 0;
+}
+#else
+uint32_t ticos_metrics_clock(void)
+{
+    return 0;
+}
+
+void ticos_metrics_latency(ticos_metric_stage_t stage, uint32_t start)
+{
+}
+
+void ticos_metrics_traffic(ticos_metric_topic_t topic, int len, int failed)
+{
+}
+
+int ticos_metrics_publish(ticos_metric_topic_t topic, const char *t, const char *data, int len, int qos, int retain)
+{
+    TICOS_TRACE_BEGIN(TICOS_TRACE_PUBLISH, len);
+    int ret = ticos_publish(t, data, len, qos, retain);
+    TICOS_TRACE_END(TICOS_TRACE_PUBLISH);
+    return ret;
+}
+
+void ticos_metrics_count(ticos_metric_counter_t counter)
+{
+}
+
+void ticos_metrics_queue(ticos_metric_queue_t queue, unsigned int depth)
+{
+}
+
+void ticos_metrics_heap(int delta)
+{
+}
+
+int ticos_get_metrics(ticos_metrics_t *metrics, int reset)
+{
+    return -1;
+}
+
+int ticos_metrics_set_report(int interval_ms)
+{
+    return -1;
+}
+
+int ticos_metrics_poll(int64_t now)
+{
+    return 0;
+}
+
+int ticos_metrics_next_ms(int64_t now)
+{
+    return -1;
+}
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+#include "ticos_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 运行统计中的事件计数
+ */
+typedef enum {
+    TICOS_METRIC_SEND_FULL,         // 发送队列已满
+    TICOS_METRIC_COMMAND_REJECTED,  // 命令被拒绝
+    TICOS_METRIC_REJECTED_KEY,      // 下发数据中被忽略的字段
+    TICOS_METRIC_COUNTER_MAX,
+} ticos_metric_counter_t;
+
+/**
+ * 运行统计中记录深度最大值的队列
+ */
+typedef enum {
+    TICOS_METRIC_SEND_QUEUE,
+    TICOS_METRIC_COMMAND_QUEUE,
+    TICOS_METRIC_QUEUE_MAX,
+} ticos_metric_queue_t;
+
+/**
+ * @brief  获取计时起点
+ * @return 微秒时间的低 32 位, 未开启 TICOS_METRICS 时返回 0
+ */
+uint32_t ticos_metrics_clock(void);
+
+/**
+ * @brief  记录一个环节从 start 到现在的耗时
+ * @param start ticos_metrics_clock() 的返回值
+ * @return void
+ */
+void ticos_metrics_latency(ticos_metric_stage_t stage, uint32_t start);
+
+/**
+ * @brief  记录一条收到或发出的消息
+ * @param len 消息的字节数
+ * @param failed 非 0 时计为失败或被丢弃的消息
+ * @return void
+ */
+void ticos_metrics_traffic(ticos_metric_topic_t topic, int len, int failed);
+
+/**
+ * @brief  以 ticos_publish() 发布一条消息, 并记录其耗时、条数和字节数
+ * @return ticos_publish() 的返回值
+ */
+int ticos_metrics_publish(ticos_metric_topic_t topic, const char *t, const char *data, int len, int qos, int retain);
+
+/**
+ * @brief  事件计数加一
+ * @return void
+ */
+void ticos_metrics_count(ticos_metric_counter_t counter);
+
+/**
+ * @brief  入队后记录队列的当前深度, 用于统计最大值
+ * @return void
+ */
+void ticos_metrics_queue(ticos_metric_queue_t queue, unsigned int depth);
+
+/**
+ * @brief  从分配器申请或释放内存块后更新尚未释放的块数
+ * @param delta 申请时为 1, 释放时为 -1
+ * @return void
+ */
+void ticos_metrics_heap(int delta);
+
+/**
+ * @brief  自动上报周期到期时上报一次运行统计
+ * @param now 当前的 ticos_uptime_ms()
+ * @return 上报的消息数
+ */
+int ticos_metrics_poll(int64_t now);
+
+/**
+ * @brief  计算距离下一次自动上报运行统计的时间
+ * @param now 当前的 ticos_uptime_ms()
+ * @return 需要等待的毫秒数, -1 代表未开启自动上报
+ */
+int ticos_metrics_next_ms(int64_t now);
+
+#ifdef __cplusplus
+}
+#endif
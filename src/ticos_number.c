@@ -0,0 +1,548 @@
+#include "ticos_number.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char m_digits[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int ticos_itoa(int64_t val, char *buf)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    uint64_t u = val < 0 ? 0 - (uint64_t)val : (uint64_t)val;
+
+    // 超出 32 位的部分才使用 64 位除法, 32 位 MCU 上 64 位除法需要调用库函数
+    while (u > UINT32_MAX) {
+        unsigned r = (unsigned)(u % 100);
+        u /= 100;
+        p -= 2;
+        memcpy(p, m_digits + r * 2, 2);
+    }
+    uint32_t v = (uint32_t)u;
+    while (v >= 100) {
+        unsigned r = v % 100;
+        v /= 100;
+        p -= 2;
+        memcpy(p, m_digits + r * 2, 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, m_digits + v * 2, 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+    if (val < 0)
+        *--p = '-';
+
+    int n = (int)(tmp + sizeof(tmp) - p);
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return n;
+}
+
+/*
+ * 最短浮点数输出使用 Grisu2 算法(Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers", PLDI 2010): 在值的舍入区间内以 64 位整数运算生成尽量短的十进制数字, 结果总能精确还原原值,
+ * 只有极少数最短表示紧靠区间边界的值(如 1e23)输出比最短表示长
+ */
+typedef struct {
+    uint64_t f;
+    int e;
+} ticos_diyfp_t;
+
+static ticos_diyfp_t ticos_diyfp(uint64_t f, int e)
+{
+    ticos_diyfp_t x = { f, e };
+    return x;
+}
+
+// 64 位乘 64 位取高 64 位, 按低 64 位四舍五入
+static ticos_diyfp_t ticos_diyfp_mul(ticos_diyfp_t x, ticos_diyfp_t y)
+{
+    uint64_t u_lo = x.f & 0xFFFFFFFFu, u_hi = x.f >> 32;
+    uint64_t v_lo = y.f & 0xFFFFFFFFu, v_hi = y.f >> 32;
+    uint64_t p0 = u_lo * v_lo;
+    uint64_t p1 = u_lo * v_hi;
+    uint64_t p2 = u_hi * v_lo;
+    uint64_t p3 = u_hi * v_hi;
+    uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu) + (1u << 31);
+    return ticos_diyfp(p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32), x.e + y.e + 64);
+}
+
+static ticos_diyfp_t ticos_diyfp_normalize(ticos_diyfp_t x)
+{
+    while (!(x.f >> 63)) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/*
+ * 计算值 v 及其舍入区间的上下边界, 区间内的任何数都会被解析回 v; 区间按值本身的精度计算,
+ * 因此 float 值可以得到比提升为 double 后更短的输出
+ * bits 为值的 IEEE 754 表示, prec 为含隐含位的尾数位数, bias 为指数偏移加尾数位数
+ */
+typedef struct {
+    ticos_diyfp_t w;
+    ticos_diyfp_t minus;
+    ticos_diyfp_t plus;
+} ticos_boundaries_t;
+
+static ticos_boundaries_t ticos_boundaries(uint64_t bits, int prec, int bias)
+{
+    ticos_boundaries_t b;
+    uint64_t hidden = (uint64_t)1 << (prec - 1);
+    uint64_t frac = bits & (hidden - 1);
+    int exp = (int)(bits >> (prec - 1));
+    ticos_diyfp_t v = exp ? ticos_diyfp(frac + hidden, exp - bias) : ticos_diyfp(frac, 1 - bias);
+
+    // 尾数为 0 时下一个更小的值的间距只有一半, 下边界离 v 更近
+    int lower_closer = !frac && exp > 1;
+    ticos_diyfp_t plus = ticos_diyfp(2 * v.f + 1, v.e - 1);
+    ticos_diyfp_t minus = lower_closer ? ticos_diyfp(4 * v.f - 1, v.e - 2) : ticos_diyfp(2 * v.f - 1, v.e - 1);
+
+    b.plus = ticos_diyfp_normalize(plus);
+    b.minus = ticos_diyfp(minus.f << (minus.e - b.plus.e), b.plus.e);
+    b.w = ticos_diyfp_normalize(v);
+    return b;
+}
+
+/*
+ * 10 的幂的 64 位近似值, 十进制指数从 -300 起每隔 8 取一个, 足以覆盖 double 的范围
+ */
+typedef struct {
+    uint64_t f;
+    int e;
+    int k;
+} ticos_cached_power_t;
+
+#define TICOS_CACHED_POWERS_MIN_DEC_EXP (-300)
+#define TICOS_CACHED_POWERS_DEC_STEP    8
+
+static const ticos_cached_power_t m_cached_powers[] = {
+    { 0xAB70FE17C79AC6CA, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+    { 0xBE5691EF416BD60C, -1007, -284 },
+    { 0x8DD01FAD907FFC3C,  -980, -276 },
+    { 0xD3515C2831559A83,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5,  -927, -260 },
+    { 0xEA9C227723EE8BCB,  -901, -252 },
+    { 0xAECC49914078536D,  -874, -244 },
+    { 0x823C12795DB6CE57,  -847, -236 },
+    { 0xC21094364DFB5637,  -821, -228 },
+    { 0x9096EA6F3848984F,  -794, -220 },
+    { 0xD77485CB25823AC7,  -768, -212 },
+    { 0xA086CFCD97BF97F4,  -741, -204 },
+    { 0xEF340A98172AACE5,  -715, -196 },
+    { 0xB23867FB2A35B28E,  -688, -188 },
+    { 0x84C8D4DFD2C63F3B,  -661, -180 },
+    { 0xC5DD44271AD3CDBA,  -635, -172 },
+    { 0x936B9FCEBB25C996,  -608, -164 },
+    { 0xDBAC6C247D62A584,  -582, -156 },
+    { 0xA3AB66580D5FDAF6,  -555, -148 },
+    { 0xF3E2F893DEC3F126,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+    { 0x87625F056C7C4A8B,  -475, -124 },
+    { 0xC9BCFF6034C13053,  -449, -116 },
+    { 0x964E858C91BA2655,  -422, -108 },
+    { 0xDFF9772470297EBD,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+    { 0xF8A95FCF88747D94,  -343,  -84 },
+    { 0xB94470938FA89BCF,  -316,  -76 },
+    { 0x8A08F0F8BF0F156B,  -289,  -68 },
+    { 0xCDB02555653131B6,  -263,  -60 },
+    { 0x993FE2C6D07B7FAC,  -236,  -52 },
+    { 0xE45C10C42A2B3B06,  -210,  -44 },
+    { 0xAA242499697392D3,  -183,  -36 },
+    { 0xFD87B5F28300CA0E,  -157,  -28 },
+    { 0xBCE5086492111AEB,  -130,  -20 },
+    { 0x8CBCCC096F5088CC,  -103,  -12 },
+    { 0xD1B71758E219652C,   -77,   -4 },
+    { 0x9C40000000000000,   -50,    4 },
+    { 0xE8D4A51000000000,   -24,   12 },
+    { 0xAD78EBC5AC620000,     3,   20 },
+    { 0x813F3978F8940984,    30,   28 },
+    { 0xC097CE7BC90715B3,    56,   36 },
+    { 0x8F7E32CE7BEA5C70,    83,   44 },
+    { 0xD5D238A4ABE98068,   109,   52 },
+    { 0x9F4F2726179A2245,   136,   60 },
+    { 0xED63A231D4C4FB27,   162,   68 },
+    { 0xB0DE65388CC8ADA8,   189,   76 },
+    { 0x83C7088E1AAB65DB,   216,   84 },
+    { 0xC45D1DF942711D9A,   242,   92 },
+    { 0x924D692CA61BE758,   269,  100 },
+    { 0xDA01EE641A708DEA,   295,  108 },
+    { 0xA26DA3999AEF774A,   322,  116 },
+    { 0xF209787BB47D6B85,   348,  124 },
+    { 0xB454E4A179DD1877,   375,  132 },
+    { 0x865B86925B9BC5C2,   402,  140 },
+    { 0xC83553C5C8965D3D,   428,  148 },
+    { 0x952AB45CFA97A0B3,   455,  156 },
+    { 0xDE469FBD99A05FE3,   481,  164 },
+    { 0xA59BC234DB398C25,   508,  172 },
+    { 0xF6C69A72A3989F5C,   534,  180 },
+    { 0xB7DCBF5354E9BECE,   561,  188 },
+    { 0x88FCF317F22241E2,   588,  196 },
+    { 0xCC20CE9BD35C78A5,   614,  204 },
+    { 0x98165AF37B2153DF,   641,  212 },
+    { 0xE2A0B5DC971F303A,   667,  220 },
+    { 0xA8D9D1535CE3B396,   694,  228 },
+    { 0xFB9B7CD9A4A7443C,   720,  236 },
+    { 0xBB764C4CA7A44410,   747,  244 },
+    { 0x8BAB8EEFB6409C1A,   774,  252 },
+    { 0xD01FEF10A657842C,   800,  260 },
+    { 0x9B10A4E5E9913129,   827,  268 },
+    { 0xE7109BFBA19C0C9D,   853,  276 },
+    { 0xAC2820D9623BF429,   880,  284 },
+    { 0x80444B5E7AA7CF85,   907,  292 },
+    { 0xBF21E44003ACDD2D,   933,  300 },
+    { 0x8E679C2F5E44FF8F,   960,  308 },
+    { 0xD433179D9C8CB841,   986,  316 },
+    { 0x9E19DB92B4E31BA9,  1013,  324 },
+};
+
+// 乘以缓存的 10 的幂后, 二进制指数落在 [-60, -32] 区间, 整数部分可放入 32 位
+#define TICOS_GRISU_ALPHA   (-60)
+
+static ticos_cached_power_t ticos_cached_power(int e)
+{
+    int f = TICOS_GRISU_ALPHA - e - 1;
+    // 78913 / 2^18 为 log10(2) 的近似值
+    int k = (f * 78913) / (1 << 18) + (f > 0);
+    int index = (-TICOS_CACHED_POWERS_MIN_DEC_EXP + k + (TICOS_CACHED_POWERS_DEC_STEP - 1)) / TICOS_CACHED_POWERS_DEC_STEP;
+    return m_cached_powers[index];
+}
+
+static int ticos_pow10_floor(uint32_t n, uint32_t *pow10)
+{
+    static const uint32_t pows[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    int k = 9;
+
+    while (k > 0 && n < pows[k])
+        k--;
+    *pow10 = pows[k];
+    return k + 1;
+}
+
+// 在不超出舍入区间的前提下, 将最后一位数字向 w 靠近
+static void ticos_grisu_round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k)
+{
+    while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        buf[len - 1]--;
+        rest += ten_k;
+    }
+}
+
+/*
+ * 生成十进制数字, 值为 buf * 10^exp10, 返回数字个数
+ */
+static int ticos_grisu2(char *buf, int *exp10, ticos_boundaries_t b)
+{
+    ticos_cached_power_t cached = ticos_cached_power(b.plus.e);
+    ticos_diyfp_t c = ticos_diyfp(cached.f, cached.e);
+    ticos_diyfp_t w = ticos_diyfp_mul(b.w, c);
+    ticos_diyfp_t w_minus = ticos_diyfp_mul(b.minus, c);
+    ticos_diyfp_t w_plus = ticos_diyfp_mul(b.plus, c);
+    int len = 0;
+
+    // 乘法有最多 1 ulp 的误差, 向内收缩区间以保证输出落在真实的舍入区间内
+    w_minus.f++;
+    w_plus.f--;
+    *exp10 = -cached.k;
+
+    uint64_t delta = w_plus.f - w_minus.f;
+    uint64_t dist = w_plus.f - w.f;
+    int shift = -w_plus.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint32_t p1 = (uint32_t)(w_plus.f >> shift);
+    uint64_t p2 = w_plus.f & (one - 1);
+    uint32_t pow10;
+    int n = ticos_pow10_floor(p1, &pow10);
+
+    // 整数部分
+    while (n > 0) {
+        buf[len++] = (char)('0' + p1 / pow10);
+        p1 %= pow10;
+        n--;
+        uint64_t rest = ((uint64_t)p1 << shift) + p2;
+        if (rest <= delta) {
+            *exp10 += n;
+            ticos_grisu_round(buf, len, dist, delta, rest, (uint64_t)pow10 << shift);
+            return len;
+        }
+        pow10 /= 10;
+    }
+    // 小数部分
+    int m = 0;
+    for (;;) {
+        p2 *= 10;
+        buf[len++] = (char)('0' + (p2 >> shift));
+        p2 &= one - 1;
+        m++;
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta)
+            break;
+    }
+    *exp10 -= m;
+    ticos_grisu_round(buf, len, dist, delta, p2, one);
+    return len;
+}
+
+/*
+ * 将数字串 digits * 10^exp10 格式化为与 printf("%g") 相近的形式:
+ * 小数点位置在 (-4, 15] 之间时使用定点表示, 否则使用 "d.ddde+XX" 形式
+ */
+static int ticos_number_format(char *buf, int len, int exp10)
+{
+    int n = len + exp10;    // 小数点的位置
+
+    if (len <= n && n <= 15) {
+        memset(buf + len, '0', n - len);
+        return n;
+    }
+    if (0 < n && n <= 15) {
+        memmove(buf + n + 1, buf + n, len - n);
+        buf[n] = '.';
+        return len + 1;
+    }
+    if (-4 < n && n <= 0) {
+        memmove(buf + 2 - n, buf, len);
+        buf[0] = '0';
+        buf[1] = '.';
+        memset(buf + 2, '0', -n);
+        return 2 - n + len;
+    }
+
+    int pos = 1;
+    if (len > 1) {
+        memmove(buf + 2, buf + 1, len - 1);
+        buf[1] = '.';
+        pos = len + 1;
+    }
+    int e = n - 1;
+    buf[pos++] = 'e';
+    buf[pos++] = e < 0 ? '-' : '+';
+    if (e < 0)
+        e = -e;
+    if (e >= 100) {
+        buf[pos++] = (char)('0' + e / 100);
+        e %= 100;
+    }
+    memcpy(buf + pos, m_digits + e * 2, 2);
+    return pos + 2;
+}
+
+// 2^53 以内的整数值可以精确转换为 int64_t
+#define TICOS_EXACT_INT_MAX 9007199254740992.0
+
+int ticos_dtoa(double val, char *buf)
+{
+    uint64_t bits;
+    int exp10;
+    int pos = 0;
+
+    if (val > -TICOS_EXACT_INT_MAX && val < TICOS_EXACT_INT_MAX && val == (double)(int64_t)val)
+        return ticos_itoa((int64_t)val, buf);
+    memcpy(&bits, &val, sizeof(bits));
+    if (bits >> 63) {
+        buf[pos++] = '-';
+        bits &= ~((uint64_t)1 << 63);
+    }
+    int len = ticos_grisu2(buf + pos, &exp10, ticos_boundaries(bits, DBL_MANT_DIG, DBL_MAX_EXP - 1 + DBL_MANT_DIG - 1));
+    pos += ticos_number_format(buf + pos, len, exp10);
+    buf[pos] = '\0';
+    return pos;
+}
+
+int ticos_ftoa(float val, char *buf)
+{
+    uint32_t bits;
+    int exp10;
+    int pos = 0;
+
+    // 2^24 以上的 float 都是整数, 只需判断 int32_t 范围内的值
+    if (val > -2147483648.0f && val < 2147483648.0f && val == (float)(int32_t)val)
+        return ticos_itoa((int32_t)val, buf);
+    memcpy(&bits, &val, sizeof(bits));
+    if (bits >> 31) {
+        buf[pos++] = '-';
+        bits &= ~((uint32_t)1 << 31);
+    }
+    int len = ticos_grisu2(buf + pos, &exp10, ticos_boundaries(bits, FLT_MANT_DIG, FLT_MAX_EXP - 1 + FLT_MANT_DIG - 1));
+    pos += ticos_number_format(buf + pos, len, exp10);
+    buf[pos] = '\0';
+    return pos;
+}
+
+int ticos_atoi(const char *s, int len, int64_t *val)
+{
+    const char *end = s + len;
+    int neg = s < end && *s == '-';
+    uint64_t u = 0;
+
+    s += neg;
+    if (s == end)
+        return -1;
+    for (; s < end; s++) {
+        unsigned d = (unsigned)(*s - '0');
+        if (d > 9 || u > (UINT64_MAX - d) / 10)
+            return -1;
+        u = u * 10 + d;
+    }
+    if (u > (uint64_t)INT64_MAX + neg)
+        return -1;
+    *val = neg ? (int64_t)(0 - u) : (int64_t)u;
+    return 0;
+}
+
+/*
+ * 拆分 JSON 数值文本: 值为 (neg ? -1 : 1) * mant * 10^exp10
+ * 有效数字超过 19 位或格式不符时返回 -1, 由调用者交给 strtod()/strtof() 处理
+ */
+static int ticos_number_split(const char *s, int len, int *neg, uint64_t *mant, int *exp10)
+{
+    const char *end = s + len;
+    uint64_t m = 0;
+    int digits = 0;
+    int frac = 0;
+    int e = 0;
+
+    *neg = s < end && *s == '-';
+    s += *neg;
+    for (; s < end && *s >= '0' && *s <= '9'; s++, digits++)
+        m = m * 10 + (unsigned)(*s - '0');
+    if (s < end && *s == '.') {
+        for (s++; s < end && *s >= '0' && *s <= '9'; s++, frac++)
+            m = m * 10 + (unsigned)(*s - '0');
+        if (!frac)
+            return -1;
+    }
+    if (!digits || digits + frac > 19)
+        return -1;
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        int eneg = 0, edigits = 0;
+        s++;
+        if (s < end && (*s == '+' || *s == '-'))
+            eneg = *s++ == '-';
+        for (; s < end && *s >= '0' && *s <= '9' && edigits < 4; s++, edigits++)
+            e = e * 10 + (*s - '0');
+        if (!edigits)
+            return -1;
+        if (eneg)
+            e = -e;
+    }
+    if (s != end)
+        return -1;
+    *mant = m;
+    *exp10 = e - frac;
+    return 0;
+}
+
+// 慢速路径可解析的最大文本长度
+#define TICOS_NUMBER_PARSE_MAX  64
+
+// 按 JSON 数值的语法检查文本, C 库还接受的 "inf"、"nan"、十六进制、前导空白等形式都视为格式错误
+static int ticos_number_valid(const char *s, int len)
+{
+    const char *end = s + len;
+    const char *p;
+
+    s += s < end && *s == '-';
+    for (p = s; s < end && *s >= '0' && *s <= '9'; s++)
+        ;
+    if (s == p)
+        return 0;
+    if (s < end && *s == '.') {
+        for (p = ++s; s < end && *s >= '0' && *s <= '9'; s++)
+            ;
+        if (s == p)
+            return 0;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        s += s < end && (*s == '+' || *s == '-');
+        for (p = s; s < end && *s >= '0' && *s <= '9'; s++)
+            ;
+        if (s == p)
+            return 0;
+    }
+    return s == end;
+}
+
+// 慢速路径: 复制到以 '\0' 结尾的缓冲区后由 C 库解析, 要求整个文本都是数值
+static int ticos_number_copy(const char *s, int len, char *num, int size)
+{
+    if (len <= 0 || len >= size || !ticos_number_valid(s, len))
+        return -1;
+    memcpy(num, s, len);
+    num[len] = '\0';
+    return 0;
+}
+
+/*
+ * 快速路径(Clinger): 尾数和 10 的幂都能精确表示时, 一次乘法或除法的结果就是正确舍入的值;
+ * 需要浮点运算按声明的类型精度进行, 否则中间结果可能被两次舍入
+ */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define TICOS_NUMBER_FAST_PATH 1
+#else
+#define TICOS_NUMBER_FAST_PATH 0
+#endif
+
+int ticos_atod(const char *s, int len, double *val)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    char num[TICOS_NUMBER_PARSE_MAX];
+    char *endp;
+    uint64_t mant;
+    int neg, exp10;
+
+    if (TICOS_NUMBER_FAST_PATH && !ticos_number_split(s, len, &neg, &mant, &exp10) &&
+        mant <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22) {
+        double d = (double)mant;
+        d = exp10 < 0 ? d / pow10[-exp10] : d * pow10[exp10];
+        *val = neg ? -d : d;
+        return 0;
+    }
+    if (ticos_number_copy(s, len, num, sizeof(num)))
+        return -1;
+    *val = strtod(num, &endp);
+    return endp == num + len ? 0 : -1;
+}
+
+int ticos_atof(const char *s, int len, float *val)
+{
+    static const float pow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    char num[TICOS_NUMBER_PARSE_MAX];
+    char *endp;
+    uint64_t mant;
+    int neg, exp10;
+
+    if (TICOS_NUMBER_FAST_PATH && !ticos_number_split(s, len, &neg, &mant, &exp10) &&
+        mant <= ((uint64_t)1 << 24) && exp10 >= -10 && exp10 <= 10) {
+        float f = (float)mant;
+        f = exp10 < 0 ? f / pow10[-exp10] : f * pow10[exp10];
+        *val = neg ? -f : f;
+        return 0;
+    }
+    if (ticos_number_copy(s, len, num, sizeof(num)))
+        return -1;
+    *val = strtof(num, &endp);
+    return endp == num + len ? 0 : -1;
+}
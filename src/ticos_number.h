@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** 数值文本的最大长度(字节, 含结尾的 '\0') */
+#define TICOS_NUMBER_MAX    32
+
+/**
+ * @brief  输出整数的十进制文本
+ * @param buf 输出缓冲区, 至少 TICOS_NUMBER_MAX 字节, 输出以 '\0' 结尾
+ * @return 文本长度
+ */
+int ticos_itoa(int64_t val, char *buf);
+
+/**
+ * @brief  输出能精确还原 double 值的最短十进制文本
+ * @note   整数值按整数输出; 以 strtod() 解析输出的文本可得到原值。val 不能为 NaN 或无穷大
+ * @param buf 输出缓冲区, 至少 TICOS_NUMBER_MAX 字节, 输出以 '\0' 结尾
+ * @return 文本长度
+ */
+int ticos_dtoa(double val, char *buf);
+
+/**
+ * @brief  输出能精确还原 float 值的最短十进制文本
+ * @note   按 float 的精度取最短位数, 如 22.4f 输出为 "22.4" 而不是 "22.399999618530273";
+ *         以 strtof() 或 ticos_atof() 解析输出的文本可得到原值。val 不能为 NaN 或无穷大
+ * @param buf 输出缓冲区, 至少 TICOS_NUMBER_MAX 字节, 输出以 '\0' 结尾
+ * @return 文本长度
+ */
+int ticos_ftoa(float val, char *buf);
+
+/**
+ * @brief  解析整数文本, 不经过浮点运算
+ * @param s 文本, 不要求以 '\0' 结尾
+ * @param len 文本长度
+ * @return 0 代表成功, 文本不是 JSON 整数(带小数点或指数)或超出 int64_t 范围时返回 -1
+ */
+int ticos_atoi(const char *s, int len, int64_t *val);
+
+/**
+ * @brief  解析数值文本为 double, 结果与 strtod() 一致
+ * @note   有效数字不超过 15 位且指数较小时直接以一次浮点乘除得到正确舍入的结果, 否则交给 strtod()
+ * @param s 文本, 不要求以 '\0' 结尾
+ * @param len 文本长度
+ * @return 0 代表成功, 其他值代表格式错误
+ */
+int ticos_atod(const char *s, int len, double *val);
+
+/**
+ * @brief  解析数值文本为 float, 结果与 strtof() 一致
+ * @note   与 ticos_atod() 类似, 但快速路径使用单精度运算, 慢速路径直接舍入到 float, 不会因两次舍入产生误差
+ * @param s 文本, 不要求以 '\0' 结尾
+ * @param len 文本长度
+ * @return 0 代表成功, 其他值代表格式错误
+ */
+int ticos_atof(const char *s, int len, float *val);
+
+#ifdef __cplusplus
+}
+#endif
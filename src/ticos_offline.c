@@ -0,0 +1,370 @@
+#include "ticos_api.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_config.h"
+#include "ticos_ring.h"
+#include "ticos_time.h"
+#include <stdint.h>
+#include <string.h>
+#if TICOS_OFFLINE_LOG
+#include <stdio.h>
+#endif
+
+#if TICOS_OFFLINE_QUEUE_SIZE > 0 || TICOS_OFFLINE_LOG
+
+#define TICOS_OFFLINE_TOPIC_MAX 128
+
+/*
+ * 离线队列中的每条消息由消息头、topic 和消息内容依次拼接而成。
+ * 发送线程、命令处理线程和 HAL 事件线程都会经过这里发布消息, 队列状态只在持有上报锁时访问
+ */
+typedef struct {
+    uint8_t qos;
+    uint8_t retain;
+    uint16_t topic_len;
+} ticos_offline_hdr_t;
+
+static int m_connected = 0;
+static int m_replay_rate = TICOS_OFFLINE_REPLAY_RATE;
+static int64_t m_replay_tokens = 0;     // 令牌桶中的令牌数, 单位为千分之一条消息
+static int64_t m_replay_last = 0;
+// 重发时消息读入专用缓冲区, 避免覆盖其他线程正在上报缓冲区中编码的消息
+static char m_replay_buf[TICOS_OFFLINE_MSG_MAX];
+
+#if TICOS_OFFLINE_QUEUE_SIZE > 0
+static unsigned char ticos_offline_buf[TICOS_OFFLINE_QUEUE_SIZE];
+static ticos_ring_t m_offline_ring = { ticos_offline_buf, sizeof(ticos_offline_buf), 0, 0, 0 };
+#endif
+
+#if TICOS_OFFLINE_LOG
+/*
+ * 文件日志格式: 8 字节文件头(魔数 + 下一条待发送消息的位置), 之后依次追加消息记录,
+ * 每条记录前保存 4 字节的记录长度. 所有消息发送完成后清空文件
+ */
+#define TICOS_OFFLINE_LOG_MAGIC 0x314c5154   // "TQL1"
+#define TICOS_OFFLINE_LOG_HEAD  8
+
+static FILE *m_log = NULL;
+static char m_log_path[128];
+static uint32_t m_log_read = TICOS_OFFLINE_LOG_HEAD;
+static uint32_t m_log_end = TICOS_OFFLINE_LOG_HEAD;
+static long m_log_max = 0;
+static int m_log_count = 0;
+
+static int ticos_log_write_head(void)
+{
+    uint32_t head[2] = { TICOS_OFFLINE_LOG_MAGIC, m_log_read };
+    if (fseek(m_log, 0, SEEK_SET) || fwrite(head, sizeof(head), 1, m_log) != 1)
+        return -1;
+    return fflush(m_log);
+}
+
+static int ticos_log_reset(void)
+{
+    m_log = m_log ? freopen(m_log_path, "w+b", m_log) : fopen(m_log_path, "w+b");
+    m_log_read = m_log_end = TICOS_OFFLINE_LOG_HEAD;
+    m_log_count = 0;
+    return m_log ? ticos_log_write_head() : -1;
+}
+
+// 从文件头记录的位置开始统计未发送的消息, 遇到不完整的记录(写入时掉电)时截断
+static void ticos_log_scan(void)
+{
+    uint32_t head[2], len;
+    long size;
+
+    if (fseek(m_log, 0, SEEK_END) || (size = ftell(m_log)) < TICOS_OFFLINE_LOG_HEAD ||
+        fseek(m_log, 0, SEEK_SET) || fread(head, sizeof(head), 1, m_log) != 1 ||
+        head[0] != TICOS_OFFLINE_LOG_MAGIC || head[1] < TICOS_OFFLINE_LOG_HEAD || head[1] > size) {
+        ticos_log_reset();
+        return;
+    }
+    m_log_read = m_log_end = head[1];
+    m_log_count = 0;
+    while (!fseek(m_log, m_log_end, SEEK_SET) && fread(&len, sizeof(len), 1, m_log) == 1 &&
+           m_log_end + sizeof(len) + len <= (uint32_t)size) {
+        m_log_end += sizeof(len) + len;
+        m_log_count++;
+    }
+    if (!m_log_count)
+        ticos_log_reset();
+}
+
+static int ticos_log_open(const char *path, long max_size)
+{
+    if (m_log) {
+        fclose(m_log);
+        m_log = NULL;
+    }
+    if (!path)
+        return 0;
+    if (strlen(path) >= sizeof(m_log_path))
+        return -1;
+    strcpy(m_log_path, path);
+    m_log_max = max_size;
+    m_log = fopen(path, "r+b");
+    if (!m_log)
+        return ticos_log_reset();
+    ticos_log_scan();
+    return m_log ? 0 : -1;
+}
+
+int ticos_offline_set_log(const char *path, long max_size)
+{
+    ticos_report_lock();
+    int ret = ticos_log_open(path, max_size);
+    ticos_report_unlock();
+    return ret;
+}
+#endif
+
+static int ticos_queue_enabled(void)
+{
+#if TICOS_OFFLINE_LOG
+    if (m_log)
+        return 1;
+#endif
+    return TICOS_OFFLINE_QUEUE_SIZE > 0;
+}
+
+static int ticos_queue_pending(void)
+{
+#if TICOS_OFFLINE_LOG
+    if (m_log)
+        return m_log_count;
+#endif
+#if TICOS_OFFLINE_QUEUE_SIZE > 0
+    return m_offline_ring.count;
+#else
+    return 0;
+#endif
+}
+
+static int ticos_queue_push(const char *topic, const char *data, int len, int qos, int retain)
+{
+    ticos_offline_hdr_t hdr;
+    int topic_len = strlen(topic);
+
+    // 消息重发时需要装入重发缓冲区, 过大的消息无法缓存
+    if (topic_len >= TICOS_OFFLINE_TOPIC_MAX || len > (int)sizeof(m_replay_buf))
+        return -1;
+    hdr.qos = qos;
+    hdr.retain = retain;
+    hdr.topic_len = topic_len;
+
+#if TICOS_OFFLINE_LOG
+    if (m_log) {
+        uint32_t rec_len = sizeof(hdr) + topic_len + len;
+        if (m_log_max > 0 && m_log_end + sizeof(rec_len) + rec_len > (unsigned long)m_log_max)
+            return -1;
+        if (fseek(m_log, m_log_end, SEEK_SET) ||
+            fwrite(&rec_len, sizeof(rec_len), 1, m_log) != 1 ||
+            fwrite(&hdr, sizeof(hdr), 1, m_log) != 1 ||
+            fwrite(topic, 1, topic_len, m_log) != (size_t)topic_len ||
+            fwrite(data, 1, len, m_log) != (size_t)len ||
+            fflush(m_log))
+            return -1;
+        m_log_end += sizeof(rec_len) + rec_len;
+        m_log_count++;
+        return 0;
+    }
+#endif
+#if TICOS_OFFLINE_QUEUE_SIZE > 0
+    // 拼接 topic 和消息头后再写入, 环形缓存满时丢弃最早的消息
+    unsigned char head[sizeof(hdr) + TICOS_OFFLINE_TOPIC_MAX];
+    memcpy(head, &hdr, sizeof(hdr));
+    memcpy(head + sizeof(hdr), topic, topic_len);
+    return ticos_ring_push(&m_offline_ring, head, sizeof(hdr) + topic_len, data, len) < 0 ? -1 : 0;
+#else
+    return -1;
+#endif
+}
+
+// 将最早的消息读入 topic 和重发缓冲区中
+static int ticos_queue_peek(ticos_offline_hdr_t *hdr, char *topic, char **data, int *len)
+{
+    int size = sizeof(m_replay_buf);
+    char *buf = m_replay_buf;
+
+#if TICOS_OFFLINE_LOG
+    if (m_log) {
+        uint32_t rec_len;
+        if (fseek(m_log, m_log_read, SEEK_SET) ||
+            fread(&rec_len, sizeof(rec_len), 1, m_log) != 1 ||
+            fread(hdr, sizeof(*hdr), 1, m_log) != 1 ||
+            hdr->topic_len >= TICOS_OFFLINE_TOPIC_MAX ||
+            fread(topic, 1, hdr->topic_len, m_log) != hdr->topic_len)
+            return -1;
+        *len = rec_len - sizeof(*hdr) - hdr->topic_len;
+        if (*len > size || fread(buf, 1, *len, m_log) != (size_t)*len)
+            return -1;
+        topic[hdr->topic_len] = '\0';
+        *data = buf;
+        return 0;
+    }
+#endif
+#if TICOS_OFFLINE_QUEUE_SIZE > 0
+    int pos = ticos_ring_first(&m_offline_ring);
+    ticos_ring_read(&m_offline_ring, pos, 0, hdr, sizeof(*hdr));
+    ticos_ring_read(&m_offline_ring, pos, sizeof(*hdr), topic, hdr->topic_len);
+    topic[hdr->topic_len] = '\0';
+    *len = ticos_ring_len(&m_offline_ring, pos) - sizeof(*hdr) - hdr->topic_len;
+    if (*len > size)
+        return -1;
+    ticos_ring_read(&m_offline_ring, pos, sizeof(*hdr) + hdr->topic_len, buf, *len);
+    *data = buf;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+static void ticos_queue_pop(void)
+{
+#if TICOS_OFFLINE_LOG
+    if (m_log) {
+        uint32_t rec_len;
+        if (fseek(m_log, m_log_read, SEEK_SET) || fread(&rec_len, sizeof(rec_len), 1, m_log) != 1) {
+            ticos_log_reset();
+            return;
+        }
+        m_log_read += sizeof(rec_len) + rec_len;
+        if (--m_log_count <= 0)
+            ticos_log_reset();
+        else
+            ticos_log_write_head();
+        return;
+    }
+#endif
+#if TICOS_OFFLINE_QUEUE_SIZE > 0
+    ticos_ring_pop(&m_offline_ring);
+#endif
+}
+
+// 按令牌桶限制重发速率, 最多允许 100ms 的突发量
+static int ticos_replay_allowed(void)
+{
+    if (m_replay_rate <= 0)
+        return 1;
+
+    int64_t now = ticos_uptime_ms();
+    int64_t cap = m_replay_rate * 100 > 1000 ? m_replay_rate * 100 : 1000;
+    m_replay_tokens += (now - m_replay_last) * m_replay_rate;
+    m_replay_last = now;
+    if (m_replay_tokens > cap)
+        m_replay_tokens = cap;
+    if (m_replay_tokens < 1000)
+        return 0;
+    m_replay_tokens -= 1000;
+    return 1;
+}
+
+void ticos_offline_set_rate(int msgs_per_sec)
+{
+    ticos_report_lock();
+    m_replay_rate = msgs_per_sec;
+    ticos_report_unlock();
+}
+
+int ticos_offline_pending(void)
+{
+    ticos_report_lock();
+    int count = ticos_queue_pending();
+    ticos_report_unlock();
+    return count;
+}
+
+static int ticos_queue_replay(void)
+{
+    ticos_offline_hdr_t hdr;
+    char topic[TICOS_OFFLINE_TOPIC_MAX];
+    char *data;
+    int len;
+    int sent = 0;
+
+    while (m_connected && ticos_queue_pending() > 0 && ticos_replay_allowed()) {
+        // 无法读取的消息直接丢弃, 避免阻塞后续消息
+        if (ticos_queue_peek(&hdr, topic, &data, &len)) {
+            ticos_queue_pop();
+            continue;
+        }
+        if (ticos_hal_mqtt_publish(topic, data, len, hdr.qos, hdr.retain) < 0)
+            break;
+        ticos_queue_pop();
+        sent++;
+    }
+    return sent;
+}
+
+int ticos_offline_poll(void)
+{
+    ticos_report_lock();
+    int sent = ticos_queue_replay();
+    ticos_report_unlock();
+    return sent;
+}
+
+void ticos_offline_event(ticos_evt_t evt)
+{
+    ticos_report_lock();
+    m_connected = (evt == TICOS_EVENT_CONNECT);
+    if (m_connected) {
+        m_replay_tokens = 1000;
+        m_replay_last = ticos_uptime_ms();
+        ticos_queue_replay();
+    }
+    ticos_report_unlock();
+}
+
+int ticos_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    int ret;
+
+    ticos_report_lock();
+    if (!ticos_queue_enabled()) {
+        ret = ticos_hal_mqtt_publish(topic, data, len, qos, retain);
+    } else if (!m_connected || ticos_queue_pending() > 0) {
+        // 离线或还有未重发的消息时按顺序排队, 保证云端按产生的先后收到消息
+        ret = ticos_queue_push(topic, data, len, qos, retain);
+        ticos_queue_replay();
+    } else {
+        ret = ticos_hal_mqtt_publish(topic, data, len, qos, retain);
+        if (ret < 0)
+            ret = ticos_queue_push(topic, data, len, qos, retain);
+    }
+    ticos_report_unlock();
+    return ret;
+}
+
+#else
+
+int ticos_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    return ticos_hal_mqtt_publish(topic, data, len, qos, retain);
+}
+
+void ticos_offline_event(ticos_evt_t evt)
+{
+}
+
+int ticos_offline_poll(void)
+{
+    return 0;
+}
+
+int ticos_offline_pending(void)
+{
+    return 0;
+}
+
+void ticos_offline_set_rate(int msgs_per_sec)
+{
+}
+
+#endif
+
+#if !TICOS_OFFLINE_LOG
+int ticos_offline_set_log(const char *path, long max_size)
+{
+    return path ? -1 : 0;
+}
+#endif
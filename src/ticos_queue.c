@@ -0,0 +1,82 @@
+#include "ticos_queue.h"
+#include <string.h>
+
+static atomic_uint *ticos_queue_seq(ticos_queue_t *q, unsigned int pos)
+{
+    return (atomic_uint *)(q->cells + (pos & q->mask) * q->stride);
+}
+
+int ticos_queue_init(ticos_queue_t *q, void *buf, unsigned int cnt, unsigned int elem_size)
+{
+    if (!cnt || (cnt & (cnt - 1)))
+        return -1;
+    q->cells = buf;
+    q->mask = cnt - 1;
+    q->elem_size = elem_size;
+    q->stride = TICOS_QUEUE_STRIDE(elem_size);
+    // 单元格 i 的序号为 i 时可写入第 i 个元素, 为 i + 1 时可读出
+    for (unsigned int i = 0; i < cnt; i++)
+        atomic_init(ticos_queue_seq(q, i), i);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    return 0;
+}
+
+int ticos_queue_push(ticos_queue_t *q, const void *elem)
+{
+    unsigned int pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_uint *seq;
+
+    for (;;) {
+        seq = ticos_queue_seq(q, pos);
+        int diff = (int)(atomic_load_explicit(seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // 单元格中还是上一轮的元素, 未被取走
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    memcpy((unsigned char *)seq + TICOS_QUEUE_HDR_SIZE, elem, q->elem_size);
+    atomic_store_explicit(seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+int ticos_queue_pop(ticos_queue_t *q, void *elem)
+{
+    unsigned int pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_uint *seq;
+
+    for (;;) {
+        seq = ticos_queue_seq(q, pos);
+        int diff = (int)(atomic_load_explicit(seq, memory_order_acquire) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    memcpy(elem, (unsigned char *)seq + TICOS_QUEUE_HDR_SIZE, q->elem_size);
+    // 释放单元格供下一轮写入
+    atomic_store_explicit(seq, pos + q->mask + 1, memory_order_release);
+    return 0;
+}
+
+int ticos_queue_empty(ticos_queue_t *q)
+{
+    unsigned int pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    return atomic_load_explicit(ticos_queue_seq(q, pos), memory_order_acquire) != pos + 1;
+}
+
+unsigned int ticos_queue_count(ticos_queue_t *q)
+{
+    return atomic_load_explicit(&q->head, memory_order_relaxed) - atomic_load_explicit(&q->tail, memory_order_relaxed);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 单元格中元素之前的序号所占的字节数, 保证元素按 8 字节对齐
+#define TICOS_QUEUE_HDR_SIZE 8
+
+/** 元素大小为 elem_size 时每个单元格占用的字节数 */
+#define TICOS_QUEUE_STRIDE(elem_size) ((TICOS_QUEUE_HDR_SIZE + (elem_size) + 7) & ~7u)
+
+/** 容纳 cnt 个元素的队列所需的缓冲区大小, 缓冲区须按 8 字节对齐 */
+#define TICOS_QUEUE_BUF_SIZE(cnt, elem_size) ((cnt) * TICOS_QUEUE_STRIDE(elem_size))
+
+/**
+ * 定长元素的有界无锁队列, 支持多个生产者和消费者并发访问.
+ * 每个单元格带有一个序号: 生产者以 CAS 抢占入队位置, 写入元素后再发布序号,
+ * 消费者看到已发布的序号才读取元素, 入队和出队都不加锁. 队列满时入队立即失败, 由调用者决定丢弃或重试
+ */
+typedef struct {
+    unsigned char *cells;
+    unsigned int mask;      // 单元格数 - 1, 单元格数须为 2 的幂
+    unsigned int elem_size;
+    unsigned int stride;
+    atomic_uint head;       // 下一个入队位置
+    atomic_uint tail;       // 下一个出队位置
+} ticos_queue_t;
+
+/**
+ * @brief  初始化队列
+ * @param buf 缓冲区, 大小至少为 TICOS_QUEUE_BUF_SIZE(cnt, elem_size)
+ * @param cnt 元素个数, 须为 2 的幂
+ * @param elem_size 元素大小
+ * @return 0 代表成功, cnt 不是 2 的幂时返回 -1
+ */
+int ticos_queue_init(ticos_queue_t *q, void *buf, unsigned int cnt, unsigned int elem_size);
+
+/**
+ * @brief  元素入队
+ * @return 0 代表成功, 队列已满时返回 -1
+ */
+int ticos_queue_push(ticos_queue_t *q, const void *elem);
+
+/**
+ * @brief  元素出队
+ * @return 0 代表成功, 队列为空时返回 -1
+ */
+int ticos_queue_pop(ticos_queue_t *q, void *elem);
+
+/**
+ * @brief  判断队首是否有已入队完成的元素
+ * @note   正在入队、尚未发布的元素不计入, 只有一个消费者时结果是准确的
+ * @return 1 代表为空, 0 代表非空
+ */
+int ticos_queue_empty(ticos_queue_t *q);
+
+/**
+ * @brief  队列中的元素个数, 含正在入队的元素, 并发访问时只是近似值
+ */
+unsigned int ticos_queue_count(ticos_queue_t *q);
+
+#ifdef __cplusplus
+}
+#endif
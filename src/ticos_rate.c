@@ -0,0 +1,95 @@
+#include "ticos_rate.h"
+#include "ticos_config.h"
+#include "ticos_time.h"
+
+/*
+ * 令牌桶, 令牌以千分之一为单位累计, 每毫秒补充 rate 个单位, 低速率时也不会因整数除法丢失精度
+ */
+typedef struct {
+    int rate;           // 每秒补充的令牌数, 0 表示不限制
+    int64_t cap;        // 桶容量
+    int64_t tokens;     // 可能为负, 表示透支
+    int64_t last;       // 上次补充的时间
+} ticos_bucket_t;
+
+typedef struct {
+    ticos_bucket_t msgs;
+    ticos_bucket_t bytes;
+} ticos_rate_t;
+
+static ticos_rate_t m_rates[TICOS_TOPIC_CLASS_MAX];
+static int m_enabled = 0;
+
+static void ticos_bucket_set(ticos_bucket_t *b, int rate, int burst, int64_t now)
+{
+    b->rate = rate;
+    b->cap = (int64_t)(burst > 0 ? burst : rate) * 1000;
+    b->tokens = b->cap;
+    b->last = now;
+}
+
+static void ticos_bucket_refill(ticos_bucket_t *b, int64_t now)
+{
+    if (!b->rate || now <= b->last)
+        return;
+    b->tokens += (now - b->last) * b->rate;
+    if (b->tokens > b->cap)
+        b->tokens = b->cap;
+    b->last = now;
+}
+
+// 令牌数达到 need 还需等待的毫秒数
+static int64_t ticos_bucket_wait(const ticos_bucket_t *b, int64_t need)
+{
+    if (!b->rate || b->tokens >= need)
+        return 0;
+    return (need - b->tokens + b->rate - 1) / b->rate;
+}
+
+int ticos_set_rate_limit(ticos_topic_class_t cls, int msgs_per_sec, int bytes_per_sec, int burst_msgs, int burst_bytes)
+{
+    int64_t now = ticos_uptime_ms();
+
+    // 关闭上报合并时无法推迟受限的上报
+    if (!TICOS_COALESCE_FIELDS)
+        return -1;
+    if (cls < 0 || cls >= TICOS_TOPIC_CLASS_MAX || msgs_per_sec < 0 || bytes_per_sec < 0)
+        return -1;
+    ticos_bucket_set(&m_rates[cls].msgs, msgs_per_sec, burst_msgs, now);
+    ticos_bucket_set(&m_rates[cls].bytes, bytes_per_sec, burst_bytes, now);
+    m_enabled = 0;
+    for (int i = 0; i < TICOS_TOPIC_CLASS_MAX; i++)
+        m_enabled |= m_rates[i].msgs.rate || m_rates[i].bytes.rate;
+    return 0;
+}
+
+int ticos_rate_enabled(void)
+{
+    return m_enabled;
+}
+
+int ticos_rate_wait_ms(ticos_topic_class_t cls, int64_t now)
+{
+    ticos_rate_t *rate = &m_rates[cls];
+
+    ticos_bucket_refill(&rate->msgs, now);
+    ticos_bucket_refill(&rate->bytes, now);
+    // 消息需要一个完整的令牌; 字节允许透支, 只要余额为正即可发送
+    int64_t wait = ticos_bucket_wait(&rate->msgs, 1000);
+    int64_t wait_bytes = ticos_bucket_wait(&rate->bytes, 1);
+    return (int)(wait > wait_bytes ? wait : wait_bytes);
+}
+
+void ticos_rate_consume(ticos_topic_class_t cls, int len, int64_t now)
+{
+    ticos_rate_t *rate = &m_rates[cls];
+
+    if (!m_enabled)
+        return;
+    ticos_bucket_refill(&rate->msgs, now);
+    ticos_bucket_refill(&rate->bytes, now);
+    if (rate->msgs.rate)
+        rate->msgs.tokens -= 1000;
+    if (rate->bytes.rate)
+        rate->bytes.tokens -= (int64_t)len * 1000;
+}
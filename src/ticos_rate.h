@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "ticos_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  是否为任一类 topic 设置了速率限制
+ * @return 1 代表已设置, 0 代表未设置
+ */
+int ticos_rate_enabled(void);
+
+/**
+ * @brief  计算一类 topic 还需等待多久才能再发送一条消息
+ * @param cls topic 类别
+ * @param now 当前的 ticos_uptime_ms()
+ * @return 0 代表可以立即发送, 否则为需要等待的毫秒数
+ */
+int ticos_rate_wait_ms(ticos_topic_class_t cls, int64_t now);
+
+/**
+ * @brief  扣除一条已发送消息占用的令牌
+ * @param cls topic 类别
+ * @param len 消息的字节数
+ * @param now 当前的 ticos_uptime_ms()
+ * @return void
+ */
+void ticos_rate_consume(ticos_topic_class_t cls, int len, int64_t now);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+#include "ticos_ring.h"
+#include <string.h>
+
+typedef uint32_t ticos_ring_len_t;
+
+_Static_assert(sizeof(ticos_ring_len_t) == TICOS_RING_HDR_SIZE, "ring header size");
+
+static int ticos_ring_wrap(const ticos_ring_t *r, int pos)
+{
+    return pos % r->size;
+}
+
+static void ticos_ring_copy_in(ticos_ring_t *r, int pos, const void *data, int n)
+{
+    int first = r->size - pos;
+    if (first > n)
+        first = n;
+    memcpy(r->buf + pos, data, first);
+    memcpy(r->buf, (const unsigned char *)data + first, n - first);
+}
+
+static void ticos_ring_copy_out(const ticos_ring_t *r, int pos, void *data, int n)
+{
+    int first = r->size - pos;
+    if (first > n)
+        first = n;
+    memcpy(data, r->buf + pos, first);
+    memcpy((unsigned char *)data + first, r->buf, n - first);
+}
+
+void ticos_ring_init(ticos_ring_t *r, void *buf, int size)
+{
+    r->buf = buf;
+    r->size = size;
+    r->head = 0;
+    r->used = 0;
+    r->count = 0;
+}
+
+int ticos_ring_push(ticos_ring_t *r, const void *hdr, int hdr_len, const void *data, int len)
+{
+    ticos_ring_len_t rec_len = hdr_len + len;
+    int need = sizeof(rec_len) + rec_len;
+    int dropped = 0;
+
+    if (need > r->size)
+        return -1;
+    while (r->size - r->used < need) {
+        ticos_ring_pop(r);
+        dropped++;
+    }
+
+    int pos = ticos_ring_wrap(r, r->head + r->used);
+    ticos_ring_copy_in(r, pos, &rec_len, sizeof(rec_len));
+    pos = ticos_ring_wrap(r, pos + sizeof(rec_len));
+    ticos_ring_copy_in(r, pos, hdr, hdr_len);
+    pos = ticos_ring_wrap(r, pos + hdr_len);
+    ticos_ring_copy_in(r, pos, data, len);
+    r->used += need;
+    r->count++;
+    return dropped;
+}
+
+void ticos_ring_pop(ticos_ring_t *r)
+{
+    if (!r->count)
+        return;
+    int need = sizeof(ticos_ring_len_t) + ticos_ring_len(r, r->head);
+    r->head = ticos_ring_wrap(r, r->head + need);
+    r->used -= need;
+    r->count--;
+}
+
+int ticos_ring_first(const ticos_ring_t *r)
+{
+    return r->head;
+}
+
+int ticos_ring_next(const ticos_ring_t *r, int pos)
+{
+    return ticos_ring_wrap(r, pos + sizeof(ticos_ring_len_t) + ticos_ring_len(r, pos));
+}
+
+int ticos_ring_len(const ticos_ring_t *r, int pos)
+{
+    ticos_ring_len_t len;
+    ticos_ring_copy_out(r, pos, &len, sizeof(len));
+    return len;
+}
+
+void ticos_ring_read(const ticos_ring_t *r, int pos, int offset, void *data, int len)
+{
+    ticos_ring_copy_out(r, ticos_ring_wrap(r, pos + sizeof(ticos_ring_len_t) + offset), data, len);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 每条记录前保存记录长度所占的字节数
+#define TICOS_RING_HDR_SIZE 4
+
+/**
+ * 以记录为单位的字节环形缓存, 每条记录前保存其长度.
+ * 空间不足时丢弃最早的记录, 用于缓存待发送的样本和消息
+ */
+typedef struct {
+    unsigned char *buf;
+    int size;
+    int head;   // 最早的记录的位置
+    int used;   // 已使用的字节数, 含记录长度
+    int count;  // 记录数
+} ticos_ring_t;
+
+void ticos_ring_init(ticos_ring_t *r, void *buf, int size);
+
+/**
+ * @brief  追加一条由 hdr 和 data 两部分拼接而成的记录
+ * @note   空间不足时丢弃最早的记录
+ * @return 被丢弃的记录数, 记录超出缓存容量时返回 -1
+ */
+int ticos_ring_push(ticos_ring_t *r, const void *hdr, int hdr_len, const void *data, int len);
+
+/** @brief 丢弃最早的一条记录 */
+void ticos_ring_pop(ticos_ring_t *r);
+
+/** @brief 最早的记录的位置 */
+int ticos_ring_first(const ticos_ring_t *r);
+
+/** @brief 位于 pos 处的记录之后的下一条记录的位置 */
+int ticos_ring_next(const ticos_ring_t *r, int pos);
+
+/** @brief 位于 pos 处的记录的长度 */
+int ticos_ring_len(const ticos_ring_t *r, int pos);
+
+/**
+ * @brief  读取位于 pos 处的记录的内容
+ * @param offset 从记录内容的此偏移处开始读取
+ * @param data 输出缓冲区
+ * @param len 读取的长度
+ */
+void ticos_ring_read(const ticos_ring_t *r, int pos, int offset, void *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
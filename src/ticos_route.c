@@ -0,0 +1,204 @@
+#include "ticos_route.h"
+#include "ticos_config.h"
+#include "ticos_mem.h"
+#include "ticos_thingmodel_index.h"
+#include <string.h>
+#if TICOS_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+#if TICOS_ROUTE_BUCKETS & (TICOS_ROUTE_BUCKETS - 1)
+#error "TICOS_ROUTE_BUCKETS must be a power of 2"
+#endif
+
+// 精确路由多于桶数时桶数加倍, 初始使用静态的桶数组
+static ticos_route_t *ticos_route_buckets[TICOS_ROUTE_BUCKETS];
+static ticos_route_t **m_buckets = ticos_route_buckets;
+static uint32_t m_bucket_mask = TICOS_ROUTE_BUCKETS - 1;
+static int m_count = 0;     // 精确路由的数量
+static ticos_route_t *m_wildcards = NULL;
+
+#if TICOS_THREAD_SAFE
+static pthread_mutex_t m_route_lock;
+static pthread_once_t m_route_lock_once = PTHREAD_ONCE_INIT;
+
+// 处理函数中可能添加或移除路由, 需使用可重入锁
+static void ticos_route_lock_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_route_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void ticos_route_lock(void)
+{
+    pthread_once(&m_route_lock_once, ticos_route_lock_init);
+    pthread_mutex_lock(&m_route_lock);
+}
+
+void ticos_route_unlock(void)
+{
+    pthread_mutex_unlock(&m_route_lock);
+}
+#else
+void ticos_route_lock(void)
+{
+}
+
+void ticos_route_unlock(void)
+{
+}
+#endif
+
+// 检查通配符的位置: '+' 必须独占一级, '#' 必须独占最后一级
+static int ticos_filter_check(const char *filter, int len, int *wildcard)
+{
+    *wildcard = 0;
+    for (int i = 0; i < len; i++) {
+        if (filter[i] != '+' && filter[i] != '#')
+            continue;
+        if ((i > 0 && filter[i - 1] != '/') ||
+            (filter[i] == '+' && i + 1 < len && filter[i + 1] != '/') ||
+            (filter[i] == '#' && i + 1 != len))
+            return -1;
+        *wildcard = 1;
+    }
+    return 0;
+}
+
+int ticos_topic_match(const char *filter, int filter_len, const char *topic, int topic_len)
+{
+    int f = 0;
+    int t = 0;
+
+    while (f < filter_len) {
+        if (filter[f] == '#')
+            return 1;
+        if (filter[f] == '+') {
+            // 匹配一整级, 可以为空
+            while (t < topic_len && topic[t] != '/')
+                t++;
+            f++;
+        } else {
+            if (t >= topic_len || filter[f] != topic[t])
+                return 0;
+            f++;
+            t++;
+        }
+        // "a/#" 同时匹配 "a"
+        if (t == topic_len && f + 2 == filter_len && filter[f] == '/' && filter[f + 1] == '#')
+            return 1;
+    }
+    return t == topic_len;
+}
+
+// 保持各桶中路由的先后顺序, 重复的 topic 仍优先匹配最后添加的路由
+static void ticos_route_grow(void)
+{
+    uint32_t size = (m_bucket_mask + 1) * 2;
+    ticos_route_t **buckets = ticos_heap_malloc(size * sizeof(*buckets));
+
+    // 无法申请内存时(如全静态内存模式)保持原有的桶数
+    if (!buckets)
+        return;
+    memset(buckets, 0, size * sizeof(*buckets));
+    for (uint32_t i = 0; i <= m_bucket_mask; i++) {
+        while (m_buckets[i]) {
+            ticos_route_t *r = m_buckets[i];
+            ticos_route_t **p = &buckets[r->hash & (size - 1)];
+            m_buckets[i] = r->next;
+            while (*p)
+                p = &(*p)->next;
+            r->next = NULL;
+            *p = r;
+        }
+    }
+    if (m_buckets != ticos_route_buckets)
+        ticos_free(m_buckets);
+    m_buckets = buckets;
+    m_bucket_mask = size - 1;
+}
+
+int ticos_route_add(ticos_route_t *route, const char *topic, ticos_route_handler_t handler, void *user)
+{
+    int len = strlen(topic);
+    int wildcard;
+
+    if (!len || ticos_filter_check(topic, len, &wildcard))
+        return -1;
+    ticos_route_lock();
+    ticos_route_remove(route);
+    route->topic = topic;
+    route->len = len;
+    route->hash = ticos_hash(0, topic, len);
+    route->wildcard = wildcard;
+    route->handler = handler;
+    route->fragment = NULL;
+    route->user = user;
+    route->next = NULL;
+
+    if (!wildcard && ++m_count > (int)m_bucket_mask + 1)
+        ticos_route_grow();
+
+    // 通配符路由追加到末尾, 保持添加顺序
+    ticos_route_t **p = wildcard ? &m_wildcards : &m_buckets[route->hash & m_bucket_mask];
+    if (wildcard) {
+        while (*p)
+            p = &(*p)->next;
+    } else {
+        route->next = *p;
+    }
+    *p = route;
+    ticos_route_unlock();
+    return 0;
+}
+
+void ticos_route_remove(ticos_route_t *route)
+{
+    ticos_route_lock();
+    if (!route->topic) {
+        ticos_route_unlock();
+        return;
+    }
+    ticos_route_t **p = route->wildcard ? &m_wildcards : &m_buckets[route->hash & m_bucket_mask];
+    for (; *p; p = &(*p)->next) {
+        if (*p == route) {
+            *p = route->next;
+            if (!route->wildcard)
+                m_count--;
+            break;
+        }
+    }
+    route->topic = NULL;
+    route->next = NULL;
+    ticos_route_unlock();
+}
+
+ticos_route_t *ticos_route_find(const char *topic, int topic_len)
+{
+    uint32_t hash = ticos_hash(0, topic, topic_len);
+
+    for (ticos_route_t *r = m_buckets[hash & m_bucket_mask]; r; r = r->next) {
+        if (r->hash == hash && r->len == topic_len && !memcmp(r->topic, topic, topic_len))
+            return r;
+    }
+    for (ticos_route_t *r = m_wildcards; r; r = r->next) {
+        if (ticos_topic_match(r->topic, r->len, topic, topic_len))
+            return r;
+    }
+    return NULL;
+}
+
+int ticos_route_dispatch(const char *topic, int topic_len, const char *dat, int len)
+{
+    // 处理期间持有路由锁, 其他线程移除的路由在处理结束后才失效
+    ticos_route_lock();
+    ticos_route_t *r = ticos_route_find(topic, topic_len);
+    if (r)
+        r->handler(r->user, topic, topic_len, dat, len);
+    ticos_route_unlock();
+    return r ? 1 : 0;
+}
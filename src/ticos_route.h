@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 下发消息的处理函数, topic 和数据都不要求以 '\0' 结尾
+ */
+typedef void (*ticos_route_handler_t)(void *user, const char *topic, int topic_len, const char *dat, int len);
+
+/**
+ * 分片到达的下发消息的处理函数, 按顺序逐个给出分片
+ * @param offset 分片在消息中的位置
+ * @param total 消息的总长度
+ */
+typedef void (*ticos_route_fragment_t)(void *user, const char *dat, int len, int offset, int total);
+
+/**
+ * 一条 topic 路由, 由调用者分配并在首次添加前清零, 在移除之前须保持有效.
+ * 不含通配符的 topic 存入按哈希值分桶的表中, 路由多于桶数时桶数加倍, 平均查找时间与路由数量无关;
+ * 无法申请内存时(如开启 TICOS_STATIC_MEMORY)桶数保持 TICOS_ROUTE_BUCKETS, 查找时间随路由数量线性增长.
+ * 含有 MQTT 通配符 '+' 或 '#' 的 topic 只在没有精确匹配时按添加顺序逐个匹配
+ */
+typedef struct ticos_route_s {
+    const char *topic;      // 须在路由移除之前保持有效
+    int len;
+    uint32_t hash;
+    int wildcard;
+    ticos_route_handler_t handler;
+    ticos_route_fragment_t fragment;    // 可选, 在添加路由后设置, 为 NULL 时分片到达的消息被丢弃
+    void *user;
+    struct ticos_route_s *next;
+} ticos_route_t;
+
+/**
+ * @brief  添加路由
+ * @param route 路由, 由调用者分配
+ * @param topic 以 '\0' 结尾的 topic 或 topic 过滤器, 如 "devices/+/commands/request"
+ * @param handler 处理函数
+ * @param user 传给处理函数的用户数据
+ * @return 0 代表成功, topic 不是合法的过滤器时返回 -1
+ */
+int ticos_route_add(ticos_route_t *route, const char *topic, ticos_route_handler_t handler, void *user);
+
+/**
+ * @brief  移除路由, 未添加的路由可重复移除
+ * @return void
+ */
+void ticos_route_remove(ticos_route_t *route);
+
+/**
+ * @brief  查找与 topic 匹配的路由
+ * @note   优先返回与 topic 完全相同的路由, 没有时返回第一个匹配的通配符路由;
+ *         调用者需持有路由锁, 直到不再使用返回的路由
+ * @return 匹配的路由, 没有时返回 NULL
+ */
+ticos_route_t *ticos_route_find(const char *topic, int topic_len);
+
+/**
+ * @brief  将下发消息分发给匹配的路由
+ * @note   优先分发给与 topic 完全相同的路由, 没有时分发给第一个匹配的通配符路由; 处理期间持有路由锁
+ * @return 1 代表已分发, 0 代表没有匹配的路由
+ */
+int ticos_route_dispatch(const char *topic, int topic_len, const char *dat, int len);
+
+/**
+ * @brief  获取路由锁
+ * @note   路由锁保护路由表和已启动设备的链表, 可重入; 与上报锁同时持有时须先获取路由锁
+ * @return void
+ */
+void ticos_route_lock(void);
+
+/**
+ * @brief  释放路由锁
+ * @return void
+ */
+void ticos_route_unlock(void);
+
+/**
+ * @brief  按 MQTT 规则判断 topic 是否与过滤器匹配
+ * @return 1 代表匹配, 0 代表不匹配
+ */
+int ticos_topic_match(const char *filter, int filter_len, const char *topic, int topic_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,223 @@
+#include "ticos_schedule.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_time.h"
+#include <string.h>
+
+#if TICOS_SCHEDULE_FIELDS > 0
+
+#if TICOS_THREAD_SAFE
+#include <pthread.h>
+
+// 推进时间轮时, 其他线程可能同时启动、停止设备或修改上报周期
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void ticos_schedule_lock(void)
+{
+    pthread_mutex_lock(&m_lock);
+}
+
+static void ticos_schedule_unlock(void)
+{
+    pthread_mutex_unlock(&m_lock);
+}
+#else
+static void ticos_schedule_lock(void)
+{
+}
+
+static void ticos_schedule_unlock(void)
+{
+}
+#endif
+
+static ticos_timer_wheel_t m_wheel;
+static int m_wheel_ready = 0;
+static uint32_t m_now;              // 本次推进到的 tick
+static ticos_client_t *m_due;       // 有遥测到期的设备, 与各设备的到期字段一起由锁保护
+
+static uint32_t ticos_schedule_tick(int64_t ms)
+{
+    return (uint32_t)(ms / TICOS_TIMER_TICK_MS);
+}
+
+// 上报周期对应的 tick 数, 至少为 1
+static uint32_t ticos_schedule_ticks(int period_ms)
+{
+    uint32_t ticks = ((uint32_t)period_ms + TICOS_TIMER_TICK_MS - 1) / TICOS_TIMER_TICK_MS;
+    return ticks ? ticks : 1;
+}
+
+// 遥测当前生效的上报周期, 运行时的设置优先于物模型中的声明
+static int ticos_schedule_period(const ticos_client_t *client, int i)
+{
+    int period = client->schedule_period[i];
+
+    if (!period)
+        return client->model->telemetry_tab[i].period_ms;
+    return period > 0 ? period : 0;
+}
+
+static void ticos_schedule_ensure(int64_t now)
+{
+    if (!m_wheel_ready) {
+        ticos_timer_wheel_init(&m_wheel, ticos_schedule_tick(now));
+        m_wheel_ready = 1;
+    }
+}
+
+static void ticos_schedule_fire(ticos_timer_t *timer)
+{
+    ticos_client_t *client = timer->arg;
+    int i = timer - client->schedule_timer;
+    int period = ticos_schedule_period(client, i);
+
+    // 下一次按本次的到期时间计算, 周期不会累积误差; 落后超过一个周期时跳过错过的周期
+    if (period > 0) {
+        uint32_t ticks = ticos_schedule_ticks(period);
+        uint32_t next = timer->expires + ticks;
+        if ((int32_t)(next - m_now) <= 0)
+            next = m_now + ticks;
+        ticos_timer_add(&m_wheel, timer, next);
+    }
+
+    client->schedule_due[i >> 3] |= 1 << (i & 7);
+    if (!client->schedule_queued) {
+        client->schedule_queued = 1;
+        client->schedule_next = m_due;
+        m_due = client;
+    }
+}
+
+// 按当前周期重新启动遥测 i 的定时器, 调用者须持有锁
+static void ticos_schedule_arm(ticos_client_t *client, int i, uint32_t now)
+{
+    ticos_timer_t *timer = &client->schedule_timer[i];
+    int period = ticos_schedule_period(client, i);
+
+    ticos_timer_del(&m_wheel, timer);
+    if (period <= 0)
+        return;
+    timer->cb = ticos_schedule_fire;
+    timer->arg = client;
+    ticos_timer_add(&m_wheel, timer, now + ticos_schedule_ticks(period));
+}
+
+void ticos_schedule_start(ticos_client_t *client)
+{
+    int64_t now = ticos_uptime_ms();
+    int cnt = client->model->telemetry_cnt < TICOS_SCHEDULE_FIELDS ? client->model->telemetry_cnt : TICOS_SCHEDULE_FIELDS;
+    int armed = 0;
+
+    ticos_schedule_lock();
+    ticos_schedule_ensure(now);
+    for (int i = 0; i < cnt; i++) {
+        ticos_schedule_arm(client, i, ticos_schedule_tick(now));
+        armed |= ticos_timer_pending(&client->schedule_timer[i]);
+    }
+    ticos_schedule_unlock();
+    if (armed)
+        ticos_sender_notify();
+}
+
+void ticos_schedule_stop(ticos_client_t *client)
+{
+    ticos_schedule_lock();
+    for (int i = 0; i < TICOS_SCHEDULE_FIELDS; i++)
+        ticos_timer_del(&m_wheel, &client->schedule_timer[i]);
+    ticos_schedule_unlock();
+}
+
+int ticos_client_telemetry_set_period(ticos_client_t *client, int index, int period_ms)
+{
+    int64_t now = ticos_uptime_ms();
+
+    if (index < 0 || index >= client->model->telemetry_cnt || index >= TICOS_SCHEDULE_FIELDS)
+        return -1;
+    // 0 恢复使用物模型中的周期, 负数关闭周期上报
+    client->schedule_period[index] = period_ms < 0 ? -1 : period_ms;
+    if (!client->started)
+        return 0;
+    ticos_schedule_lock();
+    ticos_schedule_ensure(now);
+    ticos_schedule_arm(client, index, ticos_schedule_tick(now));
+    ticos_schedule_unlock();
+    ticos_sender_notify();
+    return 0;
+}
+
+int ticos_schedule_poll(int64_t now)
+{
+    int count = 0;
+
+    // 持有锁时取出到期的设备链表, 上报期间再次到期的遥测进入新的链表
+    ticos_schedule_lock();
+    if (m_wheel_ready) {
+        m_now = ticos_schedule_tick(now);
+        ticos_timer_advance(&m_wheel, m_now);
+    }
+    ticos_client_t *due = m_due;
+    m_due = NULL;
+    ticos_schedule_unlock();
+
+    // 同一设备在本次推进中到期的遥测合并为一条消息
+    while (due) {
+        ticos_client_t *client = due;
+        unsigned char fields[sizeof(client->schedule_due)];
+        ticos_schedule_lock();
+        due = client->schedule_next;
+        client->schedule_queued = 0;
+        memcpy(fields, client->schedule_due, sizeof(fields));
+        memset(client->schedule_due, 0, sizeof(fields));
+        ticos_schedule_unlock();
+        if (!client->started)
+            continue;
+        ticos_client_telemetry_report_fields(client, fields);
+        count++;
+    }
+    return count;
+}
+
+int ticos_schedule_next_ms(int64_t now)
+{
+    uint32_t expires;
+    int next = -1;
+
+    ticos_schedule_lock();
+    if (m_wheel_ready && !ticos_timer_next(&m_wheel, &expires)) {
+        int32_t ticks = (int32_t)(expires - ticos_schedule_tick(now));
+        next = ticks > 0 ? (int)(ticks * TICOS_TIMER_TICK_MS - now % TICOS_TIMER_TICK_MS) : 0;
+    }
+    ticos_schedule_unlock();
+    return next;
+}
+#else
+void ticos_schedule_start(ticos_client_t *client)
+{
+}
+
+void ticos_schedule_stop(ticos_client_t *client)
+{
+}
+
+int ticos_client_telemetry_set_period(ticos_client_t *client, int index, int period_ms)
+{
+    return -1;
+}
+
+int ticos_schedule_poll(int64_t now)
+{
+    return 0;
+}
+
+int ticos_schedule_next_ms(int64_t now)
+{
+    return -1;
+}
+#endif
+
+int ticos_telemetry_set_period(int index, int period_ms)
+{
+    return ticos_client_telemetry_set_period(ticos_client_default(), index, period_ms);
+}
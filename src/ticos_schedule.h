@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include "ticos_client.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  为启动的设备按上报周期启动各遥测的定时器
+ * @return void
+ */
+void ticos_schedule_start(ticos_client_t *client);
+
+/**
+ * @brief  停止设备的所有周期上报定时器
+ * @return void
+ */
+void ticos_schedule_stop(ticos_client_t *client);
+
+/**
+ * @brief  推进时间轮, 将每个设备已到期的遥测合并为一条消息上报
+ * @param now 当前的 ticos_uptime_ms()
+ * @return 有遥测到期的设备数
+ */
+int ticos_schedule_poll(int64_t now);
+
+/**
+ * @brief  计算距离下一个周期上报到期的时间
+ * @param now 当前的 ticos_uptime_ms()
+ * @return 需要等待的毫秒数, -1 代表没有周期上报的遥测
+ */
+int ticos_schedule_next_ms(int64_t now);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,246 @@
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_config.h"
+#include "ticos_metrics.h"
+#include "ticos_thingmodel_op.h"
+
+#if TICOS_SEND_QUEUE_SIZE > 0
+
+#include "ticos_queue.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#if TICOS_SEND_QUEUE_SIZE & (TICOS_SEND_QUEUE_SIZE - 1)
+#error "TICOS_SEND_QUEUE_SIZE must be a power of 2"
+#endif
+
+/*
+ * 队列中只保存上报请求, 字段值由发送线程在处理请求时读取并编码。应用线程的同步上报、命令处理函数中的上报
+ * 和 MQTT 接收线程中的缓存清除仍会同时访问上报缓冲区和各上报缓存, 这些访问都由上报锁(ticos_report_lock())串行化
+ */
+typedef struct {
+    ticos_client_t *client;
+    int report;
+    int index;
+} ticos_send_req_t;
+
+static uint64_t ticos_send_buf[TICOS_QUEUE_BUF_SIZE(TICOS_SEND_QUEUE_SIZE, sizeof(ticos_send_req_t)) / 8];
+static ticos_queue_t m_queue;
+static pthread_once_t m_queue_once = PTHREAD_ONCE_INIT;
+
+static pthread_t m_thread;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;  // 只用于发送线程的休眠和唤醒
+static pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int m_running = 0;
+static atomic_int m_waiting = 0;    // 发送线程是否即将休眠, 生产者只在此时才需要唤醒它
+static atomic_int m_notified = 0;   // 休眠时间计算后合并上报或周期上报的到期时间又有变化
+
+static void ticos_send_queue_init(void)
+{
+    ticos_queue_init(&m_queue, ticos_send_buf, TICOS_SEND_QUEUE_SIZE, sizeof(ticos_send_req_t));
+}
+
+static void ticos_send_execute(const ticos_send_req_t *req)
+{
+    ticos_client_t *client = req->client;
+
+    if (!client->started)
+        return;
+    switch (req->report) {
+    case TICOS_REPORT_PROPERTY:
+        ticos_client_property_report(client);
+        break;
+    case TICOS_REPORT_PROPERTY_CHANGED:
+        ticos_client_property_report_changed(client);
+        break;
+    case TICOS_REPORT_PROPERTY_INDEX:
+        ticos_client_property_report_by_index(client, req->index);
+        break;
+    case TICOS_REPORT_TELEMETRY:
+        ticos_client_telemetry_report(client);
+        break;
+    case TICOS_REPORT_TELEMETRY_INDEX:
+        ticos_client_telemetry_report_by_index(client, req->index);
+        break;
+    }
+}
+
+// 休眠到被唤醒或超过 ms 毫秒
+static void ticos_sender_timedwait(int ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&m_cond, &m_lock, &ts);
+}
+
+static void *ticos_sender_loop(void *arg)
+{
+    ticos_send_req_t req;
+
+    for (;;) {
+        if (!ticos_queue_pop(&m_queue, &req)) {
+            ticos_send_execute(&req);
+            continue;
+        }
+        // 合并上报和周期上报也由发送线程发出, 休眠时间不超过下一个到期时间
+        ticos_report_poll();
+        // 停止时先发送完已入队的请求
+        if (!atomic_load(&m_running))
+            break;
+        atomic_store(&m_waiting, 1);
+        // 与入队一侧的屏障配对: 生产者要么看到 m_waiting 而唤醒本线程, 要么其请求在这里被看到
+        atomic_thread_fence(memory_order_seq_cst);
+        // 计算时需要上报锁, 不能持有 m_lock; 此后修改上报周期的通知由 m_notified 记录, 不会丢失
+        atomic_store(&m_notified, 0);
+        int wait_ms = ticos_report_next_ms();
+        pthread_mutex_lock(&m_lock);
+        if (ticos_queue_empty(&m_queue) && atomic_load(&m_running) && !atomic_load(&m_notified)) {
+            if (wait_ms < 0)
+                pthread_cond_wait(&m_cond, &m_lock);
+            else if (wait_ms > 0)
+                ticos_sender_timedwait(wait_ms);
+        }
+        atomic_store(&m_waiting, 0);
+        pthread_mutex_unlock(&m_lock);
+    }
+    return NULL;
+}
+
+static void ticos_sender_wake(void)
+{
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+}
+
+void ticos_sender_notify(void)
+{
+    if (!atomic_load(&m_running))
+        return;
+    atomic_store(&m_notified, 1);
+    ticos_sender_wake();
+}
+
+int ticos_sender_start(void)
+{
+    pthread_attr_t attr;
+    size_t stack = TICOS_SEND_STACK_SIZE;
+
+    if (atomic_load(&m_running))
+        return 0;
+    pthread_once(&m_queue_once, ticos_send_queue_init);
+#ifdef PTHREAD_STACK_MIN
+    if (stack < PTHREAD_STACK_MIN)
+        stack = PTHREAD_STACK_MIN;
+#endif
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack);
+    atomic_store(&m_running, 1);
+    int ret = pthread_create(&m_thread, &attr, ticos_sender_loop, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret) {
+        atomic_store(&m_running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void ticos_sender_stop(void)
+{
+    if (!atomic_load(&m_running))
+        return;
+    atomic_store(&m_running, 0);
+    ticos_sender_wake();
+    pthread_join(m_thread, NULL);
+}
+
+int ticos_send_pending(void)
+{
+    pthread_once(&m_queue_once, ticos_send_queue_init);
+    return ticos_queue_count(&m_queue);
+}
+
+ticos_send_status_t ticos_client_report_async(ticos_client_t *client, ticos_report_t report, int index)
+{
+    ticos_send_req_t req = { client, report, index };
+
+    if (report == TICOS_REPORT_PROPERTY_INDEX && (index < 0 || index >= client->model->property_cnt))
+        return TICOS_SEND_ERROR;
+    if (report == TICOS_REPORT_TELEMETRY_INDEX && (index < 0 || index >= client->model->telemetry_cnt))
+        return TICOS_SEND_ERROR;
+    pthread_once(&m_queue_once, ticos_send_queue_init);
+    if (ticos_queue_push(&m_queue, &req)) {
+        ticos_metrics_count(TICOS_METRIC_SEND_FULL);
+        return TICOS_SEND_FULL;
+    }
+    ticos_metrics_queue(TICOS_METRIC_SEND_QUEUE, ticos_queue_count(&m_queue));
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&m_waiting))
+        ticos_sender_wake();
+    return TICOS_SEND_OK;
+}
+
+#else
+
+int ticos_sender_start(void)
+{
+    return -1;
+}
+
+void ticos_sender_stop(void)
+{
+}
+
+int ticos_send_pending(void)
+{
+    return 0;
+}
+
+void ticos_sender_notify(void)
+{
+}
+
+ticos_send_status_t ticos_client_report_async(ticos_client_t *client, ticos_report_t report, int index)
+{
+    return TICOS_SEND_ERROR;
+}
+
+#endif
+
+/*
+ * 不带上下文参数的接口操作默认设备
+ */
+ticos_send_status_t ticos_property_report_async(void)
+{
+    return ticos_client_report_async(ticos_client_default(), TICOS_REPORT_PROPERTY, 0);
+}
+
+ticos_send_status_t ticos_property_report_changed_async(void)
+{
+    return ticos_client_report_async(ticos_client_default(), TICOS_REPORT_PROPERTY_CHANGED, 0);
+}
+
+ticos_send_status_t ticos_property_report_by_index_async(int index)
+{
+    return ticos_client_report_async(ticos_client_default(), TICOS_REPORT_PROPERTY_INDEX, index);
+}
+
+ticos_send_status_t ticos_telemetry_report_async(void)
+{
+    return ticos_client_report_async(ticos_client_default(), TICOS_REPORT_TELEMETRY, 0);
+}
+
+ticos_send_status_t ticos_telemetry_report_by_index_async(int index)
+{
+    return ticos_client_report_async(ticos_client_default(), TICOS_REPORT_TELEMETRY_INDEX, index);
+}
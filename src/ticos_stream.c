@@ -0,0 +1,248 @@
+#include "ticos_stream.h"
+#include "ticos_json_writer.h"
+#include "ticos_metrics.h"
+#include "ticos_rate.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_time.h"
+#include "ticos_trace.h"
+#include <limits.h>
+#include <string.h>
+#if TICOS_CBOR
+#include "ticos_cbor.h"
+#endif
+
+// 平台可选的分块发布接口, 缺少时只能发送能放入上报缓冲区的消息
+extern int ticos_hal_mqtt_publish_begin(const char *topic, int len, int qos, int retain) __attribute__((weak));
+extern int ticos_hal_mqtt_publish_write(const void *data, int len) __attribute__((weak));
+extern int ticos_hal_mqtt_publish_end(void) __attribute__((weak));
+
+/*
+ * 消息由首部、字段内容和尾部组成, 依次写入上报缓冲区; 分块发送时缓冲区写满即写入连接,
+ * 否则整条消息写入缓冲区后按普通消息发送
+ */
+typedef struct {
+    char *buf;
+    int size;
+    int len;                    // 缓冲区中尚未写出的字节数
+    int chunked;
+    int failed;
+    int json;
+    int binary;
+    unsigned char carry[3];     // base64 编码时不足 3 字节的余数
+    int carry_len;
+    int content;                // 已输出的字段内容的长度
+} ticos_stream_t;
+
+static void ticos_stream_put(ticos_stream_t *s, const void *data, int n)
+{
+    const char *p = data;
+
+    while (n > 0 && !s->failed) {
+        if (s->len == s->size) {
+            if (!s->chunked || ticos_hal_mqtt_publish_write(s->buf, s->len) < 0) {
+                s->failed = 1;
+                return;
+            }
+            s->len = 0;
+        }
+        int k = s->size - s->len < n ? s->size - s->len : n;
+        memcpy(s->buf + s->len, p, k);
+        s->len += k;
+        p += k;
+        n -= k;
+    }
+}
+
+static void ticos_stream_base64(ticos_stream_t *s, const unsigned char *in, int n)
+{
+    static const char tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char out[4];
+
+    out[0] = tab[in[0] >> 2];
+    out[1] = tab[(in[0] & 0x3) << 4 | (n > 1 ? in[1] >> 4 : 0)];
+    out[2] = n > 1 ? tab[(in[1] & 0xf) << 2 | (n > 2 ? in[2] >> 6 : 0)] : '=';
+    out[3] = n > 2 ? tab[in[2] & 0x3f] : '=';
+    ticos_stream_put(s, out, 4);
+}
+
+// 输出一块字段内容, JSON 文本逐字节转义, JSON 二进制数据编码为 base64, CBOR 原样输出
+static void ticos_stream_content(ticos_stream_t *s, const unsigned char *dat, int n)
+{
+    const unsigned char *end = dat + n;
+
+    if (!s->json) {
+        ticos_stream_put(s, dat, n);
+        s->content += n;
+        return;
+    }
+    if (s->binary) {
+        while (dat < end) {
+            s->carry[s->carry_len++] = *dat++;
+            if (s->carry_len == 3) {
+                ticos_stream_base64(s, s->carry, 3);
+                s->carry_len = 0;
+                s->content += 4;
+            }
+        }
+        return;
+    }
+    const unsigned char *run = dat;
+    for (; dat < end; dat++) {
+        char esc[6];
+        int k = ticos_json_escape(*dat, esc);
+        if (!k)
+            continue;
+        ticos_stream_put(s, run, dat - run);
+        ticos_stream_put(s, esc, k);
+        s->content += dat - run + k;
+        run = dat + 1;
+    }
+    ticos_stream_put(s, run, dat - run);
+    s->content += dat - run;
+}
+
+/*
+ * 完整读取一遍字段内容, 返回编码后的长度, raw 输出原始数据的长度; 读取失败或超出 int 范围时返回 -1
+ */
+static int ticos_stream_measure(ticos_stream_read_t read, int json, int binary, int *raw)
+{
+    unsigned char chunk[TICOS_STREAM_CHUNK_SIZE];
+    int64_t len = 0;
+    int64_t total = 0;
+
+    for (;;) {
+        int n = read((size_t)total, chunk, sizeof(chunk));
+        if (n < 0 || n > (int)sizeof(chunk))
+            return -1;
+        if (!n)
+            break;
+        total += n;
+        if (json && !binary) {
+            char esc[6];
+            for (int i = 0; i < n; i++) {
+                int k = ticos_json_escape(chunk[i], esc);
+                len += k ? k : 1;
+            }
+        }
+        if (total > INT_MAX / 2 || len > INT_MAX / 2)
+            return -1;
+    }
+    *raw = (int)total;
+    if (!json)
+        return (int)total;
+    return binary ? (int)((total + 2) / 3 * 4) : (int)len;
+}
+
+int ticos_stream_report(ticos_client_t *client, ticos_topic_class_t cls, int index)
+{
+    const ticos_thingmodel_t *model = client->model;
+    unsigned char chunk[TICOS_STREAM_CHUNK_SIZE];
+    ticos_stream_t s;
+    ticos_stream_read_t read;
+    const char *id;
+    const char *topic;
+    ticos_val_type_t type;
+    int raw;
+
+    if (cls == TICOS_TOPIC_TELEMETRY) {
+        id = model->telemetry_tab[index].id;
+        type = model->telemetry_tab[index].type;
+        read = (ticos_stream_read_t)model->telemetry_tab[index].func;
+        topic = client->telemetry_topic;
+    } else {
+        id = model->property_tab[index].id;
+        type = model->property_tab[index].type;
+        read = (ticos_stream_read_t)model->property_tab[index].send_func;
+        topic = client->property_report_topic;
+    }
+    memset(&s, 0, sizeof(s));
+    s.buf = ticos_report_buffer(&s.size);
+    s.json = client->payload_format != TICOS_PAYLOAD_CBOR;
+    s.binary = type == TICOS_VAL_TYPE_BLOB;
+
+    TICOS_TRACE_BEGIN(TICOS_TRACE_GETTER, index);
+    int content = ticos_stream_measure(read, s.json, s.binary, &raw);
+    TICOS_TRACE_END(TICOS_TRACE_GETTER);
+    if (content < 0)
+        return -1;
+
+    // 首部: {"id":" 或 CBOR 的自描述标签、物模型哈希、字段下标和字符串首部
+    if (s.json) {
+        ticos_json_writer_t w;
+        ticos_json_writer_init(&w, s.buf, s.size);
+        ticos_json_object_begin(&w);
+        ticos_json_key(&w, id);
+        s.len = ticos_json_writer_finish(&w);
+        if (s.len >= 0)
+            s.buf[s.len++] = '\"';
+    }
+#if TICOS_CBOR
+    else {
+        ticos_cbor_writer_t w;
+        ticos_cbor_writer_init(&w, s.buf, s.size);
+        ticos_cbor_self_describe(&w);
+        ticos_cbor_map_begin(&w);
+        ticos_cbor_int(&w, TICOS_CBOR_KEY_HASH);
+        ticos_cbor_int(&w, model->hash);
+        ticos_cbor_int(&w, index);
+        ticos_cbor_string_head(&w, raw, s.binary);
+        s.len = ticos_cbor_writer_finish(&w);
+    }
+#endif
+    if (s.len < 0 || s.len >= s.size)
+        return -1;
+    int total = s.len + content + (s.json ? 2 : 1);
+
+    uint32_t start = ticos_metrics_clock();
+    int ret = 0;
+    s.chunked = total > s.size;
+    if (s.chunked) {
+        // 分块发送的消息不能进入离线队列, 也不能越过队列中待重发的消息
+        if (!ticos_hal_mqtt_publish_begin || ticos_offline_pending() > 0)
+            return -1;
+        TICOS_TRACE_BEGIN(TICOS_TRACE_PUBLISH, total);
+        ret = ticos_hal_mqtt_publish_begin(topic, total, 1, 0);
+        if (ret < 0) {
+            TICOS_TRACE_END(TICOS_TRACE_PUBLISH);
+            ticos_metrics_traffic(cls == TICOS_TOPIC_TELEMETRY ? TICOS_METRIC_TELEMETRY : TICOS_METRIC_PROPERTY, total, 1);
+            return -1;
+        }
+    }
+
+    TICOS_TRACE_BEGIN(TICOS_TRACE_ENCODE, cls);
+    for (int offset = 0; offset < raw && !s.failed;) {
+        int n = read(offset, chunk, raw - offset < (int)sizeof(chunk) ? raw - offset : (int)sizeof(chunk));
+        if (n <= 0 || n > raw - offset) {
+            s.failed = 1;
+            break;
+        }
+        ticos_stream_content(&s, chunk, n);
+        offset += n;
+    }
+    if (s.carry_len) {
+        ticos_stream_base64(&s, s.carry, s.carry_len);
+        s.content += 4;
+    }
+    ticos_stream_put(&s, s.json ? "\"}" : "\xff", s.json ? 2 : 1);
+    TICOS_TRACE_END(TICOS_TRACE_ENCODE);
+    // 两次读取的数据不一致时, 已声明的消息长度不再正确
+    if (s.content != content)
+        s.failed = 1;
+
+    ticos_rate_consume(cls, total, ticos_uptime_ms());
+    if (!s.chunked) {
+        if (s.failed)
+            return -1;
+        return ticos_metrics_publish(cls == TICOS_TOPIC_TELEMETRY ? TICOS_METRIC_TELEMETRY : TICOS_METRIC_PROPERTY,
+                                     topic, s.buf, s.len, 1, 0);
+    }
+    // 发送失败或长度不符时平台需放弃这条未完成的报文
+    if (!s.failed && s.len && ticos_hal_mqtt_publish_write(s.buf, s.len) < 0)
+        s.failed = 1;
+    if (ticos_hal_mqtt_publish_end() < 0)
+        s.failed = 1;
+    TICOS_TRACE_END(TICOS_TRACE_PUBLISH);
+    ticos_metrics_latency(TICOS_METRIC_PUBLISH, start);
+    ticos_metrics_traffic(cls == TICOS_TOPIC_TELEMETRY ? TICOS_METRIC_TELEMETRY : TICOS_METRIC_PROPERTY, total, s.failed);
+    return s.failed ? -1 : ret;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ticos_client.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  上报一个流式字段, 消息中只含此字段
+ * @note   字段内容以方法表中登记的 ticos_stream_read_t 分块读取, 边读取边转义或编码为 base64。消息能放入上报缓冲区时
+ *         与普通上报一样经 ticos_publish() 发送; 否则需要平台提供 ticos_hal_mqtt_publish_begin/write/end(),
+ *         以上报缓冲区为中转分块写入连接, 此时离线队列中不能有待重发的消息
+ * @param cls 字段所属的类别
+ * @param index 字段在方法表中的下标, 字段类型须为 TICOS_VAL_TYPE_STREAM 或 TICOS_VAL_TYPE_BLOB
+ * @return 与 ticos_publish() 相同, 读取或发送失败时返回 -1
+ */
+int ticos_stream_report(ticos_client_t *client, ticos_topic_class_t cls, int index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,235 @@
+#include "ticos_api.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_config.h"
+#include "ticos_metrics.h"
+#include "ticos_time.h"
+#include "ticos_ring.h"
+#include <stdint.h>
+#include <string.h>
+
+#if TICOS_TELEMETRY_BATCH_SIZE > 0
+
+#define TICOS_BATCH_PREFIX      "{\"samples\":["
+#define TICOS_BATCH_SUFFIX      "]}"
+#define TICOS_BATCH_PREFIX_LEN  ((int)sizeof(TICOS_BATCH_PREFIX) - 1)
+#define TICOS_BATCH_SUFFIX_LEN  ((int)sizeof(TICOS_BATCH_SUFFIX) - 1)
+
+/*
+ * 环形缓存中的每个样本由采集时的系统时间和编码好的 JSON 对象组成,
+ * 系统时间用于计算样本的缓存时长。样本和批量消息都在上报缓冲区中编码, 环形缓存和上报缓冲区只在持有上报锁时访问
+ */
+typedef uint32_t ticos_batch_hdr_t;
+
+static unsigned char ticos_batch_buf[TICOS_TELEMETRY_BATCH_SIZE];
+static ticos_ring_t m_batch_ring = { ticos_batch_buf, sizeof(ticos_batch_buf), 0, 0, 0 };
+
+static int m_batch_max_samples = TICOS_TELEMETRY_BATCH_MAX_SAMPLES;
+static int m_batch_max_bytes = TICOS_TELEMETRY_BATCH_MAX_BYTES;
+static int m_batch_max_age_ms = TICOS_TELEMETRY_BATCH_MAX_AGE_MS;
+
+static int ticos_batch_sample_len(int pos)
+{
+    return ticos_ring_len(&m_batch_ring, pos) - sizeof(ticos_batch_hdr_t);
+}
+
+// 所有样本 JSON 的总长度
+static int ticos_batch_bytes(void)
+{
+    return m_batch_ring.used - m_batch_ring.count * (TICOS_RING_HDR_SIZE + (int)sizeof(ticos_batch_hdr_t));
+}
+
+static void ticos_batch_drop(int n)
+{
+    while (n-- > 0 && m_batch_ring.count > 0)
+        ticos_ring_pop(&m_batch_ring);
+}
+
+// 含 n 个样本, 总长度为 bytes 的批量消息的长度
+static int ticos_batch_payload_len(int n, int bytes)
+{
+    return TICOS_BATCH_PREFIX_LEN + bytes + (n > 0 ? n - 1 : 0) + TICOS_BATCH_SUFFIX_LEN;
+}
+
+static int ticos_batch_budget(void)
+{
+    int size;
+    ticos_report_buffer(&size);
+    size -= 1;  // 结尾的 '\0'
+    if (m_batch_max_bytes > 0 && m_batch_max_bytes < size)
+        return m_batch_max_bytes;
+    return size;
+}
+
+// 将最早的 n 个样本打包为一条消息发送, 发送成功后从缓存中移除
+static int ticos_batch_publish(int n)
+{
+    int size;
+    char *buf = ticos_report_buffer(&size);
+    int pos = ticos_ring_first(&m_batch_ring);
+    int len = TICOS_BATCH_PREFIX_LEN;
+
+    if (n <= 0)
+        return 0;
+    memcpy(buf, TICOS_BATCH_PREFIX, TICOS_BATCH_PREFIX_LEN);
+    for (int i = 0; i < n; i++) {
+        int sample_len = ticos_batch_sample_len(pos);
+        if (len + sample_len + 1 + TICOS_BATCH_SUFFIX_LEN >= size)
+            return -1;
+        if (i)
+            buf[len++] = ',';
+        ticos_ring_read(&m_batch_ring, pos, sizeof(ticos_batch_hdr_t), buf + len, sample_len);
+        len += sample_len;
+        pos = ticos_ring_next(&m_batch_ring, pos);
+    }
+    memcpy(buf + len, TICOS_BATCH_SUFFIX, TICOS_BATCH_SUFFIX_LEN);
+    len += TICOS_BATCH_SUFFIX_LEN;
+    buf[len] = '\0';
+
+    int ret = ticos_metrics_publish(TICOS_METRIC_TELEMETRY, ticos_client_default()->telemetry_topic, buf, len, 1, 0);
+    // 发送失败时保留样本, 等待下次发送
+    if (ret >= 0)
+        ticos_batch_drop(n);
+    return ret;
+}
+
+// 从最早的样本起, 计算一条消息最多能容纳的样本数
+static int ticos_batch_fit(void)
+{
+    int budget = ticos_batch_budget();
+    int pos = ticos_ring_first(&m_batch_ring);
+    int bytes = 0;
+    int n = 0;
+
+    while (n < m_batch_ring.count) {
+        int sample_len = ticos_batch_sample_len(pos);
+        if (ticos_batch_payload_len(n + 1, bytes + sample_len) > budget)
+            break;
+        bytes += sample_len;
+        pos = ticos_ring_next(&m_batch_ring, pos);
+        n++;
+    }
+    return n;
+}
+
+static int ticos_batch_expired(void)
+{
+    ticos_batch_hdr_t uptime;
+
+    if (m_batch_max_age_ms <= 0 || !m_batch_ring.count)
+        return 0;
+    ticos_ring_read(&m_batch_ring, ticos_ring_first(&m_batch_ring), 0, &uptime, sizeof(uptime));
+    return (uint32_t)ticos_uptime_ms() - uptime >= (uint32_t)m_batch_max_age_ms;
+}
+
+void ticos_telemetry_batch_policy(int max_samples, int max_bytes, int max_age_ms)
+{
+    ticos_report_lock();
+    m_batch_max_samples = max_samples;
+    m_batch_max_bytes = max_bytes;
+    m_batch_max_age_ms = max_age_ms;
+    ticos_report_unlock();
+}
+
+static int ticos_batch_flush(void)
+{
+    while (m_batch_ring.count > 0) {
+        int n = ticos_batch_fit();
+        // 缩小大小限制后, 单个样本可能已无法发送, 直接丢弃
+        if (!n) {
+            ticos_batch_drop(1);
+            continue;
+        }
+        int ret = ticos_batch_publish(n);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int ticos_batch_sample(void)
+{
+    int size;
+    char *buf = ticos_report_buffer(&size);
+    ticos_json_writer_t w;
+    ticos_value_t val;
+    // 批量上报只支持默认设备
+    const ticos_thingmodel_t *model = ticos_client_default()->model;
+
+    // 样本先编码到上报缓冲区中, 再复制到环形缓存
+    ticos_json_writer_init(&w, buf, size);
+    ticos_json_object_begin(&w);
+    ticos_json_add_int(&w, "ts", ticos_time_ms());
+    for (int i = 0; i < model->telemetry_cnt; i++) {
+        ticos_value_get(&val, model->telemetry_tab[i].type, model->telemetry_tab[i].func);
+        ticos_json_add_value(&w, model->telemetry_tab[i].id, &val);
+    }
+    ticos_json_object_end(&w);
+    int len = ticos_json_writer_finish(&w);
+    if (len < 0 || ticos_batch_payload_len(1, len) > ticos_batch_budget())
+        return -1;
+
+    // 缓存已满时丢弃最早的样本
+    ticos_batch_hdr_t uptime = (uint32_t)ticos_uptime_ms();
+    if (ticos_ring_push(&m_batch_ring, &uptime, sizeof(uptime), buf, len) < 0)
+        return -1;
+
+    // 缓存的样本超出单条消息的大小限制时, 先发送能容纳的部分
+    if (ticos_batch_payload_len(m_batch_ring.count, ticos_batch_bytes()) > ticos_batch_budget()) {
+        int ret = ticos_batch_publish(ticos_batch_fit());
+        if (ret < 0)
+            return ret;
+    }
+    if ((m_batch_max_samples > 0 && m_batch_ring.count >= m_batch_max_samples) || ticos_batch_expired())
+        return ticos_batch_flush();
+    return 0;
+}
+
+int ticos_telemetry_sample(void)
+{
+    ticos_report_lock();
+    int ret = ticos_batch_sample();
+    ticos_report_unlock();
+    return ret;
+}
+
+int ticos_telemetry_flush(void)
+{
+    ticos_report_lock();
+    int ret = ticos_batch_flush();
+    ticos_report_unlock();
+    return ret;
+}
+
+int ticos_telemetry_batch_poll(void)
+{
+    int ret = 0;
+
+    ticos_report_lock();
+    if (ticos_batch_expired())
+        ret = ticos_batch_flush();
+    ticos_report_unlock();
+    return ret;
+}
+
+#else
+
+void ticos_telemetry_batch_policy(int max_samples, int max_bytes, int max_age_ms)
+{
+}
+
+int ticos_telemetry_sample(void)
+{
+    return -1;
+}
+
+int ticos_telemetry_flush(void)
+{
+    return -1;
+}
+
+int ticos_telemetry_batch_poll(void)
+{
+    return 0;
+}
+
+#endif
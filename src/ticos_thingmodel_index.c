@@ -0,0 +1,29 @@
+#include "ticos_thingmodel_index.h"
+
+#define TICOS_HASH_PRIME    0x01000193
+
+uint32_t ticos_hash(uint32_t seed, const char *key, int len)
+{
+    uint32_t h = seed ? seed : TICOS_HASH_PRIME;
+    for (int i = 0; i < len; i++)
+        h = (h * TICOS_HASH_PRIME) ^ (unsigned char)key[i];
+    // 末尾再混合一次, 使低位也能均匀分布
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+int ticos_index_lookup(const ticos_thingmodel_index_t *index, const char *key, int len)
+{
+    if (!index || index->size <= 0)
+        return -1;
+
+    int d = index->disp[ticos_hash(0, key, len) % index->size];
+    uint32_t slot = d < 0 ? (uint32_t)(-d - 1) : ticos_hash(d, key, len) % index->size;
+    if (index->slots[slot].len != len)
+        return -1;
+    return index->slots[slot].index;
+}
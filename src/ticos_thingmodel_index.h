@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include "ticos_thingmodel_type.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  计算字段名的哈希值
+ * @note   须与 ticos_thingmodel_gen.py 中的 fnv_hash() 保持一致
+ * @param seed 哈希种子, 0 代表使用默认种子
+ * @param key 字段名, 不要求以 '\0' 结尾
+ * @param len 字段名长度
+ * @return 哈希值
+ */
+uint32_t ticos_hash(uint32_t seed, const char *key, int len);
+
+/**
+ * @brief  在完美哈希表中查找字段名
+ * @note   未知字段名也可能命中某个槽位, 调用者需再比较一次字段名以确认
+ * @param index 生成的哈希表
+ * @param key 字段名, 不要求以 '\0' 结尾
+ * @param len 字段名长度
+ * @return 字段在方法表中的下标, 未找到时返回 -1
+ */
+int ticos_index_lookup(const ticos_thingmodel_index_t *index, const char *key, int len);
+
+#ifdef __cplusplus
+}
+#endif
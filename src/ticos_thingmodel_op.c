@@ -1,230 +1,1738 @@
-#include "ticos_thingmodel_type.h"
+#include "ticos_thingmodel_op.h"
+#include "ticos_thingmodel_index.h"
+#include "ticos_config.h"
+#include "ticos_mem.h"
+#include "ticos_metrics.h"
+#include "ticos_command.h"
+#include "ticos_rate.h"
+#include "ticos_schedule.h"
+#include "ticos_stream.h"
+#include "ticos_time.h"
+#include "ticos_trace.h"
+#include "ticos_number.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#if TICOS_THREAD_SAFE
+#include <pthread.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#if !TICOS_JSON_STREAM || !TICOS_JSON_TOKENIZER
 #include "cJSON.h"
+#endif
+#if TICOS_JSON_TOKENIZER
+#include "ticos_json_reader.h"
+#endif
+#if TICOS_CBOR
+#include "ticos_cbor.h"
+#endif
+#if TICOS_RECV_FRAGMENT_SIZE > 0
+#include "ticos_json_feed.h"
+#endif
 
-typedef int (*_ticos_send_int_t)();
-typedef int (*_ticos_send_bool_t)();
-typedef float (*_ticos_send_float_t)();
-typedef const char* (*_ticos_send_string_t)();
+#if !TICOS_THREAD_SAFE && (TICOS_SEND_QUEUE_SIZE > 0 || TICOS_COMMAND_QUEUE_SIZE > 0)
+#error "TICOS_SEND_QUEUE_SIZE and TICOS_COMMAND_QUEUE_SIZE require TICOS_THREAD_SAFE"
+#endif
 
-typedef void (*_ticos_recv_int_t)(int);
-typedef void (*_ticos_recv_bool_t)(int);
-typedef void (*_ticos_recv_float_t)(float);
-typedef void (*_ticos_recv_string_t)(const char*);
+// 正在处理上报或下发的设备; 接收线程、发送线程和应用线程可能同时处理, 需按线程分别记录
+#if TICOS_THREAD_SAFE
+static _Thread_local ticos_client_t *m_current = NULL;
+#else
+static ticos_client_t *m_current = NULL;
+#endif
 
-extern const ticos_telemetry_info_t ticos_telemetry_tab[];
-extern const ticos_property_info_t ticos_property_tab[];
-extern const ticos_command_info_t ticos_command_tab[];
-extern const int ticos_telemetry_cnt;
-extern const int ticos_property_cnt;
-extern const int ticos_command_cnt;
+ticos_client_t *ticos_client_current(void)
+{
+    return m_current ? m_current : ticos_client_default();
+}
 
-extern char ticos_property_report_topic[];
-extern char ticos_telemery_topic[];
-int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain);
+// 物模型回调中可能再次调用上报接口, 退出时需恢复外层的设备
+static ticos_client_t *ticos_client_enter(ticos_client_t *client)
+{
+    ticos_client_t *prev = m_current;
+    m_current = client;
+    return prev;
+}
 
-int ticos_telemetry_report(void)
+void ticos_value_get(ticos_value_t *val, ticos_val_type_t type, void *func)
 {
-    cJSON *telemetries = cJSON_CreateObject();
+    val->type = type;
+    switch (type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        val->v.i = ((_ticos_send_bool_t)func)();
+        break;
+    case TICOS_VAL_TYPE_INTEGER:
+        val->v.i = ((_ticos_send_int_t)func)();
+        break;
+    case TICOS_VAL_TYPE_FLOAT:
+        val->v.f = ((_ticos_send_float_t)func)();
+        break;
+    case TICOS_VAL_TYPE_STRING:
+        val->v.s = ((_ticos_send_string_t)func)();
+        break;
+    case TICOS_VAL_TYPE_STREAM:
+    case TICOS_VAL_TYPE_BLOB:
+        // 流式字段只能单独上报, 在其他上报中与值为 NULL 的字符串一样被跳过
+        val->type = TICOS_VAL_TYPE_STRING;
+        val->v.s = NULL;
+        break;
+    default:
+        val->v.i = 0;
+        break;
+    }
+}
 
-    for (int i = 0; i < ticos_telemetry_cnt; i++) {
-        void *func = ticos_telemetry_tab[i].func;
-        switch (ticos_telemetry_tab[i].type) {
-        case TICOS_VAL_TYPE_BOOLEAN:
-            cJSON_AddBoolToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_bool_t)func)());
-            break;
-        case TICOS_VAL_TYPE_INTEGER:
-            cJSON_AddNumberToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_int_t)func)());
-            break;
-        case TICOS_VAL_TYPE_FLOAT:
-            cJSON_AddNumberToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_float_t)func)());
-            break;
-        case TICOS_VAL_TYPE_STRING:
-            cJSON_AddStringToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_string_t)func)());
-            break;
-        default:
-            cJSON_AddNullToObject(telemetries, ticos_telemetry_tab[i].id);
-            break;
-        }
+int ticos_value_set(const ticos_value_t *val, void *func)
+{
+    switch (val->type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        return ((_ticos_recv_bool_t)func)(val->v.i);
+    case TICOS_VAL_TYPE_INTEGER:
+        return ((_ticos_recv_int_t)func)(val->v.i);
+    case TICOS_VAL_TYPE_FLOAT:
+        return ((_ticos_recv_float_t)func)(val->v.f);
+    case TICOS_VAL_TYPE_STRING:
+        return ((_ticos_recv_string_t)func)(val->v.s);
+    default:
+        return -1;
     }
+}
 
-    char *telemetries_str = cJSON_PrintUnformatted(telemetries);
+static char ticos_report_buf[TICOS_REPORT_BUF_SIZE];
+static char *m_report_buf = ticos_report_buf;
+static int m_report_buf_size = sizeof(ticos_report_buf);
 
-    int ret = ticos_hal_mqtt_publish(ticos_telemery_topic, telemetries_str, strlen(telemetries_str), 1, 0);
-    cJSON_free(telemetries_str);
-    cJSON_Delete(telemetries);
-    return ret;
+#if TICOS_THREAD_SAFE
+static pthread_mutex_t m_report_lock;
+static pthread_once_t m_report_lock_once = PTHREAD_ONCE_INIT;
+
+// 上报接口可能在物模型回调中再次调用, 需使用可重入锁
+static void ticos_report_lock_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_report_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
 }
 
-void ticos_command_receive(const char *dat, int len)
+void ticos_report_lock(void)
 {
-    cJSON *commands = cJSON_Parse(dat);
-    if ((!commands) || (!cJSON_IsObject(commands)))
-        return;
+    pthread_once(&m_report_lock_once, ticos_report_lock_init);
+    pthread_mutex_lock(&m_report_lock);
+}
 
-    int size = cJSON_GetArraySize(commands);
-    for (int i = 0; i < size; i++) {
-        cJSON *command = cJSON_GetArrayItem(commands, i);
-        for (int j = 0; j < ticos_command_cnt; j++) {
-            if (!strcmp(command->string, ticos_command_tab[j].id)) {
-                void *command_func = ticos_command_tab[j].func;
-                switch (ticos_command_tab[j].type) {
-                case TICOS_VAL_TYPE_BOOLEAN:
-                    if (cJSON_IsBool(command))
-                        ((_ticos_recv_bool_t)command_func)(cJSON_IsTrue(command));
-                    break;
-                case TICOS_VAL_TYPE_INTEGER:
-                    if (cJSON_IsNumber(command))
-                        ((_ticos_recv_int_t)command_func)(cJSON_GetNumberValue(command));
-                    break;
-                case TICOS_VAL_TYPE_FLOAT:
-                    if (cJSON_IsNumber(command))
-                        ((_ticos_recv_float_t)command_func)(cJSON_GetNumberValue(command));
-                    break;
-                case TICOS_VAL_TYPE_STRING:
-                    if (cJSON_IsString(command))
-                        ((_ticos_recv_string_t)command_func)(cJSON_GetStringValue(command));
-                    break;
-                default:
-                    break;
-                }
-            }
-        }
+void ticos_report_unlock(void)
+{
+    pthread_mutex_unlock(&m_report_lock);
+}
+#else
+void ticos_report_lock(void)
+{
+}
+
+void ticos_report_unlock(void)
+{
+}
+#endif
+
+int ticos_set_report_buffer(char *buf, int size)
+{
+    if (buf && size <= 0)
+        return -1;
+    ticos_report_lock();
+    m_report_buf = buf ? buf : ticos_report_buf;
+    m_report_buf_size = buf ? size : (int)sizeof(ticos_report_buf);
+    ticos_report_unlock();
+    return 0;
+}
+
+char *ticos_report_buffer(int *size)
+{
+    *size = m_report_buf_size;
+    return m_report_buf;
+}
+
+void ticos_json_add_value(ticos_json_writer_t *w, const char *id, const ticos_value_t *val)
+{
+    switch (val->type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        ticos_json_add_bool(w, id, val->v.i);
+        break;
+    case TICOS_VAL_TYPE_INTEGER:
+        ticos_json_add_int(w, id, val->v.i);
+        break;
+    case TICOS_VAL_TYPE_FLOAT:
+        ticos_json_add_float(w, id, val->v.f);
+        break;
+    case TICOS_VAL_TYPE_STRING:
+        // 与 cJSON 行为一致: 字符串为 NULL 时不输出该字段
+        if (val->v.s)
+            ticos_json_add_string(w, id, val->v.s);
+        break;
+    default:
+        ticos_json_add_null(w, id);
+        break;
     }
-    cJSON_Delete(commands);
 }
 
-void ticos_property_receive(const char *dat, int len)
+// 发送一条上报消息, 并扣除所属类别的限速令牌; start 为开始编码的时间
+static int ticos_report_send(ticos_topic_class_t cls, const char *topic, const char *data, int len, uint32_t start)
 {
-    cJSON *propretys = cJSON_Parse(dat);
-    if ((!propretys) || (!cJSON_IsObject(propretys)))
-        return;
+    ticos_metrics_latency(TICOS_METRIC_SERIALIZE, start);
+    ticos_rate_consume(cls, len, ticos_uptime_ms());
+    return ticos_metrics_publish(cls == TICOS_TOPIC_TELEMETRY ? TICOS_METRIC_TELEMETRY : TICOS_METRIC_PROPERTY,
+                                 topic, data, len, 1, 0);
+}
 
-    int size = cJSON_GetArraySize(propretys);
-    for (int i = 0; i < size; i++) {
-        cJSON *property = cJSON_GetArrayItem(propretys, i);
-        for (int j = 0; j < ticos_property_cnt; j++) {
-            if (!strcmp(ticos_property_tab[j].id, property->string)) {
-                void *recv_func = ticos_property_tab[j].recv_func;
-                switch (ticos_property_tab[j].type) {
-                case TICOS_VAL_TYPE_BOOLEAN:
-                    if (cJSON_IsBool(property))
-                        ((_ticos_recv_bool_t)recv_func)(cJSON_IsTrue(property));
-                    break;
-                case TICOS_VAL_TYPE_INTEGER:
-                    if (cJSON_IsNumber(property))
-                        ((_ticos_recv_int_t)recv_func)(cJSON_GetNumberValue(property));
-                    break;
-                case TICOS_VAL_TYPE_FLOAT:
-                    if (cJSON_IsNumber(property))
-                        ((_ticos_recv_float_t)recv_func)(cJSON_GetNumberValue(property));
-                    break;
-                case TICOS_VAL_TYPE_STRING:
-                    if (cJSON_IsString(property))
-                        ((_ticos_recv_string_t)recv_func)(cJSON_GetStringValue(property));
-                    break;
-                default:
-                    break;
-                }
-                break;
-            }
+#if TICOS_JSON_STREAM
+typedef struct {
+    ticos_json_writer_t writer;
+} ticos_json_payload_t;
+
+static void ticos_json_payload_begin(ticos_json_payload_t *payload)
+{
+    ticos_json_writer_init(&payload->writer, m_report_buf, m_report_buf_size);
+    ticos_json_object_begin(&payload->writer);
+}
+
+static void ticos_json_payload_add(ticos_json_payload_t *payload, const char *id, const ticos_value_t *val)
+{
+    ticos_json_add_value(&payload->writer, id, val);
+}
+
+static void ticos_json_payload_discard(ticos_json_payload_t *payload)
+{
+}
+
+static int ticos_json_payload_publish(ticos_json_payload_t *payload, ticos_topic_class_t cls, const char *topic,
+                                      uint32_t start)
+{
+    TICOS_TRACE_BEGIN(TICOS_TRACE_ENCODE, cls);
+    ticos_json_object_end(&payload->writer);
+    int len = ticos_json_writer_finish(&payload->writer);
+    TICOS_TRACE_END(TICOS_TRACE_ENCODE);
+    if (len < 0)
+        return -1;
+    return ticos_report_send(cls, topic, m_report_buf, len, start);
+}
+#else
+typedef struct {
+    cJSON *root;
+} ticos_json_payload_t;
+
+static void ticos_json_payload_begin(ticos_json_payload_t *payload)
+{
+    ticos_mem_begin();
+    payload->root = cJSON_CreateObject();
+}
+
+// 数值使用 SDK 的数值编码而不是 cJSON 的 "%1.15g", 与流式编码的输出一致
+static void ticos_json_payload_add(ticos_json_payload_t *payload, const char *id, const ticos_value_t *val)
+{
+    cJSON *root = payload->root;
+    char num[TICOS_NUMBER_MAX];
+    switch (val->type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        cJSON_AddBoolToObject(root, id, val->v.i);
+        break;
+    case TICOS_VAL_TYPE_INTEGER:
+        ticos_itoa(val->v.i, num);
+        cJSON_AddRawToObject(root, id, num);
+        break;
+    case TICOS_VAL_TYPE_FLOAT:
+        if (isnan(val->v.f) || isinf(val->v.f)) {
+            cJSON_AddNullToObject(root, id);
+            break;
         }
+        ticos_ftoa(val->v.f, num);
+        cJSON_AddRawToObject(root, id, num);
+        break;
+    case TICOS_VAL_TYPE_STRING:
+        cJSON_AddStringToObject(root, id, val->v.s);
+        break;
+    default:
+        cJSON_AddNullToObject(root, id);
+        break;
     }
-    cJSON_Delete(propretys);
 }
 
-int ticos_property_report(void)
+static void ticos_json_payload_discard(ticos_json_payload_t *payload)
+{
+    cJSON_Delete(payload->root);
+    payload->root = NULL;
+    ticos_mem_end();
+}
+
+static int ticos_json_payload_publish(ticos_json_payload_t *payload, ticos_topic_class_t cls, const char *topic,
+                                      uint32_t start)
+{
+    TICOS_TRACE_BEGIN(TICOS_TRACE_ENCODE, cls);
+    char *str = payload->root ? cJSON_PrintUnformatted(payload->root) : NULL;
+    TICOS_TRACE_END(TICOS_TRACE_ENCODE);
+    int ret = -1;
+    if (str) {
+        ret = ticos_report_send(cls, topic, str, strlen(str), start);
+        cJSON_free(str);
+    }
+    cJSON_Delete(payload->root);
+    payload->root = NULL;
+    ticos_mem_end();
+    return ret;
+}
+#endif
+
+int ticos_client_set_payload_format(ticos_client_t *client, ticos_payload_format_t format)
+{
+#if !TICOS_CBOR
+    if (format != TICOS_PAYLOAD_JSON)
+        return -1;
+#endif
+    client->payload_format = format;
+    return 0;
+}
+
+/*
+ * 上报数据按所选格式编码, CBOR 以字段下标作为键, 直接编码到上报缓冲区中
+ */
+typedef struct {
+#if TICOS_CBOR
+    int cbor;
+    ticos_cbor_writer_t cbor_writer;
+#endif
+    ticos_json_payload_t json;
+    uint32_t start;         // 开始编码的时间, 用于统计编码耗时
+} ticos_payload_t;
+
+static void ticos_payload_begin(ticos_payload_t *payload, ticos_client_t *client)
 {
-    cJSON *propretys = cJSON_CreateObject();
+    payload->start = ticos_metrics_clock();
+#if TICOS_CBOR
+    payload->cbor = client->payload_format == TICOS_PAYLOAD_CBOR;
+    if (payload->cbor) {
+        ticos_cbor_writer_init(&payload->cbor_writer, m_report_buf, m_report_buf_size);
+        ticos_cbor_self_describe(&payload->cbor_writer);
+        ticos_cbor_map_begin(&payload->cbor_writer);
+        ticos_cbor_int(&payload->cbor_writer, TICOS_CBOR_KEY_HASH);
+        ticos_cbor_int(&payload->cbor_writer, client->model->hash);
+        return;
+    }
+#endif
+    ticos_json_payload_begin(&payload->json);
+}
 
-    for (int i = 0; i < ticos_property_cnt; i++) {
-        void *func = ticos_property_tab[i].send_func;
-        switch (ticos_property_tab[i].type) {
+static void ticos_payload_add(ticos_payload_t *payload, int index, const char *id, const ticos_value_t *val)
+{
+#if TICOS_CBOR
+    if (payload->cbor) {
+        ticos_cbor_writer_t *w = &payload->cbor_writer;
+        if (val->type == TICOS_VAL_TYPE_STRING && !val->v.s)
+            return;
+        ticos_cbor_int(w, index);
+        switch (val->type) {
         case TICOS_VAL_TYPE_BOOLEAN:
-            cJSON_AddBoolToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_bool_t)func)());
+            ticos_cbor_bool(w, val->v.i);
             break;
         case TICOS_VAL_TYPE_INTEGER:
-            cJSON_AddNumberToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_int_t)func)());
+            ticos_cbor_int(w, val->v.i);
             break;
         case TICOS_VAL_TYPE_FLOAT:
-            cJSON_AddNumberToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_float_t)func)());
+            ticos_cbor_float(w, val->v.f);
             break;
         case TICOS_VAL_TYPE_STRING:
-            cJSON_AddStringToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_string_t)func)());
+            ticos_cbor_string(w, val->v.s);
             break;
         default:
-            cJSON_AddNullToObject(propretys, ticos_property_tab[i].id);
+            ticos_cbor_null(w);
             break;
         }
+        return;
     }
+#endif
+    ticos_json_payload_add(&payload->json, id, val);
+}
 
-    char *propertys_str = cJSON_PrintUnformatted(propretys);
-    int ret = ticos_hal_mqtt_publish(ticos_property_report_topic, propertys_str, strlen(propertys_str), 1, 0);
-    cJSON_free(propertys_str);
-    cJSON_Delete(propretys);
-    return ret;
+static void ticos_payload_discard(ticos_payload_t *payload)
+{
+#if TICOS_CBOR
+    if (payload->cbor)
+        return;
+#endif
+    ticos_json_payload_discard(&payload->json);
 }
 
-int ticos_property_report_by_index(int index)
+static int ticos_payload_publish(ticos_payload_t *payload, ticos_topic_class_t cls, const char *topic)
 {
-    if (index >= ticos_property_cnt)
-        return -1;
+#if TICOS_CBOR
+    if (payload->cbor) {
+        TICOS_TRACE_BEGIN(TICOS_TRACE_ENCODE, cls);
+        ticos_cbor_map_end(&payload->cbor_writer);
+        int len = ticos_cbor_writer_finish(&payload->cbor_writer);
+        TICOS_TRACE_END(TICOS_TRACE_ENCODE);
+        if (len < 0)
+            return -1;
+        return ticos_report_send(cls, topic, m_report_buf, len, payload->start);
+    }
+#endif
+    return ticos_json_payload_publish(&payload->json, cls, topic, payload->start);
+}
+
+/*
+ * 全量上报时优先使用生成的专用编码函数, 返回 0 表示当前编码方式不支持, 需逐个字段编码
+ */
+static int ticos_payload_serialize(ticos_payload_t *payload, ticos_client_t *client, int property)
+{
+#if TICOS_CBOR
+    if (payload->cbor)
+        return 0;
+#endif
+#if TICOS_JSON_STREAM
+    const ticos_thingmodel_t *model = client->model;
+    if (property && model->serialize_property) {
+        model->serialize_property(client, &payload->json.writer);
+        return 1;
+    }
+    if (!property && model->serialize_telemetry) {
+        model->serialize_telemetry(&payload->json.writer);
+        return 1;
+    }
+#endif
+    return 0;
+}
 
-    int i = index;
-    cJSON *propretys = cJSON_CreateObject();
-    void *func = ticos_property_tab[i].send_func;
-    switch (ticos_property_tab[i].type) {
+#if TICOS_PROPERTY_CACHE_SIZE > 0 || TICOS_FILTER_FIELDS > 0 || TICOS_DESIRED_CACHE_SIZE > 0
+static void ticos_value_cache_set(ticos_value_cache_t *cur, const ticos_value_t *val)
+{
+    memset(cur, 0, sizeof(*cur));
+    switch (val->type) {
     case TICOS_VAL_TYPE_BOOLEAN:
-        cJSON_AddBoolToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_bool_t)func)());
+        cur->i = !!val->v.i;
         break;
     case TICOS_VAL_TYPE_INTEGER:
-        cJSON_AddNumberToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_int_t)func)());
+        cur->i = val->v.i;
         break;
     case TICOS_VAL_TYPE_FLOAT:
-        cJSON_AddNumberToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_float_t)func)());
+        cur->f = val->v.f;
         break;
     case TICOS_VAL_TYPE_STRING:
-        cJSON_AddStringToObject(propretys, ticos_property_tab[i].id, ((_ticos_send_string_t)func)());
+        cur->s.len = strlen(val->v.s);
+        cur->s.hash = ticos_hash(0, val->v.s, cur->s.len);
         break;
     default:
-        cJSON_AddNullToObject(propretys, ticos_property_tab[i].id);
         break;
     }
-    char *propertys_str = cJSON_PrintUnformatted(propretys);
-    int ret = ticos_hal_mqtt_publish(ticos_property_report_topic, propertys_str, strlen(propertys_str), 1, 0);
-    cJSON_free(propertys_str);
-    cJSON_Delete(propretys);
-    return ret;
 }
+#endif
 
-int ticos_telemetry_report_by_index(int index)
+#if TICOS_DESIRED_CACHE_SIZE > 0
+// 属性值是否与设备已应用或已上报的值不同
+static int ticos_desired_changed(ticos_client_t *client, int i, const ticos_value_t *val)
 {
-    if (index >= ticos_telemetry_cnt)
-        return -1;
+    ticos_value_cache_t cur;
 
-    int i = index;
-    cJSON *telemetries = cJSON_CreateObject();
-    void *func = ticos_telemetry_tab[i].func;
-    switch (ticos_telemetry_tab[i].type) {
-    case TICOS_VAL_TYPE_BOOLEAN:
-        cJSON_AddBoolToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_bool_t)func)());
-        break;
+    if (i >= TICOS_DESIRED_CACHE_SIZE || !((client->desired_cached[i >> 3] >> (i & 7)) & 1))
+        return 1;
+    ticos_value_cache_set(&cur, val);
+    return memcmp(&client->desired_cache[i], &cur, sizeof(cur)) != 0;
+}
+
+// 记录设备当前的属性值, 云端再次下发相同的值时不必调用 recv 函数
+static void ticos_desired_store(ticos_client_t *client, int i, const ticos_value_t *val)
+{
+    if (i >= TICOS_DESIRED_CACHE_SIZE)
+        return;
+    ticos_value_cache_set(&client->desired_cache[i], val);
+    client->desired_cached[i >> 3] |= 1 << (i & 7);
+}
+#else
+static int ticos_desired_changed(ticos_client_t *client, int i, const ticos_value_t *val)
+{
+    return 1;
+}
+
+static void ticos_desired_store(ticos_client_t *client, int i, const ticos_value_t *val)
+{
+}
+#endif
+
+#if TICOS_PROPERTY_CACHE_SIZE > 0
+void ticos_property_cache_reset(ticos_client_t *client)
+{
+    memset(client->property_cached, 0, sizeof(client->property_cached));
+}
+
+static void ticos_property_cache_invalidate(ticos_client_t *client, int begin, int end)
+{
+    for (int i = begin; i < end && i < TICOS_PROPERTY_CACHE_SIZE; i++)
+        client->property_cached[i >> 3] &= ~(1 << (i & 7));
+}
+
+int ticos_property_cache_update(ticos_client_t *client, int i, const ticos_value_t *val)
+{
+    ticos_value_cache_t cur;
+
+    // 上报时读到的值即设备当前的值
+    ticos_desired_store(client, i, val);
+    if (i >= TICOS_PROPERTY_CACHE_SIZE)
+        return 1;
+    ticos_value_cache_set(&cur, val);
+
+    unsigned char bit = 1 << (i & 7);
+    if ((client->property_cached[i >> 3] & bit) && !memcmp(&client->property_cache[i], &cur, sizeof(cur)))
+        return 0;
+    client->property_cache[i] = cur;
+    client->property_cached[i >> 3] |= bit;
+    return 1;
+}
+#else
+void ticos_property_cache_reset(ticos_client_t *client)
+{
+}
+
+static void ticos_property_cache_invalidate(ticos_client_t *client, int begin, int end)
+{
+}
+
+int ticos_property_cache_update(ticos_client_t *client, int i, const ticos_value_t *val)
+{
+    ticos_desired_store(client, i, val);
+    return 1;
+}
+#endif
+
+#if TICOS_FILTER_FIELDS > 0
+void ticos_report_filter_reset(ticos_client_t *client)
+{
+    memset(client->filtered, 0, sizeof(client->filtered));
+}
+
+static void ticos_filter_invalidate(ticos_client_t *client, ticos_topic_class_t cls, int begin, int end)
+{
+    for (int i = begin; i < end && i < TICOS_FILTER_FIELDS; i++)
+        client->filtered[cls][i >> 3] &= ~(1 << (i & 7));
+}
+
+// 数值与上次上报值之差是否超出死区, 其他类型只比较值是否改变
+static int ticos_filter_exceeded(const ticos_report_filter_t *filter, ticos_val_type_t type,
+                                 const ticos_value_cache_t *last, const ticos_value_cache_t *cur)
+{
+    float diff, band;
+    int64_t delta;
+
+    switch (type) {
     case TICOS_VAL_TYPE_INTEGER:
-        cJSON_AddNumberToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_int_t)func)());
+        delta = (int64_t)cur->i - last->i;
+        diff = (float)(delta < 0 ? -delta : delta);
+        band = fabsf((float)last->i) * filter->deadband_pct / 100;
         break;
     case TICOS_VAL_TYPE_FLOAT:
-        cJSON_AddNumberToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_float_t)func)());
-        break;
-    case TICOS_VAL_TYPE_STRING:
-        cJSON_AddStringToObject(telemetries, ticos_telemetry_tab[i].id, ((_ticos_send_string_t)func)());
+        diff = fabsf(cur->f - last->f);
+        band = fabsf(last->f) * filter->deadband_pct / 100;
         break;
     default:
-        cJSON_AddNullToObject(telemetries, ticos_telemetry_tab[i].id);
-        break;
+        return memcmp(last, cur, sizeof(*cur)) != 0;
+    }
+    if (band < filter->deadband)
+        band = filter->deadband;
+    return diff > band;
+}
+
+/*
+ * 字段 i 本次是否需要上报: 从未上报或超过最大间隔时总是上报, 否则须超过最小间隔且变化超出死区;
+ * 未声明过滤条件或下标超出 TICOS_FILTER_FIELDS 的字段总是上报
+ */
+static int ticos_filter_pass(ticos_client_t *client, ticos_topic_class_t cls, int i,
+                             const ticos_report_filter_t *filter, const ticos_value_t *val, uint32_t now)
+{
+    ticos_value_cache_t cur;
+
+    if (!filter || i >= TICOS_FILTER_FIELDS || !((client->filtered[cls][i >> 3] >> (i & 7)) & 1))
+        return 1;
+
+    const ticos_filter_state_t *state = &client->filter[cls][i];
+    uint32_t elapsed = now - state->time;
+    if (filter->max_interval_ms > 0 && elapsed >= (uint32_t)filter->max_interval_ms)
+        return 1;
+    if (filter->min_interval_ms > 0 && elapsed < (uint32_t)filter->min_interval_ms)
+        return 0;
+    ticos_value_cache_set(&cur, val);
+    return ticos_filter_exceeded(filter, val->type, &state->value, &cur);
+}
+
+// 记录字段 i 本次上报的值和时间, 之后的变化以此为准计算死区
+static void ticos_filter_record(ticos_client_t *client, ticos_topic_class_t cls, int i,
+                                const ticos_report_filter_t *filter, const ticos_value_t *val, uint32_t now)
+{
+    if (!filter || i >= TICOS_FILTER_FIELDS)
+        return;
+    ticos_value_cache_set(&client->filter[cls][i].value, val);
+    client->filter[cls][i].time = now;
+    client->filtered[cls][i >> 3] |= 1 << (i & 7);
+}
+#else
+void ticos_report_filter_reset(ticos_client_t *client)
+{
+}
+
+static void ticos_filter_invalidate(ticos_client_t *client, ticos_topic_class_t cls, int begin, int end)
+{
+}
+
+static int ticos_filter_pass(ticos_client_t *client, ticos_topic_class_t cls, int i,
+                             const ticos_report_filter_t *filter, const ticos_value_t *val, uint32_t now)
+{
+    return 1;
+}
+
+static void ticos_filter_record(ticos_client_t *client, ticos_topic_class_t cls, int i,
+                                const ticos_report_filter_t *filter, const ticos_value_t *val, uint32_t now)
+{
+}
+#endif
+
+// 合并上报或周期上报的字段位图中是否记录了字段 i
+static int ticos_field_forced(const unsigned char *forced, int i)
+{
+    return forced && i < TICOS_FIELD_BITS && (forced[i >> 3] >> (i & 7)) & 1;
+}
+
+/*
+ * forced 为合并上报的字段位图, 为 NULL 时上报 begin 到 end 的所有字段;
+ * filtered 时按物模型中声明的过滤条件跳过变化不大的字段
+ */
+static int ticos_telemetry_encode(ticos_client_t *client, int begin, int end, const unsigned char *forced,
+                                  int filtered)
+{
+    const ticos_telemetry_info_t *tab = client->model->telemetry_tab;
+    uint32_t now = (uint32_t)ticos_uptime_ms();
+    ticos_payload_t payload;
+    ticos_value_t val;
+    int count = 0;
+
+    ticos_payload_begin(&payload, client);
+    // 声明了过滤条件的物模型不会生成专用编码函数
+    if (begin == 0 && end == client->model->telemetry_cnt && !forced && ticos_payload_serialize(&payload, client, 0))
+        return ticos_payload_publish(&payload, TICOS_TOPIC_TELEMETRY, client->telemetry_topic);
+    for (int i = begin; i < end; i++) {
+        if (forced && !ticos_field_forced(forced, i))
+            continue;
+        TICOS_TRACE_BEGIN(TICOS_TRACE_GETTER, i);
+        ticos_value_get(&val, tab[i].type, tab[i].func);
+        TICOS_TRACE_END(TICOS_TRACE_GETTER);
+        if (val.type == TICOS_VAL_TYPE_STRING && !val.v.s)
+            continue;
+        if (filtered && !ticos_filter_pass(client, TICOS_TOPIC_TELEMETRY, i, tab[i].filter, &val, now))
+            continue;
+        ticos_filter_record(client, TICOS_TOPIC_TELEMETRY, i, tab[i].filter, &val, now);
+        ticos_payload_add(&payload, i, tab[i].id, &val);
+        count++;
+    }
+    if (filtered && !count) {
+        ticos_payload_discard(&payload);
+        return 0;
+    }
+
+    int ret = ticos_payload_publish(&payload, TICOS_TOPIC_TELEMETRY, client->telemetry_topic);
+    if (ret < 0)
+        ticos_filter_invalidate(client, TICOS_TOPIC_TELEMETRY, begin, end);
+    return ret;
+}
+
+/*
+ * forced 不为 NULL 时, 其中记录的字段总是上报; 其余字段在 only_changed 时按变化上报, 否则不上报。
+ * 按变化上报时, 声明了过滤条件的字段以过滤条件代替与上报缓存的比较
+ */
+static int ticos_property_encode(ticos_client_t *client, int begin, int end, int only_changed,
+                                 const unsigned char *forced)
+{
+    const ticos_property_info_t *tab = client->model->property_tab;
+    uint32_t now = (uint32_t)ticos_uptime_ms();
+    ticos_payload_t payload;
+    ticos_value_t val;
+    int count = 0;
+
+    ticos_payload_begin(&payload, client);
+    // 生成的专用编码函数同样会更新属性上报缓存
+    int serialized = begin == 0 && end == client->model->property_cnt && !only_changed && !forced &&
+                     ticos_payload_serialize(&payload, client, 1);
+    for (int i = begin; i < end && !serialized; i++) {
+        int force = ticos_field_forced(forced, i);
+        if (forced && !force && !only_changed)
+            continue;
+        TICOS_TRACE_BEGIN(TICOS_TRACE_GETTER, i);
+        ticos_value_get(&val, tab[i].type, tab[i].send_func);
+        TICOS_TRACE_END(TICOS_TRACE_GETTER);
+        // 值为 NULL 的字符串不会被上报, 也不参与缓存
+        if (val.type == TICOS_VAL_TYPE_STRING && !val.v.s)
+            continue;
+        int changed = ticos_property_cache_update(client, i, &val);
+        if (only_changed && tab[i].filter)
+            changed = ticos_filter_pass(client, TICOS_TOPIC_PROPERTY, i, tab[i].filter, &val, now);
+        if (!changed && only_changed && !force)
+            continue;
+        ticos_filter_record(client, TICOS_TOPIC_PROPERTY, i, tab[i].filter, &val, now);
+        ticos_payload_add(&payload, i, tab[i].id, &val);
+        count++;
     }
-    char *telemetries_str = cJSON_PrintUnformatted(telemetries);
-    int ret = ticos_hal_mqtt_publish(ticos_telemery_topic, telemetries_str, strlen(telemetries_str), 1, 0);
-    cJSON_free(telemetries_str);
-    cJSON_Delete(telemetries);
+    if (only_changed && !count) {
+        ticos_payload_discard(&payload);
+        return 0;
+    }
+
+    int ret = ticos_payload_publish(&payload, TICOS_TOPIC_PROPERTY, client->property_report_topic);
+    // 上报失败时缓存的值不再可信, 下次需要重新上报
+    if (ret < 0) {
+        ticos_property_cache_invalidate(client, begin, end);
+        ticos_filter_invalidate(client, TICOS_TOPIC_PROPERTY, begin, end);
+    }
+    return ret;
+}
+
+static int ticos_telemetry_publish(ticos_client_t *client, int begin, int end, const unsigned char *forced,
+                                   int filtered)
+{
+    TICOS_TRACE_BEGIN(TICOS_TRACE_REPORT, TICOS_TOPIC_TELEMETRY);
+    int ret = ticos_telemetry_encode(client, begin, end, forced, filtered);
+    TICOS_TRACE_END(TICOS_TRACE_REPORT);
+    return ret;
+}
+
+static int ticos_property_publish(ticos_client_t *client, int begin, int end, int only_changed,
+                                  const unsigned char *forced)
+{
+    TICOS_TRACE_BEGIN(TICOS_TRACE_REPORT, TICOS_TOPIC_PROPERTY);
+    int ret = ticos_property_encode(client, begin, end, only_changed, forced);
+    TICOS_TRACE_END(TICOS_TRACE_REPORT);
     return ret;
 }
+
+static int ticos_property_find(const ticos_thingmodel_t *model, const char *key, int len)
+{
+    const ticos_property_info_t *tab = model->property_tab;
+
+    if (model->property_index) {
+        int i = ticos_index_lookup(model->property_index, key, len);
+        if (i >= 0 && i < model->property_cnt && !memcmp(tab[i].id, key, len))
+            return i;
+        return -1;
+    }
+    for (int i = 0; i < model->property_cnt; i++) {
+        if (!strncmp(tab[i].id, key, len) && !tab[i].id[len])
+            return i;
+    }
+    return -1;
+}
+
+static int ticos_command_find(const ticos_thingmodel_t *model, const char *key, int len)
+{
+    const ticos_command_info_t *tab = model->command_tab;
+
+    if (model->command_index) {
+        int i = ticos_index_lookup(model->command_index, key, len);
+        if (i >= 0 && i < model->command_cnt && !memcmp(tab[i].id, key, len))
+            return i;
+        return -1;
+    }
+    for (int i = 0; i < model->command_cnt; i++) {
+        if (!strncmp(tab[i].id, key, len) && !tab[i].id[len])
+            return i;
+    }
+    return -1;
+}
+
+// 请求 id, 命令的执行结果以此 id 回复云端; 下发消息都在 MQTT 接收线程中依次处理
+static char ticos_command_rid[TICOS_COMMAND_ID_MAX];
+
+/*
+ * 将解码后的下发字段值交给属性的 recv 函数或命令处理模块;
+ * 与设备当前值相同的属性不调用 recv 函数, recv 函数返回 0 时记录为已应用的值
+ */
+static void ticos_field_receive(const ticos_thingmodel_t *model, int j, int command, const ticos_value_t *val)
+{
+    ticos_client_t *client = ticos_client_current();
+
+    if (command) {
+        ticos_command_submit(client, j, val, ticos_command_rid);
+        return;
+    }
+    // 发送线程上报时也会更新期望属性缓存, recv 函数在锁外调用
+    ticos_report_lock();
+    int changed = ticos_desired_changed(client, j, val);
+    ticos_report_unlock();
+    if (!changed)
+        return;
+    TICOS_TRACE_BEGIN(TICOS_TRACE_RECV_FUNC, j);
+    int ret = ticos_value_set(val, model->property_tab[j].recv_func);
+    TICOS_TRACE_END(TICOS_TRACE_RECV_FUNC);
+    if (ret)
+        return;
+    ticos_report_lock();
+    ticos_desired_store(client, j, val);
+    ticos_report_unlock();
+}
+
+// 下发数据中未定义的字段计入统计, 以 '$' 开头的元数据字段除外
+static void ticos_key_reject(const char *key, int len)
+{
+    if (!key || !len || key[0] != '$')
+        ticos_metrics_count(TICOS_METRIC_REJECTED_KEY);
+}
+
+void ticos_desired_reset(ticos_client_t *client)
+{
+    ticos_report_lock();
+    client->desired_version = 0;
+    ticos_report_unlock();
+}
+
+/*
+ * 期望属性文档的 $version 不大于已处理的版本时为过期或重复的文档, 返回 -1 表示整条丢弃;
+ * 否则记录新的版本号。没有 $version 的文档(version 为 0)总是处理
+ */
+static int ticos_desired_accept(int64_t version)
+{
+    ticos_client_t *client = ticos_client_current();
+    int ret = 0;
+
+    if (version <= 0)
+        return 0;
+    // 已处理的版本号可能同时在其他线程中被清除
+    ticos_report_lock();
+    if (client->desired_version && version <= client->desired_version)
+        ret = -1;
+    else
+        client->desired_version = version;
+    ticos_report_unlock();
+    return ret;
+}
+
+// 数值按字段类型转换, 整数向零取整; 超出范围的值与整数路径一样截断到类型的范围, NaN 转换为 0
+static void ticos_value_number(ticos_value_t *val, ticos_val_type_t type, double num)
+{
+    val->type = type;
+    if (isnan(num))
+        num = 0;
+    if (type == TICOS_VAL_TYPE_INTEGER)
+        val->v.i = num >= INT_MAX ? INT_MAX : num <= INT_MIN ? INT_MIN : (int)num;
+    else if (isinf(num))
+        val->v.f = num;
+    else
+        val->v.f = num > FLT_MAX ? FLT_MAX : num < -FLT_MAX ? -FLT_MAX : (float)num;
+}
+
+// 超出 float 范围的文本解析为无穷大, 与 ticos_value_number() 一样截断到类型的范围
+static float ticos_float_clamp(float f)
+{
+    return isinf(f) ? (f > 0 ? FLT_MAX : -FLT_MAX) : f;
+}
+
+#if TICOS_CBOR
+static char ticos_cbor_str[TICOS_RECV_STRING_MAX];
+
+/*
+ * 按字段类型解码 CBOR 数据项, 类型不符时返回 -1
+ */
+static int ticos_cbor_value(const char *dat, const ticos_cbor_item_t *item, ticos_val_type_t type, ticos_value_t *val)
+{
+    double num = item->type == TICOS_CBOR_INT ? (double)item->i : item->f;
+
+    switch (type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        if (item->type != TICOS_CBOR_BOOL)
+            return -1;
+        val->type = type;
+        val->v.i = item->i;
+        return 0;
+    case TICOS_VAL_TYPE_INTEGER:
+    case TICOS_VAL_TYPE_FLOAT:
+        if (item->type != TICOS_CBOR_INT && item->type != TICOS_CBOR_FLOAT)
+            return -1;
+        ticos_value_number(val, type, num);
+        return 0;
+    case TICOS_VAL_TYPE_STRING:
+        if (item->type != TICOS_CBOR_STRING || item->len >= (int)sizeof(ticos_cbor_str))
+            return -1;
+        memcpy(ticos_cbor_str, dat + item->start, item->len);
+        ticos_cbor_str[item->len] = '\0';
+        val->type = type;
+        val->v.s = ticos_cbor_str;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static void ticos_cbor_rid(const char *dat, const ticos_cbor_item_t *val)
+{
+    if (val->type == TICOS_CBOR_STRING && val->len < (int)sizeof(ticos_command_rid)) {
+        memcpy(ticos_command_rid, dat + val->start, val->len);
+        ticos_command_rid[val->len] = '\0';
+    } else if (val->type == TICOS_CBOR_INT) {
+        snprintf(ticos_command_rid, sizeof(ticos_command_rid), "%lld", (long long)val->i);
+    }
+}
+
+/*
+ * 解析 CBOR 编码的下发数据, 键为字段下标或字段名;
+ * 数据中携带的物模型哈希值与本地不一致时丢弃整条数据, 返回 -1
+ */
+static int ticos_cbor_receive(const ticos_thingmodel_t *model, const char *dat, int len, int command)
+{
+    ticos_cbor_reader_t reader;
+    ticos_cbor_item_t key, val;
+    ticos_value_t value;
+    uint32_t hash = model->hash;
+    int64_t version = 0;
+
+    if (ticos_cbor_check_map(dat, len))
+        return -1;
+
+    ticos_cbor_map_enter(&reader, dat, len);
+    while (ticos_cbor_map_next(&reader, &key, &val) > 0) {
+        if (key.type == TICOS_CBOR_INT && key.i == TICOS_CBOR_KEY_HASH) {
+            if (hash && (val.type != TICOS_CBOR_INT || val.i != hash))
+                return -1;
+        } else if (command && key.type == TICOS_CBOR_STRING && key.len == TICOS_COMMAND_ID_KEY_LEN &&
+                   !memcmp(dat + key.start, TICOS_COMMAND_ID_KEY, key.len)) {
+            ticos_cbor_rid(dat, &val);
+        } else if (!command && key.type == TICOS_CBOR_STRING && key.len == TICOS_DESIRED_VERSION_KEY_LEN &&
+                   !memcmp(dat + key.start, TICOS_DESIRED_VERSION_KEY, key.len) && val.type == TICOS_CBOR_INT) {
+            version = val.i;
+        }
+    }
+    if (!command && ticos_desired_accept(version))
+        return -1;
+
+    int cnt = command ? model->command_cnt : model->property_cnt;
+    ticos_cbor_map_enter(&reader, dat, len);
+    while (ticos_cbor_map_next(&reader, &key, &val) > 0) {
+        int j = -1;
+        if (key.type == TICOS_CBOR_INT && key.i >= 0 && key.i < cnt)
+            j = key.i;
+        else if (key.type == TICOS_CBOR_STRING)
+            j = command ? ticos_command_find(model, dat + key.start, key.len) : ticos_property_find(model, dat + key.start, key.len);
+        if (j < 0) {
+            if (key.type == TICOS_CBOR_STRING)
+                ticos_key_reject(dat + key.start, key.len);
+            else if (key.type != TICOS_CBOR_INT || key.i != TICOS_CBOR_KEY_HASH)
+                ticos_key_reject(NULL, 0);
+            continue;
+        }
+        ticos_val_type_t type = command ? model->command_tab[j].type : model->property_tab[j].type;
+        if (!ticos_cbor_value(dat, &val, type, &value))
+            ticos_field_receive(model, j, command, &value);
+        else
+            ticos_key_reject(NULL, 0);
+    }
+    return 0;
+}
+#endif
+
+#if TICOS_JSON_TOKENIZER
+static char ticos_recv_str[TICOS_RECV_STRING_MAX];
+
+/*
+ * 字段名中含有转义字符时先解码到 ticos_recv_str 中再查找,
+ * 查找完成后该缓冲区即可用于解码字段值
+ */
+static const char *ticos_key_resolve(const char *dat, const ticos_json_tok_t *key, int *len)
+{
+    const char *p = dat + key->start;
+    *len = key->end - key->start;
+    if (!memchr(p, '\\', *len))
+        return p;
+    *len = ticos_json_tok_string(dat, key, ticos_recv_str, sizeof(ticos_recv_str));
+    return *len < 0 ? NULL : ticos_recv_str;
+}
+
+/*
+ * 按字段类型解码 JSON 值, 类型不符时返回 -1
+ */
+static int ticos_tok_value(const char *dat, const ticos_json_tok_t *tok, ticos_val_type_t type, ticos_value_t *val)
+{
+    double num;
+    int64_t i;
+
+    switch (type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        if (tok->type != TICOS_JSON_TRUE && tok->type != TICOS_JSON_FALSE)
+            return -1;
+        val->type = type;
+        val->v.i = tok->type == TICOS_JSON_TRUE;
+        return 0;
+    case TICOS_VAL_TYPE_INTEGER:
+        // 整数直接解析, 带小数点或指数的值仍按 double 解析后取整
+        if (!ticos_json_tok_int(dat, tok, &i)) {
+            val->type = type;
+            val->v.i = i > INT_MAX ? INT_MAX : i < INT_MIN ? INT_MIN : (int)i;
+            return 0;
+        }
+        if (ticos_json_tok_number(dat, tok, &num))
+            return -1;
+        ticos_value_number(val, type, num);
+        return 0;
+    case TICOS_VAL_TYPE_FLOAT:
+        if (ticos_json_tok_float(dat, tok, &val->v.f))
+            return -1;
+        val->type = type;
+        val->v.f = ticos_float_clamp(val->v.f);
+        return 0;
+    case TICOS_VAL_TYPE_STRING:
+        if (ticos_json_tok_string(dat, tok, ticos_recv_str, sizeof(ticos_recv_str)) < 0)
+            return -1;
+        val->type = type;
+        val->v.s = ticos_recv_str;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// 请求 id 可以是字符串或数字, 数字按原文保存
+static void ticos_tok_rid(const char *dat, const ticos_json_tok_t *val)
+{
+    int len = val->end - val->start;
+
+    // 过长或无法解码的请求 id 视为没有请求 id
+    if (val->type == TICOS_JSON_STRING) {
+        if (ticos_json_tok_string(dat, val, ticos_command_rid, sizeof(ticos_command_rid)) < 0)
+            ticos_command_rid[0] = '\0';
+    } else if (val->type == TICOS_JSON_NUMBER && len < (int)sizeof(ticos_command_rid)) {
+        memcpy(ticos_command_rid, dat + val->start, len);
+        ticos_command_rid[len] = '\0';
+    }
+}
+
+/*
+ * 解析并分发一条下发数据, 格式错误或被整条丢弃时返回 -1
+ */
+static int ticos_dispatch_all(const ticos_thingmodel_t *model, const char *dat, int len, int command)
+{
+    ticos_json_reader_t reader;
+    ticos_json_tok_t key, val;
+    ticos_value_t value;
+    int64_t version = 0;
+
+#if TICOS_CBOR
+    if (ticos_cbor_detect(dat, len))
+        return ticos_cbor_receive(model, dat, len, command);
+#endif
+    // 先完整检查一遍格式, 保证格式错误的数据不会触发任何回调
+    if (ticos_json_check_object(dat, len))
+        return -1;
+
+    // 请求 id 和期望属性的版本号可能位于其他字段之后, 需要先找到它们
+    const char *meta = command ? TICOS_COMMAND_ID_KEY : TICOS_DESIRED_VERSION_KEY;
+    int meta_len = command ? TICOS_COMMAND_ID_KEY_LEN : TICOS_DESIRED_VERSION_KEY_LEN;
+    ticos_json_reader_init(&reader, dat, len);
+    ticos_json_object_enter(&reader);
+    while (ticos_json_object_next(&reader, &key, &val) > 0) {
+        if (key.end - key.start == meta_len && !memcmp(dat + key.start, meta, meta_len)) {
+            if (command)
+                ticos_tok_rid(dat, &val);
+            else if (ticos_json_tok_int(dat, &val, &version))
+                version = 0;
+            break;
+        }
+    }
+    if (!command && ticos_desired_accept(version))
+        return -1;
+
+    ticos_json_reader_init(&reader, dat, len);
+    ticos_json_object_enter(&reader);
+    while (ticos_json_object_next(&reader, &key, &val) > 0) {
+        int key_len;
+        const char *key_str = ticos_key_resolve(dat, &key, &key_len);
+        int j = -1;
+        if (key_str)
+            j = command ? ticos_command_find(model, key_str, key_len) : ticos_property_find(model, key_str, key_len);
+        if (j < 0) {
+            ticos_key_reject(key_str, key_len);
+            continue;
+        }
+        ticos_val_type_t type = command ? model->command_tab[j].type : model->property_tab[j].type;
+        if (!ticos_tok_value(dat, &val, type, &value))
+            ticos_field_receive(model, j, command, &value);
+        else
+            ticos_key_reject(NULL, 0);
+    }
+    return 0;
+}
+#else
+/*
+ * 按字段类型取出 cJSON 值, 类型不符时返回 -1
+ */
+static int ticos_cjson_value(const cJSON *item, ticos_val_type_t type, ticos_value_t *val)
+{
+    switch (type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        if (!cJSON_IsBool(item))
+            return -1;
+        val->type = type;
+        val->v.i = cJSON_IsTrue(item);
+        return 0;
+    case TICOS_VAL_TYPE_INTEGER:
+    case TICOS_VAL_TYPE_FLOAT:
+        if (!cJSON_IsNumber(item))
+            return -1;
+        ticos_value_number(val, type, cJSON_GetNumberValue(item));
+        return 0;
+    case TICOS_VAL_TYPE_STRING:
+        if (!cJSON_IsString(item))
+            return -1;
+        val->type = type;
+        val->v.s = cJSON_GetStringValue(item);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static int ticos_dispatch_all(const ticos_thingmodel_t *model, const char *dat, int len, int command)
+{
+    ticos_value_t value;
+    int ret = -1;
+
+#if TICOS_CBOR
+    if (ticos_cbor_detect(dat, len))
+        return ticos_cbor_receive(model, dat, len, command);
+#endif
+    ticos_mem_begin();
+    cJSON *fields = cJSON_ParseWithLength(dat, len);
+    if (fields && cJSON_IsObject(fields)) {
+        cJSON *rid = command ? cJSON_GetObjectItemCaseSensitive(fields, TICOS_COMMAND_ID_KEY) : NULL;
+        if (cJSON_IsString(rid))
+            snprintf(ticos_command_rid, sizeof(ticos_command_rid), "%s", cJSON_GetStringValue(rid));
+        else if (cJSON_IsNumber(rid))
+            snprintf(ticos_command_rid, sizeof(ticos_command_rid), "%.17g", cJSON_GetNumberValue(rid));
+        cJSON *version = command ? NULL : cJSON_GetObjectItemCaseSensitive(fields, TICOS_DESIRED_VERSION_KEY);
+        ret = ticos_desired_accept(cJSON_IsNumber(version) ? (int64_t)cJSON_GetNumberValue(version) : 0);
+        for (cJSON *field = ret ? NULL : fields->child; field; field = field->next) {
+            int j = command ? ticos_command_find(model, field->string, strlen(field->string))
+                            : ticos_property_find(model, field->string, strlen(field->string));
+            if (j < 0) {
+                ticos_key_reject(field->string, strlen(field->string));
+                continue;
+            }
+            ticos_val_type_t type = command ? model->command_tab[j].type : model->property_tab[j].type;
+            if (!ticos_cjson_value(field, type, &value))
+                ticos_field_receive(model, j, command, &value);
+            else
+                ticos_key_reject(NULL, 0);
+        }
+    }
+    cJSON_Delete(fields);
+    ticos_mem_end();
+    return ret;
+}
+#endif
+
+#if TICOS_RECV_FRAGMENT_SIZE > 0
+#define TICOS_FRAGMENT_META     (-1)    // 当前成员是请求 id 或 $version
+#define TICOS_FRAGMENT_IGNORED  (-2)    // 当前成员是未定义的字段或其他元数据
+
+/*
+ * 分片到达的下发消息。MQTT 连接上的消息依次到达, 同一时间只有一条消息在分片接收中。
+ * JSON 消息由增量解析器逐个分片解析, 解码后的字段值暂存在 pending 中, 整条消息格式正确时再按 $version 过滤并依次分发,
+ * 与完整到达的消息一样, 格式错误的数据不会触发任何回调; CBOR 消息拼接到 pending 中后按完整消息处理
+ */
+typedef struct {
+    ticos_client_t *client;
+    int command;
+    int active;             // 有正在接收的消息
+    int offset;             // 下一个分片在消息中的位置
+    int total;
+    int failed;             // 格式错误或暂存区不足, 消息结束时整条丢弃
+    int field;              // 当前成员的字段下标, 或 TICOS_FRAGMENT_META / TICOS_FRAGMENT_IGNORED
+    int rejected;           // 被忽略的字段数, 消息被分发时计入统计
+    int meta_seen;          // 已遇到请求 id 或 $version
+    int64_t version;
+    int used;               // pending 中已使用的字节数
+    uint32_t elapsed;       // 已处理的分片的解析耗时(微秒)
+#if TICOS_CBOR
+    int cbor;
+#endif
+    ticos_json_feed_t parser;
+    char str[TICOS_RECV_STRING_MAX];
+    char pending[TICOS_RECV_FRAGMENT_SIZE];
+} ticos_fragment_t;
+
+// 暂存的字段值, 字符串值的内容紧随其后存放
+typedef struct {
+    int index;
+    int str_len;            // 字符串值的长度(不含 '\0'), 其他类型为 -1
+    ticos_value_t val;
+} ticos_pending_field_t;
+
+static ticos_fragment_t m_fragment;
+
+static void ticos_fragment_key(ticos_fragment_t *f, const char *key, int len)
+{
+    const ticos_thingmodel_t *model = f->client->model;
+    const char *meta = f->command ? TICOS_COMMAND_ID_KEY : TICOS_DESIRED_VERSION_KEY;
+
+    if (len == (f->command ? TICOS_COMMAND_ID_KEY_LEN : TICOS_DESIRED_VERSION_KEY_LEN) && !memcmp(key, meta, len)) {
+        f->field = TICOS_FRAGMENT_META;
+        return;
+    }
+    f->field = len < 0 ? -1 : f->command ? ticos_command_find(model, key, len) : ticos_property_find(model, key, len);
+    if (f->field >= 0)
+        return;
+    f->field = TICOS_FRAGMENT_IGNORED;
+    if (len <= 0 || key[0] != '$')
+        f->rejected++;
+}
+
+// 与完整消息的处理一致, 请求 id 和 $version 只看第一次出现的成员, 其值不合法时视为没有, 不再查找后续的同名成员
+static void ticos_fragment_meta(ticos_fragment_t *f, ticos_json_type_t type, const char *str, int len)
+{
+    f->field = TICOS_FRAGMENT_IGNORED;
+    if (f->meta_seen)
+        return;
+    f->meta_seen = 1;
+    if (f->command) {
+        if ((type == TICOS_JSON_STRING || type == TICOS_JSON_NUMBER) && len >= 0 && len < (int)sizeof(ticos_command_rid))
+            memcpy(ticos_command_rid, str, len + 1);
+    } else if (type != TICOS_JSON_NUMBER || len < 0 || ticos_atoi(str, len, &f->version)) {
+        f->version = 0;
+    }
+}
+
+/*
+ * 按字段类型解码成员值并暂存, 类型不符时计为被忽略的字段
+ */
+static void ticos_fragment_value(ticos_fragment_t *f, ticos_json_type_t type, const char *str, int len)
+{
+    ticos_pending_field_t field;
+    ticos_val_type_t val_type = f->command ? f->client->model->command_tab[f->field].type
+                                           : f->client->model->property_tab[f->field].type;
+    double num;
+    int64_t i;
+    int ok = len >= 0;
+
+    field.index = f->field;
+    field.str_len = -1;
+    field.val.type = val_type;
+    switch (val_type) {
+    case TICOS_VAL_TYPE_BOOLEAN:
+        ok = type == TICOS_JSON_TRUE || type == TICOS_JSON_FALSE;
+        field.val.v.i = type == TICOS_JSON_TRUE;
+        break;
+    case TICOS_VAL_TYPE_INTEGER:
+        // 整数直接解析, 带小数点或指数的值仍按 double 解析后取整
+        ok = ok && type == TICOS_JSON_NUMBER;
+        if (ok && !ticos_atoi(str, len, &i)) {
+            field.val.v.i = i > INT_MAX ? INT_MAX : i < INT_MIN ? INT_MIN : (int)i;
+            break;
+        }
+        ok = ok && !ticos_atod(str, len, &num);
+        if (ok)
+            ticos_value_number(&field.val, val_type, num);
+        break;
+    case TICOS_VAL_TYPE_FLOAT:
+        ok = ok && type == TICOS_JSON_NUMBER && !ticos_atof(str, len, &field.val.v.f);
+        field.val.v.f = ticos_float_clamp(field.val.v.f);
+        break;
+    case TICOS_VAL_TYPE_STRING:
+        ok = ok && type == TICOS_JSON_STRING;
+        field.str_len = len;
+        break;
+    default:
+        ok = 0;
+        break;
+    }
+    f->field = TICOS_FRAGMENT_IGNORED;
+    if (!ok) {
+        f->rejected++;
+        return;
+    }
+    int size = sizeof(field) + (field.str_len >= 0 ? field.str_len + 1 : 0);
+    if (f->used + size > (int)sizeof(f->pending)) {
+        f->failed = 1;
+        return;
+    }
+    memcpy(f->pending + f->used, &field, sizeof(field));
+    if (field.str_len >= 0)
+        memcpy(f->pending + f->used + sizeof(field), str, field.str_len + 1);
+    f->used += size;
+}
+
+static void ticos_fragment_member(void *user, int key, ticos_json_type_t type, const char *str, int len)
+{
+    ticos_fragment_t *f = user;
+
+    if (f->failed)
+        return;
+    if (key)
+        ticos_fragment_key(f, str, len);
+    else if (f->field == TICOS_FRAGMENT_META)
+        ticos_fragment_meta(f, type, str, len);
+    else if (f->field >= 0)
+        ticos_fragment_value(f, type, str, len);
+}
+
+// 消息完整且格式正确后分发暂存的字段, 返回 -1 代表整条丢弃
+static int ticos_fragment_dispatch(ticos_fragment_t *f)
+{
+    const ticos_thingmodel_t *model = f->client->model;
+    ticos_pending_field_t field;
+
+#if TICOS_CBOR
+    if (f->cbor)
+        return ticos_cbor_receive(model, f->pending, f->total, f->command);
+#endif
+    if (!f->command && ticos_desired_accept(f->version))
+        return -1;
+    for (int off = 0; off < f->used; off += sizeof(field) + (field.str_len >= 0 ? field.str_len + 1 : 0)) {
+        memcpy(&field, f->pending + off, sizeof(field));
+        if (field.str_len >= 0)
+            field.val.v.s = f->pending + off + sizeof(field);
+        ticos_field_receive(model, field.index, f->command, &field.val);
+    }
+    while (f->rejected-- > 0)
+        ticos_metrics_count(TICOS_METRIC_REJECTED_KEY);
+    return 0;
+}
+
+static void ticos_fragment_finish(ticos_fragment_t *f, int ret, uint32_t start)
+{
+    ticos_metrics_latency(TICOS_METRIC_PARSE, start - f->elapsed);
+    ticos_metrics_traffic(f->command ? TICOS_METRIC_COMMAND : TICOS_METRIC_DESIRED, f->total, ret);
+    f->active = 0;
+}
+
+void ticos_client_receive_fragment(ticos_client_t *client, int command, const char *dat, int len, int offset, int total)
+{
+    ticos_fragment_t *f = &m_fragment;
+    ticos_client_t *prev = ticos_client_enter(client);
+    uint32_t start = ticos_metrics_clock();
+
+    TICOS_TRACE_BEGIN(TICOS_TRACE_DISPATCH, command);
+    if (!offset) {
+        // 上一条消息的分片不完整
+        if (f->active)
+            ticos_fragment_finish(f, -1, start);
+        memset(f, 0, offsetof(ticos_fragment_t, parser));
+        f->client = client;
+        f->command = command;
+        f->active = 1;
+        f->total = total;
+        f->field = TICOS_FRAGMENT_IGNORED;
+        if (command)
+            ticos_command_rid[0] = '\0';
+        ticos_json_feed_init(&f->parser, f->str, sizeof(f->str), ticos_fragment_member, f);
+#if TICOS_CBOR
+        f->cbor = ticos_cbor_detect(dat, len);
+        f->failed = f->cbor && total > (int)sizeof(f->pending);
+#endif
+    }
+    if (!f->active || f->client != client || f->command != command || offset != f->offset || len > total - offset) {
+        // 分片缺失或错位, 整条丢弃
+        if (f->active)
+            ticos_fragment_finish(f, -1, start);
+    } else {
+        int done = 0;
+        f->offset += len;
+#if TICOS_CBOR
+        if (f->cbor && !f->failed)
+            memcpy(f->pending + offset, dat, len);
+        else
+#endif
+        if (!f->failed)
+            done = ticos_json_feed(&f->parser, dat, len);
+        if (done < 0)
+            f->failed = 1;
+        if (f->offset == total) {
+#if TICOS_CBOR
+            done |= f->cbor;
+#endif
+            ticos_fragment_finish(f, f->failed || done != 1 ? -1 : ticos_fragment_dispatch(f), start);
+        } else {
+            f->elapsed += ticos_metrics_clock() - start;
+        }
+    }
+    TICOS_TRACE_END(TICOS_TRACE_DISPATCH);
+    ticos_client_enter(prev);
+}
+#else
+void ticos_client_receive_fragment(ticos_client_t *client, int command, const char *dat, int len, int offset, int total)
+{
+    if (offset + len >= total)
+        ticos_metrics_traffic(command ? TICOS_METRIC_COMMAND : TICOS_METRIC_DESIRED, total, 1);
+}
+#endif
+
+void ticos_client_command_receive(ticos_client_t *client, const char *dat, int len)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+    uint32_t start = ticos_metrics_clock();
+    ticos_command_rid[0] = '\0';
+    TICOS_TRACE_BEGIN(TICOS_TRACE_DISPATCH, 1);
+    int ret = ticos_dispatch_all(client->model, dat, len, 1);
+    TICOS_TRACE_END(TICOS_TRACE_DISPATCH);
+    ticos_metrics_latency(TICOS_METRIC_PARSE, start);
+    ticos_metrics_traffic(TICOS_METRIC_COMMAND, len, ret);
+    ticos_client_enter(prev);
+}
+
+int ticos_client_command_execute(ticos_client_t *client, int index, const ticos_value_t *val)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+    TICOS_TRACE_BEGIN(TICOS_TRACE_COMMAND, index);
+    int ret = ticos_value_set(val, client->model->command_tab[index].func);
+    TICOS_TRACE_END(TICOS_TRACE_COMMAND);
+    ticos_client_enter(prev);
+    return ret;
+}
+
+void ticos_client_property_receive(ticos_client_t *client, const char *dat, int len)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+    uint32_t start = ticos_metrics_clock();
+    TICOS_TRACE_BEGIN(TICOS_TRACE_DISPATCH, 0);
+    int ret = ticos_dispatch_all(client->model, dat, len, 0);
+    TICOS_TRACE_END(TICOS_TRACE_DISPATCH);
+    ticos_metrics_latency(TICOS_METRIC_PARSE, start);
+    ticos_metrics_traffic(TICOS_METRIC_DESIRED, len, ret);
+    ticos_client_enter(prev);
+}
+
+// 立即执行一个上报请求
+static int ticos_report_now(ticos_client_t *client, ticos_report_t report, int index)
+{
+    const ticos_thingmodel_t *model = client->model;
+
+    switch (report) {
+    case TICOS_REPORT_PROPERTY:
+        return ticos_property_publish(client, 0, model->property_cnt, 0, NULL);
+    case TICOS_REPORT_PROPERTY_CHANGED:
+        return ticos_property_publish(client, 0, model->property_cnt, 1, NULL);
+    case TICOS_REPORT_PROPERTY_INDEX:
+        return ticos_property_publish(client, index, index + 1, 0, NULL);
+    case TICOS_REPORT_TELEMETRY:
+        return ticos_telemetry_publish(client, 0, model->telemetry_cnt, NULL, 1);
+    case TICOS_REPORT_TELEMETRY_INDEX:
+        return ticos_telemetry_publish(client, index, index + 1, NULL, 0);
+    }
+    return -1;
+}
+
+#if TICOS_COALESCE_FIELDS > 0
+static int m_report_window = TICOS_REPORT_WINDOW_MS;
+
+void ticos_set_report_window(int window_ms)
+{
+    m_report_window = window_ms > 0 ? window_ms : 0;
+}
+
+static void ticos_coalesce_mark(ticos_coalesce_t *co, ticos_report_t report, int index)
+{
+    co->pending = 1;
+    switch (report) {
+    case TICOS_REPORT_PROPERTY:
+    case TICOS_REPORT_TELEMETRY:
+        co->all = 1;
+        break;
+    case TICOS_REPORT_PROPERTY_CHANGED:
+        co->changed = 1;
+        break;
+    default:
+        if (index < TICOS_COALESCE_FIELDS)
+            co->dirty[index >> 3] |= 1 << (index & 7);
+        else
+            co->all = 1;
+        break;
+    }
+}
+
+// 距离一类合并上报可以发送还需等待的毫秒数, 需同时满足合并窗口和速率限制
+static int ticos_coalesce_wait_ms(ticos_client_t *client, ticos_topic_class_t cls, int64_t now)
+{
+    int64_t last = client->coalesce[cls].last;
+    int64_t wait = last ? last + m_report_window - now : 0;
+    int rate_wait = ticos_rate_wait_ms(cls, now);
+
+    if (wait < rate_wait)
+        wait = rate_wait;
+    return wait > 0 ? (int)wait : 0;
+}
+
+// 以合并后的请求上报一次, 之后重新开始合并窗口
+static int ticos_coalesce_flush(ticos_client_t *client, ticos_topic_class_t cls, int64_t now)
+{
+    const ticos_thingmodel_t *model = client->model;
+    ticos_coalesce_t req = client->coalesce[cls];
+
+    // 先清除合并状态, getter 中再次发起的上报进入下一次合并
+    memset(&client->coalesce[cls], 0, sizeof(req));
+    client->coalesce[cls].last = now;
+    if (cls == TICOS_TOPIC_TELEMETRY)
+        return ticos_telemetry_publish(client, 0, model->telemetry_cnt, req.all ? NULL : req.dirty, req.all);
+    if (req.all)
+        return ticos_property_publish(client, 0, model->property_cnt, 0, NULL);
+    return ticos_property_publish(client, 0, model->property_cnt, req.changed, req.dirty);
+}
+
+static int ticos_coalesce_poll(int64_t now)
+{
+    int count = 0;
+
+    for (ticos_client_t *client = ticos_client_list(); client; client = client->next) {
+        for (int cls = 0; cls < TICOS_TOPIC_CLASS_MAX; cls++) {
+            if (!client->coalesce[cls].pending || ticos_coalesce_wait_ms(client, cls, now))
+                continue;
+            ticos_client_t *prev = ticos_client_enter(client);
+            ticos_coalesce_flush(client, cls, now);
+            ticos_client_enter(prev);
+            count++;
+        }
+    }
+    return count;
+}
+
+static int ticos_coalesce_next_ms(int64_t now)
+{
+    int next = -1;
+
+    for (ticos_client_t *client = ticos_client_list(); client; client = client->next) {
+        for (int cls = 0; cls < TICOS_TOPIC_CLASS_MAX; cls++) {
+            if (!client->coalesce[cls].pending)
+                continue;
+            int wait = ticos_coalesce_wait_ms(client, cls, now);
+            if (next < 0 || wait < next)
+                next = wait;
+        }
+    }
+    return next;
+}
+#else
+void ticos_set_report_window(int window_ms)
+{
+}
+
+static int ticos_coalesce_poll(int64_t now)
+{
+    return 0;
+}
+
+static int ticos_coalesce_next_ms(int64_t now)
+{
+    return -1;
+}
+#endif
+
+/*
+ * 重新连接后各设备全量上报一次属性, 应用只做变化上报时云端的属性也能及时同步
+ */
+static int ticos_resync_poll(void)
+{
+    int count = 0;
+
+    for (ticos_client_t *client = ticos_client_list(); client; client = client->next) {
+        if (!client->resync)
+            continue;
+        client->resync = 0;
+        ticos_client_property_report(client);
+        count++;
+    }
+    return count;
+}
+
+static int ticos_resync_pending(void)
+{
+    for (ticos_client_t *client = ticos_client_list(); client; client = client->next) {
+        if (client->resync)
+            return 1;
+    }
+    return 0;
+}
+
+int ticos_report_poll(void)
+{
+    int64_t now = ticos_uptime_ms();
+
+    // 遍历已启动的设备需持有路由锁, 须先于上报锁获取
+    ticos_route_lock();
+    ticos_report_lock();
+    int count = ticos_resync_poll();
+    // 周期上报的字段可能进入合并状态, 先于合并上报处理
+    count += ticos_schedule_poll(now);
+    count += ticos_coalesce_poll(now);
+    count += ticos_metrics_poll(now);
+    ticos_report_unlock();
+    ticos_route_unlock();
+    return count;
+}
+
+int ticos_report_next_ms(void)
+{
+    int64_t now = ticos_uptime_ms();
+
+    ticos_route_lock();
+    ticos_report_lock();
+    int next = ticos_schedule_next_ms(now);
+    int wait = ticos_coalesce_next_ms(now);
+    if (next < 0 || (wait >= 0 && wait < next))
+        next = wait;
+    wait = ticos_metrics_next_ms(now);
+    if (next < 0 || (wait >= 0 && wait < next))
+        next = wait;
+    if (ticos_resync_pending())
+        next = 0;
+    ticos_report_unlock();
+    ticos_route_unlock();
+    return next;
+}
+
+/*
+ * 设置了合并窗口或速率限制时, 不能立即发送的请求合并到设备的合并状态中, 到期后由 ticos_report_poll() 发送
+ */
+static int ticos_client_report(ticos_client_t *client, ticos_report_t report, int index)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+    int ret;
+
+    ticos_report_lock();
+#if TICOS_COALESCE_FIELDS > 0
+    if (m_report_window || ticos_rate_enabled()) {
+        ticos_topic_class_t cls = report == TICOS_REPORT_TELEMETRY || report == TICOS_REPORT_TELEMETRY_INDEX ?
+                                  TICOS_TOPIC_TELEMETRY : TICOS_TOPIC_PROPERTY;
+        int64_t now = ticos_uptime_ms();
+        ticos_coalesce_mark(&client->coalesce[cls], report, index);
+        ret = ticos_coalesce_wait_ms(client, cls, now) ? 0 : ticos_coalesce_flush(client, cls, now);
+        ticos_report_unlock();
+        ticos_client_enter(prev);
+        return ret;
+    }
+#endif
+    ret = ticos_report_now(client, report, index);
+    ticos_report_unlock();
+    ticos_client_enter(prev);
+    return ret;
+}
+
+int ticos_client_telemetry_report_fields(ticos_client_t *client, const unsigned char *fields)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+    int ret;
+
+    ticos_report_lock();
+#if TICOS_COALESCE_FIELDS > 0
+    if (m_report_window || ticos_rate_enabled()) {
+        int64_t now = ticos_uptime_ms();
+        for (int i = 0; i < client->model->telemetry_cnt; i++) {
+            if (ticos_field_forced(fields, i))
+                ticos_coalesce_mark(&client->coalesce[TICOS_TOPIC_TELEMETRY], TICOS_REPORT_TELEMETRY_INDEX, i);
+        }
+        ret = ticos_coalesce_wait_ms(client, TICOS_TOPIC_TELEMETRY, now) ? 0 :
+              ticos_coalesce_flush(client, TICOS_TOPIC_TELEMETRY, now);
+        ticos_report_unlock();
+        ticos_client_enter(prev);
+        return ret;
+    }
+#endif
+    ret = ticos_telemetry_publish(client, 0, client->model->telemetry_cnt, fields, 0);
+    ticos_report_unlock();
+    ticos_client_enter(prev);
+    return ret;
+}
+
+int ticos_client_property_report(ticos_client_t *client)
+{
+    return ticos_client_report(client, TICOS_REPORT_PROPERTY, 0);
+}
+
+int ticos_client_property_report_changed(ticos_client_t *client)
+{
+    return ticos_client_report(client, TICOS_REPORT_PROPERTY_CHANGED, 0);
+}
+
+static int ticos_val_type_stream(ticos_val_type_t type)
+{
+    return type == TICOS_VAL_TYPE_STREAM || type == TICOS_VAL_TYPE_BLOB;
+}
+
+/*
+ * 流式字段单独成一条消息, 不经过合并, 也不进入发送队列
+ */
+static int ticos_client_stream_report(ticos_client_t *client, ticos_topic_class_t cls, int index)
+{
+    ticos_client_t *prev = ticos_client_enter(client);
+
+    ticos_report_lock();
+    TICOS_TRACE_BEGIN(TICOS_TRACE_REPORT, cls);
+    int ret = ticos_stream_report(client, cls, index);
+    TICOS_TRACE_END(TICOS_TRACE_REPORT);
+    ticos_report_unlock();
+    ticos_client_enter(prev);
+    return ret;
+}
+
+int ticos_client_property_report_by_index(ticos_client_t *client, int index)
+{
+    if (index < 0 || index >= client->model->property_cnt)
+        return -1;
+    if (ticos_val_type_stream(client->model->property_tab[index].type))
+        return ticos_client_stream_report(client, TICOS_TOPIC_PROPERTY, index);
+    return ticos_client_report(client, TICOS_REPORT_PROPERTY_INDEX, index);
+}
+
+int ticos_client_telemetry_report(ticos_client_t *client)
+{
+    return ticos_client_report(client, TICOS_REPORT_TELEMETRY, 0);
+}
+
+int ticos_client_telemetry_report_by_index(ticos_client_t *client, int index)
+{
+    if (index < 0 || index >= client->model->telemetry_cnt)
+        return -1;
+    if (ticos_val_type_stream(client->model->telemetry_tab[index].type))
+        return ticos_client_stream_report(client, TICOS_TOPIC_TELEMETRY, index);
+    return ticos_client_report(client, TICOS_REPORT_TELEMETRY_INDEX, index);
+}
+
+/*
+ * 不带上下文参数的接口操作默认设备
+ */
+void ticos_command_receive(const char *dat, int len)
+{
+    ticos_client_command_receive(ticos_client_default(), dat, len);
+}
+
+void ticos_property_receive(const char *dat, int len)
+{
+    ticos_client_property_receive(ticos_client_default(), dat, len);
+}
+
+int ticos_property_report(void)
+{
+    return ticos_client_property_report(ticos_client_default());
+}
+
+int ticos_property_report_changed(void)
+{
+    return ticos_client_property_report_changed(ticos_client_default());
+}
+
+int ticos_property_report_by_index(int index)
+{
+    return ticos_client_property_report_by_index(ticos_client_default(), index);
+}
+
+int ticos_telemetry_report(void)
+{
+    return ticos_client_telemetry_report(ticos_client_default());
+}
+
+int ticos_telemetry_report_by_index(int index)
+{
+    return ticos_client_telemetry_report_by_index(ticos_client_default(), index);
+}
+
+int ticos_set_payload_format(ticos_payload_format_t format)
+{
+    return ticos_client_set_payload_format(ticos_client_default(), format);
+}
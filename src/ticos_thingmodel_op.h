@@ -0,0 +1,176 @@
+#pragma once
+
+#include "ticos_thingmodel_type.h"
+#include "ticos_json_writer.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef int (*_ticos_send_int_t)();
+typedef int (*_ticos_send_bool_t)();
+typedef float (*_ticos_send_float_t)();
+typedef const char* (*_ticos_send_string_t)();
+
+typedef int (*_ticos_recv_int_t)(int);
+typedef int (*_ticos_recv_bool_t)(int);
+typedef int (*_ticos_recv_float_t)(float);
+typedef int (*_ticos_recv_string_t)(const char*);
+
+extern const ticos_telemetry_info_t ticos_telemetry_tab[];
+extern const ticos_property_info_t ticos_property_tab[];
+extern const ticos_command_info_t ticos_command_tab[];
+extern const int ticos_telemetry_cnt;
+extern const int ticos_property_cnt;
+extern const int ticos_command_cnt;
+
+int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain);
+
+/**
+ * @brief  SDK 内部统一的消息发送入口
+ * @note   开启离线缓存时, 未连接、仍有待重发的消息或发送失败时将消息存入离线队列,
+ *         连接恢复后按先后顺序重发
+ * @return 消息 id 或 0 代表成功(已发送或已缓存), 其他值代表失败
+ */
+int ticos_publish(const char *topic, const char *data, int len, int qos, int retain);
+
+/**
+ * @brief  通知离线缓存模块连接状态的变化
+ * @return void
+ */
+void ticos_offline_event(ticos_evt_t evt);
+
+/**
+ * 从物模型的 getter 函数取到的一个字段值
+ */
+typedef struct {
+    ticos_val_type_t type;
+    union {
+        int i;          // BOOLEAN, INTEGER
+        float f;        // FLOAT
+        const char *s;  // STRING
+    } v;
+} ticos_value_t;
+
+/**
+ * @brief  调用字段的 getter 函数取值
+ * @param val 输出的字段值
+ * @param type 字段类型
+ * @param func 字段的 getter 函数
+ * @return void
+ */
+void ticos_value_get(ticos_value_t *val, ticos_val_type_t type, void *func);
+
+/**
+ * @brief  以字段值调用属性的 recv 函数或命令处理函数
+ * @param val 字段值
+ * @param func 字段的 recv 函数或命令处理函数
+ * @return 函数的返回值, 字段类型不支持时返回 -1
+ */
+int ticos_value_set(const ticos_value_t *val, void *func);
+
+/**
+ * @brief  将字段值编码为 JSON 对象的一个成员
+ * @note   输出与 cJSON 一致, 值为 NULL 的字符串不输出
+ * @return void
+ */
+void ticos_json_add_value(ticos_json_writer_t *w, const char *id, const ticos_value_t *val);
+
+/**
+ * @brief  将属性的当前值与上次上报的值比较, 并更新设备的属性上报缓存
+ * @param client 设备上下文
+ * @param i 属性在方法表中的下标
+ * @param val 属性的当前值
+ * @return 1 代表值已改变或没有缓存, 0 代表值未改变
+ */
+int ticos_property_cache_update(ticos_client_t *client, int i, const ticos_value_t *val);
+
+/**
+ * @brief  清空设备的属性上报缓存, 下一次上报全部属性
+ * @return void
+ */
+void ticos_property_cache_reset(ticos_client_t *client);
+
+/**
+ * @brief  清空设备的上报过滤状态, 声明了过滤条件的字段在下一次上报时不受过滤
+ * @return void
+ */
+void ticos_report_filter_reset(ticos_client_t *client);
+
+/**
+ * @brief  忘记设备已处理的期望属性版本, 之后收到的期望属性文档不再按 $version 丢弃
+ * @note   重新连接后云端可能重新下发同一版本的文档, 其中未变化的属性仍由期望属性缓存过滤
+ * @return void
+ */
+void ticos_desired_reset(ticos_client_t *client);
+
+/**
+ * @brief  处理设备的下发命令和属性
+ * @return void
+ */
+void ticos_client_command_receive(ticos_client_t *client, const char *dat, int len);
+void ticos_client_property_receive(ticos_client_t *client, const char *dat, int len);
+
+/**
+ * @brief  处理设备分片到达的下发命令或属性
+ * @note   分片须按顺序给出, 最后一个分片到达时整条消息格式正确才分发; 分片缺失时整条丢弃
+ * @param command 1 代表命令, 0 代表期望属性
+ * @param offset 分片在消息中的位置, 为 0 时开始一条新消息
+ * @param total 消息的总长度
+ * @return void
+ */
+void ticos_client_receive_fragment(ticos_client_t *client, int command, const char *dat, int len, int offset, int total);
+
+/**
+ * @brief  以设备上下文执行一条命令
+ * @param client 设备上下文
+ * @param index 命令在方法表中的下标
+ * @param val 命令参数
+ * @return 命令处理函数的返回值
+ */
+int ticos_client_command_execute(ticos_client_t *client, int index, const ticos_value_t *val);
+
+/**
+ * @brief  获取已启动设备的链表
+ * @note   遍历期间需持有路由锁, 见 ticos_route_lock()
+ * @return 第一个设备, 没有已启动的设备时返回 NULL
+ */
+ticos_client_t *ticos_client_list(void);
+
+/**
+ * @brief  上报设备的多个遥测, 用于周期上报, 不经过物模型中声明的过滤条件;
+ *         设置了合并窗口或速率限制时与单个遥测的上报请求一样合并
+ * @param client 设备上下文
+ * @param fields 待上报遥测的位图, 共 TICOS_FIELD_BITS 位
+ * @return 0 代表成功，其他值代表错误
+ */
+int ticos_client_telemetry_report_fields(ticos_client_t *client, const unsigned char *fields);
+
+/**
+ * @brief  通知发送线程重新计算下一次处理合并上报和周期上报的时间, 发送线程未启动时不做任何事
+ * @return void
+ */
+void ticos_sender_notify(void);
+
+/**
+ * @brief  获取或释放上报锁
+ * @note   上报缓冲区、属性上报缓存、期望属性缓存、过滤状态、合并状态、批量采样缓存和离线队列只在持有上报锁时访问;
+ *         可重入, 物模型回调中可以再次调用上报接口。TICOS_THREAD_SAFE 为 0 时为空函数
+ * @return void
+ */
+void ticos_report_lock(void);
+void ticos_report_unlock(void);
+
+/**
+ * @brief  获取当前使用的上报缓冲区, 调用者须持有上报锁
+ * @param size 输出缓冲区大小
+ * @return 缓冲区指针
+ */
+char *ticos_report_buffer(int *size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,8 @@ extern "C"
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 typedef enum {
@@ -16,18 +18,40 @@ typedef enum {
     TICOS_VAL_TYPE_ENUM,
     TICOS_VAL_TYPE_TIMESTAMP,
     TICOS_VAL_TYPE_DURATION,
+    TICOS_VAL_TYPE_STREAM,      // 分块读取的大文本, 编码为 JSON 字符串
+    TICOS_VAL_TYPE_BLOB,        // 分块读取的二进制数据, JSON 中编码为 base64 字符串, CBOR 中编码为字节串
     TICOS_VAL_TYPE_MAX,
 } ticos_val_type_t;
 
+/**
+ * 流式字段(TICOS_VAL_TYPE_STREAM / TICOS_VAL_TYPE_BLOB)的数据读取函数, 代替 getter 函数登记在方法表中:
+ * 从数据的 offset 处起读取至多 size 字节到 buf, 返回读取的字节数, 返回 0 表示已读完, 负数表示错误。
+ * SDK 先完整读取一遍计算消息长度, 再从头读取一遍编码发送, 两次读取的数据须一致
+ */
+typedef int (*ticos_stream_read_t)(size_t offset, void *buf, int size);
+
 typedef struct {
     time_t start;
     time_t end;
 } ticos_val_duration_t;
 
+/**
+ * 物模型中为字段声明的上报过滤条件, 由 ticos_thingmodel_gen.py 根据物模型 json 中的
+ * deadband, deadbandPercent, minInterval 和 maxInterval 生成
+ */
+typedef struct {
+    float deadband;         // 绝对死区, 数值与上次上报值之差不超过此值时不上报
+    float deadband_pct;     // 相对死区(百分比), 按上次上报值的绝对值计算, 与绝对死区同时声明时取较大者
+    int min_interval_ms;    // 最小上报间隔, 间隔内的变化不上报, 0 表示不限制
+    int max_interval_ms;    // 最大上报间隔, 超过时即使未变化也上报一次, 0 表示不限制
+} ticos_report_filter_t;
+
 typedef struct {
     const char *id;
     ticos_val_type_t type;
     void *func;
+    const ticos_report_filter_t *filter;    // 为 NULL 时不过滤
+    int period_ms;                          // 周期上报的间隔(毫秒), 0 表示不周期上报
 } ticos_telemetry_info_t;
 
 typedef struct {
@@ -35,6 +59,7 @@ typedef struct {
     ticos_val_type_t type;
     void *send_func;
     void *recv_func;
+    const ticos_report_filter_t *filter;    // 为 NULL 时不过滤
 } ticos_property_info_t;
 
 typedef struct {
@@ -43,6 +68,43 @@ typedef struct {
     void *func;
 } ticos_command_info_t;
 
+typedef struct {
+    unsigned short index;   // 字段在方法表中的下标
+    unsigned short len;     // 字段名的长度
+} ticos_index_slot_t;
+
+/**
+ * 由 ticos_thingmodel_gen.py 生成的字段名最小完美哈希表,
+ * 用于将云端下发的字段名在 O(1) 时间内映射为方法表中的下标
+ */
+typedef struct {
+    const int *disp;                    // 每个哈希桶的位移值, 负数 -n-1 表示直接落在槽位 n
+    const ticos_index_slot_t *slots;    // 槽位到方法表下标的映射
+    int size;                           // 哈希桶和槽位的数量
+} ticos_thingmodel_index_t;
+
+struct ticos_json_writer_s;
+struct ticos_client_s;
+
+/**
+ * 一个物模型的方法表及其附属数据, 供多设备上下文(ticos_client_t)使用;
+ * 使用全局方法表的默认设备由 SDK 根据生成的符号自动填写
+ */
+typedef struct {
+    const ticos_telemetry_info_t *telemetry_tab;
+    int telemetry_cnt;
+    const ticos_property_info_t *property_tab;
+    int property_cnt;
+    const ticos_command_info_t *command_tab;
+    int command_cnt;
+    const ticos_thingmodel_index_t *property_index;     // 为 NULL 时逐个比较字段名
+    const ticos_thingmodel_index_t *command_index;      // 为 NULL 时逐个比较字段名
+    uint32_t hash;                                      // 物模型哈希值, CBOR 上报时使用
+    // 生成的专用编码函数, 为 NULL 时逐个字段编码
+    void (*serialize_telemetry)(struct ticos_json_writer_s *w);
+    void (*serialize_property)(struct ticos_client_s *client, struct ticos_json_writer_s *w);
+} ticos_thingmodel_t;
+
 #ifdef __cplusplus
 }
 #endif
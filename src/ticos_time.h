@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief  获取当前的 UTC 时间
+ * @note   设备需要先完成网络对时, 否则返回的时间没有意义
+ * @return 自 1970-01-01 00:00:00 UTC 起的毫秒数
+ */
+int64_t ticos_time_ms(void);
+
+/**
+ * @brief  获取单调递增的系统时间, 不受对时影响, 用于计算时间间隔
+ * @return 毫秒数
+ */
+int64_t ticos_uptime_ms(void);
+
+/**
+ * @brief  获取单调递增的系统时间, 精度为微秒, 用于统计耗时
+ * @return 微秒数
+ */
+int64_t ticos_uptime_us(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#include "ticos_timer.h"
+#include <string.h>
+
+#define TICOS_TIMER_MASK    (TICOS_TIMER_SLOTS - 1)
+// 时间轮直接容纳的最大间隔, 更远的定时器先放在最高级的最远槽位, 到时再重新分配
+#define TICOS_TIMER_SPAN    ((1u << (TICOS_TIMER_BITS * TICOS_TIMER_LEVELS)) - 1)
+
+static void ticos_timer_link(ticos_timer_t **head, ticos_timer_t *timer)
+{
+    timer->next = *head;
+    if (*head)
+        (*head)->pprev = &timer->next;
+    *head = timer;
+    timer->pprev = head;
+}
+
+// 按距离下一个待处理 tick 的间隔选择级别, 已过期的定时器放在当前槽位
+static void ticos_timer_insert(ticos_timer_wheel_t *w, ticos_timer_t *timer)
+{
+    uint32_t expires = timer->expires;
+    int32_t delta = (int32_t)(expires - w->tick);
+    int level = 0;
+
+    if (delta < 0) {
+        expires = w->tick;
+        delta = 0;
+    } else if ((uint32_t)delta > TICOS_TIMER_SPAN) {
+        expires = w->tick + TICOS_TIMER_SPAN;
+        delta = TICOS_TIMER_SPAN;
+    }
+    while (level < TICOS_TIMER_LEVELS - 1 && (uint32_t)delta >= 1u << (TICOS_TIMER_BITS * (level + 1)))
+        level++;
+    ticos_timer_link(&w->slots[level][(expires >> (TICOS_TIMER_BITS * level)) & TICOS_TIMER_MASK], timer);
+}
+
+// 将高一级槽位中的定时器重新分配到低级, 返回槽位下标
+static int ticos_timer_cascade(ticos_timer_wheel_t *w, int level, int index)
+{
+    ticos_timer_t *head = w->slots[level][index];
+
+    w->slots[level][index] = NULL;
+    while (head) {
+        ticos_timer_t *timer = head;
+        head = timer->next;
+        ticos_timer_insert(w, timer);
+    }
+    return index;
+}
+
+void ticos_timer_wheel_init(ticos_timer_wheel_t *w, uint32_t now)
+{
+    memset(w, 0, sizeof(*w));
+    w->tick = now;
+}
+
+void ticos_timer_add(ticos_timer_wheel_t *w, ticos_timer_t *timer, uint32_t expires)
+{
+    timer->expires = expires;
+    ticos_timer_insert(w, timer);
+    w->count++;
+}
+
+void ticos_timer_del(ticos_timer_wheel_t *w, ticos_timer_t *timer)
+{
+    if (!timer->pprev)
+        return;
+    *timer->pprev = timer->next;
+    if (timer->next)
+        timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    w->count--;
+}
+
+int ticos_timer_pending(const ticos_timer_t *timer)
+{
+    return timer->pprev != NULL;
+}
+
+int ticos_timer_advance(ticos_timer_wheel_t *w, uint32_t now)
+{
+    int fired = 0;
+
+    while ((int32_t)(now - w->tick) >= 0) {
+        // 没有定时器时直接跳到 now 之后
+        if (!w->count) {
+            w->tick = now + 1;
+            break;
+        }
+        int index = w->tick & TICOS_TIMER_MASK;
+        if (!index) {
+            for (int level = 1; level < TICOS_TIMER_LEVELS; level++) {
+                if (ticos_timer_cascade(w, level, (w->tick >> (TICOS_TIMER_BITS * level)) & TICOS_TIMER_MASK))
+                    break;
+            }
+        }
+        // 先取下当前槽位再触发, 回调中启动的定时器进入之后的槽位, 停止的定时器从局部链表中摘除
+        ticos_timer_t *head = w->slots[0][index];
+        w->slots[0][index] = NULL;
+        if (head)
+            head->pprev = &head;
+        w->tick++;
+        while (head) {
+            ticos_timer_t *timer = head;
+            ticos_timer_del(w, timer);
+            timer->cb(timer);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+int ticos_timer_next(const ticos_timer_wheel_t *w, uint32_t *expires)
+{
+    int found = 0;
+    uint32_t best = 0;
+
+    if (!w->count)
+        return -1;
+    // 每一级中按槽位顺序找到第一个非空槽位, 其中最早的定时器即该级最早的; 各级之间再取最早的。
+    // 高级别的当前槽位在处理到其起始 tick 时才分配到低级, 之后其中只有恰好相隔一圈的定时器, 最后检查
+    for (int level = 0; level < TICOS_TIMER_LEVELS; level++) {
+        uint32_t cur = (w->tick >> (TICOS_TIMER_BITS * level)) & TICOS_TIMER_MASK;
+        int start = level && (w->tick & ((1u << (TICOS_TIMER_BITS * level)) - 1)) ? 1 : 0;
+        for (int i = start; i < start + TICOS_TIMER_SLOTS; i++) {
+            const ticos_timer_t *timer = w->slots[level][(cur + i) & TICOS_TIMER_MASK];
+            if (!timer)
+                continue;
+            for (; timer; timer = timer->next) {
+                if (!found || (int32_t)(timer->expires - best) < 0)
+                    best = timer->expires;
+                found = 1;
+            }
+            break;
+        }
+    }
+    *expires = best;
+    return 0;
+}
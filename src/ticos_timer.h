@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 每级时间轮的槽位数为 2^TICOS_TIMER_BITS, 共 TICOS_TIMER_LEVELS 级, 可直接容纳 2^24 个 tick 以内的定时器
+#define TICOS_TIMER_BITS    6
+#define TICOS_TIMER_SLOTS   (1 << TICOS_TIMER_BITS)
+#define TICOS_TIMER_LEVELS  4
+
+struct ticos_timer_s;
+typedef void (*ticos_timer_cb_t)(struct ticos_timer_s *timer);
+
+/**
+ * 定时器, 内存由调用者提供, 以双向链表挂在时间轮的槽位上
+ */
+typedef struct ticos_timer_s {
+    struct ticos_timer_s *next;
+    struct ticos_timer_s **pprev;   // 指向链表中指向本定时器的指针, 为 NULL 表示未启动
+    uint32_t expires;               // 到期的 tick
+    ticos_timer_cb_t cb;
+    void *arg;
+} ticos_timer_t;
+
+/**
+ * 分级时间轮: 第 0 级每个槽位对应一个 tick, 第 n 级每个槽位对应 2^(6n) 个 tick。
+ * 启动和停止定时器都是 O(1) 的, 低一级转过一圈时才把高一级当前槽位中的定时器重新分配到低级。
+ * 时间轮不加锁, 由调用者保证互斥
+ */
+typedef struct {
+    ticos_timer_t *slots[TICOS_TIMER_LEVELS][TICOS_TIMER_SLOTS];
+    uint32_t tick;      // 下一个待处理的 tick
+    int count;          // 已启动的定时器数
+} ticos_timer_wheel_t;
+
+/**
+ * @brief  初始化时间轮
+ * @param now 当前的 tick
+ * @return void
+ */
+void ticos_timer_wheel_init(ticos_timer_wheel_t *w, uint32_t now);
+
+/**
+ * @brief  启动定时器, 已启动的定时器须先停止
+ * @param expires 到期的 tick, 已过期时在下一次推进时间轮时触发
+ * @return void
+ */
+void ticos_timer_add(ticos_timer_wheel_t *w, ticos_timer_t *timer, uint32_t expires);
+
+/**
+ * @brief  停止定时器, 未启动的定时器不受影响
+ * @return void
+ */
+void ticos_timer_del(ticos_timer_wheel_t *w, ticos_timer_t *timer);
+
+/**
+ * @brief  定时器是否已启动且尚未触发
+ * @return 1 代表已启动, 0 代表未启动
+ */
+int ticos_timer_pending(const ticos_timer_t *timer);
+
+/**
+ * @brief  推进时间轮到 now, 依次触发到期的定时器
+ * @note   回调中可以启动或停止任意定时器, 启动的定时器到期时间不晚于 now 时在下一个 tick 触发
+ * @param now 当前的 tick
+ * @return 触发的定时器数
+ */
+int ticos_timer_advance(ticos_timer_wheel_t *w, uint32_t now);
+
+/**
+ * @brief  获取最早的到期时间
+ * @param expires 输出最早到期的 tick
+ * @return 0 代表成功, 没有已启动的定时器时返回 -1
+ */
+int ticos_timer_next(const ticos_timer_wheel_t *w, uint32_t *expires);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+#include "ticos_trace.h"
+
+static const char *const m_names[TICOS_TRACE_ID_MAX] = {
+    "report", "getter", "encode", "publish", "recv", "dispatch", "recv_func", "command",
+};
+
+const char *ticos_trace_name(int id)
+{
+    return id >= 0 && id < TICOS_TRACE_ID_MAX ? m_names[id] : "unknown";
+}
+
+#if TICOS_TRACE
+
+#include <stdatomic.h>
+#include "ticos_time.h"
+
+#if TICOS_TRACE_RECORDS & (TICOS_TRACE_RECORDS - 1)
+#error "TICOS_TRACE_RECORDS must be a power of 2"
+#endif
+
+/*
+ * 写入者以原子加法取得序号 n, 写入第 n % TICOS_TRACE_RECORDS 个槽位: 先将槽位的序号清零, 写完记录后再发布 n + 1。
+ * 读取者复制记录前后各读一次序号, 两次相同且等于期望的序号时记录才完整, 否则该记录已被覆盖或正在写入。
+ * 缓冲区绕回一圈时两个写入者可能落在同一槽位, 以 busy 标志保证同一时刻只有一个写入者, 后到的写入者和
+ * 比槽位中已有记录更旧的写入者直接丢弃记录, 不等待
+ */
+typedef struct {
+    atomic_uint seq;
+    atomic_flag busy;
+    ticos_trace_record_t rec;
+} ticos_trace_slot_t;
+
+static ticos_trace_slot_t m_ring[TICOS_TRACE_RECORDS];
+static atomic_uint m_head;
+static atomic_uint m_threads;
+static _Thread_local uint16_t m_tid;
+
+void ticos_trace_record(ticos_trace_id_t id, int phase, uint32_t arg)
+{
+    unsigned int n = atomic_fetch_add_explicit(&m_head, 1, memory_order_relaxed);
+    ticos_trace_slot_t *slot = &m_ring[n & (TICOS_TRACE_RECORDS - 1)];
+
+    if (!m_tid)
+        m_tid = (uint16_t)(atomic_fetch_add_explicit(&m_threads, 1, memory_order_relaxed) + 1);
+    if (atomic_flag_test_and_set_explicit(&slot->busy, memory_order_acquire))
+        return;
+    unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    if (seq && (int)(seq - (n + 1)) > 0) {
+        atomic_flag_clear_explicit(&slot->busy, memory_order_release);
+        return;
+    }
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->rec.ts_us = (uint32_t)ticos_uptime_us();
+    slot->rec.arg = arg;
+    slot->rec.tid = m_tid;
+    slot->rec.id = (uint8_t)id;
+    slot->rec.phase = (uint8_t)phase;
+    atomic_store_explicit(&slot->seq, n + 1, memory_order_release);
+    atomic_flag_clear_explicit(&slot->busy, memory_order_release);
+}
+
+int ticos_trace_read(ticos_trace_record_t *records, int max)
+{
+    unsigned int head = atomic_load_explicit(&m_head, memory_order_acquire);
+    unsigned int cnt = head < TICOS_TRACE_RECORDS ? head : TICOS_TRACE_RECORDS;
+    int out = 0;
+
+    if (max < 0)
+        return 0;
+    if (cnt > (unsigned int)max)
+        cnt = max;
+    for (unsigned int n = head - cnt; n != head; n++) {
+        ticos_trace_slot_t *slot = &m_ring[n & (TICOS_TRACE_RECORDS - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != n + 1)
+            continue;
+        ticos_trace_record_t rec = slot->rec;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != n + 1)
+            continue;
+        records[out++] = rec;
+    }
+    return out;
+}
+#else
+void ticos_trace_record(ticos_trace_id_t id, int phase, uint32_t arg)
+{
+}
+
+int ticos_trace_read(ticos_trace_record_t *records, int max)
+{
+    return 0;
+}
+#endif
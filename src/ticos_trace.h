@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include "ticos_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 跟踪点, 名称见 ticos_trace_name()
+ */
+typedef enum {
+    TICOS_TRACE_REPORT,         // 编码并发送一条上报, arg 为 ticos_topic_class_t
+    TICOS_TRACE_GETTER,         // 物模型的 getter 函数, arg 为字段下标
+    TICOS_TRACE_ENCODE,         // 结束编码, 生成上报数据
+    TICOS_TRACE_PUBLISH,        // 发布一条消息, arg 为消息的字节数
+    TICOS_TRACE_RECV,           // ticos_msg_recv() 处理一条下发消息, arg 为消息的字节数
+    TICOS_TRACE_DISPATCH,       // 解析下发数据并分发给各字段, arg 为 1 时是命令, 0 时是期望属性
+    TICOS_TRACE_RECV_FUNC,      // 物模型属性的 recv 函数, arg 为字段下标
+    TICOS_TRACE_COMMAND,        // 命令处理函数, arg 为命令下标
+    TICOS_TRACE_ID_MAX,
+} ticos_trace_id_t;
+
+/**
+ * 一条跟踪记录
+ */
+typedef struct {
+    uint32_t ts_us;     // ticos_uptime_us() 的低 32 位
+    uint32_t arg;
+    uint16_t tid;       // 线程编号, 从 1 开始按线程首次记录的先后分配
+    uint8_t id;         // ticos_trace_id_t
+    uint8_t phase;      // 'B' 代表开始, 'E' 代表结束
+} ticos_trace_record_t;
+
+#if TICOS_TRACE
+#define TICOS_TRACE_BEGIN(id, arg)  ticos_trace_record((id), 'B', (uint32_t)(arg))
+#define TICOS_TRACE_END(id)         ticos_trace_record((id), 'E', 0)
+#else
+#define TICOS_TRACE_BEGIN(id, arg)  ((void)0)
+#define TICOS_TRACE_END(id)         ((void)0)
+#endif
+
+/**
+ * @brief  写入一条跟踪记录, 由 TICOS_TRACE_BEGIN() 和 TICOS_TRACE_END() 调用
+ * @note   可在任意线程中并发调用, 以原子加法占用位置, 不加锁也不申请内存
+ * @return void
+ */
+void ticos_trace_record(ticos_trace_id_t id, int phase, uint32_t arg);
+
+/**
+ * @brief  按写入的先后读出环形缓冲区中的跟踪记录
+ * @note   正在被写入或读取期间被覆盖的记录会被跳过
+ * @param records 输出的记录
+ * @param max 最多读出的记录数, 超出时只读出最新的 max 条
+ * @return 读出的记录数, 未开启 TICOS_TRACE 时返回 0
+ */
+int ticos_trace_read(ticos_trace_record_t *records, int max);
+
+/**
+ * @brief  获取跟踪点的名称
+ * @return 名称, id 无效时返回 "unknown"
+ */
+const char *ticos_trace_name(int id);
+
+#ifdef __cplusplus
+}
+#endif
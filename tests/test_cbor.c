@@ -0,0 +1,270 @@
+/*
+ * CBOR 编解码: 编码结果与 RFC 8949 附录 A 的示例一致, 解码能还原编码的值, 格式错误或截断的数据被拒绝,
+ * 上报和下发使用字段下标和物模型哈希值
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_cbor.h"
+#include "ticos_thingmodel_type.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+void ticos_property_receive(const char *dat, int len);
+
+static int m_light = 7;
+static float m_temp = 21.5f;
+static int m_calls = 0;
+
+static int light_send(void) { return m_light; }
+static int light_recv(int v) { m_light = v; m_calls++; return 0; }
+static float temp_send(void) { return m_temp; }
+static int temp_recv(float v) { m_temp = v; m_calls++; return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+    { "temp", TICOS_VAL_TYPE_FLOAT, temp_send, temp_recv },
+};
+const int ticos_property_cnt = 2;
+const uint32_t ticos_thingmodel_hash = 0x12345678;
+
+static int hex(const char *s, unsigned char *out)
+{
+    int n = 0;
+    unsigned int b;
+    while (sscanf(s + 2 * n, "%2x", &b) == 1)
+        out[n++] = b;
+    return n;
+}
+
+static void check_bytes(const unsigned char *buf, int len, const char *expect)
+{
+    unsigned char want[64];
+    int n = hex(expect, want);
+    TICOS_CHECK_INT(len, n);
+    if (len == n && memcmp(buf, want, n))
+        TICOS_CHECK(!"encoded bytes differ");
+}
+
+static void test_encode(void)
+{
+    static const struct {
+        int64_t val;
+        const char *hex;
+    } ints[] = {
+        { 0, "00" }, { 23, "17" }, { 24, "1818" }, { 255, "18ff" }, { 256, "190100" }, { 65535, "19ffff" },
+        { 65536, "1a00010000" }, { 4294967295LL, "1affffffff" }, { 4294967296LL, "1b0000000100000000" },
+        { INT64_MAX, "1b7fffffffffffffff" }, { -1, "20" }, { -24, "37" }, { -25, "3818" }, { -1000, "3903e7" },
+        { INT64_MIN, "3b7fffffffffffffff" },
+    };
+    unsigned char buf[64];
+    ticos_cbor_writer_t w;
+
+    for (unsigned i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        ticos_cbor_writer_init(&w, buf, sizeof(buf));
+        ticos_cbor_int(&w, ints[i].val);
+        check_bytes(buf, ticos_cbor_writer_finish(&w), ints[i].hex);
+    }
+
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_float(&w, 100000.0f);
+    check_bytes(buf, ticos_cbor_writer_finish(&w), "fa47c35000");
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_string(&w, "\xc3\xbc");
+    check_bytes(buf, ticos_cbor_writer_finish(&w), "62c3bc");
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_string(&w, "");
+    ticos_cbor_bool(&w, 0);
+    ticos_cbor_bool(&w, 1);
+    ticos_cbor_null(&w);
+    check_bytes(buf, ticos_cbor_writer_finish(&w), "60f4f5f6");
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_self_describe(&w);
+    ticos_cbor_map_begin(&w);
+    ticos_cbor_int(&w, 1);
+    ticos_cbor_string(&w, "a");
+    ticos_cbor_map_end(&w);
+    check_bytes(buf, ticos_cbor_writer_finish(&w), "d9d9f7bf016161ff");
+
+    // 缓冲区不足时整体失败, 不越过缓冲区
+    for (int size = 0; size < 8; size++) {
+        memset(buf, 0xAA, sizeof(buf));
+        ticos_cbor_writer_init(&w, buf, size);
+        ticos_cbor_self_describe(&w);
+        ticos_cbor_map_begin(&w);
+        ticos_cbor_int(&w, 1);
+        ticos_cbor_string(&w, "a");
+        ticos_cbor_map_end(&w);
+        TICOS_CHECK_INT(ticos_cbor_writer_finish(&w), -1);
+        TICOS_CHECK_INT(buf[size], 0xAA);
+    }
+}
+
+// 解码只含一个成员的 map, 返回成员值
+static int decode_one(const char *hexstr, ticos_cbor_item_t *val)
+{
+    unsigned char buf[64];
+    ticos_cbor_reader_t r;
+    ticos_cbor_item_t key;
+    int n = hex(hexstr, buf);
+
+    if (ticos_cbor_check_map(buf, n) || ticos_cbor_map_enter(&r, buf, n) || ticos_cbor_map_next(&r, &key, val) != 1)
+        return -1;
+    return 0;
+}
+
+static void test_decode(void)
+{
+    ticos_cbor_item_t v;
+
+    TICOS_CHECK_INT(decode_one("a1001b7fffffffffffffff", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_INT);
+    TICOS_CHECK(v.i == INT64_MAX);
+    TICOS_CHECK_INT(decode_one("a1003b7fffffffffffffff", &v), 0);
+    TICOS_CHECK(v.i == INT64_MIN);
+    // 超出 int64 范围的整数取最接近的值
+    TICOS_CHECK_INT(decode_one("a1001bffffffffffffffff", &v), 0);
+    TICOS_CHECK(v.i == INT64_MAX);
+    TICOS_CHECK_INT(decode_one("a1003bffffffffffffffff", &v), 0);
+    TICOS_CHECK(v.i == INT64_MIN);
+
+    // 半精度、单精度和双精度浮点数
+    static const struct {
+        const char *hex;
+        double val;
+    } floats[] = {
+        { "a100f93c00", 1.0 }, { "a100f93e00", 1.5 }, { "a100f97bff", 65504.0 }, { "a100f90001", 5.960464477539063e-8 },
+        { "a100f90400", 6.103515625e-5 }, { "a100f9c400", -4.0 }, { "a100fa47c35000", 100000.0 },
+        { "a100fb3ff199999999999a", 1.1 }, { "a100fbc010666666666666", -4.1 },
+    };
+    for (unsigned i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        TICOS_CHECK_INT(decode_one(floats[i].hex, &v), 0);
+        TICOS_CHECK_INT(v.type, TICOS_CBOR_FLOAT);
+        TICOS_CHECK(v.f == floats[i].val);
+    }
+    TICOS_CHECK_INT(decode_one("a100f97c00", &v), 0);
+    TICOS_CHECK(isinf(v.f) && v.f > 0);
+    TICOS_CHECK_INT(decode_one("a100f97e00", &v), 0);
+    TICOS_CHECK(isnan(v.f));
+
+    // 字符串、嵌套容器和标签
+    TICOS_CHECK_INT(decode_one("a10064494554460", &v), -1);
+    TICOS_CHECK_INT(decode_one("a1006449455446", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_STRING);
+    TICOS_CHECK_INT(v.len, 4);
+    TICOS_CHECK_INT(decode_one("a1008301820203820405", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_OTHER);
+    TICOS_CHECK_INT(decode_one("a1007f657374726561646d696e67ff", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_OTHER);
+    TICOS_CHECK_INT(decode_one("a100c11a514b67b0", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_INT);
+    TICOS_CHECK_INT(v.i, 1363896240);
+    TICOS_CHECK_INT(decode_one("d9d9f7a100f5", &v), 0);
+    TICOS_CHECK_INT(v.type, TICOS_CBOR_BOOL);
+    TICOS_CHECK_INT(v.i, 1);
+}
+
+static void test_malformed(void)
+{
+    static const char *bad[] = {
+        "", "00", "80", "a1", "a100", "bf00", "bf0001", "bf00ff", "a2000001", "a1001c", "a1001d", "a1001e",
+        "a1ff", "a100ff", "a1001f", "a1003f", "a100df00", "a1007f01ff", "a1007f6161", "a100626161ff",
+        "a1008301", "a10062", "a1001a0000", "a100a1", "a10081ff", "bf0001ff00", "a1000000", "a1006161a1",
+        "a100bf00ff", "a100bb80000000000000000000", "a1009b8000000000000001", "a1005f6101ff", "c0", "9f01ff",
+    };
+    unsigned char buf[64];
+
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        int n = hex(bad[i], buf);
+        if (!ticos_cbor_check_map(buf, n)) {
+            printf("accepted malformed: %s\n", bad[i]);
+            TICOS_CHECK(!"malformed CBOR accepted");
+        }
+    }
+
+    // 截断在任意位置的数据都被拒绝
+    const char *good = "d9d9f7bf201a1234567800076474656d70fa41ac0000ff";
+    int n = hex(good, buf);
+    TICOS_CHECK_INT(ticos_cbor_check_map(buf, n), 0);
+    for (int i = 0; i < n; i++)
+        TICOS_CHECK(ticos_cbor_check_map(buf, i) != 0);
+
+    // 嵌套层数超出限制
+    int depth = 0;
+    buf[depth++] = 0xa1;
+    buf[depth++] = 0x00;
+    while (depth < 40)
+        buf[depth++] = 0x81;
+    buf[depth++] = 0x00;
+    TICOS_CHECK(ticos_cbor_check_map(buf, depth) != 0);
+}
+
+static void test_report(void)
+{
+    ticos_test_connect();
+    TICOS_CHECK_INT(ticos_set_payload_format(TICOS_PAYLOAD_CBOR), 0);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    const ticos_test_msg_t *msg = ticos_test_msg(0);
+    TICOS_CHECK(msg != NULL);
+    if (msg) {
+        TICOS_CHECK_STR(msg->topic, "devices/D/twin/reported");
+        ticos_cbor_reader_t r;
+        ticos_cbor_item_t key, val;
+        int seen = 0;
+        TICOS_CHECK(ticos_cbor_detect(msg->data, msg->len));
+        TICOS_CHECK_INT(ticos_cbor_check_map(msg->data, msg->len), 0);
+        ticos_cbor_map_enter(&r, msg->data, msg->len);
+        while (ticos_cbor_map_next(&r, &key, &val) > 0) {
+            TICOS_CHECK_INT(key.type, TICOS_CBOR_INT);
+            if (key.i == TICOS_CBOR_KEY_HASH) {
+                TICOS_CHECK_INT(val.i, 0x12345678);
+                seen |= 1;
+            } else if (key.i == 0) {
+                TICOS_CHECK_INT(val.i, 7);
+                seen |= 2;
+            } else if (key.i == 1) {
+                TICOS_CHECK(val.type == TICOS_CBOR_FLOAT && val.f == 21.5);
+                seen |= 4;
+            }
+        }
+        TICOS_CHECK_INT(seen, 7);
+    }
+    ticos_set_payload_format(TICOS_PAYLOAD_JSON);
+}
+
+static void test_receive(void)
+{
+    unsigned char buf[64];
+    int n;
+
+    // 以下标和字段名为键都可以, 带有标签时也能识别
+    n = hex("d9d9f7bf201a1234567800186401fa3f800000ff", buf);
+    ticos_property_receive((const char *)buf, n);
+    TICOS_CHECK_INT(m_calls, 2);
+    TICOS_CHECK_INT(m_light, 100);
+    TICOS_CHECK(m_temp == 1.0f);
+    n = hex("a2656c696768741865646e6f6e650a", buf);
+    ticos_property_receive((const char *)buf, n);
+    TICOS_CHECK_INT(m_calls, 3);
+    TICOS_CHECK_INT(m_light, 101);
+
+    // 物模型哈希值不符、格式错误和截断的数据整条丢弃
+    n = hex("a2201a12345679001866", buf);
+    ticos_property_receive((const char *)buf, n);
+    n = hex("bf00186701", buf);
+    ticos_property_receive((const char *)buf, n);
+    n = hex("a2001868011868ff", buf);
+    ticos_property_receive((const char *)buf, n);
+    TICOS_CHECK_INT(m_calls, 3);
+    TICOS_CHECK_INT(m_light, 101);
+}
+
+int main(void)
+{
+    test_encode();
+    test_decode();
+    test_malformed();
+    test_report();
+    test_receive();
+    return ticos_test_result();
+}
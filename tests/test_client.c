@@ -0,0 +1,265 @@
+/*
+ * 多设备上下文: 每个设备使用各自的身份信息、topic 和物模型, 共用一条连接, 下发消息只分发给对应的设备
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include <stdio.h>
+#include <unistd.h>
+
+typedef struct {
+    int value;          // getter 返回的值
+    int recv;           // recv 函数收到的值
+    int recv_calls;
+    int cmd;            // 命令收到的值
+    int cmd_calls;
+    int connects;
+    int disconnects;
+} device_t;
+
+static device_t m_dev[4];
+static ticos_client_t m_client[4];
+
+// 共用同一物模型的设备以 ticos_client_current() 区分
+static device_t *current(void)
+{
+    return ticos_client_user_data(ticos_client_current());
+}
+
+static int get_v(void) { return current()->value; }
+static int recv_v(int v) { current()->recv = v; current()->recv_calls++; return 0; }
+static int cmd_v(int v) { current()->cmd = v; current()->cmd_calls++; return 0; }
+static float get_other(void) { return 2.5f; }
+
+static const ticos_property_info_t m_props[] = {
+    { "v", TICOS_VAL_TYPE_INTEGER, get_v, recv_v },
+};
+static const ticos_telemetry_info_t m_teles[] = {
+    { "t", TICOS_VAL_TYPE_INTEGER, get_v },
+};
+static const ticos_command_info_t m_cmds[] = {
+    { "cmd", TICOS_VAL_TYPE_INTEGER, cmd_v },
+};
+static const ticos_thingmodel_t m_model = { m_teles, 1, m_props, 1, m_cmds, 1 };
+
+static const ticos_property_info_t m_other_props[] = {
+    { "other", TICOS_VAL_TYPE_FLOAT, get_other, NULL },
+};
+static const ticos_thingmodel_t m_other_model = { NULL, 0, m_other_props, 1, NULL, 0 };
+
+static void on_event(void *user_data, ticos_evt_t evt)
+{
+    device_t *dev = user_data;
+
+    if (evt == TICOS_EVENT_CONNECT)
+        dev->connects++;
+    else
+        dev->disconnects++;
+}
+
+// 与 HAL 一致, 连接成功时先通知再订阅
+static void connected(void)
+{
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_mqtt_subscribe();
+}
+
+static void recv(const char *topic, const char *data)
+{
+    ticos_msg_recv(topic, data, strlen(data));
+}
+
+// 命令可能由工作线程执行, 等待回复发布
+static int wait_count(int count)
+{
+    for (int i = 0; i < 1000 && ticos_test_count() < count; i++)
+        usleep(1000);
+    return ticos_test_count() >= count;
+}
+
+static void init_devices(void)
+{
+    static const char *const ids[] = { "A", "B", "C", "D" };
+
+    memset(m_dev, 0, sizeof(m_dev));
+    for (int i = 0; i < 4; i++) {
+        TICOS_CHECK_INT(ticos_client_init(&m_client[i], i == 3 ? &m_other_model : &m_model, "P", ids[i], "S"), 0);
+        ticos_client_set_event_cb(&m_client[i], on_event, &m_dev[i]);
+        m_dev[i].value = 10 * (i + 1);
+    }
+}
+
+// 身份信息或 topic 超出缓冲区时初始化失败
+static void test_init(void)
+{
+    char id[TICOS_DEVICE_ID_MAX + 1];
+    ticos_client_t client;
+
+    memset(id, 'x', sizeof(id) - 1);
+    id[sizeof(id) - 1] = '\0';
+    TICOS_CHECK_INT(ticos_client_init(&client, &m_model, "P", id, "S"), -1);
+    TICOS_CHECK_INT(ticos_client_init(&client, &m_model, "P", "A", "S"), 0);
+    TICOS_CHECK_STR(client.property_report_topic, "devices/A/twin/reported");
+    TICOS_CHECK_STR(client.command_response_topic, "devices/A/commands/response");
+    TICOS_CHECK_STR(client.client_id, "A@@@P");
+    // 不指定物模型时使用全局的方法表
+    TICOS_CHECK_INT(ticos_client_init(&client, NULL, "P", "A", "S"), 0);
+    TICOS_CHECK(client.model == ticos_client_default()->model);
+}
+
+static void test_devices(void)
+{
+    init_devices();
+    ticos_test_reset();
+
+    // 第一个设备启动连接, 连接成功前不订阅
+    TICOS_CHECK(!ticos_test_started());
+    TICOS_CHECK_INT(ticos_client_start(&m_client[0]), 0);
+    TICOS_CHECK(ticos_test_started());
+    TICOS_CHECK_INT(ticos_client_start(&m_client[1]), 0);
+    TICOS_CHECK_INT(ticos_client_start(&m_client[1]), 0);
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 0);
+
+    // 连接成功后为每个设备订阅, 并通知每个设备
+    connected();
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 4);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/A/twin/desired"), 1);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/A/commands/request"), 1);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/B/twin/desired"), 1);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/B/commands/request"), 1);
+    TICOS_CHECK_INT(m_dev[0].connects, 1);
+    TICOS_CHECK_INT(m_dev[1].connects, 1);
+    TICOS_CHECK_INT(m_dev[2].connects, 0);
+
+    // 已连接时启动的设备立即订阅
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_client_start(&m_client[2]), 0);
+    TICOS_CHECK_INT(ticos_client_start(&m_client[3]), 0);
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 4);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/C/commands/request"), 1);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/D/twin/desired"), 1);
+
+    // 上报使用各自的 topic 和物模型, getter 中可区分设备
+    ticos_test_reset();
+    for (int i = 0; i < 4; i++)
+        TICOS_CHECK(ticos_client_property_report(&m_client[i]) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 4);
+    TICOS_CHECK_STR(ticos_test_msg(3)->topic, "devices/A/twin/reported");
+    TICOS_CHECK_STR(ticos_test_msg(3)->data, "{\"v\":10}");
+    TICOS_CHECK_STR(ticos_test_msg(2)->topic, "devices/B/twin/reported");
+    TICOS_CHECK_STR(ticos_test_msg(2)->data, "{\"v\":20}");
+    TICOS_CHECK_STR(ticos_test_msg(1)->data, "{\"v\":30}");
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/twin/reported");
+    TICOS_CHECK_STR(ticos_test_msg(0)->data, "{\"other\":2.5}");
+    TICOS_CHECK(ticos_client_telemetry_report(&m_client[1]) >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":20}");
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/B/telemetry");
+    // 上报之外取到的是默认设备
+    TICOS_CHECK(ticos_client_current() == ticos_client_default());
+
+    // 下发消息只分发给 topic 对应的设备
+    recv("devices/B/twin/desired", "{\"v\":5}");
+    TICOS_CHECK_INT(m_dev[1].recv_calls, 1);
+    TICOS_CHECK_INT(m_dev[1].recv, 5);
+    TICOS_CHECK_INT(m_dev[0].recv_calls + m_dev[2].recv_calls, 0);
+    recv("devices/C/twin/desired", "{\"v\":6}");
+    TICOS_CHECK_INT(m_dev[2].recv, 6);
+    TICOS_CHECK_INT(m_dev[1].recv_calls, 1);
+
+    // 前缀相同或不存在的设备的 topic 不会误分发
+    recv("devices/A/twin/desired/x", "{\"v\":7}");
+    recv("devices/AB/twin/desired", "{\"v\":7}");
+    recv("devices/E/twin/desired", "{\"v\":7}");
+    TICOS_CHECK_INT(m_dev[0].recv_calls, 0);
+
+    // 命令的回复发布到执行命令的设备的 topic
+    ticos_test_reset();
+    recv("devices/C/commands/request", "{\"$id\":\"9\",\"cmd\":3}");
+    TICOS_CHECK(wait_count(1));
+    TICOS_CHECK_INT(m_dev[2].cmd, 3);
+    TICOS_CHECK_INT(m_dev[0].cmd_calls + m_dev[1].cmd_calls, 0);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/C/commands/response");
+    TICOS_CHECK(strstr(ticos_test_last(), "\"$id\":\"9\"") != NULL);
+
+    // 停止的设备不再收到下发消息, 其他设备不受影响
+    ticos_client_stop(&m_client[1]);
+    recv("devices/B/twin/desired", "{\"v\":8}");
+    TICOS_CHECK_INT(m_dev[1].recv_calls, 1);
+    recv("devices/A/twin/desired", "{\"v\":8}");
+    TICOS_CHECK_INT(m_dev[0].recv, 8);
+    TICOS_CHECK(ticos_test_started());
+
+    // 重新连接时只订阅和通知仍在运行的设备
+    ticos_test_reset();
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    connected();
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 6);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/B/twin/desired"), 0);
+    TICOS_CHECK_INT(m_dev[0].disconnects, 1);
+    TICOS_CHECK_INT(m_dev[1].disconnects, 0);
+    TICOS_CHECK_INT(m_dev[2].connects, 1);
+
+    // 最后一个设备停止时断开连接
+    ticos_client_stop(&m_client[0]);
+    ticos_client_stop(&m_client[2]);
+    TICOS_CHECK(ticos_test_started());
+    ticos_client_stop(&m_client[3]);
+    TICOS_CHECK(!ticos_test_started());
+    ticos_client_stop(&m_client[3]);
+}
+
+// 通配符订阅: 连接后只订阅两个 topic, 之后启动的设备无需订阅, 消息仍按设备分发
+static void test_wildcard(void)
+{
+    init_devices();
+    ticos_test_reset();
+    ticos_client_set_wildcard(1);
+    TICOS_CHECK_INT(ticos_client_start(&m_client[0]), 0);
+    TICOS_CHECK_INT(ticos_client_start(&m_client[1]), 0);
+    connected();
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 2);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/+/twin/desired"), 1);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/+/commands/request"), 1);
+
+    TICOS_CHECK_INT(ticos_client_start(&m_client[2]), 0);
+    TICOS_CHECK_INT(ticos_test_subscribe_count(), 2);
+    recv("devices/C/twin/desired", "{\"v\":4}");
+    recv("devices/A/twin/desired", "{\"v\":3}");
+    TICOS_CHECK_INT(m_dev[2].recv, 4);
+    TICOS_CHECK_INT(m_dev[0].recv, 3);
+    TICOS_CHECK_INT(m_dev[1].recv_calls, 0);
+
+    ticos_cloud_stop();
+    TICOS_CHECK(!ticos_test_started());
+    recv("devices/A/twin/desired", "{\"v\":1}");
+    TICOS_CHECK_INT(m_dev[0].recv_calls, 1);
+    ticos_client_set_wildcard(0);
+}
+
+// 默认设备与上下文设备共用连接
+static void test_default(void)
+{
+    init_devices();
+    ticos_test_connect();
+    TICOS_CHECK_INT(ticos_client_start(&m_client[0]), 0);
+    TICOS_CHECK_INT(ticos_test_subscribed("devices/A/twin/desired"), 1);
+    TICOS_CHECK(ticos_client_property_report(&m_client[0]) >= 0);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/A/twin/reported");
+    recv("devices/A/twin/desired", "{\"v\":2}");
+    TICOS_CHECK_INT(m_dev[0].recv, 2);
+
+    // 默认设备停止后连接仍由其他设备使用
+    ticos_client_stop(ticos_client_default());
+    TICOS_CHECK(ticos_test_started());
+    ticos_client_stop(&m_client[0]);
+    TICOS_CHECK(!ticos_test_started());
+}
+
+int main(void)
+{
+    test_init();
+    test_devices();
+    test_wildcard();
+    test_default();
+    return ticos_test_result();
+}
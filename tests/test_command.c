@@ -0,0 +1,304 @@
+/*
+ * 命令执行: 请求 id 与回复对应, 线程池中执行的慢命令不阻塞接收线程, 并发数、超时和队列满时按结果码回复
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_command.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static pthread_t m_main;
+static atomic_int m_gate;           // slow 命令等待放行
+static atomic_int m_slow_running;
+static atomic_int m_slow_calls;
+static atomic_int m_on_worker;      // 在接收线程之外执行的次数
+static atomic_int m_set_calls;
+static int m_set;
+static char m_name[64];
+static int m_light;
+
+static int cmd_set(int v)
+{
+    m_set = v;
+    atomic_fetch_add(&m_set_calls, 1);
+    if (!pthread_equal(pthread_self(), m_main))
+        atomic_fetch_add(&m_on_worker, 1);
+    return v * 2;
+}
+
+static int cmd_slow(int v)
+{
+    atomic_fetch_add(&m_slow_running, 1);
+    while (!atomic_load(&m_gate))
+        usleep(1000);
+    atomic_fetch_add(&m_slow_calls, 1);
+    atomic_fetch_sub(&m_slow_running, 1);
+    return 0;
+}
+
+static int cmd_sleep(int ms)
+{
+    usleep(ms * 1000);
+    return 0;
+}
+
+static int cmd_name(const char *name)
+{
+    snprintf(m_name, sizeof(m_name), "%s", name);
+    return 0;
+}
+
+static int light_recv(int v) { m_light = v; return 0; }
+static int light_send(void) { return m_light; }
+
+enum { CMD_SET, CMD_SLOW, CMD_SLEEP, CMD_NAME };
+
+const ticos_command_info_t ticos_command_tab[] = {
+    { "set", TICOS_VAL_TYPE_INTEGER, cmd_set },
+    { "slow", TICOS_VAL_TYPE_INTEGER, cmd_slow },
+    { "sleep", TICOS_VAL_TYPE_INTEGER, cmd_sleep },
+    { "name", TICOS_VAL_TYPE_STRING, cmd_name },
+};
+const int ticos_command_cnt = sizeof(ticos_command_tab) / sizeof(ticos_command_tab[0]);
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static void command(const char *data)
+{
+    ticos_msg_recv("devices/D/commands/request", data, strlen(data));
+}
+
+// 查找请求 id 对应的回复, 返回回复的个数, code 为最后一个回复的结果码
+static int response(const char *rid, int *code)
+{
+    char key[80];
+    int n = 0;
+
+    snprintf(key, sizeof(key), "{\"$id\":\"%s\",", rid);
+    for (int back = ticos_test_count() - 1; back >= 0; back--) {
+        const ticos_test_msg_t *msg = ticos_test_msg(back);
+        if (!msg || strcmp(msg->topic, "devices/D/commands/response") || strncmp(msg->data, key, strlen(key)))
+            continue;
+        const char *p = strstr(msg->data, "\"code\":");
+        if (p && code)
+            *code = atoi(p + 7);
+        n++;
+    }
+    return n;
+}
+
+static int wait_response(const char *rid, int *code)
+{
+    for (int i = 0; i < 2000 && !response(rid, code); i++)
+        usleep(1000);
+    return response(rid, code);
+}
+
+static int wait_value(atomic_int *v, int expect)
+{
+    for (int i = 0; i < 2000 && atomic_load(v) != expect; i++)
+        usleep(1000);
+    return atomic_load(v) == expect;
+}
+
+// 未启动线程池时在接收线程中直接执行, 回复处理函数的返回值
+static void test_inline(void)
+{
+    int code = 0;
+
+    ticos_test_connect();
+    command("{\"$id\":\"1\",\"set\":5}");
+    TICOS_CHECK_INT(m_set, 5);
+    TICOS_CHECK_INT(atomic_load(&m_on_worker), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/commands/response");
+    TICOS_CHECK_STR(ticos_test_last(), "{\"$id\":\"1\",\"command\":\"set\",\"code\":10}");
+    TICOS_CHECK_INT(ticos_test_msg(0)->qos, 1);
+
+    // 请求 id 可以位于命令之后, 也可以是数字
+    command("{\"set\":-3,\"$id\":\"after\"}");
+    TICOS_CHECK_INT(response("after", &code), 1);
+    TICOS_CHECK_INT(code, -6);
+    command("{\"$id\":42,\"set\":1}");
+    TICOS_CHECK_INT(response("42", &code), 1);
+    TICOS_CHECK_INT(code, 2);
+
+    // 一条请求中的多个命令各回复一次
+    ticos_test_reset();
+    command("{\"$id\":\"multi\",\"set\":7,\"name\":\"abc\",\"unknown\":1}");
+    TICOS_CHECK_INT(response("multi", NULL), 2);
+    TICOS_CHECK_STR(m_name, "abc");
+    TICOS_CHECK(strstr(ticos_test_last(), "\"command\":\"name\",\"code\":0") != NULL);
+
+    // 没有请求 id 或请求 id 过长时执行但不回复
+    ticos_test_reset();
+    atomic_store(&m_set_calls, 0);
+    command("{\"set\":9}");
+    char doc[TICOS_COMMAND_ID_MAX + 32];
+    char rid[TICOS_COMMAND_ID_MAX + 1];
+    memset(rid, 'r', sizeof(rid) - 1);
+    rid[sizeof(rid) - 1] = '\0';
+    snprintf(doc, sizeof(doc), "{\"$id\":\"%s\",\"set\":9}", rid);
+    command(doc);
+    TICOS_CHECK_INT(atomic_load(&m_set_calls), 2);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+
+    // 格式错误的请求不执行也不回复
+    command("{\"$id\":\"bad\",\"set\":1");
+    command("{\"$id\":\"bad\",\"set\":\"x\"}");
+    TICOS_CHECK_INT(atomic_load(&m_set_calls), 2);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+}
+
+static void test_pool(void)
+{
+    int code = 0;
+
+    TICOS_CHECK_INT(ticos_command_pool_start(0), -1);
+    TICOS_CHECK_INT(ticos_command_pool_start(TICOS_COMMAND_WORKERS_MAX + 1), -1);
+    TICOS_CHECK_INT(ticos_command_pool_start(2), 0);
+    TICOS_CHECK_INT(ticos_command_pool_start(2), 0);
+
+    // 命令在工作线程中执行, 字符串参数在入队时复制
+    ticos_test_reset();
+    command("{\"$id\":\"w\",\"set\":4}");
+    TICOS_CHECK(wait_response("w", &code));
+    TICOS_CHECK_INT(code, 8);
+    TICOS_CHECK_INT(atomic_load(&m_on_worker), 1);
+    command("{\"$id\":\"n\",\"name\":\"queued string\"}");
+    TICOS_CHECK(wait_response("n", &code));
+    TICOS_CHECK_STR(m_name, "queued string");
+
+    // 慢命令执行期间接收线程继续处理下发消息
+    ticos_test_reset();
+    atomic_store(&m_gate, 0);
+    command("{\"$id\":\"s1\",\"slow\":1}");
+    TICOS_CHECK(wait_value(&m_slow_running, 1));
+    ticos_msg_recv("devices/D/twin/desired", "{\"light\":3}", 11);
+    TICOS_CHECK_INT(m_light, 3);
+    command("{\"$id\":\"w2\",\"set\":1}");
+    TICOS_CHECK(wait_response("w2", &code));
+    TICOS_CHECK_INT(response("s1", NULL), 0);
+    atomic_store(&m_gate, 1);
+    TICOS_CHECK(wait_response("s1", &code));
+    TICOS_CHECK_INT(code, 0);
+}
+
+// 超出并发数的命令不执行, 直接回复 TICOS_COMMAND_BUSY
+static void test_limit(void)
+{
+    int code = 0;
+
+    TICOS_CHECK_INT(ticos_command_set_limit(ticos_command_cnt, 1, 0), -1);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SLOW, -1, 0), -1);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SLOW, 1, 0), 0);
+    ticos_test_reset();
+    atomic_store(&m_gate, 0);
+    atomic_store(&m_slow_calls, 0);
+    command("{\"$id\":\"c1\",\"slow\":1}");
+    command("{\"$id\":\"c2\",\"slow\":1}");
+    command("{\"$id\":\"c3\",\"slow\":1}");
+    TICOS_CHECK_INT(response("c2", &code), 1);
+    TICOS_CHECK_INT(code, TICOS_COMMAND_BUSY);
+    TICOS_CHECK_INT(response("c3", &code), 1);
+    TICOS_CHECK_INT(code, TICOS_COMMAND_BUSY);
+    atomic_store(&m_gate, 1);
+    TICOS_CHECK(wait_response("c1", &code));
+    TICOS_CHECK_INT(code, 0);
+    TICOS_CHECK_INT(atomic_load(&m_slow_calls), 1);
+
+    // 执行完成后名额释放
+    command("{\"$id\":\"c4\",\"slow\":1}");
+    TICOS_CHECK(wait_response("c4", &code));
+    TICOS_CHECK_INT(code, 0);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SLOW, 0, 0), 0);
+}
+
+// 超过时限仍未开始执行的命令不执行, 执行完成时已超时的命令也按超时回复
+static void test_timeout(void)
+{
+    int code = 0;
+
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SET, 0, 50), 0);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SLEEP, 0, 50), 0);
+    ticos_test_reset();
+    atomic_store(&m_gate, 0);
+    atomic_store(&m_set_calls, 0);
+    command("{\"$id\":\"b1\",\"slow\":1}");
+    command("{\"$id\":\"b2\",\"slow\":1}");
+    TICOS_CHECK(wait_value(&m_slow_running, 2));
+    command("{\"$id\":\"late\",\"set\":1}");
+    usleep(100 * 1000);
+    atomic_store(&m_gate, 1);
+    TICOS_CHECK(wait_response("late", &code));
+    TICOS_CHECK_INT(code, TICOS_COMMAND_TIMEOUT);
+    TICOS_CHECK_INT(atomic_load(&m_set_calls), 0);
+
+    command("{\"$id\":\"long\",\"sleep\":100}");
+    TICOS_CHECK(wait_response("long", &code));
+    TICOS_CHECK_INT(code, TICOS_COMMAND_TIMEOUT);
+    command("{\"$id\":\"short\",\"sleep\":1}");
+    TICOS_CHECK(wait_response("short", &code));
+    TICOS_CHECK_INT(code, 0);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SET, 0, 0), 0);
+    TICOS_CHECK_INT(ticos_command_set_limit(CMD_SLEEP, 0, 0), 0);
+}
+
+// 任务队列满时回复 TICOS_COMMAND_BUSY, 停止线程池时执行完已入队的命令
+static void test_queue_full(void)
+{
+    char doc[64];
+    char rid[16];
+    int code = 0;
+    int busy = 0;
+
+    ticos_test_reset();
+    atomic_store(&m_gate, 0);
+    atomic_store(&m_set_calls, 0);
+    command("{\"$id\":\"q1\",\"slow\":1}");
+    command("{\"$id\":\"q2\",\"slow\":1}");
+    TICOS_CHECK(wait_value(&m_slow_running, 2));
+    for (int i = 0; i < TICOS_COMMAND_QUEUE_SIZE + 4; i++) {
+        snprintf(doc, sizeof(doc), "{\"$id\":\"f%d\",\"set\":%d}", i, i);
+        command(doc);
+    }
+    TICOS_CHECK_INT(ticos_command_pending(), TICOS_COMMAND_QUEUE_SIZE);
+    for (int i = 0; i < TICOS_COMMAND_QUEUE_SIZE + 4; i++) {
+        snprintf(rid, sizeof(rid), "f%d", i);
+        if (response(rid, &code))
+            busy += code == TICOS_COMMAND_BUSY;
+    }
+    TICOS_CHECK_INT(busy, 4);
+
+    atomic_store(&m_gate, 1);
+    ticos_command_pool_stop();
+    TICOS_CHECK_INT(ticos_command_pending(), 0);
+    TICOS_CHECK_INT(atomic_load(&m_set_calls), TICOS_COMMAND_QUEUE_SIZE);
+    TICOS_CHECK_INT(response("f0", &code), 1);
+    TICOS_CHECK_INT(code, 0);
+
+    // 停止后恢复在接收线程中执行
+    atomic_store(&m_on_worker, 0);
+    command("{\"$id\":\"i\",\"set\":1}");
+    TICOS_CHECK_INT(response("i", &code), 1);
+    TICOS_CHECK_INT(atomic_load(&m_on_worker), 0);
+}
+
+int main(void)
+{
+    m_main = pthread_self();
+    test_inline();
+    test_pool();
+    test_limit();
+    test_timeout();
+    test_queue_full();
+    return ticos_test_result();
+}
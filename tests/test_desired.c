@@ -0,0 +1,178 @@
+/*
+ * 期望属性同步: $version 不大于已处理版本的文档整条丢弃, 与设备当前值相同的属性不调用 recv 函数
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_cbor.h"
+#include "ticos_client.h"
+#include "ticos_thingmodel_type.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int m_light;
+static float m_temp;
+static char m_mode[16];
+static int m_light_calls;
+static int m_temp_calls;
+static int m_mode_calls;
+static int m_light_ret;
+
+static int light_send(void) { return m_light; }
+static int light_recv(int v) { m_light_calls++; if (!m_light_ret) m_light = v; return m_light_ret; }
+static float temp_send(void) { return m_temp; }
+static int temp_recv(float v) { m_temp_calls++; m_temp = v; return 0; }
+static char *mode_send(void) { return m_mode; }
+static int mode_recv(char *v) { m_mode_calls++; snprintf(m_mode, sizeof(m_mode), "%s", v); return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+    { "temp", TICOS_VAL_TYPE_FLOAT, temp_send, temp_recv },
+    { "mode", TICOS_VAL_TYPE_STRING, mode_send, mode_recv },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static void desired(const char *data)
+{
+    ticos_msg_recv("devices/D/twin/desired", data, strlen(data));
+}
+
+static int calls(void)
+{
+    return m_light_calls + m_temp_calls + m_mode_calls;
+}
+
+static void test_version(void)
+{
+    ticos_test_connect();
+    desired("{\"$version\":3,\"light\":1,\"temp\":20.5,\"mode\":\"auto\"}");
+    TICOS_CHECK_INT(calls(), 3);
+    TICOS_CHECK_INT(m_light, 1);
+    TICOS_CHECK(m_temp == 20.5f);
+    TICOS_CHECK_STR(m_mode, "auto");
+
+    // 重复和过期的文档整条丢弃, 即使其中的值已改变
+    desired("{\"$version\":3,\"light\":2}");
+    desired("{\"$version\":2,\"light\":2}");
+    desired("{\"light\":2,\"$version\":1}");
+    TICOS_CHECK_INT(calls(), 3);
+    TICOS_CHECK_INT(m_light, 1);
+
+    // 新版本中只有改变的属性调用 recv 函数; $version 位于其他字段之后也先按版本过滤
+    desired("{\"light\":2,\"temp\":20.5,\"mode\":\"auto\",\"$version\":4}");
+    TICOS_CHECK_INT(m_light_calls, 2);
+    TICOS_CHECK_INT(calls(), 4);
+    TICOS_CHECK_INT(m_light, 2);
+    desired("{\"$version\":5,\"mode\":\"eco\"}");
+    TICOS_CHECK_INT(m_mode_calls, 2);
+    TICOS_CHECK_STR(m_mode, "eco");
+
+    // 没有 $version 或其值不是整数的文档总是处理, 但相同的值仍然跳过
+    desired("{\"light\":2,\"temp\":21}");
+    TICOS_CHECK_INT(calls(), 6);
+    TICOS_CHECK(m_temp == 21.0f);
+    desired("{\"$version\":\"x\",\"light\":3}");
+    TICOS_CHECK_INT(m_light, 3);
+    TICOS_CHECK_INT(calls(), 7);
+
+    // 格式错误的文档不影响已处理的版本
+    desired("{\"$version\":9,\"light\":");
+    desired("{\"$version\":6,\"light\":4}");
+    TICOS_CHECK_INT(m_light, 4);
+    TICOS_CHECK_INT(calls(), 8);
+}
+
+static void test_cache(void)
+{
+    // recv 函数拒绝的值不记为设备的当前值, 再次下发时重新调用
+    m_light_ret = -1;
+    desired("{\"light\":5}");
+    TICOS_CHECK_INT(m_light_calls, 5);
+    TICOS_CHECK_INT(m_light, 4);
+    m_light_ret = 0;
+    desired("{\"light\":5}");
+    TICOS_CHECK_INT(m_light_calls, 6);
+    TICOS_CHECK_INT(m_light, 5);
+    desired("{\"light\":5}");
+    TICOS_CHECK_INT(m_light_calls, 6);
+
+    // 设备在本地改变并上报的值成为当前值, 云端下发旧值时重新应用
+    m_light = 7;
+    TICOS_CHECK(ticos_property_report_by_index(0) >= 0);
+    desired("{\"light\":5}");
+    TICOS_CHECK_INT(m_light_calls, 7);
+    TICOS_CHECK_INT(m_light, 5);
+
+    // 重新连接后忘记版本号, 云端重发的同一版本会被处理, 其中未改变的属性仍然跳过
+    int n = calls();
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    desired("{\"$version\":6,\"light\":5,\"mode\":\"off\"}");
+    TICOS_CHECK_INT(calls(), n + 1);
+    TICOS_CHECK_STR(m_mode, "off");
+    desired("{\"$version\":6,\"mode\":\"on\"}");
+    TICOS_CHECK_STR(m_mode, "off");
+}
+
+// CBOR 格式的期望属性同样按版本过滤
+static void test_cbor(void)
+{
+    char buf[64];
+    ticos_cbor_writer_t w;
+
+    for (int i = 0; i < 3; i++) {
+        static const int versions[] = { 7, 7, 8 };
+        ticos_cbor_writer_init(&w, buf, sizeof(buf));
+        ticos_cbor_self_describe(&w);
+        ticos_cbor_map_begin(&w);
+        ticos_cbor_string(&w, "$version");
+        ticos_cbor_int(&w, versions[i]);
+        ticos_cbor_int(&w, 0);
+        ticos_cbor_int(&w, 10 + i);
+        ticos_cbor_map_end(&w);
+        int n = ticos_cbor_writer_finish(&w);
+        TICOS_CHECK(n > 0);
+        ticos_msg_recv("devices/D/twin/desired", buf, n);
+    }
+    TICOS_CHECK_INT(m_light, 12);
+}
+
+// 下发数据不以 '\0' 结尾时只解析 len 个字节, 之后的保护字节和数据不影响结果
+static void test_length(void)
+{
+    static const char topic[] = "devices/D/twin/desired";
+    const char *doc = "{\"light\":21}";
+    int len = strlen(doc);
+    char buf[64];
+
+    memcpy(buf, doc, len);
+    buf[len] = 'x';
+    ticos_msg_recv(topic, buf, len);
+    TICOS_CHECK_INT(m_light, 21);
+
+    // 与数据等长的堆内存, 越界读取可由 ASan 发现
+    char *heap = malloc(len);
+    memcpy(heap, "{\"light\":22}", len);
+    ticos_msg_recv_fragment(topic, strlen(topic), heap, len, 0, len);
+    free(heap);
+    TICOS_CHECK_INT(m_light, 22);
+
+    // len 之后紧跟另一个文档时只处理前一个; 截断的文档格式错误, 整条丢弃
+    snprintf(buf, sizeof(buf), "{\"light\":23}{\"light\":24}");
+    ticos_msg_recv(topic, buf, len);
+    TICOS_CHECK_INT(m_light, 23);
+    snprintf(buf, sizeof(buf), "{\"light\":25}");
+    ticos_msg_recv(topic, buf, len - 2);
+    TICOS_CHECK_INT(m_light, 23);
+    snprintf(buf, sizeof(buf), "{\"mode\":\"abc\"}");
+    ticos_msg_recv(topic, buf, strlen(buf) - 3);
+    TICOS_CHECK_STR(m_mode, "off");
+}
+
+int main(void)
+{
+    test_version();
+    test_cache();
+    test_cbor();
+    test_length();
+    return ticos_test_result();
+}
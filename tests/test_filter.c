@@ -0,0 +1,198 @@
+/*
+ * 上报过滤: 变化不超出死区或未到最小间隔的字段不上报, 到达最大间隔时即使未变化也上报; 单个字段和全量属性上报不过滤
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include <stdio.h>
+#include <unistd.h>
+
+static const ticos_report_filter_t m_abs = { 0.5f, 0, 0, 0 };
+static const ticos_report_filter_t m_pct = { 0, 10, 0, 0 };
+static const ticos_report_filter_t m_both = { 1, 10, 0, 0 };
+static const ticos_report_filter_t m_interval = { 0, 0, 100, 300 };
+
+static float m_t = 20;
+static int m_p = 100;
+static int m_b = 5;
+static int m_n = 1;
+static int m_a = 1;
+static char m_s[16] = "on";
+
+static float get_t(void) { return m_t; }
+static int get_p(void) { return m_p; }
+static int get_b(void) { return m_b; }
+static int get_n(void) { return m_n; }
+static int get_a(void) { return m_a; }
+static char *get_s(void) { return m_s; }
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "t", TICOS_VAL_TYPE_FLOAT, get_t, &m_abs },
+    { "p", TICOS_VAL_TYPE_INTEGER, get_p, &m_pct },
+    { "b", TICOS_VAL_TYPE_INTEGER, get_b, &m_both },
+    { "n", TICOS_VAL_TYPE_INTEGER, get_n },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "a", TICOS_VAL_TYPE_INTEGER, get_a, NULL, &m_interval },
+    { "s", TICOS_VAL_TYPE_STRING, get_s, NULL, &m_abs },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+// 超出 TICOS_FILTER_FIELDS 的字段不做过滤
+#define MANY_CNT (TICOS_FILTER_FIELDS + 1)
+static ticos_telemetry_info_t m_many[MANY_CNT];
+static char m_many_id[MANY_CNT][8];
+
+static void test_deadband(void)
+{
+    ticos_test_connect();
+
+    // 第一次上报所有字段
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":20,\"p\":100,\"b\":5,\"n\":1}");
+
+    // 绝对死区: 与上次上报值之差超出 0.5 才上报, 未声明过滤条件的字段总是上报
+    m_t = 20.4f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+    m_t = 20.6f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":20.6,\"n\":1}");
+    // 缓慢漂移以上次上报值为准累计
+    m_t = 20.9f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+    m_t = 21.2f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":21.2,\"n\":1}");
+    m_t = 20.6f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":20.6,\"n\":1}");
+
+    // 相对死区按上次上报值的绝对值计算, 恰好等于死区时不上报
+    m_p = 110;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+    m_p = 89;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"p\":89,\"n\":1}");
+    m_p = 0;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    m_p = 1;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"p\":1,\"n\":1}");
+
+    // 同时声明时取较大的死区: 5 的 10% 小于 1, 按 1 计算
+    m_b = 6;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+    m_b = 7;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"b\":7,\"n\":1}");
+
+    // 单个字段上报不过滤, 但更新过滤状态
+    m_t = 20.7f;
+    TICOS_CHECK(ticos_telemetry_report_by_index(0) >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":20.7}");
+    m_t = 21.1f;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+}
+
+// 发布失败的消息进入离线队列, 值算作已上报; 重新连接后过滤状态失效, 下次上报所有字段
+static void test_reconnect(void)
+{
+    ticos_test_publish_fail(1);
+    m_t = 30;
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 1);
+    ticos_test_publish_fail(0);
+
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":30,\"n\":1}");
+    ticos_test_reset();
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":30,\"p\":1,\"b\":7,\"n\":1}");
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+}
+
+// 变化上报时按过滤条件代替上报缓存; 最小间隔内的变化推迟, 最大间隔到达时未变化也上报
+static void test_interval(void)
+{
+    ticos_test_reset();
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"a\":1,\"s\":\"on\"}");
+
+    // 所有字段都被过滤时不发布消息
+    m_a = 2;
+    TICOS_CHECK_INT(ticos_property_report_changed(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    usleep(120 * 1000);
+    TICOS_CHECK(ticos_property_report_changed() > 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"a\":2}");
+
+    // 字符串字段只比较是否改变
+    strcpy(m_s, "off");
+    TICOS_CHECK(ticos_property_report_changed() > 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"s\":\"off\"}");
+    TICOS_CHECK_INT(ticos_property_report_changed(), 0);
+
+    // 未变化的字段到达最大间隔时作为心跳上报
+    int count = ticos_test_count();
+    usleep(320 * 1000);
+    TICOS_CHECK(ticos_property_report_changed() > 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"a\":2}");
+    TICOS_CHECK_INT(ticos_test_count(), count + 1);
+    TICOS_CHECK_INT(ticos_property_report_changed(), 0);
+
+    // 全量上报不过滤
+    TICOS_CHECK(ticos_property_report() > 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"a\":2,\"s\":\"off\"}");
+}
+
+static int get_one(void)
+{
+    return 1;
+}
+
+static void test_field_limit(void)
+{
+    static const ticos_thingmodel_t model = { m_many, MANY_CNT, NULL, 0, NULL, 0 };
+    ticos_client_t client;
+
+    for (int i = 0; i < MANY_CNT; i++) {
+        snprintf(m_many_id[i], sizeof(m_many_id[i]), "f%d", i);
+        m_many[i].id = m_many_id[i];
+        m_many[i].type = TICOS_VAL_TYPE_INTEGER;
+        m_many[i].func = get_one;
+        m_many[i].filter = &m_abs;
+    }
+    TICOS_CHECK_INT(ticos_client_init(&client, &model, "P", "E", "S"), 0);
+    TICOS_CHECK_INT(ticos_client_start(&client), 0);
+    ticos_test_reset();
+    TICOS_CHECK(ticos_client_telemetry_report(&client) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK(ticos_client_telemetry_report(&client) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    char expect[32];
+    snprintf(expect, sizeof(expect), "{\"f%d\":1}", MANY_CNT - 1);
+    TICOS_CHECK_STR(ticos_test_last(), expect);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/E/telemetry");
+    ticos_client_stop(&client);
+}
+
+int main(void)
+{
+    test_deadband();
+    test_reconnect();
+    test_interval();
+    test_field_limit();
+    return ticos_test_result();
+}
@@ -0,0 +1,316 @@
+/*
+ * 分片接收: 期望属性和命令在任意位置分片送入时, recv 函数、命令回复和统计与整条收到时相同; 分片缺失、重复或
+ * 错位以及格式错误、暂存区不足的消息整条丢弃, 不调用任何 recv 函数; CBOR 消息拼接后处理
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_cbor.h"
+#include "ticos_client.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include <stdio.h>
+
+#define DESIRED     "devices/D/twin/desired"
+#define COMMAND     "devices/D/commands/request"
+#define LOG_MAX     2048
+
+// recv 函数和命令依次记录为 "名称=值", 以空格分隔
+static char m_log[LOG_MAX];
+static int m_len;
+
+static void record(const char *name, const char *fmt, double v, const char *s)
+{
+    if (m_len > LOG_MAX - 128)
+        return;
+    m_len += snprintf(m_log + m_len, LOG_MAX - m_len, "%s%s=", m_len ? " " : "", name);
+    if (s)
+        m_len += snprintf(m_log + m_len, LOG_MAX - m_len, "%.64s", s);
+    else
+        m_len += snprintf(m_log + m_len, LOG_MAX - m_len, fmt, v);
+}
+
+static int light_send(void) { return 0; }
+static int light_recv(int v) { record("light", "%.0f", v, NULL); return 0; }
+static float temp_send(void) { return 0; }
+static int temp_recv(float v) { record("temp", "%g", v, NULL); return 0; }
+static char *mode_send(void) { return ""; }
+static int mode_recv(char *v) { record("mode", NULL, 0, v); return 0; }
+static int on_send(void) { return 0; }
+static int on_recv(int v) { record("on", "%.0f", v, NULL); return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+    { "temp", TICOS_VAL_TYPE_FLOAT, temp_send, temp_recv },
+    { "mode", TICOS_VAL_TYPE_STRING, mode_send, mode_recv },
+    { "on", TICOS_VAL_TYPE_BOOLEAN, on_send, on_recv },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static int cmd_set(int v) { record("set", "%.0f", v, NULL); return v + 1; }
+static int cmd_name(char *v) { record("name", NULL, 0, v); return 0; }
+
+const ticos_command_info_t ticos_command_tab[] = {
+    { "set", TICOS_VAL_TYPE_INTEGER, cmd_set },
+    { "name", TICOS_VAL_TYPE_STRING, cmd_name },
+};
+const int ticos_command_cnt = sizeof(ticos_command_tab) / sizeof(ticos_command_tab[0]);
+
+static ticos_metrics_t m;
+
+// 清空记录、统计和期望属性缓存, 每条消息中的属性都调用 recv 函数
+static void clear(void)
+{
+    ticos_client_t *client = ticos_client_default();
+
+    memset(client->desired_cached, 0, sizeof(client->desired_cached));
+    m_len = 0;
+    m_log[0] = '\0';
+    ticos_test_reset();
+    ticos_get_metrics(&m, 1);
+}
+
+/*
+ * 记录的结果: recv 函数的调用、发布的回复、消息的条数、错误数和被忽略的字段数
+ */
+static const char *result(int topic)
+{
+    static char buf[LOG_MAX * 2];
+    int len = snprintf(buf, sizeof(buf), "%s |", m_log);
+
+    for (int back = ticos_test_count() - 1; back >= 0; back--) {
+        const ticos_test_msg_t *msg = ticos_test_msg(back);
+        if (msg)
+            len += snprintf(buf + len, sizeof(buf) - len, " %s", msg->data);
+    }
+    ticos_get_metrics(&m, 0);
+    snprintf(buf + len, sizeof(buf) - len, " | %u/%u/%u/%u", m.traffic[topic].msgs, m.traffic[topic].errors,
+             m.traffic[topic].bytes, m.rejected_keys);
+    return buf;
+}
+
+// 整条收到
+static const char *whole(const char *topic, const char *dat, int len)
+{
+    clear();
+    ticos_msg_recv(topic, dat, len);
+    return result(strcmp(topic, COMMAND) ? TICOS_METRIC_DESIRED : TICOS_METRIC_COMMAND);
+}
+
+// 在 cuts 中的位置分片送入, 之后的分片不带 topic
+static void send_parts(const char *topic, const char *dat, int len, const int *cuts, int ncut)
+{
+    int from = 0;
+
+    for (int i = 0; i <= ncut; i++) {
+        int to = i < ncut ? cuts[i] : len;
+        ticos_msg_recv_fragment(from ? NULL : topic, from ? 0 : strlen(topic), dat + from, to - from, from, len);
+        from = to;
+    }
+}
+
+static const char *parts(const char *topic, const char *dat, int len, const int *cuts, int ncut)
+{
+    clear();
+    send_parts(topic, dat, len, cuts, ncut);
+    return result(strcmp(topic, COMMAND) ? TICOS_METRIC_DESIRED : TICOS_METRIC_COMMAND);
+}
+
+/*
+ * 在每个位置分成两片、在每两个位置分成三片以及逐字节送入时, 结果都与整条收到时相同
+ */
+static int same_as_whole(const char *topic, const char *dat)
+{
+    static char expect[LOG_MAX * 2];
+    static int cuts[LOG_MAX];
+    int len = strlen(dat);
+    int ok = 1;
+
+    snprintf(expect, sizeof(expect), "%s", whole(topic, dat, len));
+    for (int i = 1; i < len && ok; i++) {
+        cuts[0] = i;
+        ok &= !strcmp(parts(topic, dat, len, cuts, 1), expect);
+        for (int j = i + 1; j < len && len < 64 && ok; j++) {
+            cuts[1] = j;
+            ok &= !strcmp(parts(topic, dat, len, cuts, 2), expect);
+        }
+    }
+    for (int i = 1; i < len; i++)
+        cuts[i - 1] = i;
+    if (ok)
+        ok &= !strcmp(parts(topic, dat, len, cuts, len - 1), expect);
+    if (!ok)
+        printf("%s\nexpect: %s\n   got: %s\n", dat, expect, result(strcmp(topic, COMMAND) ? TICOS_METRIC_DESIRED
+                                                                                           : TICOS_METRIC_COMMAND));
+    return ok;
+}
+
+static void test_split(void)
+{
+    const char *doc = "{\"light\":3,\"on\":true}";
+
+    ticos_test_connect();
+    TICOS_CHECK(same_as_whole(DESIRED, doc));
+    TICOS_CHECK_STR(whole(DESIRED, doc, strlen(doc)), "light=3 on=1 | | 1/0/21/0");
+    TICOS_CHECK(same_as_whole(DESIRED, "{\"mode\":\"a\\\"b\\u00e9\",\"temp\":-1.5e1}"));
+
+    // 未定义的字段、类型不符的值和嵌套容器计入被忽略的字段, 以 '$' 开头的未定义字段不计入
+    doc = "{ \"light\" : 1.6e1 , \"x\":[1,{\"a\":\"}\"}],\"light\":\"x\",\"$meta\":{},\"on\":0,"
+          "\"mode\":\"\\ud83d\\ude00\",\"temp\":1}";
+    TICOS_CHECK(same_as_whole(DESIRED, doc));
+    TICOS_CHECK_STR(whole(DESIRED, doc, strlen(doc)),
+                    "light=16 mode=\xf0\x9f\x98\x80 temp=1 | | 1/0/99/3");
+
+    // 请求 id 在字段之后时回复中也带有请求 id
+    TICOS_CHECK(same_as_whole(COMMAND, "{\"$id\":\"r1\",\"set\":5,\"name\":\"a b\",\"zz\":1}"));
+    TICOS_CHECK(same_as_whole(COMMAND, "{\"set\":2,\"$id\":7}"));
+    TICOS_CHECK(strstr(whole(COMMAND, "{\"set\":2,\"$id\":7}", 17), "set=2 | {\"$id\":\"7\",") != NULL);
+
+    // 格式错误的消息不调用任何 recv 函数, 计为错误
+    TICOS_CHECK(same_as_whole(DESIRED, "{\"light\":5,\"temp\":}"));
+    TICOS_CHECK_STR(whole(DESIRED, "{\"light\":5,\"temp\":}", 19), " | | 1/1/19/0");
+    TICOS_CHECK(same_as_whole(DESIRED, "{\"light\":5}x"));
+    TICOS_CHECK(same_as_whole(COMMAND, "{\"$id\":\"e\",\"set\":1"));
+}
+
+// $version 位于字段之后时同样先按版本过滤, 重复和过期的文档整条丢弃
+static void test_version(void)
+{
+    const char *doc = "{\"light\":1,\"$version\":10}";
+    int len = strlen(doc);
+    int cut = 5;
+
+    TICOS_CHECK_STR(parts(DESIRED, doc, len, &cut, 1), "light=1 | | 1/0/25/0");
+    cut = 20;
+    TICOS_CHECK_STR(parts(DESIRED, doc, len, &cut, 1), " | | 1/1/25/0");
+    doc = "{\"light\":2,\"$version\":9}";
+    TICOS_CHECK_STR(parts(DESIRED, doc, strlen(doc), &cut, 1), " | | 1/1/24/0");
+    doc = "{\"$version\":11,\"light\":3,\"$version\":1}";
+    TICOS_CHECK_STR(parts(DESIRED, doc, strlen(doc), &cut, 1), "light=3 | | 1/0/38/0");
+    TICOS_CHECK_STR(whole(DESIRED, doc, strlen(doc)), " | | 1/1/38/0");
+}
+
+// 分片缺失、重复、错位或超出总长度时整条丢弃, 之后的消息不受影响
+static void test_broken(void)
+{
+    const char *doc = "{\"light\":7,\"on\":false}";
+    int len = strlen(doc);
+
+    // 缺少中间的分片
+    clear();
+    ticos_msg_recv_fragment(DESIRED, strlen(DESIRED), doc, 5, 0, len);
+    ticos_msg_recv_fragment(NULL, 0, doc + 10, len - 10, 10, len);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), " | | 1/1/22/0");
+
+    // 重复的分片
+    clear();
+    ticos_msg_recv_fragment(DESIRED, strlen(DESIRED), doc, 5, 0, len);
+    ticos_msg_recv_fragment(NULL, 0, doc + 5, 5, 5, len);
+    ticos_msg_recv_fragment(NULL, 0, doc + 5, 5, 5, len);
+    ticos_msg_recv_fragment(NULL, 0, doc + 10, len - 10, 10, len);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), " | | 1/1/22/0");
+
+    // 最后一个分片超出总长度
+    clear();
+    ticos_msg_recv_fragment(DESIRED, strlen(DESIRED), doc, 5, 0, len);
+    ticos_msg_recv_fragment(NULL, 0, doc + 5, len - 4, 5, len);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), " | | 1/1/22/0");
+
+    // 没有前面分片的后续分片直接丢弃
+    clear();
+    ticos_msg_recv_fragment(NULL, 0, doc + 10, len - 10, 10, len);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), " | | 0/0/0/0");
+
+    // 新消息的第一个分片打断未完成的消息, 未完成的消息计为错误
+    clear();
+    ticos_msg_recv_fragment(DESIRED, strlen(DESIRED), doc, 5, 0, len);
+    int cut = 9;
+    send_parts(DESIRED, doc, len, &cut, 1);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), "light=7 on=0 | | 2/1/44/0");
+
+    // 期望属性未完成时开始的命令同样打断期望属性
+    clear();
+    ticos_msg_recv_fragment(DESIRED, strlen(DESIRED), doc, 5, 0, len);
+    const char *cmd = "{\"$id\":\"c\",\"set\":1}";
+    cut = 3;
+    send_parts(COMMAND, cmd, strlen(cmd), &cut, 1);
+    TICOS_CHECK(strstr(result(TICOS_METRIC_COMMAND), "set=1 | {\"$id\":\"c\",") != NULL);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_DESIRED].errors, 1);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_COMMAND].errors, 0);
+
+    // 没有路由的 topic 的分片被忽略
+    clear();
+    send_parts("devices/D/unknown", doc, len, &cut, 1);
+    TICOS_CHECK_STR(result(TICOS_METRIC_DESIRED), " | | 0/0/0/0");
+    TICOS_CHECK_STR(parts(DESIRED, doc, len, &cut, 1), "light=7 on=0 | | 1/0/22/0");
+}
+
+// 暂存的字段值放不下暂存区时整条丢弃, 不调用任何 recv 函数
+static void test_pending(void)
+{
+    static char doc[TICOS_RECV_FRAGMENT_SIZE * 2];
+    int len = sprintf(doc, "{\"light\":1");
+    int fields = 0;
+    int cut = 100;
+
+    while (len < TICOS_RECV_FRAGMENT_SIZE + 100)
+        len += sprintf(doc + len, ",\"mode\":\"m%02d-0123456789\"", fields++);
+    len += sprintf(doc + len, "}");
+    TICOS_CHECK(strstr(whole(DESIRED, doc, len), "light=1 mode=m00-0123456789") != NULL);
+    TICOS_CHECK(!strncmp(parts(DESIRED, doc, len, &cut, 1), " | | 1/1/", 9));
+
+    // 放得下时与整条收到相同
+    len = sprintf(doc, "{\"light\":1");
+    for (int i = 0; i < 8; i++)
+        len += sprintf(doc + len, ",\"mode\":\"m%02d-0123456789\"", i);
+    sprintf(doc + len, "}");
+    TICOS_CHECK(same_as_whole(DESIRED, doc));
+}
+
+// CBOR 消息拼接后按整条处理, 超出暂存区的消息整条丢弃
+static void test_cbor(void)
+{
+    static char buf[TICOS_RECV_FRAGMENT_SIZE * 2];
+    ticos_cbor_writer_t w;
+    int cut = 4;
+
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_self_describe(&w);
+    ticos_cbor_map_begin(&w);
+    ticos_cbor_int(&w, 0);
+    ticos_cbor_int(&w, 9);
+    ticos_cbor_string(&w, "mode");
+    ticos_cbor_string(&w, "cbor");
+    ticos_cbor_map_end(&w);
+    int len = ticos_cbor_writer_finish(&w);
+    TICOS_CHECK_STR(whole(DESIRED, buf, len), "light=9 mode=cbor | | 1/0/17/0");
+    TICOS_CHECK(same_as_whole(DESIRED, "{\"light\":9}"));
+    // 第一个分片至少含有 self-describe 标签的 3 个字节, 才能识别为 CBOR
+    for (int i = 3; i < len; i++) {
+        cut = i;
+        TICOS_CHECK_STR(parts(DESIRED, buf, len, &cut, 1), "light=9 mode=cbor | | 1/0/17/0");
+    }
+
+    ticos_cbor_writer_init(&w, buf, sizeof(buf));
+    ticos_cbor_self_describe(&w);
+    ticos_cbor_map_begin(&w);
+    for (int i = 0; i < TICOS_RECV_FRAGMENT_SIZE / 2; i++) {
+        ticos_cbor_int(&w, 0);
+        ticos_cbor_int(&w, 9);
+    }
+    ticos_cbor_map_end(&w);
+    len = ticos_cbor_writer_finish(&w);
+    TICOS_CHECK(len > TICOS_RECV_FRAGMENT_SIZE);
+    TICOS_CHECK_STR(whole(DESIRED, buf, len), "light=9 | | 1/0/1029/0");
+    cut = 512;
+    TICOS_CHECK(!strncmp(parts(DESIRED, buf, len, &cut, 1), " | | 1/1/", 9));
+}
+
+int main(void)
+{
+    test_split();
+    test_version();
+    test_broken();
+    test_pending();
+    test_cbor();
+    return ticos_test_result();
+}
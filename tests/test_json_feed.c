@@ -0,0 +1,281 @@
+/*
+ * 增量 JSON 解析器: 数据在任意位置分段送入, 回调给出的成员与一次送入时相同; 格式是否正确的判断与
+ * ticos_json_check_object() 一致, 格式错误后不再接受数据; 超出缓冲区的成员名和值以长度 -1 给出
+ */
+#include "ticos_test.h"
+#include "ticos_json_feed.h"
+#include "ticos_json_reader.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define LOG_MAX     4096
+
+// 回调依次记录为 "K:成员名" 或 "<类型>:<长度>:<值>", 以空格分隔
+typedef struct {
+    char log[LOG_MAX];
+    int len;
+} feed_log_t;
+
+static void on_member(void *user, int key, ticos_json_type_t type, const char *str, int len)
+{
+    feed_log_t *l = user;
+
+    if (l->len > LOG_MAX - 64 - (len > 0 ? len : 0))
+        return;
+    if (key)
+        l->len += snprintf(l->log + l->len, LOG_MAX - l->len, "%sK%d:", l->len ? " " : "", len);
+    else
+        l->len += snprintf(l->log + l->len, LOG_MAX - l->len, "%s%d:%d:", l->len ? " " : "", type, len);
+    if (len > 0) {
+        memcpy(l->log + l->len, str, len);
+        l->len += len;
+    }
+    l->log[l->len] = '\0';
+}
+
+/*
+ * 按 cuts 中的位置分段送入 js, 返回最后一段的结果; 格式错误时各段都返回 -1, 之前的段返回 0
+ */
+static int feed_parts(const char *js, int len, const int *cuts, int ncut, feed_log_t *l, int size)
+{
+    static char buf[256];
+    ticos_json_feed_t p;
+    int from = 0;
+    int ret = 0;
+    int failed = 0;
+
+    memset(l, 0, sizeof(*l));
+    ticos_json_feed_init(&p, buf, size, on_member, l);
+    for (int i = 0; i <= ncut; i++) {
+        int to = i < ncut ? cuts[i] : len;
+        ret = ticos_json_feed(&p, js + from, to - from);
+        // 格式错误之后的每一段都返回 -1; 顶层对象结束之前的段返回 0
+        if (failed && ret != -1)
+            return -2;
+        failed |= ret < 0;
+        if (!failed && i < ncut && ret == 1 && ticos_json_check_object(js, to))
+            return -2;
+        from = to;
+    }
+    return ret;
+}
+
+static int feed_all(const char *js, int len, feed_log_t *l, int size)
+{
+    return feed_parts(js, len, NULL, 0, l, size);
+}
+
+/*
+ * 一次送入、在每个位置分成两段、逐字节送入的结果和回调都相同, 返回一次送入的结果
+ */
+static int feed_split(const char *js, int len, int size)
+{
+    static feed_log_t whole, part;
+    static int cuts[LOG_MAX];
+    int ret = feed_all(js, len, &whole, size);
+    int ok = 1;
+
+    for (int i = 0; i <= len; i++) {
+        ok &= feed_parts(js, len, &i, 1, &part, size) == ret;
+        // 格式错误时错误之前已给出的回调可能不同, 只比较格式正确的数据
+        ok &= ret < 0 || !strcmp(part.log, whole.log);
+    }
+    for (int i = 0; i < len; i++)
+        cuts[i] = i;
+    ok &= feed_parts(js, len, cuts, len, &part, size) == ret;
+    ok &= ret < 0 || !strcmp(part.log, whole.log);
+    if (!ok)
+        printf("split mismatch: %.*s\n", len, js);
+    return ok ? ret : -2;
+}
+
+static int feed_str(const char *js)
+{
+    return feed_split(js, strlen(js), 256);
+}
+
+static const char *log_of(const char *js, int size)
+{
+    static feed_log_t l;
+
+    feed_all(js, strlen(js), &l, size);
+    return l.log;
+}
+
+// 成员名和各类型的值, 嵌套容器只给出类型
+static void test_members(void)
+{
+    TICOS_CHECK_INT(feed_str("{}"), 1);
+    TICOS_CHECK_STR(log_of("{}", 256), "");
+    TICOS_CHECK_INT(feed_str(" {\"a\" : 1 }\r\n\t "), 1);
+    TICOS_CHECK_STR(log_of("{\"a\":1}", 256), "K1:a 4:1:1");
+
+    const char *doc = "{\"n\":-0.5e+3,\"s\":\"x\",\"t\":true,\"f\":false,\"z\":null,"
+                      "\"o\":{\"a\":[1,{\"b\":\"c\"}]},\"arr\":[],\"\":\"\",\"i\":0}";
+    TICOS_CHECK_INT(feed_str(doc), 1);
+    TICOS_CHECK_STR(log_of(doc, 256), "K1:n 4:7:-0.5e+3 K1:s 3:1:x K1:t 5:4:true K1:f 6:5:false K1:z 7:4:null "
+                                      "K1:o 1:0: K3:arr 2:0: K0: 3:0: K1:i 4:1:0");
+
+    // 转义序列和代理对解码为 UTF-8
+    doc = "{\"e\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\",\"u\":\"\\u00e9\\u4E2D\\ud83d\\ude00\"}";
+    TICOS_CHECK_INT(feed_str(doc), 1);
+    TICOS_CHECK_STR(log_of(doc, 256), "K1:e 3:8:\"\\/\b\f\n\r\t K1:u 3:9:\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80");
+
+    // 同名的成员按出现顺序各给出一次
+    TICOS_CHECK_STR(log_of("{\"a\":1,\"a\":2}", 256), "K1:a 4:1:1 K1:a 4:1:2");
+}
+
+// 长度为缓冲区大小减一的内容正好放得下, 更长的以长度 -1 给出, 不影响之后的成员
+static void test_overflow(void)
+{
+    TICOS_CHECK_STR(log_of("{\"abcdefg\":\"1234567\"}", 8), "K7:abcdefg 3:7:1234567");
+    TICOS_CHECK_STR(log_of("{\"abcdefgh\":\"12345678\",\"n\":123456789,\"m\":1}", 8),
+                    "K-1: 3:-1: K1:n 4:-1: K1:m 4:1:1");
+    TICOS_CHECK_STR(log_of("{\"s\":\"\\u00e9\\u00e9\\u00e9x\"}", 8), "K1:s 3:7:\xc3\xa9\xc3\xa9\xc3\xa9x");
+    TICOS_CHECK_STR(log_of("{\"s\":\"\\u00e9\\u00e9\\u00e9\\u00e9\"}", 8), "K1:s 3:-1:");
+    // 嵌套容器中的内容不占用缓冲区
+    TICOS_CHECK_STR(log_of("{\"o\":{\"long key\":\"long value\"},\"a\":1}", 4), "K1:o 1:0: K1:a 4:1:1");
+    const char *doc = "{\"abcdefgh\":\"12345678\",\"n\":123456789}";
+    TICOS_CHECK_INT(feed_split(doc, strlen(doc), 8), 1);
+}
+
+// 格式正确与否的判断与 ticos_json_check_object() 一致, 在任意位置分段送入时结果不变
+static void test_syntax(void)
+{
+    static const struct {
+        const char *js;
+        int ok;
+    } cases[] = {
+        { "{\"a\":[1,2,[3,{}],\"x\"],\"b\":{\"c\":{}}}", 1 },
+        { "{\"n\":0,\"m\":-12.25E-2,\"k\":1e5,\"j\":-0}", 1 },
+        { "{\"a\":\"\\u0041\\uD834\\uDD1E\"}", 1 },
+        { "{\"a\":1}  \n", 1 },
+        { "", 0 },
+        { "   ", 0 },
+        { "[]", 0 },
+        { "\"a\"", 0 },
+        { "{", 0 },
+        { "{\"a\"}", 0 },
+        { "{\"a\":}", 0 },
+        { "{\"a\" 1}", 0 },
+        { "{\"a\":1,}", 0 },
+        { "{,}", 0 },
+        { "{\"a\":1 \"b\":2}", 0 },
+        { "{a:1}", 0 },
+        { "{'a':1}", 0 },
+        { "{\"a\":01}", 0 },
+        { "{\"a\":-}", 0 },
+        { "{\"a\":1.}", 0 },
+        { "{\"a\":.5}", 0 },
+        { "{\"a\":1e}", 0 },
+        { "{\"a\":1e+}", 0 },
+        { "{\"a\":+1}", 0 },
+        { "{\"a\":NaN}", 0 },
+        { "{\"a\":tru}", 0 },
+        { "{\"a\":truex}", 0 },
+        { "{\"a\":nul}", 0 },
+        { "{\"a\":\"\\x\"}", 0 },
+        { "{\"a\":\"\\u12g4\"}", 0 },
+        { "{\"a\":\"\\ud800\"}", 0 },
+        { "{\"a\":\"\\ud800\\u0041\"}", 0 },
+        { "{\"a\":\"\\udc00\"}", 0 },
+        { "{\"a\":\"\x01\"}", 0 },
+        { "{\"a\":\"x\ny\"}", 0 },
+        { "{\"a\":\"x}", 0 },
+        { "{\"a\":[1,]}", 0 },
+        { "{\"a\":[1}", 0 },
+        { "{\"a\":{\"b\"]}", 0 },
+        { "{\"a\":{\"b\":1]}", 0 },
+        { "{\"a\":[1}]", 0 },
+        { "{}}", 0 },
+        { "{} {}", 0 },
+        { "{}x", 0 },
+        { "{\"a\":1}\0", 0 },
+    };
+    int n = sizeof(cases) / sizeof(cases[0]);
+
+    for (int i = 0; i < n; i++) {
+        const char *js = cases[i].js;
+        int len = strlen(js) + (i == n - 1);
+        int ret = feed_split(js, len, 256);
+        if ((ret == 1) != cases[i].ok || (ticos_json_check_object(js, len) == 0) != cases[i].ok)
+            printf("case %d: %s\n", i, js);
+        TICOS_CHECK_INT(ret == 1, cases[i].ok);
+        TICOS_CHECK_INT(ticos_json_check_object(js, len) == 0, cases[i].ok);
+        // 不完整的数据返回 0, 而不是错误
+        TICOS_CHECK(ret != -2);
+    }
+    TICOS_CHECK_INT(feed_str("{\"a\":[1,"), 0);
+    TICOS_CHECK_INT(feed_str("{\"a\":\"\\ud83d"), 0);
+    TICOS_CHECK_INT(feed_str("{\"a\":12"), 0);
+    TICOS_CHECK_INT(feed_str("{\"a\":12}x"), -1);
+}
+
+// 嵌套层数的上限与 ticos_json_check_object() 相同
+static void test_depth(void)
+{
+    static char js[256];
+    int passed = 0;
+    int failed = 0;
+
+    for (int depth = 28; depth < 40; depth++) {
+        int len = sprintf(js, "{\"a\":");
+        memset(js + len, '[', depth);
+        memset(js + len + depth, ']', depth);
+        len += depth * 2;
+        js[len++] = '}';
+        int ret = feed_split(js, len, 256);
+        TICOS_CHECK_INT(ret == 1, ticos_json_check_object(js, len) == 0);
+        passed += ret == 1;
+        failed += ret == -1;
+    }
+    TICOS_CHECK(passed > 0);
+    TICOS_CHECK(failed > 0);
+}
+
+/*
+ * 随机改写格式正确的数据中的字节, 解析器的判断始终与 ticos_json_check_object() 一致
+ */
+static void test_mutation(void)
+{
+    static const char *const seeds[] = {
+        "{\"a\":[1,-2.5e3,{\"b\":\"c\\u00e9\\n\"}],\"t\":true,\"n\":null,\"s\":\"\\ud83d\\ude00\"}",
+        "{\"$version\":12,\"light\":0,\"mode\":\"eco\",\"o\":{\"x\":[false,{}]}}",
+    };
+    static const char alphabet[] = "{}[]:,\"\\/ubnrtfe0123456789+-.aEx \x01\xc3";
+    static char js[256];
+    static feed_log_t l;
+    uint32_t seed = 1;
+    int ok = 1;
+    int valid = 0;
+
+    for (int round = 0; round < 4000; round++) {
+        const char *src = seeds[round & 1];
+        int len = strlen(src);
+        memcpy(js, src, len);
+        for (int k = 0; k < 1 + round % 3; k++) {
+            seed = seed * 1103515245 + 12345;
+            int pos = (seed >> 8) % len;
+            seed = seed * 1103515245 + 12345;
+            js[pos] = alphabet[(seed >> 8) % (sizeof(alphabet) - 1)];
+        }
+        int ret = round % 50 ? feed_all(js, len, &l, 256) : feed_split(js, len, 256);
+        if ((ret == 1) != (ticos_json_check_object(js, len) == 0) || ret == -2) {
+            printf("mutation mismatch: %.*s\n", len, js);
+            ok = 0;
+        }
+        valid += ret == 1;
+    }
+    TICOS_CHECK(ok);
+    TICOS_CHECK(valid > 0);
+}
+
+int main(void)
+{
+    test_members();
+    test_overflow();
+    test_syntax();
+    test_depth();
+    test_mutation();
+    return ticos_test_result();
+}
@@ -0,0 +1,201 @@
+/*
+ * 原地 JSON 解析器: 成员遍历、格式检查、长度边界、字符串解码和数值转换, 以及格式错误的下发数据不触发回调
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_json_reader.h"
+#include "ticos_thingmodel_type.h"
+#include <stdint.h>
+#include <stdio.h>
+
+void ticos_property_receive(const char *dat, int len);
+
+static int m_calls = 0;
+static int m_light = 0;
+
+static int get_light(void) { return m_light; }
+static int set_light(int v) { m_calls++; m_light = v; return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, get_light, set_light },
+};
+const int ticos_property_cnt = 1;
+
+static void test_members(void)
+{
+    const char *js = " { \"a\" : 1 , \"b\\\"\":\"x\\ny\", \"o\":{\"p\":[1,{\"q\":\"}\"}]}, \"t\":true,\"f\":false,\"n\":null,\"e\":[] } ";
+    ticos_json_reader_t r;
+    ticos_json_tok_t key, val;
+    static const ticos_json_type_t types[] = { TICOS_JSON_NUMBER, TICOS_JSON_STRING, TICOS_JSON_OBJECT, TICOS_JSON_TRUE,
+                                               TICOS_JSON_FALSE, TICOS_JSON_NULL, TICOS_JSON_ARRAY };
+    int n = 0;
+
+    TICOS_CHECK_INT(ticos_json_check_object(js, strlen(js)), 0);
+    ticos_json_reader_init(&r, js, strlen(js));
+    TICOS_CHECK_INT(ticos_json_object_enter(&r), 0);
+    while (ticos_json_object_next(&r, &key, &val) > 0) {
+        if (n < (int)(sizeof(types) / sizeof(types[0])))
+            TICOS_CHECK_INT(val.type, types[n]);
+        if (n == 1) {
+            TICOS_CHECK(ticos_json_tok_equal(js, &key, "b\""));
+            char buf[8];
+            TICOS_CHECK_INT(ticos_json_tok_string(js, &val, buf, sizeof(buf)), 3);
+            TICOS_CHECK_STR(buf, "x\ny");
+        }
+        // 嵌套的对象整体跳过, 范围包含括号
+        if (n == 2) {
+            TICOS_CHECK_INT(val.end - val.start, 19);
+            TICOS_CHECK(!memcmp(js + val.start, "{\"p\":[1,{\"q\":\"}\"}]}", 19));
+        }
+        n++;
+    }
+    TICOS_CHECK_INT(n, 7);
+    TICOS_CHECK_INT(ticos_json_object_next(&r, &key, &val), 0);
+
+    ticos_json_reader_init(&r, "[1]", 3);
+    TICOS_CHECK(ticos_json_object_enter(&r) < 0);
+}
+
+static void test_malformed(void)
+{
+    static const char *bad[] = {
+        "", " ", "{", "}", "[]", "1", "\"a\"", "{\"a\"}", "{\"a\":}", "{\"a\" 1}", "{a:1}", "{\"a\":1,}",
+        "{,\"a\":1}", "{\"a\":1 \"b\":2}", "{\"a\":1}}", "{\"a\":1} x", "{\"a\":\"x}", "{\"a\":\"\\x\"}",
+        "{\"a\":\"\\u12\"}", "{\"a\":\"\x01\"}", "{\"a\":tru}", "{\"a\":nul}", "{\"a\":-}", "{\"a\":1.}",
+        "{\"a\":.5}", "{\"a\":1e}", "{\"a\":01}", "{\"a\":+1}", "{\"a\":[1,]}", "{\"a\":[1}", "{\"a\":{\"b\":1}",
+        "{\"a\":[}]}", "{\"a\":1}{", "{\"a\":\"\\ud83d\"}", "{\"a\":\"\\ude00\\ud83d\"}",
+    };
+    static const char *good[] = {
+        "{}", " {\"a\":-0} ", "{\"a\":1.5e-3,\"b\":-2E+2}", "{\"a\":\"\\u00e9\\/\"}", "{\"a\":[[],{},\"]\"]}",
+        "{\"\":0}", "{\"a\":1,\"a\":2}",
+    };
+
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (!ticos_json_check_object(bad[i], strlen(bad[i]))) {
+            printf("accepted malformed: %s\n", bad[i]);
+            TICOS_CHECK(!"malformed JSON accepted");
+        }
+    }
+    for (unsigned i = 0; i < sizeof(good) / sizeof(good[0]); i++) {
+        if (ticos_json_check_object(good[i], strlen(good[i]))) {
+            printf("rejected: %s\n", good[i]);
+            TICOS_CHECK(!"valid JSON rejected");
+        }
+    }
+}
+
+// 数据不要求以 '\0' 结尾, 解析不能越过给定的长度
+static void test_bounds(void)
+{
+    const char *js = "{\"a\":12}";
+    int len = strlen(js);
+
+    for (int i = 0; i < len; i++)
+        TICOS_CHECK(ticos_json_check_object(js, i) != 0);
+    TICOS_CHECK_INT(ticos_json_check_object(js, len), 0);
+
+    // 截断在数值中间时数值不能读到长度之外
+    char buf[16];
+    memcpy(buf, "{\"a\":12345", 10);
+    memcpy(buf + 10, "}", 2);
+    TICOS_CHECK(ticos_json_check_object(buf, 10) != 0);
+
+    ticos_json_reader_t r;
+    ticos_json_tok_t key, val;
+    int64_t v;
+    ticos_json_reader_init(&r, "{\"a\":12}ignored", 8);
+    TICOS_CHECK_INT(ticos_json_object_enter(&r), 0);
+    TICOS_CHECK_INT(ticos_json_object_next(&r, &key, &val), 1);
+    TICOS_CHECK_INT(ticos_json_tok_int("{\"a\":12}", &val, &v), 0);
+    TICOS_CHECK_INT(v, 12);
+}
+
+static void test_strings(void)
+{
+    const char *js = "{\"s\":\"a\\u00e9\\ud83d\\ude00\\\"\\\\\\/\\b\\f\\n\\r\\t\",\"e\":\"\",\"k\":\"abc\"}";
+    ticos_json_reader_t r;
+    ticos_json_tok_t key, val[3];
+    char buf[32];
+
+    ticos_json_reader_init(&r, js, strlen(js));
+    ticos_json_object_enter(&r);
+    for (int i = 0; i < 3; i++)
+        TICOS_CHECK_INT(ticos_json_object_next(&r, &key, &val[i]), 1);
+
+    TICOS_CHECK_INT(ticos_json_tok_string(js, &val[0], buf, sizeof(buf)), 15);
+    TICOS_CHECK_STR(buf, "a\xc3\xa9\xf0\x9f\x98\x80\"\\/\b\f\n\r\t");
+    TICOS_CHECK_INT(ticos_json_tok_string(js, &val[1], buf, 1), 0);
+    TICOS_CHECK_STR(buf, "");
+    // 结果连同 '\0' 恰好放下时成功, 少一个字节时失败
+    TICOS_CHECK_INT(ticos_json_tok_string(js, &val[2], buf, 4), 3);
+    TICOS_CHECK(ticos_json_tok_string(js, &val[2], buf, 3) < 0);
+    TICOS_CHECK(ticos_json_tok_string(js, &val[2], buf, 0) < 0);
+    TICOS_CHECK(ticos_json_tok_equal(js, &val[2], "abc"));
+    TICOS_CHECK(!ticos_json_tok_equal(js, &val[2], "ab"));
+    TICOS_CHECK(!ticos_json_tok_equal(js, &val[2], "abcd"));
+}
+
+static void test_numbers(void)
+{
+    static const struct {
+        const char *js;
+        int ok;
+        int64_t val;
+    } ints[] = {
+        { "{\"v\":0}", 1, 0 },
+        { "{\"v\":-0}", 1, 0 },
+        { "{\"v\":9223372036854775807}", 1, INT64_MAX },
+        { "{\"v\":-9223372036854775808}", 1, INT64_MIN },
+        { "{\"v\":9223372036854775808}", 0, 0 },
+        { "{\"v\":1.5}", 0, 0 },
+        { "{\"v\":1e3}", 0, 0 },
+        { "{\"v\":\"1\"}", 0, 0 },
+    };
+
+    for (unsigned i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        ticos_json_reader_t r;
+        ticos_json_tok_t key, val;
+        int64_t v = 0;
+        double d;
+        ticos_json_reader_init(&r, ints[i].js, strlen(ints[i].js));
+        ticos_json_object_enter(&r);
+        TICOS_CHECK_INT(ticos_json_object_next(&r, &key, &val), 1);
+        TICOS_CHECK_INT(ticos_json_tok_int(ints[i].js, &val, &v) == 0, ints[i].ok);
+        if (ints[i].ok)
+            TICOS_CHECK_INT(v, ints[i].val);
+        TICOS_CHECK_INT(ticos_json_tok_number(ints[i].js, &val, &d) == 0, val.type == TICOS_JSON_NUMBER);
+    }
+}
+
+// 格式错误的数据整条丢弃, 其中格式正确的成员也不会触发 recv 函数
+static void test_receive(void)
+{
+    static const char *bad[] = { "{\"light\":1,", "{\"light\":2,\"x\":[}", "{\"light\":3}x", "{\"light\":4" };
+
+    ticos_test_connect();
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        ticos_property_receive(bad[i], strlen(bad[i]));
+    TICOS_CHECK_INT(m_calls, 0);
+
+    // 下发数据只在给定长度内解析
+    ticos_property_receive("{\"light\":5}{\"light\":6}", 11);
+    TICOS_CHECK_INT(m_calls, 1);
+    TICOS_CHECK_INT(m_light, 5);
+    // 整数字段接受带小数的值, 向零取整
+    ticos_property_receive("{\"light\":-7.9}", 14);
+    TICOS_CHECK_INT(m_light, -7);
+    // 类型不符的字段被忽略
+    ticos_property_receive("{\"light\":\"8\"}", 13);
+    TICOS_CHECK_INT(m_light, -7);
+}
+
+int main(void)
+{
+    test_members();
+    test_malformed();
+    test_bounds();
+    test_strings();
+    test_numbers();
+    test_receive();
+    return ticos_test_result();
+}
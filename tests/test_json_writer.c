@@ -0,0 +1,174 @@
+/*
+ * 流式 JSON 编码器: 分隔符、转义、数值格式、缓冲区边界, 以及属性和遥测上报的输出
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_json_writer.h"
+#include "ticos_thingmodel_type.h"
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+
+static int m_light = 7;
+static const char *m_info = "line\n\"quoted\"\\\x01";
+
+static int get_switch(void) { return 1; }
+static int get_light(void) { return m_light; }
+static const char *get_info(void) { return m_info; }
+static int set_switch(int v) { return 0; }
+static int set_light(int v) { return 0; }
+static int set_info(const char *v) { return 0; }
+static int get_pressure(void) { return -1023; }
+static float get_temperature(void) { return 22.4f; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "switch", TICOS_VAL_TYPE_BOOLEAN, get_switch, set_switch },
+    { "light", TICOS_VAL_TYPE_INTEGER, get_light, set_light },
+    { "info", TICOS_VAL_TYPE_STRING, get_info, set_info },
+};
+const int ticos_property_cnt = 3;
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "pressure", TICOS_VAL_TYPE_INTEGER, get_pressure },
+    { "temperature", TICOS_VAL_TYPE_FLOAT, get_temperature },
+};
+const int ticos_telemetry_cnt = 2;
+
+static void test_structure(void)
+{
+    char buf[256];
+    ticos_json_writer_t w;
+
+    ticos_json_writer_init(&w, buf, sizeof(buf));
+    ticos_json_object_begin(&w);
+    ticos_json_object_end(&w);
+    TICOS_CHECK_INT(ticos_json_writer_finish(&w), 2);
+    TICOS_CHECK_STR(buf, "{}");
+
+    ticos_json_writer_init(&w, buf, sizeof(buf));
+    ticos_json_object_begin(&w);
+    ticos_json_add_bool(&w, "t", 1);
+    ticos_json_add_bool(&w, "f", 0);
+    ticos_json_key(&w, "o");
+    ticos_json_object_begin(&w);
+    ticos_json_add_null(&w, "n");
+    ticos_json_key(&w, "e");
+    ticos_json_object_begin(&w);
+    ticos_json_object_end(&w);
+    ticos_json_object_end(&w);
+    ticos_json_add_string(&w, "s", NULL);
+    ticos_json_key_raw(&w, "\"raw\":", 6);
+    ticos_json_int(&w, 5);
+    ticos_json_object_end(&w);
+    TICOS_CHECK(ticos_json_writer_finish(&w) > 0);
+    TICOS_CHECK_STR(buf, "{\"t\":true,\"f\":false,\"o\":{\"n\":null,\"e\":{}},\"s\":\"\",\"raw\":5}");
+}
+
+static void test_escape(void)
+{
+    char buf[256];
+    ticos_json_writer_t w;
+
+    ticos_json_writer_init(&w, buf, sizeof(buf));
+    ticos_json_object_begin(&w);
+    ticos_json_add_string(&w, "k\"\\", "\b\f\n\r\t\x1f/\xc3\xa9");
+    ticos_json_object_end(&w);
+    TICOS_CHECK(ticos_json_writer_finish(&w) > 0);
+    // 控制字符转义, '/' 和 UTF-8 多字节字符原样输出
+    TICOS_CHECK_STR(buf, "{\"k\\\"\\\\\":\"\\b\\f\\n\\r\\t\\u001f/\xc3\xa9\"}");
+
+    char esc[6];
+    TICOS_CHECK_INT(ticos_json_escape('a', esc), 0);
+    TICOS_CHECK_INT(ticos_json_escape(0x7f, esc), 0);
+    TICOS_CHECK_INT(ticos_json_escape(0, esc), 6);
+    TICOS_CHECK(!memcmp(esc, "\\u0000", 6));
+}
+
+static void test_numbers(void)
+{
+    char buf[512];
+    ticos_json_writer_t w;
+
+    ticos_json_writer_init(&w, buf, sizeof(buf));
+    ticos_json_object_begin(&w);
+    ticos_json_add_int(&w, "max", INT64_MAX);
+    ticos_json_add_int(&w, "min", INT64_MIN);
+    ticos_json_add_int(&w, "zero", 0);
+    ticos_json_add_number(&w, "tenth", 0.1);
+    ticos_json_add_number(&w, "third", 1.0 / 3);
+    ticos_json_add_number(&w, "int", 100);
+    ticos_json_add_float(&w, "f", 22.4f);
+    ticos_json_add_number(&w, "nan", NAN);
+    ticos_json_add_number(&w, "inf", -INFINITY);
+    ticos_json_add_float(&w, "finf", INFINITY);
+    ticos_json_object_end(&w);
+    TICOS_CHECK(ticos_json_writer_finish(&w) > 0);
+    TICOS_CHECK_STR(buf, "{\"max\":9223372036854775807,\"min\":-9223372036854775808,\"zero\":0,"
+                         "\"tenth\":0.1,\"third\":0.3333333333333333,\"int\":100,\"f\":22.4,"
+                         "\"nan\":null,\"inf\":null,\"finf\":null}");
+}
+
+// 输出恰好占满缓冲区时需要为结尾的 '\0' 留出空间, 溢出后不再写入
+static void test_overflow(void)
+{
+    char buf[32];
+    ticos_json_writer_t w;
+    const char *expect = "{\"key\":\"value\"}";
+    int len = strlen(expect);
+
+    for (int size = 0; size <= len + 1; size++) {
+        memset(buf, 'x', sizeof(buf));
+        ticos_json_writer_init(&w, buf, size);
+        ticos_json_object_begin(&w);
+        ticos_json_add_string(&w, "key", "value");
+        ticos_json_object_end(&w);
+        int ret = ticos_json_writer_finish(&w);
+        TICOS_CHECK_INT(ret, size > len ? len : -1);
+        for (int i = size; i < (int)sizeof(buf); i++) {
+            if (buf[i] != 'x') {
+                TICOS_CHECK(!"write past the end of the buffer");
+                break;
+            }
+        }
+    }
+    TICOS_CHECK_STR(buf, expect);
+
+    ticos_json_writer_init(&w, NULL, 16);
+    ticos_json_object_begin(&w);
+    TICOS_CHECK_INT(ticos_json_writer_finish(&w), -1);
+}
+
+static void test_report(void)
+{
+    ticos_test_connect();
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/twin/reported");
+    TICOS_CHECK_STR(ticos_test_last(), "{\"switch\":true,\"light\":7,\"info\":\"line\\n\\\"quoted\\\"\\\\\\u0001\"}");
+
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/telemetry");
+    TICOS_CHECK_STR(ticos_test_last(), "{\"pressure\":-1023,\"temperature\":22.4}");
+
+    TICOS_CHECK(ticos_property_report_by_index(1) >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"light\":7}");
+    TICOS_CHECK(ticos_property_report_by_index(3) < 0);
+
+    // 超出上报缓冲区的消息不发布
+    static char big[TICOS_REPORT_BUF_SIZE + 1];
+    memset(big, 'a', sizeof(big) - 1);
+    m_info = big;
+    int count = ticos_test_count();
+    TICOS_CHECK(ticos_property_report() < 0);
+    TICOS_CHECK_INT(ticos_test_count(), count);
+    m_info = "";
+}
+
+int main(void)
+{
+    test_structure();
+    test_escape();
+    test_numbers();
+    test_overflow();
+    test_report();
+    return ticos_test_result();
+}
@@ -0,0 +1,212 @@
+/*
+ * Linux HAL: 经进程内 broker 完成连接、订阅、上报和下发; 超出接收缓冲区的消息按分片交给 SDK,
+ * 报文在缓冲区边界附近截断时不丢失数据; 超出上报缓冲区的流式字段经分块发布接口写出完整的报文
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_hal_linux.h"
+#include "ticos_mqtt_broker.h"
+#include "ticos_mqtt_packet.h"
+#include "ticos_thingmodel_type.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static volatile int m_light = 0;
+static volatile int m_light_calls = 0;
+static volatile float m_oxygen = 0;
+
+static int light_send(void) { return m_light; }
+static int light_recv(int v) { m_light = v; m_light_calls++; return 0; }
+static int oxygen_cmd(float v) { m_oxygen = v; return 0; }
+
+#define LOG_SIZE 6000
+static char m_log[LOG_SIZE];
+
+static int log_read(size_t offset, void *buf, int size)
+{
+    int n = offset < LOG_SIZE ? LOG_SIZE - (int)offset : 0;
+    n = n < size ? n : size;
+    memcpy(buf, m_log + offset, n);
+    return n;
+}
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "log", TICOS_VAL_TYPE_STREAM, log_read },
+};
+const int ticos_telemetry_cnt = 1;
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+};
+const int ticos_property_cnt = 1;
+
+const ticos_command_info_t ticos_command_tab[] = {
+    { "oxygen", TICOS_VAL_TYPE_FLOAT, oxygen_cmd },
+};
+const int ticos_command_cnt = 1;
+
+// broker 收到的设备消息
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;
+static char m_topic[128];
+static char m_data[256];
+static char m_large[LOG_SIZE * 2];
+static int m_len;
+static volatile int m_published = 0;
+
+static void on_publish(const char *topic, const char *data, int len, void *user_data)
+{
+    pthread_mutex_lock(&m_lock);
+    snprintf(m_topic, sizeof(m_topic), "%s", topic);
+    snprintf(m_data, sizeof(m_data), "%.*s", len, data);
+    m_len = len;
+    memcpy(m_large, data, len < (int)sizeof(m_large) ? len : (int)sizeof(m_large));
+    m_published++;
+    pthread_mutex_unlock(&m_lock);
+}
+
+static int wait_until(volatile int *val, int expect)
+{
+    for (int i = 0; i < 500 && *val < expect; i++)
+        usleep(10000);
+    return *val >= expect;
+}
+
+static void test_packet(void)
+{
+    static const int lens[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455 };
+    uint8_t buf[TICOS_MQTT_FIXED_HDR_MAX];
+
+    for (unsigned i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        int hdr_len = 0;
+        int n = ticos_mqtt_put_header(buf, TICOS_MQTT_PUBLISH, lens[i]);
+        TICOS_CHECK_INT(n, 2 + (lens[i] >= 128) + (lens[i] >= 16384) + (lens[i] >= 2097152));
+        // 报头不完整时等待更多数据
+        for (int avail = 0; avail < n; avail++)
+            TICOS_CHECK_INT(ticos_mqtt_frame(buf, avail, &hdr_len), 0);
+        TICOS_CHECK_INT(ticos_mqtt_frame(buf, n + lens[i], &hdr_len), n + lens[i]);
+        TICOS_CHECK_INT(hdr_len, n);
+        if (lens[i] > 0)
+            TICOS_CHECK_INT(ticos_mqtt_frame(buf, n + lens[i] - 1, &hdr_len), 0);
+    }
+    // 剩余长度最多 4 字节
+    uint8_t bad[] = { TICOS_MQTT_PUBLISH, 0xff, 0xff, 0xff, 0xff, 0x01 };
+    int hdr_len;
+    TICOS_CHECK_INT(ticos_mqtt_frame(bad, sizeof(bad), &hdr_len), -1);
+}
+
+static void test_roundtrip(void)
+{
+    pthread_mutex_lock(&m_lock);
+    int published = m_published;
+    pthread_mutex_unlock(&m_lock);
+
+    m_light = 3;
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(wait_until(&m_published, published + 1));
+    pthread_mutex_lock(&m_lock);
+    TICOS_CHECK_STR(m_topic, "devices/D/twin/reported");
+    TICOS_CHECK_STR(m_data, "{\"light\":3}");
+    pthread_mutex_unlock(&m_lock);
+
+    const char *desired = "{\"light\":5}";
+    TICOS_CHECK_INT(ticos_broker_publish("devices/D/twin/desired", desired, strlen(desired)), 1);
+    TICOS_CHECK(wait_until(&m_light_calls, 1));
+    TICOS_CHECK_INT(m_light, 5);
+
+    // 命令执行后以请求 id 回复
+    const char *command = "{\"$id\":\"7\",\"oxygen\":20.5}";
+    TICOS_CHECK_INT(ticos_broker_publish("devices/D/commands/request", command, strlen(command)), 1);
+    TICOS_CHECK(wait_until(&m_published, published + 2));
+    TICOS_CHECK(m_oxygen == 20.5f);
+    pthread_mutex_lock(&m_lock);
+    TICOS_CHECK_STR(m_topic, "devices/D/commands/response");
+    TICOS_CHECK(strstr(m_data, "\"$id\":\"7\"") != NULL);
+    pthread_mutex_unlock(&m_lock);
+}
+
+// 下发消息的长度跨过接收缓冲区大小, 超出的部分按分片处理, 之后的消息不受影响
+static void test_large(void)
+{
+    static char doc[12000];
+    int calls = m_light_calls;
+
+    for (int total = 4000; total < 4200; total += 7) {
+        int pad = total - (int)strlen("{\"pad\":\"\",\"light\":1000}");
+        int len = snprintf(doc, sizeof(doc), "{\"pad\":\"%0*d\",\"light\":%d}", pad, 0, 1000 + total % 1000);
+        TICOS_CHECK_INT(len, total);
+        ticos_broker_publish("devices/D/twin/desired", doc, len);
+        TICOS_CHECK(wait_until(&m_light_calls, ++calls));
+        TICOS_CHECK_INT(m_light, 1000 + total % 1000);
+    }
+
+    int len = snprintf(doc, sizeof(doc), "{\"pad\":\"%0*d\",\"light\":42}", 11000, 0);
+    ticos_broker_publish("devices/D/twin/desired", doc, len);
+    TICOS_CHECK(wait_until(&m_light_calls, ++calls));
+    TICOS_CHECK_INT(m_light, 42);
+
+    const char *desired = "{\"light\":43}";
+    ticos_broker_publish("devices/D/twin/desired", desired, strlen(desired));
+    TICOS_CHECK(wait_until(&m_light_calls, ++calls));
+    TICOS_CHECK_INT(m_light, 43);
+}
+
+// 流式字段的消息长于上报缓冲区, 分块写入连接后 broker 收到完整的报文, 之后的上报不受影响
+static void test_stream(void)
+{
+    static char expect[LOG_SIZE * 2];
+    int published = m_published;
+
+    for (int i = 0; i < LOG_SIZE; i++)
+        m_log[i] = i % 10 ? 'a' + i % 26 : '\n';
+    int len = snprintf(expect, sizeof(expect), "{\"log\":\"");
+    for (int i = 0; i < LOG_SIZE; i++) {
+        if (m_log[i] == '\n') {
+            expect[len++] = '\\';
+            expect[len++] = 'n';
+        } else {
+            expect[len++] = m_log[i];
+        }
+    }
+    len += snprintf(expect + len, sizeof(expect) - len, "\"}");
+    TICOS_CHECK(len > TICOS_REPORT_BUF_SIZE);
+
+    TICOS_CHECK(ticos_telemetry_report_by_index(0) >= 0);
+    TICOS_CHECK(wait_until(&m_published, published + 1));
+    pthread_mutex_lock(&m_lock);
+    TICOS_CHECK_STR(m_topic, "devices/D/telemetry");
+    TICOS_CHECK_INT(m_len, len);
+    TICOS_CHECK(!memcmp(m_large, expect, len));
+    pthread_mutex_unlock(&m_lock);
+
+    m_light = 9;
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(wait_until(&m_published, published + 2));
+    pthread_mutex_lock(&m_lock);
+    TICOS_CHECK_STR(m_data, "{\"light\":9}");
+    pthread_mutex_unlock(&m_lock);
+}
+
+int main(void)
+{
+    test_packet();
+
+    int port = ticos_broker_start(0);
+    TICOS_CHECK(port > 0);
+    ticos_broker_set_hook(on_publish, NULL);
+    ticos_hal_mqtt_set_server("127.0.0.1", port);
+    ticos_cloud_start("P", "D", "S");
+    for (int i = 0; i < 500 && ticos_broker_subscriptions() < 2; i++)
+        usleep(10000);
+    TICOS_CHECK(ticos_broker_subscriptions() >= 2);
+    TICOS_CHECK_INT(ticos_hal_mqtt_connected(), 1);
+
+    test_roundtrip();
+    test_large();
+    test_stream();
+
+    ticos_cloud_stop();
+    ticos_broker_stop();
+    return ticos_test_result();
+}
@@ -0,0 +1,197 @@
+/*
+ * 内存池: 操作期间顺序分配并在结束时整体释放, 只回退最近一次分配, 不足或被其他线程占用时改用分配器
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_mem.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static uint64_t m_buf[33];
+static int m_mallocs = 0;
+static int m_frees = 0;
+
+static void *count_malloc(size_t size) { m_mallocs++; return malloc(size); }
+static void count_free(void *ptr) { m_frees++; free(ptr); }
+
+static int in_arena(const void *ptr, const void *buf, size_t size)
+{
+    return (const char *)ptr >= (const char *)buf && (const char *)ptr < (const char *)buf + size;
+}
+
+static void test_allocator(void)
+{
+    ticos_allocator_t bad = { count_malloc, NULL };
+    ticos_allocator_t alloc = { count_malloc, count_free };
+
+    TICOS_CHECK(ticos_set_allocator(&bad) < 0);
+    TICOS_CHECK_INT(ticos_set_allocator(&alloc), 0);
+    // 没有内存池时直接使用分配器
+    void *p = ticos_malloc(16);
+    TICOS_CHECK(p != NULL);
+    ticos_free(p);
+    ticos_free(NULL);
+    TICOS_CHECK_INT(m_mallocs, 1);
+    TICOS_CHECK_INT(m_frees, 1);
+}
+
+static void test_arena(void)
+{
+    ticos_arena_stats_t st;
+
+    TICOS_CHECK_INT(ticos_set_arena(m_buf, 256), 0);
+    ticos_mem_begin();
+    char *a = ticos_malloc(10);
+    char *b = ticos_malloc(10);
+    TICOS_CHECK(a == (char *)m_buf);
+    TICOS_CHECK(b == (char *)m_buf + 16);
+    // 只有最近一次的分配可以回退
+    ticos_free(a);
+    ticos_free(b);
+    char *c = ticos_malloc(3);
+    TICOS_CHECK(c == b);
+    // 剩余空间刚好够用和不够用
+    char *d = ticos_malloc(256 - 24);
+    TICOS_CHECK(d == (char *)m_buf + 24);
+    char *e = ticos_malloc(1);
+    TICOS_CHECK(e && !in_arena(e, m_buf, 256));
+    TICOS_CHECK_INT(m_mallocs, 2);
+    ticos_free(e);
+    TICOS_CHECK_INT(m_frees, 2);
+    // 操作进行中不能更换内存池
+    TICOS_CHECK(ticos_set_arena(NULL, 0) < 0);
+    ticos_mem_end();
+
+    ticos_get_arena_stats(&st, 1);
+    TICOS_CHECK_INT(st.size, 256);
+    TICOS_CHECK_INT(st.peak, 256);
+    TICOS_CHECK_INT(st.ops, 1);
+    TICOS_CHECK_INT(st.allocs, 4);
+    TICOS_CHECK_INT(st.fallbacks, 1);
+    ticos_get_arena_stats(&st, 0);
+    TICOS_CHECK_INT(st.size, 256);
+    TICOS_CHECK_INT(st.peak, 0);
+    TICOS_CHECK_INT(st.ops, 0);
+
+    // 嵌套的操作共用外层的内存池, 最外层结束时才整体释放
+    ticos_mem_begin();
+    a = ticos_malloc(8);
+    ticos_mem_begin();
+    b = ticos_malloc(8);
+    ticos_mem_end();
+    c = ticos_malloc(8);
+    TICOS_CHECK(a == (char *)m_buf && b == a + 8 && c == a + 16);
+    ticos_mem_end();
+    ticos_mem_begin();
+    TICOS_CHECK(ticos_malloc(8) == (char *)m_buf);
+    ticos_mem_end();
+    // 多余的 end 无效果
+    ticos_mem_end();
+
+    // 操作之外的分配不使用内存池
+    m_mallocs = 0;
+    void *p = ticos_malloc(8);
+    TICOS_CHECK(!in_arena(p, m_buf, 256));
+    ticos_free(p);
+    TICOS_CHECK_INT(m_mallocs, 1);
+    // 超出内存池范围的大小不会回绕
+    ticos_mem_begin();
+    p = ticos_malloc(SIZE_MAX - 4);
+    TICOS_CHECK(p == NULL);
+    ticos_mem_end();
+}
+
+// 未对齐的内存池按地址对齐分配
+static void test_unaligned(void)
+{
+    char *buf = (char *)m_buf + 3;
+
+    TICOS_CHECK_INT(ticos_set_arena(buf, 200), 0);
+    ticos_mem_begin();
+    for (int i = 0; i < 4; i++) {
+        char *p = ticos_malloc(5);
+        TICOS_CHECK(in_arena(p, buf, 200));
+        TICOS_CHECK_INT((uintptr_t)p % 8, 0);
+    }
+    char *p = ticos_malloc(200);
+    TICOS_CHECK(!in_arena(p, buf, 200));
+    ticos_free(p);
+    ticos_mem_end();
+    ticos_arena_stats_t st;
+    ticos_get_arena_stats(&st, 1);
+    TICOS_CHECK(st.size <= 200 && st.size >= 192);
+}
+
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+static int m_step = 0;
+
+static void step(int next)
+{
+    pthread_mutex_lock(&m_lock);
+    m_step = next;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+}
+
+static void wait_step(int expect)
+{
+    pthread_mutex_lock(&m_lock);
+    while (m_step != expect)
+        pthread_cond_wait(&m_cond, &m_lock);
+    pthread_mutex_unlock(&m_lock);
+}
+
+static void *other_thread(void *arg)
+{
+    wait_step(1);
+    // 内存池被主线程占用, 本线程的操作改用分配器
+    ticos_mem_begin();
+    void *p = ticos_malloc(8);
+    *(int *)arg = in_arena(p, m_buf, 256);
+    ticos_free(p);
+    ticos_mem_end();
+    step(2);
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    pthread_t t;
+    int used_arena = -1;
+    ticos_arena_stats_t st;
+
+    TICOS_CHECK_INT(ticos_set_arena(m_buf, 256), 0);
+    pthread_create(&t, NULL, other_thread, &used_arena);
+    ticos_mem_begin();
+    char *a = ticos_malloc(8);
+    step(1);
+    wait_step(2);
+    char *b = ticos_malloc(8);
+    TICOS_CHECK(a == (char *)m_buf && b == a + 8);
+    ticos_mem_end();
+    pthread_join(t, NULL);
+    TICOS_CHECK_INT(used_arena, 0);
+    ticos_get_arena_stats(&st, 1);
+    TICOS_CHECK_INT(st.allocs, 2);
+    TICOS_CHECK_INT(st.fallbacks, 1);
+
+    // 主线程结束操作后内存池可由其他线程使用
+    m_step = 0;
+    pthread_create(&t, NULL, other_thread, &used_arena);
+    step(1);
+    wait_step(2);
+    pthread_join(t, NULL);
+    TICOS_CHECK_INT(used_arena, 1);
+    TICOS_CHECK_INT(ticos_set_arena(NULL, 0), 0);
+}
+
+int main(void)
+{
+    test_allocator();
+    test_arena();
+    test_unaligned();
+    test_threads();
+    return ticos_test_result();
+}
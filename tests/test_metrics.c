@@ -0,0 +1,213 @@
+/*
+ * 运行统计: 各类消息的条数和字节数、耗时直方图、队列深度和被忽略的字段数, 多线程并发累计不丢失, 读取时可清零
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_metrics.h"
+#include "ticos_thingmodel_type.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define THREADS     4
+#define PER_THREAD  100000
+
+static int m_light = 1;
+static int m_set;
+
+static int light_send(void) { return m_light; }
+static int light_recv(int v) { m_light = v; return 0; }
+static int cmd_set(int v) { m_set = v; return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "t", TICOS_VAL_TYPE_INTEGER, light_send },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+const ticos_command_info_t ticos_command_tab[] = {
+    { "set", TICOS_VAL_TYPE_INTEGER, cmd_set },
+};
+const int ticos_command_cnt = sizeof(ticos_command_tab) / sizeof(ticos_command_tab[0]);
+
+static ticos_metrics_t m;
+
+static void receive(const char *topic, const char *data)
+{
+    ticos_msg_recv(topic, data, strlen(data));
+}
+
+// 直方图各桶之和等于样本数, 最大值不小于平均值
+static int hist_valid(const ticos_metric_hist_t *h)
+{
+    unsigned int sum = 0;
+
+    for (int b = 0; b < TICOS_METRIC_BUCKETS; b++)
+        sum += h->buckets[b];
+    return sum == h->count && (!h->count || h->max_us >= h->total_us / h->count);
+}
+
+static void test_traffic(void)
+{
+    ticos_test_connect();
+    TICOS_CHECK_INT(ticos_get_metrics(&m, 1), 0);
+
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_PROPERTY].msgs, 1);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_PROPERTY].bytes, strlen("{\"light\":1}"));
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].msgs, 2);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].bytes, 2 * strlen("{\"t\":1}"));
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].errors, 0);
+    TICOS_CHECK_INT(m.latency[TICOS_METRIC_SERIALIZE].count, 3);
+    TICOS_CHECK_INT(m.latency[TICOS_METRIC_PUBLISH].count, 3);
+    TICOS_CHECK(hist_valid(&m.latency[TICOS_METRIC_SERIALIZE]));
+    TICOS_CHECK(hist_valid(&m.latency[TICOS_METRIC_PUBLISH]));
+
+    // 下发的期望属性: 格式错误和版本过期的文档计为错误, 未定义和类型不符的字段计入被忽略的字段, $version 不计入
+    receive("devices/D/twin/desired", "{\"$version\":2,\"light\":3}");
+    receive("devices/D/twin/desired", "{\"$version\":1,\"light\":4}");
+    receive("devices/D/twin/desired", "{\"light\":");
+    receive("devices/D/twin/desired", "{\"light\":\"x\",\"unknown\":1,\"light\":5}");
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m_light, 5);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_DESIRED].msgs, 4);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_DESIRED].errors, 2);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_DESIRED].bytes,
+                    strlen("{\"$version\":2,\"light\":3}") + strlen("{\"$version\":1,\"light\":4}") +
+                    strlen("{\"light\":") + strlen("{\"light\":\"x\",\"unknown\":1,\"light\":5}"));
+    TICOS_CHECK_INT(m.rejected_keys, 2);
+    TICOS_CHECK_INT(m.latency[TICOS_METRIC_PARSE].count, 4);
+    TICOS_CHECK(hist_valid(&m.latency[TICOS_METRIC_PARSE]));
+
+    // 命令和回复分别计数
+    receive("devices/D/commands/request", "{\"$id\":\"1\",\"set\":7}");
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m_set, 7);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_COMMAND].msgs, 1);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_RESPONSE].msgs, 1);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_RESPONSE].bytes, ticos_test_msg(0)->len);
+
+    // 发布失败的消息进入离线队列
+    ticos_test_publish_fail(1);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    ticos_test_publish_fail(0);
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.offline_pending, 1);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.offline_pending, 0);
+
+    // 清零后计数、耗时和最大值都为 0
+    ticos_get_metrics(&m, 1);
+    ticos_get_metrics(&m, 0);
+    for (int i = 0; i < TICOS_METRIC_TOPIC_MAX; i++)
+        TICOS_CHECK_INT(m.traffic[i].msgs + m.traffic[i].bytes + m.traffic[i].errors, 0);
+    for (int i = 0; i < TICOS_METRIC_STAGE_MAX; i++)
+        TICOS_CHECK_INT(m.latency[i].count + m.latency[i].total_us + m.latency[i].max_us, 0);
+    TICOS_CHECK_INT(m.rejected_keys, 0);
+}
+
+// 发送线程未启动时异步请求留在队列中, 队列满时计数
+static void test_queue(void)
+{
+    for (int i = 0; i < 10; i++)
+        TICOS_CHECK_INT(ticos_telemetry_report_async(), TICOS_SEND_OK);
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.send_queue, 10);
+    TICOS_CHECK_INT(m.send_queue_peak, 10);
+    while (ticos_telemetry_report_async() == TICOS_SEND_OK)
+        ;
+    ticos_get_metrics(&m, 1);
+    TICOS_CHECK_INT(m.send_full, 1);
+    TICOS_CHECK_INT(m.send_queue, TICOS_SEND_QUEUE_SIZE);
+    TICOS_CHECK_INT(m.send_queue_peak, TICOS_SEND_QUEUE_SIZE);
+
+    // 清零不影响当前的队列深度, 发送后深度为 0
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.send_queue, TICOS_SEND_QUEUE_SIZE);
+    TICOS_CHECK_INT(m.send_queue_peak, 0);
+    TICOS_CHECK_INT(ticos_sender_start(), 0);
+    ticos_sender_stop();
+    ticos_get_metrics(&m, 0);
+    TICOS_CHECK_INT(m.send_queue, 0);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].msgs, TICOS_SEND_QUEUE_SIZE);
+}
+
+static void *counter(void *arg)
+{
+    for (int i = 0; i < PER_THREAD; i++) {
+        ticos_metrics_traffic(TICOS_METRIC_TELEMETRY, 3, i & 1);
+        ticos_metrics_latency(TICOS_METRIC_SERIALIZE, ticos_metrics_clock());
+        ticos_metrics_count(TICOS_METRIC_REJECTED_KEY);
+        ticos_metrics_queue(TICOS_METRIC_COMMAND_QUEUE, (unsigned int)(uintptr_t)arg * 10 + i % 10);
+    }
+    return NULL;
+}
+
+// 多线程并发累计的计数不丢失
+static void test_concurrent(void)
+{
+    pthread_t threads[THREADS];
+
+    ticos_get_metrics(&m, 1);
+    for (uintptr_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, counter, (void *)i);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    ticos_get_metrics(&m, 1);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].msgs, THREADS * PER_THREAD);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].bytes, THREADS * PER_THREAD * 3);
+    TICOS_CHECK_INT(m.traffic[TICOS_METRIC_TELEMETRY].errors, THREADS * PER_THREAD / 2);
+    TICOS_CHECK_INT(m.latency[TICOS_METRIC_SERIALIZE].count, THREADS * PER_THREAD);
+    TICOS_CHECK(hist_valid(&m.latency[TICOS_METRIC_SERIALIZE]));
+    TICOS_CHECK_INT(m.rejected_keys, THREADS * PER_THREAD);
+    TICOS_CHECK_INT(m.command_queue_peak, (THREADS - 1) * 10 + 9);
+}
+
+// 自动上报以 $metrics 为键在遥测 topic 上发布, 不清零统计
+static void test_report(void)
+{
+    TICOS_CHECK_INT(ticos_metrics_set_report(-1), -1);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+    TICOS_CHECK_INT(ticos_metrics_set_report(30), 0);
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_report_poll(), 0);
+    int next = ticos_report_next_ms();
+    TICOS_CHECK(next > 0 && next <= 30);
+    for (int i = 0; i < 100 && !ticos_test_count(); i++) {
+        usleep(1000);
+        ticos_report_poll();
+    }
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/telemetry");
+    TICOS_CHECK(!strncmp(ticos_test_last(), "{\"$metrics\":{\"uptime\":", 22));
+    TICOS_CHECK(strstr(ticos_test_last(), "\"telemetry\":{\"msgs\":0,\"bytes\":0,\"errors\":0}") != NULL);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"serialize\":{\"count\":0,") != NULL);
+
+    // 自动上报本身也计入遥测
+    for (int i = 0; i < 100 && ticos_test_count() < 2; i++) {
+        usleep(1000);
+        ticos_report_poll();
+    }
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"telemetry\":{\"msgs\":1,") != NULL);
+
+    TICOS_CHECK_INT(ticos_metrics_set_report(0), 0);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+}
+
+int main(void)
+{
+    test_traffic();
+    test_queue();
+    test_concurrent();
+    test_report();
+    return ticos_test_result();
+}
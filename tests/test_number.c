@@ -0,0 +1,387 @@
+/*
+ * 数值编解码: 输出为能精确还原的最短文本, 解析结果与 strtod()/strtof() 逐位相同, 整数不经过浮点运算
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_number.h"
+#include "ticos_thingmodel_type.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RANDOM_CNT 200000
+
+static uint64_t m_seed = 0x9e3779b97f4a7c15ull;
+// Grisu2 对极少数值的输出比最短表示长(最短表示紧靠舍入区间的边界时)
+static int m_longer;
+
+static uint64_t next_random(void)
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 7;
+    m_seed ^= m_seed << 17;
+    return m_seed;
+}
+
+// 文本中有效数字的个数
+static int digits(const char *s)
+{
+    int n = 0;
+    int lead = 1;
+    int zeros = 0;
+
+    for (; *s && *s != 'e' && *s != 'E'; s++) {
+        if (*s < '0' || *s > '9')
+            continue;
+        if (lead && *s == '0')
+            continue;
+        lead = 0;
+        // 整数末尾的 0 不算有效数字
+        if (*s == '0') {
+            zeros++;
+        } else {
+            n += zeros + 1;
+            zeros = 0;
+        }
+    }
+    return n;
+}
+
+static void test_itoa(void)
+{
+    static const int64_t values[] = { 0, 1, -1, 9, 10, -10, 99, 100, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN, INT64_MIN + 1 };
+    char buf[TICOS_NUMBER_MAX];
+    char expect[TICOS_NUMBER_MAX];
+    int ok = 1;
+
+    for (int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+        TICOS_CHECK_INT(ticos_itoa(values[i], buf), snprintf(expect, sizeof(expect), "%lld", (long long)values[i]));
+        TICOS_CHECK_STR(buf, expect);
+    }
+    // 每个位数的边界
+    for (int64_t p = 1; p <= INT64_MAX / 10; p *= 10) {
+        for (int64_t d = -1; d <= 1; d++) {
+            for (int sign = -1; sign <= 1; sign += 2) {
+                int64_t v = sign * (p + d);
+                int len = ticos_itoa(v, buf);
+                snprintf(expect, sizeof(expect), "%lld", (long long)v);
+                ok &= len == (int)strlen(expect) && !strcmp(buf, expect);
+            }
+        }
+    }
+    for (int i = 0; i < RANDOM_CNT; i++) {
+        int64_t v = (int64_t)next_random() >> (next_random() % 64);
+        int len = ticos_itoa(v, buf);
+        snprintf(expect, sizeof(expect), "%lld", (long long)v);
+        ok &= len == (int)strlen(expect) && !strcmp(buf, expect);
+    }
+    TICOS_CHECK(ok);
+}
+
+// float 以最短的位数输出(整数值按整数输出), 且 strtof() 和 ticos_atof() 都能还原原值; 不是最短时计入 m_longer
+static int check_ftoa(float v)
+{
+    char buf[TICOS_NUMBER_MAX];
+    char shortest[TICOS_NUMBER_MAX];
+    float back;
+    int p;
+
+    int len = ticos_ftoa(v, buf);
+    if (len != (int)strlen(buf) || len >= TICOS_NUMBER_MAX)
+        return 0;
+    if (strtof(buf, NULL) != v)
+        return 0;
+    if (ticos_atof(buf, len, &back) || back != v)
+        return 0;
+    if (!strchr(buf, '.') && !strchr(buf, 'e'))
+        return 1;
+    for (p = 1; p < 9; p++) {
+        snprintf(shortest, sizeof(shortest), "%.*g", p, v);
+        if (strtof(shortest, NULL) == v)
+            break;
+    }
+    m_longer += digits(buf) > p;
+    return 1;
+}
+
+static void test_ftoa(void)
+{
+    static const struct {
+        float v;
+        const char *s;
+    } cases[] = {
+        { 0.0f, "0" },
+        { 1.0f, "1" },
+        { -1.5f, "-1.5" },
+        { 22.4f, "22.4" },
+        { 0.1f, "0.1" },
+        { 3.14159f, "3.14159" },
+        { 100.0f, "100" },
+        { 16777216.0f, "16777216" },
+    };
+    static const float edges[] = { FLT_MIN, -FLT_MIN, FLT_MAX, -FLT_MAX, FLT_TRUE_MIN, FLT_EPSILON, 1e-10f, 1e10f,
+                                   1e38f, 123456789.0f, 0.3f, 2.0f / 3.0f, -0.0f, 8388607.5f, 1e-45f };
+    char buf[TICOS_NUMBER_MAX];
+    int ok = 1;
+
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        ticos_ftoa(cases[i].v, buf);
+        TICOS_CHECK_STR(buf, cases[i].s);
+    }
+    for (int i = 0; i < (int)(sizeof(edges) / sizeof(edges[0])); i++)
+        TICOS_CHECK(check_ftoa(edges[i]));
+
+    // 随机的位模式覆盖所有指数, 包括非规格化数
+    m_longer = 0;
+    for (int i = 0; i < RANDOM_CNT; i++) {
+        uint32_t bits = (uint32_t)next_random();
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        if (isnan(v) || isinf(v))
+            continue;
+        if (!check_ftoa(v)) {
+            printf("ftoa failed: %.9g\n", v);
+            ok = 0;
+            break;
+        }
+    }
+    TICOS_CHECK(ok);
+    TICOS_CHECK(m_longer < RANDOM_CNT / 1000);
+    // 所有指数的边界和其相邻的值: 最短表示在指数边界处上下间距不同
+    for (uint32_t e = 1; e < 255 && ok; e++) {
+        for (uint32_t bits = (e << 23) - 1; bits <= (e << 23) + 1; bits++) {
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            ok &= check_ftoa(v);
+        }
+    }
+    TICOS_CHECK(ok);
+}
+
+static int check_dtoa(double v)
+{
+    char buf[TICOS_NUMBER_MAX];
+    char shortest[TICOS_NUMBER_MAX];
+    double back;
+    int p;
+
+    int len = ticos_dtoa(v, buf);
+    if (len != (int)strlen(buf) || len >= TICOS_NUMBER_MAX)
+        return 0;
+    if (strtod(buf, NULL) != v)
+        return 0;
+    if (ticos_atod(buf, len, &back) || back != v)
+        return 0;
+    if (!strchr(buf, '.') && !strchr(buf, 'e'))
+        return 1;
+    for (p = 1; p < 17; p++) {
+        snprintf(shortest, sizeof(shortest), "%.*g", p, v);
+        if (strtod(shortest, NULL) == v)
+            break;
+    }
+    m_longer += digits(buf) > p;
+    return 1;
+}
+
+static void test_dtoa(void)
+{
+    static const double edges[] = { 0.0, 1.0, -1.0, 0.1, 0.3, 1e23, 5e-324, DBL_MIN, DBL_MAX, -DBL_MAX,
+                                    9007199254740993.0, 1.7976931348623157e308, 2.2250738585072009e-308,
+                                    123456789012345678.0, 1e-7, 1e21, 1e22 };
+    char buf[TICOS_NUMBER_MAX];
+    int ok = 1;
+
+    ticos_dtoa(0.1, buf);
+    TICOS_CHECK_STR(buf, "0.1");
+    ticos_dtoa(1e23, buf);
+    TICOS_CHECK(strtod(buf, NULL) == 1e23);
+    ticos_dtoa(-42.0, buf);
+    TICOS_CHECK_STR(buf, "-42");
+    for (int i = 0; i < (int)(sizeof(edges) / sizeof(edges[0])); i++)
+        TICOS_CHECK(check_dtoa(edges[i]));
+    m_longer = 0;
+    for (int i = 0; i < RANDOM_CNT; i++) {
+        uint64_t bits = next_random();
+        double v;
+        memcpy(&v, &bits, sizeof(v));
+        if (isnan(v) || isinf(v))
+            continue;
+        if (!check_dtoa(v)) {
+            printf("dtoa failed: %.17g\n", v);
+            ok = 0;
+            break;
+        }
+    }
+    TICOS_CHECK(ok);
+    TICOS_CHECK(m_longer < RANDOM_CNT / 1000);
+    printf("dtoa longer than shortest: %d\n", m_longer);
+}
+
+static void test_atoi(void)
+{
+    static const struct {
+        const char *s;
+        int ret;
+        int64_t v;
+    } cases[] = {
+        { "0", 0, 0 },
+        { "-0", 0, 0 },
+        { "123", 0, 123 },
+        { "-123", 0, -123 },
+        { "9223372036854775807", 0, INT64_MAX },
+        { "-9223372036854775808", 0, INT64_MIN },
+        { "9223372036854775808", -1, 0 },
+        { "-9223372036854775809", -1, 0 },
+        { "99999999999999999999", -1, 0 },
+        { "1.0", -1, 0 },
+        { "1e3", -1, 0 },
+        { "1E3", -1, 0 },
+        { "", -1, 0 },
+        { "-", -1, 0 },
+        { "+1", -1, 0 },
+        { "12a", -1, 0 },
+        { " 1", -1, 0 },
+    };
+    int64_t v;
+
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        v = 0;
+        int ret = ticos_atoi(cases[i].s, strlen(cases[i].s), &v);
+        ticos_test_check_int(ret, cases[i].ret, cases[i].s, __FILE__, __LINE__);
+        if (!ret)
+            ticos_test_check_int(v, cases[i].v, cases[i].s, __FILE__, __LINE__);
+    }
+    // 只解析给定长度的文本
+    TICOS_CHECK_INT(ticos_atoi("12345", 3, &v), 0);
+    TICOS_CHECK_INT(v, 123);
+}
+
+// 随机生成的数值文本, 有效数字位数和指数覆盖快速路径和慢速路径
+static int random_number(char *buf, int size)
+{
+    char mant[32];
+    int n = 1 + next_random() % 25;
+
+    for (int i = 0; i < n; i++)
+        mant[i] = '0' + next_random() % 10;
+    mant[n] = '\0';
+    int point = next_random() % n;
+    int exp = (int)(next_random() % 700) - 350;
+    const char *sign = next_random() & 1 ? "-" : "";
+    switch (next_random() % 4) {
+    case 0:
+        return snprintf(buf, size, "%s%s", sign, mant);
+    case 1:
+        return snprintf(buf, size, "%s%.*s.%s", sign, point ? point : 1, point ? mant : "0", mant + point);
+    case 2:
+        return snprintf(buf, size, "%s%.*s.%se%d", sign, point ? point : 1, point ? mant : "0", mant + point, exp % 45);
+    default:
+        return snprintf(buf, size, "%s%.*sE%+d", sign, point ? point : n, mant, exp);
+    }
+}
+
+static void test_atod(void)
+{
+    static const char *const invalid[] = { "", "-", ".5", "1.", "1e", "1e+", "--1", "1.2.3", "0x10", "inf", "nan", "1 " };
+    static const char *const hard[] = {
+        "1.00000005960464477539062499", "1.00000005960464477539062501", "1.000000059604644775390625",
+        "2.2250738585072011e-308", "2.2250738585072012e-308", "4.9406564584124654e-324", "1.7976931348623158e308",
+        "0.1", "3.4028235677973366e38", "3.4028235e38", "1.17549435e-38", "1.4e-45", "7.038531e-26",
+        "9007199254740993", "123456789012345678901234567890", "0.000000000000000000000000000001",
+    };
+    char buf[64];
+    double d;
+    float f;
+    int ok = 1;
+
+    for (int i = 0; i < (int)(sizeof(invalid) / sizeof(invalid[0])); i++) {
+        ticos_test_check(ticos_atod(invalid[i], strlen(invalid[i]), &d) != 0, invalid[i], __FILE__, __LINE__);
+        ticos_test_check(ticos_atof(invalid[i], strlen(invalid[i]), &f) != 0, invalid[i], __FILE__, __LINE__);
+    }
+    for (int i = 0; i < (int)(sizeof(hard) / sizeof(hard[0])); i++) {
+        int len = strlen(hard[i]);
+        ticos_test_check(!ticos_atod(hard[i], len, &d) && d == strtod(hard[i], NULL), hard[i], __FILE__, __LINE__);
+        ticos_test_check(!ticos_atof(hard[i], len, &f) && f == strtof(hard[i], NULL), hard[i], __FILE__, __LINE__);
+    }
+    for (int i = 0; i < RANDOM_CNT; i++) {
+        int len = random_number(buf, sizeof(buf));
+        double de = strtod(buf, NULL);
+        float fe = strtof(buf, NULL);
+        if (ticos_atod(buf, len, &d) || memcmp(&d, &de, sizeof(d)) ||
+            ticos_atof(buf, len, &f) || memcmp(&f, &fe, sizeof(f))) {
+            printf("atod failed: %s\n", buf);
+            ok = 0;
+            break;
+        }
+    }
+    TICOS_CHECK(ok);
+}
+
+static int m_int;
+static float m_float;
+
+static int int_recv(int v) { m_int = v; return 0; }
+static int float_recv(float v) { m_float = v; return 0; }
+static int int_send(void) { return m_int; }
+static float float_send(void) { return m_float; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "i", TICOS_VAL_TYPE_INTEGER, int_send, int_recv },
+    { "f", TICOS_VAL_TYPE_FLOAT, float_send, float_recv },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static void desired(const char *data)
+{
+    ticos_msg_recv("devices/D/twin/desired", data, strlen(data));
+}
+
+// 下发的数值超出字段类型的范围时取最接近的值, 上报的文本与下发的值一致
+static void test_receive(void)
+{
+    ticos_test_connect();
+    desired("{\"i\":2147483647}");
+    TICOS_CHECK_INT(m_int, INT_MAX);
+    desired("{\"i\":3000000000}");
+    TICOS_CHECK_INT(m_int, INT_MAX);
+    desired("{\"i\":-3000000000}");
+    TICOS_CHECK_INT(m_int, INT_MIN);
+    desired("{\"i\":99999999999999999999}");
+    TICOS_CHECK_INT(m_int, INT_MAX);
+    desired("{\"i\":-1e20}");
+    TICOS_CHECK_INT(m_int, INT_MIN);
+    desired("{\"i\":2.9}");
+    TICOS_CHECK_INT(m_int, 2);
+    desired("{\"i\":1e3}");
+    TICOS_CHECK_INT(m_int, 1000);
+
+    desired("{\"f\":22.4}");
+    TICOS_CHECK(m_float == 22.4f);
+    desired("{\"f\":1e39}");
+    TICOS_CHECK(m_float == FLT_MAX);
+    desired("{\"f\":-1e39}");
+    TICOS_CHECK(m_float == -FLT_MAX);
+    desired("{\"f\":1e-50}");
+    TICOS_CHECK(m_float == 0.0f);
+    desired("{\"f\":7}");
+    TICOS_CHECK(m_float == 7.0f);
+
+    m_float = 22.4f;
+    m_int = -5;
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"i\":-5,\"f\":22.4}");
+}
+
+int main(void)
+{
+    test_itoa();
+    test_ftoa();
+    test_dtoa();
+    test_atoi();
+    test_atod();
+    test_receive();
+    return ticos_test_result();
+}
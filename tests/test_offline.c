@@ -0,0 +1,178 @@
+/*
+ * 离线队列: 离线和发布失败的消息按顺序排队, 连接后按令牌桶限速重发; 内存队列满时丢弃最早的消息, 文件日志可跨重启恢复
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_op.h"
+#include <stdio.h>
+#include <unistd.h>
+
+#define LOG_PATH "test_offline.log"
+
+static int publish(int seq)
+{
+    char data[32];
+    int len = snprintf(data, sizeof(data), "{\"seq\":%d}", seq);
+    return ticos_publish("t", data, len, 1, 0);
+}
+
+// 最近 count 条消息的序号从 first 开始连续递增
+static void check_sequence(int count, int first)
+{
+    for (int i = 0; i < count; i++) {
+        const ticos_test_msg_t *msg = ticos_test_msg(count - 1 - i);
+        char expect[32];
+        snprintf(expect, sizeof(expect), "{\"seq\":%d}", first + i);
+        TICOS_CHECK_STR(msg->data, expect);
+        TICOS_CHECK_STR(msg->topic, "t");
+        TICOS_CHECK_INT(msg->qos, 1);
+    }
+}
+
+static void drain(void)
+{
+    ticos_offline_set_rate(0);
+    ticos_offline_poll();
+    ticos_offline_set_rate(TICOS_OFFLINE_REPLAY_RATE);
+    ticos_test_reset();
+}
+
+// 离线期间的消息在连接后按顺序重发, 未重发完时新消息排在后面
+static void test_order(void)
+{
+    ticos_offline_set_rate(0);
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    for (int i = 0; i < 5; i++)
+        TICOS_CHECK_INT(publish(i), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 5);
+
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 5);
+    check_sequence(5, 0);
+
+    // 已连接但发布失败的消息也进入队列, 之后的消息排在它后面
+    ticos_test_reset();
+    ticos_test_publish_fail(1);
+    TICOS_CHECK_INT(publish(5), 0);
+    ticos_test_publish_fail(0);
+    TICOS_CHECK_INT(publish(6), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    check_sequence(2, 5);
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+    ticos_offline_set_rate(TICOS_OFFLINE_REPLAY_RATE);
+}
+
+// 令牌桶: 连接时允许一条, 之后按速率补充, 突发量不超过 100ms 的配额
+static void test_rate(void)
+{
+    ticos_test_reset();
+    ticos_offline_set_rate(100);
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    for (int i = 0; i < 40; i++)
+        TICOS_CHECK_INT(publish(i), 0);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK_INT(ticos_offline_poll(), 0);
+
+    usleep(50 * 1000);
+    int sent = ticos_offline_poll();
+    TICOS_CHECK(sent >= 4 && sent <= 10);
+    // 长时间未重发后的突发量受限: 100 条/秒 * 100ms
+    usleep(300 * 1000);
+    sent = ticos_offline_poll();
+    TICOS_CHECK_INT(sent, 10);
+    TICOS_CHECK_INT(ticos_offline_pending(), 40 - ticos_test_count());
+    drain();
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+}
+
+// 内存队列满时丢弃最早的消息, 超出单条消息上限的消息被拒绝
+static void test_overflow(void)
+{
+    static char big[TICOS_OFFLINE_MSG_MAX + 2];
+
+    ticos_test_reset();
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    for (int i = 0; i < 1000; i++)
+        TICOS_CHECK_INT(publish(i), 0);
+    int pending = ticos_offline_pending();
+    TICOS_CHECK(pending > 10 && pending < 1000);
+
+    memset(big, 'x', sizeof(big));
+    TICOS_CHECK(ticos_publish("t", big, sizeof(big), 1, 0) < 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), pending);
+
+    ticos_offline_set_rate(0);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_test_count(), pending);
+    // 桩函数只保留最近的消息
+    int kept = pending < TICOS_TEST_MSGS ? pending : TICOS_TEST_MSGS;
+    check_sequence(kept, 1000 - kept);
+    ticos_offline_set_rate(TICOS_OFFLINE_REPLAY_RATE);
+}
+
+// 文件日志: 重新打开后继续重发, 写了一半的记录被截断, 日志满时拒绝新消息
+static void test_log(void)
+{
+    ticos_test_reset();
+    remove(LOG_PATH);
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    TICOS_CHECK_INT(ticos_offline_set_log(LOG_PATH, 0), 0);
+    for (int i = 0; i < 3; i++)
+        TICOS_CHECK_INT(publish(i), 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 3);
+
+    // 模拟掉电: 日志末尾写入不完整的记录
+    ticos_offline_set_log(NULL, 0);
+    FILE *f = fopen(LOG_PATH, "ab");
+    TICOS_CHECK(f != NULL);
+    if (f) {
+        unsigned char partial[] = { 40, 0, 0, 0, 1, 0 };
+        fwrite(partial, 1, sizeof(partial), f);
+        fclose(f);
+    }
+    TICOS_CHECK_INT(ticos_offline_set_log(LOG_PATH, 0), 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 3);
+
+    // 重发一条后重新打开, 从下一条继续
+    ticos_offline_set_rate(100);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    ticos_offline_set_log(NULL, 0);
+    TICOS_CHECK_INT(ticos_offline_set_log(LOG_PATH, 0), 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 2);
+    ticos_offline_set_rate(0);
+    ticos_offline_poll();
+    TICOS_CHECK_INT(ticos_test_count(), 3);
+    check_sequence(3, 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+
+    // 新消息在日志已满时被拒绝: 文件头 8 字节, 每条记录 18 字节
+    ticos_test_reset();
+    ticos_offline_set_log(NULL, 0);
+    TICOS_CHECK_INT(ticos_offline_set_log(LOG_PATH, 50), 0);
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    TICOS_CHECK_INT(publish(0), 0);
+    TICOS_CHECK_INT(publish(1), 0);
+    TICOS_CHECK(publish(2) < 0);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    check_sequence(2, 0);
+
+    ticos_offline_set_log(NULL, 0);
+    remove(LOG_PATH);
+    ticos_offline_set_rate(TICOS_OFFLINE_REPLAY_RATE);
+}
+
+int main(void)
+{
+    ticos_test_connect();
+    test_order();
+    test_rate();
+    test_overflow();
+    test_log();
+    return ticos_test_result();
+}
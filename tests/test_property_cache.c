@@ -0,0 +1,161 @@
+/*
+ * 属性增量上报: 只上报与最近一次成功上报不同的值, 发布失败或重新连接后重新上报
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include <stdio.h>
+
+#define PROP_CNT (TICOS_PROPERTY_CACHE_SIZE + 1)
+
+static int m_int = 1;
+static float m_float = 1.5f;
+static char m_str[16] = "abc";
+static int m_extra[PROP_CNT];
+
+static int get_int(void) { return m_int; }
+static float get_float(void) { return m_float; }
+static const char *get_str(void) { return m_str; }
+
+#define EXTRA(n) static int get_extra##n(void) { return m_extra[n]; }
+EXTRA(3) EXTRA(4) EXTRA(5) EXTRA(6) EXTRA(7) EXTRA(8) EXTRA(9) EXTRA(10) EXTRA(11) EXTRA(12) EXTRA(13) EXTRA(14) EXTRA(15)
+EXTRA(16) EXTRA(17) EXTRA(18) EXTRA(19) EXTRA(20) EXTRA(21) EXTRA(22) EXTRA(23) EXTRA(24) EXTRA(25) EXTRA(26) EXTRA(27)
+EXTRA(28) EXTRA(29) EXTRA(30) EXTRA(31) EXTRA(32)
+
+#define PROP(n) { "p" #n, TICOS_VAL_TYPE_INTEGER, get_extra##n, NULL }
+
+// 最后一个属性的下标超出缓存的范围, 每次都上报
+const ticos_property_info_t ticos_property_tab[] = {
+    { "i", TICOS_VAL_TYPE_INTEGER, get_int, NULL },
+    { "f", TICOS_VAL_TYPE_FLOAT, get_float, NULL },
+    { "s", TICOS_VAL_TYPE_STRING, get_str, NULL },
+    PROP(3), PROP(4), PROP(5), PROP(6), PROP(7), PROP(8), PROP(9), PROP(10), PROP(11), PROP(12), PROP(13), PROP(14),
+    PROP(15), PROP(16), PROP(17), PROP(18), PROP(19), PROP(20), PROP(21), PROP(22), PROP(23), PROP(24), PROP(25),
+    PROP(26), PROP(27), PROP(28), PROP(29), PROP(30), PROP(31), PROP(32),
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static void test_delta(void)
+{
+    TICOS_CHECK_INT(ticos_property_cnt, PROP_CNT);
+    // 不经过 ticos_test_connect(), 其中的 ticos_report_poll() 会先发出全量上报
+    ticos_cloud_start("P", "D", "S");
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_test_reset();
+
+    // 连接后的第一次上报是全量上报
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"i\":1,\"f\":1.5,\"s\":\"abc\",\"p3\":0") != NULL);
+
+    // 没有变化时只有超出缓存范围的属性
+    ticos_test_reset();
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"p32\":0}");
+
+    m_int = 2;
+    m_extra[31] = 7;
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"i\":2,\"p31\":7,\"p32\":0}");
+
+    // 长度相同的字符串也能发现变化
+    snprintf(m_str, sizeof(m_str), "abd");
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"s\":\"abd\",\"p32\":0}");
+    snprintf(m_str, sizeof(m_str), "abdd");
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"s\":\"abdd\",\"p32\":0}");
+
+    // 浮点数按位比较, 微小的变化也会上报
+    m_float = 1.5000001f;
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK(strncmp(ticos_test_last(), "{\"f\":1.5", 8) == 0);
+}
+
+static void test_invalidate(void)
+{
+    // 全量上报也更新缓存
+    m_int = 3;
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"i\":3") != NULL);
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"p32\":0}");
+
+    // 单个属性上报也更新缓存
+    m_int = 4;
+    TICOS_CHECK(ticos_property_report_by_index(0) >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"i\":4}");
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"p32\":0}");
+
+    // 发布失败的消息进入离线队列, 由队列负责重发, 值算作已上报
+    m_int = 5;
+    ticos_test_publish_fail(1);
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 1);
+
+    // 离线日志满时发布失败, 值不算已上报
+    int n = 0;
+    ticos_offline_set_rate(0);
+    ticos_test_publish_fail(0);
+    ticos_offline_poll();
+    remove("test_property_cache.log");
+    TICOS_CHECK_INT(ticos_offline_set_log("test_property_cache.log", 1024), 0);
+    ticos_test_publish_fail(1);
+    m_int = 6;
+    while (ticos_property_report() >= 0 && n < 100)
+        n++;
+    TICOS_CHECK(n > 0 && n < 100);
+    ticos_test_publish_fail(0);
+    ticos_offline_poll();
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+    ticos_offline_set_log(NULL, 0);
+    remove("test_property_cache.log");
+    ticos_offline_set_rate(TICOS_OFFLINE_REPLAY_RATE);
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK(strstr(ticos_test_last(), "{\"i\":6,\"f\":") == ticos_test_last());
+
+    // 重新连接后全量上报
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_test_reset();
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK(strstr(ticos_test_last(), "{\"i\":6,\"f\":") == ticos_test_last());
+    TICOS_CHECK(strstr(ticos_test_last(), "\"p31\":7") != NULL);
+}
+
+// 重新连接后应用不调用上报接口, ticos_report_poll() 也会全量上报一次; 连接断开后不再发出
+static void test_resync(void)
+{
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_report_next_ms(), 0);
+    TICOS_CHECK_INT(ticos_report_poll(), 1);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/twin/reported");
+    TICOS_CHECK(strstr(ticos_test_last(), "{\"i\":6,\"f\":") == ticos_test_last());
+    TICOS_CHECK(strstr(ticos_test_last(), "\"p31\":7,\"p32\":0}") != NULL);
+    TICOS_CHECK_INT(ticos_report_poll(), 0);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+
+    // 全量上报已更新缓存, 之后的变化上报只有变化的属性
+    m_int = 7;
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"i\":7,\"p32\":0}");
+
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_event_notify(TICOS_EVENT_DISCONNECT);
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_report_poll(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+}
+
+int main(void)
+{
+    test_delta();
+    test_invalidate();
+    test_resync();
+    return ticos_test_result();
+}
@@ -0,0 +1,229 @@
+/*
+ * 无锁队列和发送线程: 绕回、队列满时拒绝、多生产者并发入队不丢失不重复, 发送线程按入队顺序上报
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_config.h"
+#include "ticos_queue.h"
+#include "ticos_thingmodel_type.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define PRODUCERS   4
+#define PER_PRODUCER 20000
+
+static int m_a = 1;
+static int m_b = 2;
+
+static int get_a(void) { return m_a; }
+static int get_b(void) { return m_b; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "a", TICOS_VAL_TYPE_INTEGER, get_a, NULL },
+    { "b", TICOS_VAL_TYPE_INTEGER, get_b, NULL },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "t", TICOS_VAL_TYPE_INTEGER, get_a },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+static uint64_t m_buf[TICOS_QUEUE_BUF_SIZE(1024, sizeof(uint32_t)) / 8];
+static ticos_queue_t m_queue;
+
+static void test_init(void)
+{
+    TICOS_CHECK_INT(ticos_queue_init(&m_queue, m_buf, 0, sizeof(uint32_t)), -1);
+    TICOS_CHECK_INT(ticos_queue_init(&m_queue, m_buf, 3, sizeof(uint32_t)), -1);
+    TICOS_CHECK_INT(ticos_queue_init(&m_queue, m_buf, 1, sizeof(uint32_t)), 0);
+    TICOS_CHECK_INT(TICOS_QUEUE_STRIDE(1) % 8, 0);
+    TICOS_CHECK_INT(TICOS_QUEUE_STRIDE(12), 24);
+}
+
+// 队列满时入队立即失败, 序号多次绕回后仍按先进先出
+static void test_wrap(void)
+{
+    uint32_t v;
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    int ok = 1;
+
+    TICOS_CHECK_INT(ticos_queue_init(&m_queue, m_buf, 8, sizeof(uint32_t)), 0);
+    TICOS_CHECK(ticos_queue_empty(&m_queue));
+    TICOS_CHECK_INT(ticos_queue_pop(&m_queue, &v), -1);
+    for (; next_in < 8; next_in++)
+        TICOS_CHECK_INT(ticos_queue_push(&m_queue, &next_in), 0);
+    TICOS_CHECK_INT(ticos_queue_push(&m_queue, &next_in), -1);
+    TICOS_CHECK_INT(ticos_queue_count(&m_queue), 8);
+    TICOS_CHECK(!ticos_queue_empty(&m_queue));
+
+    // 每轮入队和出队的个数不同, 使读写位置落在单元格的各个位置
+    for (int round = 0; round < 1000; round++) {
+        int pops = 1 + round % 8;
+        for (int i = 0; i < pops && !ticos_queue_pop(&m_queue, &v); i++)
+            ok &= v == next_out++;
+        while (!ticos_queue_push(&m_queue, &next_in))
+            next_in++;
+        ok &= ticos_queue_count(&m_queue) == 8;
+    }
+    TICOS_CHECK(ok);
+    while (!ticos_queue_pop(&m_queue, &v))
+        ok &= v == next_out++;
+    TICOS_CHECK(ok);
+    TICOS_CHECK_INT(next_out, next_in);
+    TICOS_CHECK(ticos_queue_empty(&m_queue));
+    TICOS_CHECK_INT(ticos_queue_count(&m_queue), 0);
+}
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t seq = 0; seq < PER_PRODUCER; seq++) {
+        uint32_t v = id << 24 | seq;
+        while (ticos_queue_push(&m_queue, &v))
+            sched_yield();
+    }
+    return NULL;
+}
+
+// 多个生产者并发入队: 每个元素恰好出队一次, 同一生产者的元素保持顺序
+static void test_producers(void)
+{
+    pthread_t threads[PRODUCERS];
+    uint32_t next[PRODUCERS] = { 0 };
+    uint32_t v;
+    int received = 0;
+    int ok = 1;
+
+    TICOS_CHECK_INT(ticos_queue_init(&m_queue, m_buf, 64, sizeof(uint32_t)), 0);
+    for (uintptr_t i = 0; i < PRODUCERS; i++)
+        pthread_create(&threads[i], NULL, producer, (void *)i);
+    while (received < PRODUCERS * PER_PRODUCER) {
+        if (ticos_queue_pop(&m_queue, &v)) {
+            sched_yield();
+            continue;
+        }
+        uint32_t id = v >> 24;
+        ok &= id < PRODUCERS && (v & 0xffffff) == next[id];
+        if (id < PRODUCERS)
+            next[id]++;
+        received++;
+    }
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    TICOS_CHECK(ok);
+    TICOS_CHECK(ticos_queue_empty(&m_queue));
+    for (int i = 0; i < PRODUCERS; i++)
+        TICOS_CHECK_INT(next[i], PER_PRODUCER);
+}
+
+static int wait_count(int count)
+{
+    for (int i = 0; i < 2000 && ticos_test_count() < count; i++)
+        usleep(1000);
+    return ticos_test_count() >= count;
+}
+
+// 发送线程未启动时请求保留在队列中, 队列满时返回 TICOS_SEND_FULL, 启动后按入队顺序发送
+static void test_sender(void)
+{
+    ticos_test_connect();
+    TICOS_CHECK_INT(ticos_send_pending(), 0);
+    TICOS_CHECK_INT(ticos_property_report_by_index_async(2), TICOS_SEND_ERROR);
+    TICOS_CHECK_INT(ticos_property_report_by_index_async(-1), TICOS_SEND_ERROR);
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index_async(1), TICOS_SEND_ERROR);
+
+    for (int i = 0; i < TICOS_SEND_QUEUE_SIZE; i++)
+        TICOS_CHECK_INT(ticos_property_report_by_index_async(i & 1), TICOS_SEND_OK);
+    TICOS_CHECK_INT(ticos_property_report_async(), TICOS_SEND_FULL);
+    TICOS_CHECK_INT(ticos_send_pending(), TICOS_SEND_QUEUE_SIZE);
+    usleep(10000);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+
+    TICOS_CHECK_INT(ticos_sender_start(), 0);
+    TICOS_CHECK_INT(ticos_sender_start(), 0);
+    TICOS_CHECK(wait_count(TICOS_SEND_QUEUE_SIZE));
+    TICOS_CHECK_INT(ticos_send_pending(), 0);
+    int ok = 1;
+    for (int i = 0; i < TICOS_SEND_QUEUE_SIZE && i < TICOS_TEST_MSGS; i++) {
+        const ticos_test_msg_t *msg = ticos_test_msg(TICOS_SEND_QUEUE_SIZE - 1 - i);
+        ok &= msg && !strcmp(msg->data, i & 1 ? "{\"b\":2}" : "{\"a\":1}");
+    }
+    TICOS_CHECK(ok);
+
+    // 处理请求时才读取字段的值
+    ticos_test_reset();
+    m_a = 5;
+    TICOS_CHECK_INT(ticos_telemetry_report_async(), TICOS_SEND_OK);
+    TICOS_CHECK(wait_count(1));
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t\":5}");
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/telemetry");
+
+    // 变化上报只发送改变的字段
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_property_report_async(), TICOS_SEND_OK);
+    TICOS_CHECK(wait_count(1));
+    m_b = 3;
+    TICOS_CHECK_INT(ticos_property_report_changed_async(), TICOS_SEND_OK);
+    TICOS_CHECK(wait_count(2));
+    TICOS_CHECK_STR(ticos_test_last(), "{\"b\":3}");
+}
+
+static void *reporter(void *arg)
+{
+    int *full = arg;
+
+    for (int i = 0; i < 500; i++) {
+        while (ticos_telemetry_report_async() == TICOS_SEND_FULL) {
+            __atomic_add_fetch(full, 1, __ATOMIC_RELAXED);
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// 多个线程并发请求上报, 队列满时重试, 每个入队的请求都被发送
+static void test_concurrent(void)
+{
+    pthread_t threads[PRODUCERS];
+    int full = 0;
+
+    ticos_test_reset();
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_create(&threads[i], NULL, reporter, &full);
+    for (int i = 0; i < PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    // 停止时先发送完已入队的请求
+    ticos_sender_stop();
+    TICOS_CHECK_INT(ticos_send_pending(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), PRODUCERS * 500);
+    printf("send queue full %d times\n", full);
+
+    // 停止后请求留在队列中, 设备停止后请求被丢弃
+    ticos_test_reset();
+    TICOS_CHECK_INT(ticos_telemetry_report_async(), TICOS_SEND_OK);
+    TICOS_CHECK_INT(ticos_send_pending(), 1);
+    ticos_cloud_stop();
+    TICOS_CHECK_INT(ticos_sender_start(), 0);
+    for (int i = 0; i < 100 && ticos_send_pending(); i++)
+        usleep(1000);
+    ticos_sender_stop();
+    TICOS_CHECK_INT(ticos_send_pending(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+}
+
+int main(void)
+{
+    test_init();
+    test_wrap();
+    test_producers();
+    test_sender();
+    test_concurrent();
+    return ticos_test_result();
+}
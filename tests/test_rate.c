@@ -0,0 +1,170 @@
+/*
+ * 上报合并和速率限制: 窗口内的请求合并为一条含所有涉及字段的消息, 令牌不足时推迟而不丢失, 突发量有上限
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_thingmodel_type.h"
+#include "ticos_time.h"
+#include <unistd.h>
+
+static int m_v[3] = { 1, 2, 3 };
+
+static int get_0(void) { return m_v[0]; }
+static int get_1(void) { return m_v[1]; }
+static int get_2(void) { return m_v[2]; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "a", TICOS_VAL_TYPE_INTEGER, get_0, NULL },
+    { "b", TICOS_VAL_TYPE_INTEGER, get_1, NULL },
+    { "c", TICOS_VAL_TYPE_INTEGER, get_2, NULL },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "t0", TICOS_VAL_TYPE_INTEGER, get_0 },
+    { "t1", TICOS_VAL_TYPE_INTEGER, get_1 },
+    { "t2", TICOS_VAL_TYPE_INTEGER, get_2 },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+// 轮询直到发出一条推迟的上报
+static int poll_until_sent(int timeout_ms)
+{
+    int64_t end = ticos_uptime_ms() + timeout_ms;
+
+    while (ticos_uptime_ms() < end) {
+        int n = ticos_report_poll();
+        if (n)
+            return n;
+        usleep(1000);
+    }
+    return 0;
+}
+
+static void test_window(void)
+{
+    ticos_test_connect();
+    ticos_set_report_window(100);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+
+    // 窗口外的第一次请求立即发送
+    TICOS_CHECK(ticos_telemetry_report_by_index(1) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t1\":2}");
+
+    // 窗口内的请求被合并, 发送时包含所有涉及的字段, 取发送时的值
+    int64_t start = ticos_uptime_ms();
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index(0), 0);
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index(2), 0);
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index(0), 0);
+    m_v[2] = 30;
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    int next = ticos_report_next_ms();
+    TICOS_CHECK(next > 0 && next <= 100);
+    TICOS_CHECK_INT(ticos_report_poll(), 0);
+    TICOS_CHECK_INT(poll_until_sent(1000), 1);
+    TICOS_CHECK(ticos_uptime_ms() - start >= 90);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t0\":1,\"t2\":30}");
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+
+    // 发送后重新开始窗口; 全量请求与单个字段合并为全量上报
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index(1), 0);
+    TICOS_CHECK_INT(ticos_telemetry_report(), 0);
+    TICOS_CHECK_INT(poll_until_sent(1000), 1);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t0\":1,\"t1\":2,\"t2\":30}");
+
+    // 属性和遥测分别合并, 变化上报与单个字段合并
+    ticos_test_reset();
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    m_v[1] = 20;
+    TICOS_CHECK_INT(ticos_property_report_changed(), 0);
+    TICOS_CHECK_INT(ticos_property_report_by_index(0), 0);
+    TICOS_CHECK_INT(poll_until_sent(1000), 1);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"a\":1,\"b\":20}");
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/twin/reported");
+
+    // 关闭窗口后立即发送
+    ticos_set_report_window(0);
+    ticos_test_reset();
+    TICOS_CHECK(ticos_telemetry_report_by_index(0) >= 0);
+    TICOS_CHECK(ticos_telemetry_report_by_index(0) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+}
+
+static void test_msgs(void)
+{
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_CLASS_MAX, 1, 0, 0, 0), -1);
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_TELEMETRY, -1, 0, 0, 0), -1);
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_TELEMETRY, 20, 0, 2, 0), 0);
+
+    // 突发量内立即发送, 之后推迟到令牌补充
+    ticos_test_reset();
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_INT(ticos_telemetry_report(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    int next = ticos_report_next_ms();
+    TICOS_CHECK(next > 0 && next <= 50);
+
+    // 其他类别不受限制
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 5);
+
+    TICOS_CHECK_INT(poll_until_sent(1000), 1);
+    TICOS_CHECK_INT(ticos_test_count(), 6);
+
+    // 持续的请求按速率发出, 最后一次请求的值不会丢失
+    ticos_test_reset();
+    int64_t start = ticos_uptime_ms();
+    for (int i = 0; i < 300; i++) {
+        m_v[0] = i;
+        ticos_telemetry_report_by_index(0);
+        ticos_report_poll();
+        usleep(1000);
+    }
+    int64_t elapsed = ticos_uptime_ms() - start;
+    TICOS_CHECK(poll_until_sent(1000) <= 1);
+    int sent = ticos_test_count();
+    TICOS_CHECK(sent <= 2 + (elapsed + 100) * 20 / 1000 + 1);
+    TICOS_CHECK(sent >= elapsed * 20 / 1000 / 2);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"t0\":299}");
+
+    // 取消限制后立即发送
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_TELEMETRY, 0, 0, 0, 0), 0);
+    ticos_test_reset();
+    for (int i = 0; i < 5; i++)
+        TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 5);
+}
+
+// 字节数允许透支: 余额为正时可以发送, 透支后等待余额恢复
+static void test_bytes(void)
+{
+    const char *expect = "{\"a\":299,\"b\":20,\"c\":30}";
+    int len = strlen(expect);
+
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_PROPERTY, 0, len * 10, 0, len + len / 2), 0);
+    ticos_test_reset();
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), expect);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_INT(ticos_property_report(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    int next = ticos_report_next_ms();
+    TICOS_CHECK(next > 0 && next <= 100);
+    TICOS_CHECK_INT(poll_until_sent(1000), 1);
+    TICOS_CHECK_INT(ticos_test_count(), 3);
+    TICOS_CHECK_INT(ticos_set_rate_limit(TICOS_TOPIC_PROPERTY, 0, 0, 0, 0), 0);
+}
+
+int main(void)
+{
+    test_window();
+    test_msgs();
+    test_bytes();
+    return ticos_test_result();
+}
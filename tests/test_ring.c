@@ -0,0 +1,99 @@
+/*
+ * 记录环形缓存: 跨越缓存末尾的记录读写, 空间不足时丢弃最早的记录, 超出容量的记录被拒绝
+ */
+#include "ticos_test.h"
+#include "ticos_ring.h"
+#include <stdio.h>
+
+// 缓存大小不是记录长度的整数倍, 记录头和内容都会在不同位置跨越末尾
+#define RING_SIZE 61
+
+static unsigned char m_buf[RING_SIZE + 8];
+
+static void check_record(const ticos_ring_t *r, int pos, int seq, int len)
+{
+    unsigned char hdr, data[64];
+
+    TICOS_CHECK_INT(ticos_ring_len(r, pos), len + 1);
+    ticos_ring_read(r, pos, 0, &hdr, 1);
+    TICOS_CHECK_INT(hdr, seq & 0xff);
+    ticos_ring_read(r, pos, 1, data, len);
+    for (int i = 0; i < len; i++)
+        TICOS_CHECK_INT(data[i], (seq + i) & 0xff);
+    // 从记录内容中间开始读取
+    if (len > 2) {
+        ticos_ring_read(r, pos, 3, data, len - 2);
+        TICOS_CHECK_INT(data[0], (seq + 2) & 0xff);
+    }
+}
+
+static int push(ticos_ring_t *r, int seq, int len)
+{
+    unsigned char hdr = seq, data[64];
+    for (int i = 0; i < len; i++)
+        data[i] = seq + i;
+    return ticos_ring_push(r, &hdr, 1, data, len);
+}
+
+static void test_wrap(void)
+{
+    ticos_ring_t r;
+    int first = 0;
+
+    memset(m_buf, 0xAA, sizeof(m_buf));
+    ticos_ring_init(&r, m_buf, RING_SIZE);
+    // 记录长度在 0 到 12 之间变化, 反复绕过缓存末尾
+    for (int seq = 0; seq < 1000; seq++) {
+        int len = seq % 13;
+        int dropped = push(&r, seq, len);
+        TICOS_CHECK(dropped >= 0);
+        first += dropped;
+        TICOS_CHECK(r.used <= RING_SIZE);
+        TICOS_CHECK_INT(r.count, seq + 1 - first);
+
+        int pos = ticos_ring_first(&r);
+        for (int i = first; i <= seq; i++) {
+            check_record(&r, pos, i, i % 13);
+            pos = ticos_ring_next(&r, pos);
+        }
+        // 缓存之后的字节不被改写
+        for (int i = RING_SIZE; i < (int)sizeof(m_buf); i++)
+            TICOS_CHECK_INT(m_buf[i], 0xAA);
+        // 丢弃最早的记录后剩余空间能容纳新记录
+        TICOS_CHECK(RING_SIZE - r.used >= 0);
+    }
+}
+
+static void test_limits(void)
+{
+    ticos_ring_t r;
+
+    ticos_ring_init(&r, m_buf, RING_SIZE);
+    // 刚好占满整个缓存的记录
+    TICOS_CHECK_INT(push(&r, 1, RING_SIZE - TICOS_RING_HDR_SIZE - 1), 0);
+    TICOS_CHECK_INT(r.used, RING_SIZE);
+    // 新记录挤出唯一的记录
+    TICOS_CHECK_INT(push(&r, 2, 3), 1);
+    TICOS_CHECK_INT(r.count, 1);
+    check_record(&r, ticos_ring_first(&r), 2, 3);
+
+    // 超出容量的记录被拒绝, 原有记录保留
+    TICOS_CHECK_INT(push(&r, 3, RING_SIZE - TICOS_RING_HDR_SIZE), -1);
+    TICOS_CHECK_INT(r.count, 1);
+    check_record(&r, ticos_ring_first(&r), 2, 3);
+
+    ticos_ring_pop(&r);
+    TICOS_CHECK_INT(r.count, 0);
+    TICOS_CHECK_INT(r.used, 0);
+    // 空缓存上的 pop 无效果
+    ticos_ring_pop(&r);
+    TICOS_CHECK_INT(r.count, 0);
+    TICOS_CHECK_INT(r.used, 0);
+}
+
+int main(void)
+{
+    test_wrap();
+    test_limits();
+    return ticos_test_result();
+}
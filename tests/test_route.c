@@ -0,0 +1,206 @@
+/*
+ * topic 路由表: 精确匹配优先, 通配符按 MQTT 规则匹配, 桶数随路由数量增长, 移除后不再分发
+ */
+#include "ticos_test.h"
+#include "ticos_config.h"
+#include "ticos_route.h"
+#include <stdio.h>
+
+#define ROUTE_CNT (TICOS_ROUTE_BUCKETS * 40)
+
+static ticos_route_t m_routes[ROUTE_CNT];
+static char m_topics[ROUTE_CNT][40];
+static void *m_user;
+static char m_topic[64];
+static char m_data[64];
+static int m_calls;
+
+static void on_msg(void *user, const char *topic, int topic_len, const char *dat, int len)
+{
+    m_user = user;
+    snprintf(m_topic, sizeof(m_topic), "%.*s", topic_len, topic);
+    snprintf(m_data, sizeof(m_data), "%.*s", len, dat);
+    m_calls++;
+}
+
+// 处理函数中移除自身的路由
+static void on_msg_remove(void *user, const char *topic, int topic_len, const char *dat, int len)
+{
+    ticos_route_remove(user);
+    m_calls++;
+}
+
+static int match(const char *filter, const char *topic)
+{
+    return ticos_topic_match(filter, strlen(filter), topic, strlen(topic));
+}
+
+// 分发到的路由的用户数据, 没有匹配的路由时为 NULL
+static void *dispatch(const char *topic)
+{
+    m_user = NULL;
+    int ret = ticos_route_dispatch(topic, strlen(topic), "x", 1);
+    TICOS_CHECK_INT(ret, m_user != NULL);
+    return m_user;
+}
+
+static void test_match(void)
+{
+    TICOS_CHECK(match("a/b", "a/b"));
+    TICOS_CHECK(!match("a/b", "a/bc"));
+    TICOS_CHECK(!match("a/bc", "a/b"));
+    TICOS_CHECK(!match("a/b", "a/b/"));
+    TICOS_CHECK(match("devices/+/commands/request", "devices/D/commands/request"));
+    TICOS_CHECK(match("devices/+/commands/request", "devices/long-device-id/commands/request"));
+    TICOS_CHECK(!match("devices/+/commands/request", "devices/D/x/commands/request"));
+    TICOS_CHECK(!match("devices/+/commands/request", "devices/D/commands/requests"));
+    TICOS_CHECK(!match("devices/+/commands/request", "devices/D/commands"));
+    // '+' 匹配一整级, 可以为空
+    TICOS_CHECK(match("a/+/b", "a//b"));
+    TICOS_CHECK(match("a/+", "a/"));
+    TICOS_CHECK(!match("a/+", "a"));
+    TICOS_CHECK(!match("a/+", "a/b/c"));
+    TICOS_CHECK(match("+", "abc"));
+    TICOS_CHECK(!match("+", "a/b"));
+    TICOS_CHECK(match("+/+", "/"));
+    TICOS_CHECK(match("+/b", "a/b"));
+    // '#' 匹配其余所有级, 包括父级本身
+    TICOS_CHECK(match("#", "a/b/c"));
+    TICOS_CHECK(match("a/#", "a"));
+    TICOS_CHECK(match("a/#", "a/"));
+    TICOS_CHECK(match("a/#", "a/b/c"));
+    TICOS_CHECK(!match("a/#", "ab"));
+    TICOS_CHECK(!match("a/#", "b/a"));
+    TICOS_CHECK(match("a/+/#", "a/b"));
+    TICOS_CHECK(!match("a/+/#", "a"));
+
+    // topic 和过滤器都不要求以 '\0' 结尾
+    TICOS_CHECK(ticos_topic_match("a/b/c", 3, "a/bxyz", 3));
+    TICOS_CHECK(!ticos_topic_match("a/+", 3, "a/b/c", 5));
+    TICOS_CHECK(ticos_topic_match("a/+", 3, "a/b/c", 3));
+}
+
+// 通配符不独占一级的过滤器和空 topic 被拒绝
+static void test_invalid(void)
+{
+    static const char *const invalid[] = { "", "a+", "+a", "a/b+", "a/+b/c", "a#", "a/#/b", "#/a", "a/b#" };
+    static const char *const valid[] = { "+", "#", "/", "a/+/", "+/+", "/#", "a/b/#" };
+    ticos_route_t route;
+
+    for (int i = 0; i < (int)(sizeof(invalid) / sizeof(invalid[0])); i++) {
+        memset(&route, 0, sizeof(route));
+        TICOS_CHECK_INT(ticos_route_add(&route, invalid[i], on_msg, NULL), -1);
+        TICOS_CHECK(route.topic == NULL);
+    }
+    for (int i = 0; i < (int)(sizeof(valid) / sizeof(valid[0])); i++) {
+        memset(&route, 0, sizeof(route));
+        TICOS_CHECK_INT(ticos_route_add(&route, valid[i], on_msg, NULL), 0);
+        TICOS_CHECK_INT(route.wildcard, i != 2);
+        ticos_route_remove(&route);
+    }
+    // 未添加和已移除的路由可重复移除
+    memset(&route, 0, sizeof(route));
+    ticos_route_remove(&route);
+    ticos_route_remove(&route);
+}
+
+static void test_priority(void)
+{
+    ticos_route_t exact, wild1, wild2, dup;
+
+    memset(&exact, 0, sizeof(exact));
+    memset(&wild1, 0, sizeof(wild1));
+    memset(&wild2, 0, sizeof(wild2));
+    memset(&dup, 0, sizeof(dup));
+    TICOS_CHECK_INT(ticos_route_add(&wild1, "devices/+/twin/desired", on_msg, &wild1), 0);
+    TICOS_CHECK_INT(ticos_route_add(&wild2, "devices/#", on_msg, &wild2), 0);
+    TICOS_CHECK_INT(ticos_route_add(&exact, "devices/D/twin/desired", on_msg, &exact), 0);
+
+    // 精确匹配优先于先添加的通配符, 通配符之间按添加顺序
+    m_calls = 0;
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == &exact);
+    TICOS_CHECK_STR(m_topic, "devices/D/twin/desired");
+    TICOS_CHECK_STR(m_data, "x");
+    TICOS_CHECK(dispatch("devices/E/twin/desired") == &wild1);
+    TICOS_CHECK(dispatch("devices/E/commands/request") == &wild2);
+    TICOS_CHECK(dispatch("device/E/twin/desired") == NULL);
+    TICOS_CHECK_INT(m_calls, 3);
+
+    // 相同的 topic 优先分发给最后添加的路由, 移除后恢复之前的路由
+    TICOS_CHECK_INT(ticos_route_add(&dup, "devices/D/twin/desired", on_msg, &dup), 0);
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == &dup);
+    ticos_route_remove(&dup);
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == &exact);
+
+    // 移除精确路由后由通配符匹配
+    ticos_route_remove(&exact);
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == &wild1);
+    ticos_route_remove(&wild1);
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == &wild2);
+    ticos_route_remove(&wild2);
+    TICOS_CHECK(dispatch("devices/D/twin/desired") == NULL);
+
+    // 重新添加已添加的路由时更换 topic
+    TICOS_CHECK_INT(ticos_route_add(&exact, "a", on_msg, &exact), 0);
+    TICOS_CHECK_INT(ticos_route_add(&exact, "b", on_msg, &exact), 0);
+    TICOS_CHECK(dispatch("a") == NULL);
+    TICOS_CHECK(dispatch("b") == &exact);
+    ticos_route_remove(&exact);
+}
+
+// 路由数量远超初始桶数时全部可以找到, 移除一部分后其余不受影响
+static void test_grow(void)
+{
+    int ok = 1;
+
+    memset(m_routes, 0, sizeof(m_routes));
+    for (int i = 0; i < ROUTE_CNT; i++) {
+        snprintf(m_topics[i], sizeof(m_topics[i]), "devices/dev%05d/twin/desired", i);
+        ok &= !ticos_route_add(&m_routes[i], m_topics[i], on_msg, &m_routes[i]);
+    }
+    TICOS_CHECK(ok);
+    for (int i = 0; i < ROUTE_CNT; i++)
+        ok &= dispatch(m_topics[i]) == &m_routes[i];
+    TICOS_CHECK(ok);
+    TICOS_CHECK(dispatch("devices/dev99999/twin/desired") == NULL);
+
+    for (int i = 0; i < ROUTE_CNT; i += 2)
+        ticos_route_remove(&m_routes[i]);
+    for (int i = 0; i < ROUTE_CNT; i++)
+        ok &= dispatch(m_topics[i]) == (i & 1 ? &m_routes[i] : NULL);
+    TICOS_CHECK(ok);
+
+    // 重新添加后与未移除的路由一样可以找到
+    for (int i = 0; i < ROUTE_CNT; i += 2)
+        ok &= !ticos_route_add(&m_routes[i], m_topics[i], on_msg, &m_routes[i]);
+    for (int i = 0; i < ROUTE_CNT; i++)
+        ok &= dispatch(m_topics[i]) == &m_routes[i];
+    TICOS_CHECK(ok);
+    for (int i = 0; i < ROUTE_CNT; i++)
+        ticos_route_remove(&m_routes[i]);
+    TICOS_CHECK(dispatch(m_topics[0]) == NULL);
+}
+
+// 处理函数中可以移除路由, 之后的消息不再分发
+static void test_remove_in_handler(void)
+{
+    ticos_route_t route;
+
+    memset(&route, 0, sizeof(route));
+    TICOS_CHECK_INT(ticos_route_add(&route, "devices/+/commands/request", on_msg_remove, &route), 0);
+    m_calls = 0;
+    TICOS_CHECK_INT(ticos_route_dispatch("devices/D/commands/request", 26, "x", 1), 1);
+    TICOS_CHECK_INT(ticos_route_dispatch("devices/D/commands/request", 26, "x", 1), 0);
+    TICOS_CHECK_INT(m_calls, 1);
+    TICOS_CHECK(route.topic == NULL);
+}
+
+int main(void)
+{
+    test_match();
+    test_invalid();
+    test_priority();
+    test_grow();
+    test_remove_in_handler();
+    return ticos_test_result();
+}
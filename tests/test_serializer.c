@@ -0,0 +1,166 @@
+/*
+ * 生成的专用编码函数: 全量上报的内容与逐字段编码逐字节相同, 属性上报缓存的状态也一致
+ * 物模型由 ticos_serializer_gen.py 在构建时生成, getter 返回下面的 ticos_test_* 变量
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_thingmodel.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+
+bool ticos_test_telemetry_t_boolean;
+int ticos_test_telemetry_t_integer;
+float ticos_test_telemetry_t_float;
+const char *ticos_test_telemetry_t_string;
+int ticos_test_telemetry_t_enum;
+time_t ticos_test_telemetry_t_timestamp;
+bool ticos_test_property_p_boolean;
+int ticos_test_property_p_integer;
+float ticos_test_property_p_float;
+const char *ticos_test_property_p_string;
+int ticos_test_property_p_enum;
+time_t ticos_test_property_p_timestamp;
+
+typedef struct {
+    bool b;
+    int i;
+    float f;
+    const char *s;
+} test_values_t;
+
+static const test_values_t m_values[] = {
+    { true, 0, 0.0f, "" },
+    { false, 1, 1.5f, "abc" },
+    { true, -1, -0.0f, NULL },
+    { false, INT_MAX, 0.1f, "quote\" backslash\\ newline\n tab\t ctrl\x01" },
+    { true, INT_MIN, -3.14159f, "温度" },
+    { false, 123456, 1e-10f, NULL },
+    { true, -42, 3.4e38f, "x" },
+    { false, 7, 16777217.0f, "x" },
+    { true, 7, 123456789.0f, "long string long string long string long" },
+    { false, 0, -1e30f, "" },
+    { true, 99, NAN, "nan" },
+    { false, 99, INFINITY, "inf" },
+};
+
+#define VALUE_CNT ((int)(sizeof(m_values) / sizeof(m_values[0])))
+
+static ticos_thingmodel_t m_plain_model;
+static ticos_client_t m_plain;
+
+static void set_values(int n)
+{
+    const test_values_t *v = &m_values[n];
+
+    ticos_test_telemetry_t_boolean = v->b;
+    ticos_test_telemetry_t_integer = v->i;
+    ticos_test_telemetry_t_float = v->f;
+    ticos_test_telemetry_t_string = v->s;
+    ticos_test_telemetry_t_enum = v->i;
+    ticos_test_telemetry_t_timestamp = (time_t)v->i * 1000;
+    ticos_test_property_p_boolean = !v->b;
+    ticos_test_property_p_integer = -v->i / 2;
+    ticos_test_property_p_float = v->f / 3;
+    ticos_test_property_p_string = v->s;
+    ticos_test_property_p_enum = v->i;
+    ticos_test_property_p_timestamp = (time_t)v->i;
+}
+
+// 两个设备分别以专用编码函数和逐字段编码上报, 比较两条消息的内容
+static void check_same(int fast_ret, int plain_ret, int n)
+{
+    char what[32];
+
+    snprintf(what, sizeof(what), "values %d", n);
+    // 返回值为消息 ID, 两个设备的消息 ID 不同
+    TICOS_CHECK(fast_ret >= 0);
+    TICOS_CHECK(plain_ret >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    const ticos_test_msg_t *fast = ticos_test_msg(1);
+    const ticos_test_msg_t *plain = ticos_test_msg(0);
+    if (!fast || !plain)
+        return;
+    TICOS_CHECK_STR(fast->topic + strlen("devices/D/"), plain->topic + strlen("devices/D2/"));
+    TICOS_CHECK_INT(fast->len, plain->len);
+    ticos_test_check_str(fast->data, plain->data, what, __FILE__, __LINE__);
+}
+
+static void test_setup(void)
+{
+    ticos_test_connect();
+    const ticos_thingmodel_t *model = ticos_client_default()->model;
+    TICOS_CHECK(model->serialize_telemetry != NULL);
+    TICOS_CHECK(model->serialize_property != NULL);
+
+    m_plain_model = *model;
+    m_plain_model.serialize_telemetry = NULL;
+    m_plain_model.serialize_property = NULL;
+    TICOS_CHECK_INT(ticos_client_init(&m_plain, &m_plain_model, "P", "D2", "S"), 0);
+    TICOS_CHECK_INT(ticos_client_start(&m_plain), 0);
+}
+
+static void test_telemetry(void)
+{
+    for (int n = 0; n < VALUE_CNT; n++) {
+        set_values(n);
+        ticos_test_reset();
+        int fast = ticos_telemetry_report();
+        int plain = ticos_client_telemetry_report(&m_plain);
+        check_same(fast, plain, n);
+    }
+    // 值为 NULL 的字符串字段被省略, 其他类型不支持的字段编码为 null
+    set_values(2);
+    ticos_test_reset();
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK(strstr(ticos_test_last(), "t_string") == NULL);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"t_enum\":null") != NULL);
+}
+
+static void test_property(void)
+{
+    for (int n = 0; n < VALUE_CNT; n++) {
+        set_values(n);
+        ticos_test_reset();
+        int fast = ticos_property_report();
+        int plain = ticos_client_property_report(&m_plain);
+        check_same(fast, plain, n);
+
+        // 全量上报后缓存与设备的值一致, 变化上报不再发送
+        ticos_test_reset();
+        TICOS_CHECK_INT(ticos_property_report_changed(), ticos_client_property_report_changed(&m_plain));
+        TICOS_CHECK_INT(ticos_test_count(), 0);
+    }
+}
+
+// 专用编码函数更新的上报缓存与逐字段编码一致, 之后的变化上报选出相同的字段
+static void test_changed(void)
+{
+    for (int n = 1; n < VALUE_CNT; n++) {
+        set_values(n - 1);
+        ticos_test_reset();
+        ticos_property_report();
+        ticos_client_property_report(&m_plain);
+
+        set_values(n);
+        ticos_test_reset();
+        int fast = ticos_property_report_changed();
+        int plain = ticos_client_property_report_changed(&m_plain);
+        if (ticos_test_count() == 0) {
+            TICOS_CHECK_INT(fast, plain);
+            continue;
+        }
+        check_same(fast, plain, n);
+    }
+}
+
+int main(void)
+{
+    test_setup();
+    test_telemetry();
+    test_property();
+    test_changed();
+    ticos_client_stop(&m_plain);
+    return ticos_test_result();
+}
@@ -0,0 +1,266 @@
+/*
+ * 全静态内存模式: 上报缓冲区和下发字符串的大小取自按物模型生成的 ticos_thingmodel_config.h, 所有字段取最坏情况时
+ * 上报仍然成功且不超出计算的大小; 设备启动后上报、下发、命令、离线队列和发送线程的各条路径都不申请堆内存
+ * 物模型由 ticos_static_gen.py 在构建时生成, 链接时以 --wrap 拦截 SDK 对 malloc 系列函数的调用并计数
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_client.h"
+#include "ticos_config.h"
+#include "ticos_mem.h"
+#include "ticos_route.h"
+#include "ticos_thingmodel.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ROUTE_CNT (TICOS_ROUTE_BUCKETS * 4)
+
+static int m_heap;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    m_heap++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    m_heap++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    m_heap++;
+    return __real_realloc(ptr, size);
+}
+
+bool ticos_test_telemetry_t_boolean;
+int ticos_test_telemetry_t_integer;
+float ticos_test_telemetry_t_float;
+int ticos_test_telemetry_t_enum;
+time_t ticos_test_telemetry_t_timestamp;
+const char *ticos_test_telemetry_t_string;
+bool ticos_test_property_p_boolean;
+int ticos_test_property_p_integer;
+float ticos_test_property_p_float;
+const char *ticos_test_property_p_string;
+
+static int m_p_integer;
+static char m_p_string[64];
+static char m_c_string[64];
+static int m_c_integer;
+static char m_t_worst[64];
+static char m_p_worst[64];
+
+int ticos_test_property_p_boolean_recv(bool v) { return 0; }
+int ticos_test_property_p_integer_recv(int v) { m_p_integer = v; return 0; }
+int ticos_test_property_p_float_recv(float v) { return 0; }
+int ticos_test_property_p_string_recv(const char *v) { snprintf(m_p_string, sizeof(m_p_string), "%s", v); return 0; }
+int ticos_test_command_c_string_recv(const char *v) { snprintf(m_c_string, sizeof(m_c_string), "%s", v); return 0; }
+int ticos_test_command_c_integer_recv(int v) { m_c_integer = v; return 0; }
+
+static ticos_route_t m_routes[ROUTE_CNT];
+static char m_topics[ROUTE_CNT][40];
+
+static void on_route(void *user, const char *topic, int topic_len, const char *dat, int len)
+{
+}
+
+// 长度为 n 的字符串, 每个字节都需要转义为 \u00XX
+static const char *escaped(char *buf, int n)
+{
+    memset(buf, 0x01, n);
+    buf[n] = '\0';
+    return buf;
+}
+
+// 所有字段取编码后最长的值: ticos_ftoa() 最长输出 16 字节, 整数取 INT_MIN, 字符串取 maxLength 个需要转义的字节
+static void set_worst(void)
+{
+    ticos_test_telemetry_t_boolean = false;
+    ticos_test_telemetry_t_integer = INT_MIN;
+    ticos_test_telemetry_t_float = -835195600000000.0f;
+    ticos_test_telemetry_t_enum = INT_MIN;
+    ticos_test_telemetry_t_timestamp = (time_t)INT_MIN;
+    ticos_test_telemetry_t_string = escaped(m_t_worst, 24);
+    ticos_test_property_p_boolean = false;
+    ticos_test_property_p_integer = INT_MIN;
+    ticos_test_property_p_float = -835195600000000.0f;
+    ticos_test_property_p_string = escaped(m_p_worst, 40);
+}
+
+static void desired(const char *data)
+{
+    ticos_msg_recv("devices/D/twin/desired", data, strlen(data));
+}
+
+static void command(const char *data)
+{
+    ticos_msg_recv("devices/D/commands/request", data, strlen(data));
+}
+
+// 缓冲区大小取物模型的最坏情况, 不能改用堆内存
+static void test_config(void)
+{
+    static const ticos_allocator_t alloc = { malloc, free };
+
+    TICOS_CHECK_INT(TICOS_REPORT_BUF_SIZE, TICOS_THINGMODEL_REPORT_MAX);
+    TICOS_CHECK_INT(TICOS_RECV_STRING_MAX, TICOS_THINGMODEL_STRING_MAX);
+    TICOS_CHECK_INT(TICOS_THINGMODEL_STRING_MAX, 49);
+    TICOS_CHECK(TICOS_THINGMODEL_REPORT_MAX >= TICOS_THINGMODEL_TELEMETRY_MAX);
+    TICOS_CHECK(TICOS_THINGMODEL_REPORT_MAX >= TICOS_THINGMODEL_PROPERTY_MAX);
+    TICOS_CHECK(TICOS_THINGMODEL_REPORT_MAX >= TICOS_THINGMODEL_SAMPLE_MAX);
+    TICOS_CHECK_INT(ticos_set_allocator(&alloc), -1);
+    TICOS_CHECK_INT(ticos_set_allocator(NULL), -1);
+    TICOS_CHECK(ticos_heap_malloc(16) == NULL);
+    TICOS_CHECK(ticos_malloc(16) == NULL);
+
+    // 内存池用完后分配失败, 不改用堆内存
+    static uint64_t arena[8];
+    TICOS_CHECK_INT(ticos_set_arena(arena, sizeof(arena)), 0);
+    ticos_mem_begin();
+    TICOS_CHECK(ticos_malloc(32) != NULL);
+    TICOS_CHECK(ticos_malloc(32) != NULL);
+    TICOS_CHECK(ticos_malloc(8) == NULL);
+    ticos_mem_end();
+    TICOS_CHECK_INT(ticos_set_arena(NULL, 0), 0);
+    TICOS_CHECK_INT(m_heap, 0);
+
+    // 格式化后超出 topic 缓冲区的设备 ID 在初始化时失败
+    char id[200];
+    ticos_client_t client;
+    memset(id, 'x', sizeof(id) - 1);
+    id[sizeof(id) - 1] = '\0';
+    TICOS_CHECK_INT(ticos_client_init(&client, NULL, "P", id, "S"), -1);
+}
+
+// 最坏情况的全量上报恰好放得下, 长度不超出生成的大小
+static void test_worst_report(void)
+{
+    ticos_test_connect();
+    m_heap = 0;
+    set_worst();
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    TICOS_CHECK(ticos_test_msg(0)->len < TICOS_THINGMODEL_TELEMETRY_MAX);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"t_float\":-835195600000000,") != NULL);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 2);
+    TICOS_CHECK(ticos_test_msg(0)->len < TICOS_THINGMODEL_PROPERTY_MAX);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"p_string\":\"\\u0001") != NULL);
+    TICOS_CHECK(ticos_property_report_changed() >= 0);
+    TICOS_CHECK(ticos_telemetry_report_by_index(TICOS_TELEMETRY_t_string) >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 3);
+
+    // CBOR 编码同样放得下
+    TICOS_CHECK_INT(ticos_set_payload_format(TICOS_PAYLOAD_CBOR), 0);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 5);
+    TICOS_CHECK(ticos_test_msg(0)->len <= TICOS_THINGMODEL_PROPERTY_MAX);
+    TICOS_CHECK(ticos_test_msg(1)->len <= TICOS_THINGMODEL_TELEMETRY_MAX);
+    TICOS_CHECK_INT(ticos_set_payload_format(TICOS_PAYLOAD_JSON), 0);
+
+    // 只含一个最坏情况样本的批量消息也放得下
+    ticos_telemetry_batch_policy(0, 0, 0);
+    TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK_INT(ticos_telemetry_flush(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 6);
+    TICOS_CHECK(!strncmp(ticos_test_last(), "{\"samples\":[{\"ts\":", 18));
+    TICOS_CHECK(ticos_test_msg(0)->len < TICOS_THINGMODEL_SAMPLE_MAX);
+
+    // 超出 maxLength 的字符串使上报失败, 不会越界
+    char longer[64];
+    ticos_test_property_p_string = escaped(longer, 60);
+    TICOS_CHECK(ticos_property_report() < 0);
+    TICOS_CHECK_INT(ticos_test_count(), 6);
+    TICOS_CHECK_INT(m_heap, 0);
+}
+
+// 下发的字符串不超过 maxLength 时完整收到, 超出时作为被忽略的字段; 分片到达的消息同样处理
+static void test_receive(void)
+{
+    char buf[128];
+
+    m_heap = 0;
+    desired("{\"p_integer\":-7,\"p_string\":\"0123456789012345678901234567890123456789\"}");
+    TICOS_CHECK_INT(m_p_integer, -7);
+    TICOS_CHECK_STR(m_p_string, "0123456789012345678901234567890123456789");
+    snprintf(buf, sizeof(buf), "{\"p_string\":\"%049d\",\"p_integer\":8}", 0);
+    desired(buf);
+    TICOS_CHECK_STR(m_p_string, "0123456789012345678901234567890123456789");
+    TICOS_CHECK_INT(m_p_integer, 8);
+
+    const char *doc = "{\"p_integer\":9,\"p_string\":\"frag\"}";
+    int len = strlen(doc);
+    ticos_msg_recv_fragment("devices/D/twin/desired", 22, doc, 10, 0, len);
+    ticos_msg_recv_fragment("devices/D/twin/desired", 22, doc + 10, len - 10, 10, len);
+    TICOS_CHECK_INT(m_p_integer, 9);
+    TICOS_CHECK_STR(m_p_string, "frag");
+
+    // 命令的字符串参数最长 48 字节
+    snprintf(buf, sizeof(buf), "{\"$id\":\"1\",\"c_string\":\"%048d\"}", 0);
+    command(buf);
+    TICOS_CHECK_INT(strlen(m_c_string), 48);
+    TICOS_CHECK(strstr(ticos_test_last(), "\"command\":\"c_string\",\"code\":0") != NULL);
+    command("{\"$id\":\"2\",\"c_integer\":-5}");
+    TICOS_CHECK_INT(m_c_integer, -5);
+    TICOS_CHECK_INT(m_heap, 0);
+}
+
+// 离线队列、发送线程、命令工作线程和路由表都使用静态内存; 线程本身由 libc 创建, 不计入 SDK 的分配
+static void test_threads(void)
+{
+    m_heap = 0;
+    ticos_test_publish_fail(1);
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    ticos_test_publish_fail(0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 1);
+    ticos_test_reset();
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK_INT(ticos_offline_pending(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+
+    for (int i = 0; i < 8; i++)
+        TICOS_CHECK_INT(ticos_telemetry_report_async(), TICOS_SEND_OK);
+    TICOS_CHECK_INT(ticos_sender_start(), 0);
+    ticos_sender_stop();
+    TICOS_CHECK_INT(ticos_send_pending(), 0);
+    // 另有发送线程在重新连接后发出的全量属性上报
+    TICOS_CHECK_INT(ticos_test_count(), 10);
+
+    TICOS_CHECK_INT(ticos_command_pool_start(2), 0);
+    command("{\"$id\":\"3\",\"c_integer\":11}");
+    for (int i = 0; i < 2000 && m_c_integer != 11; i++)
+        usleep(1000);
+    ticos_command_pool_stop();
+    TICOS_CHECK_INT(m_c_integer, 11);
+
+    // 路由数量远超桶数时桶数不增长, 仍能查找
+    for (int i = 0; i < ROUTE_CNT; i++) {
+        snprintf(m_topics[i], sizeof(m_topics[i]), "static/%d", i);
+        TICOS_CHECK_INT(ticos_route_add(&m_routes[i], m_topics[i], on_route, NULL), 0);
+    }
+    TICOS_CHECK(ticos_route_find("static/7", 8) == &m_routes[7]);
+    TICOS_CHECK(ticos_route_find(m_topics[ROUTE_CNT - 1], strlen(m_topics[ROUTE_CNT - 1])) == &m_routes[ROUTE_CNT - 1]);
+    for (int i = 0; i < ROUTE_CNT; i++)
+        ticos_route_remove(&m_routes[i]);
+    TICOS_CHECK_INT(m_heap, 0);
+    ticos_cloud_stop();
+}
+
+int main(void)
+{
+    test_config();
+    test_worst_report();
+    test_receive();
+    test_threads();
+    return ticos_test_result();
+}
@@ -0,0 +1,318 @@
+/*
+ * 流式字段上报: 字段内容分块读取, 边读取边转义或编码为 base64, 结果与整段编码相同; 放不下上报缓冲区的消息
+ * 经分块发布接口写出, 声明的长度与写出的字节数一致; 两次读取不一致或读取失败时上报失败
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_cbor.h"
+#include "ticos_client.h"
+#include "ticos_json_writer.h"
+#include "ticos_thingmodel_type.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define DATA_MAX    20000
+#define OUT_MAX     (DATA_MAX * 6 + 256)
+
+static unsigned char m_data[DATA_MAX];
+static int m_size;
+static int m_step = TICOS_STREAM_CHUNK_SIZE;   // 每次读取返回的最大字节数
+static int m_pass;                              // 从头读取的次数
+static int m_shrink;                            // 第二遍读取时少返回的字节数
+static int m_quote;                             // 第二遍读取时第一个字节改为需要转义的引号
+static int m_fail;                              // 读取返回错误
+static int m_n = 1;
+
+// 从 m_data 中读取, 每次至多 m_step 字节
+static int read_data(size_t offset, void *buf, int size)
+{
+    if (!offset)
+        m_pass++;
+    int total = m_size - (m_pass > 1 ? m_shrink : 0);
+
+    if (m_fail)
+        return -1;
+    if ((int)offset >= total)
+        return 0;
+    int n = total - (int)offset;
+    n = n < size ? n : size;
+    n = n < m_step ? n : m_step;
+    memcpy(buf, m_data + offset, n);
+    if (m_quote && m_pass > 1 && !offset)
+        *(char *)buf = '"';
+    return n;
+}
+
+static int get_n(void) { return m_n; }
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "log", TICOS_VAL_TYPE_STREAM, read_data },
+    { "n", TICOS_VAL_TYPE_INTEGER, get_n },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "dump", TICOS_VAL_TYPE_BLOB, read_data, NULL },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+// 分块发布接口的桩函数, 记录一条消息
+static char m_topic[128];
+static char m_out[OUT_MAX];
+static int m_declared = -1;
+static int m_written;
+static int m_begins;
+static int m_write_fail;
+
+int ticos_hal_mqtt_publish_begin(const char *topic, int len, int qos, int retain)
+{
+    snprintf(m_topic, sizeof(m_topic), "%s", topic);
+    m_declared = len;
+    m_written = 0;
+    m_begins++;
+    return len > OUT_MAX ? -1 : 0;
+}
+
+int ticos_hal_mqtt_publish_write(const void *data, int len)
+{
+    if (m_write_fail || len > m_declared - m_written)
+        return -1;
+    memcpy(m_out + m_written, data, len);
+    m_written += len;
+    return 0;
+}
+
+int ticos_hal_mqtt_publish_end(void)
+{
+    int ret = m_written == m_declared ? 0 : -1;
+    m_declared = -1;
+    return ret;
+}
+
+static char m_expect[OUT_MAX];
+static char m_small[64];
+
+static void fill(int n, uint32_t seed)
+{
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        m_data[i] = (unsigned char)(seed >> 16);
+        if (!m_data[i])
+            m_data[i] = 'z';
+    }
+    m_size = n;
+}
+
+// 整段编码的期望结果: {"<id>":"<转义后的文本>"}
+static int expect_text(const char *id)
+{
+    static char str[DATA_MAX + 1];
+    ticos_json_writer_t w;
+
+    memcpy(str, m_data, m_size);
+    str[m_size] = '\0';
+    ticos_json_writer_init(&w, m_expect, sizeof(m_expect));
+    ticos_json_object_begin(&w);
+    ticos_json_add_string(&w, id, str);
+    ticos_json_object_end(&w);
+    return ticos_json_writer_finish(&w);
+}
+
+static int expect_base64(const char *id)
+{
+    static const char tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int len = snprintf(m_expect, sizeof(m_expect), "{\"%s\":\"", id);
+
+    for (int i = 0; i < m_size; i += 3) {
+        uint32_t v = (uint32_t)m_data[i] << 16 | (i + 1 < m_size ? m_data[i + 1] << 8 : 0) |
+                     (i + 2 < m_size ? m_data[i + 2] : 0);
+        m_expect[len++] = tab[v >> 18 & 0x3f];
+        m_expect[len++] = tab[v >> 12 & 0x3f];
+        m_expect[len++] = i + 1 < m_size ? tab[v >> 6 & 0x3f] : '=';
+        m_expect[len++] = i + 2 < m_size ? tab[v & 0x3f] : '=';
+    }
+    return len + sprintf(m_expect + len, "\"}");
+}
+
+// 上报并返回消息内容: 放得下上报缓冲区时取桩函数记录的消息, 否则取分块发布的消息
+static const char *report(int property, int *len, int *chunked)
+{
+    int begins = m_begins;
+
+    ticos_test_reset();
+    m_pass = 0;
+    int ret = property ? ticos_property_report_by_index(0) : ticos_telemetry_report_by_index(0);
+    *chunked = m_begins != begins;
+    if (ret < 0)
+        return NULL;
+    if (*chunked) {
+        *len = m_written;
+        return m_out;
+    }
+    if (ticos_test_count() != 1)
+        return NULL;
+    *len = ticos_test_msg(0)->len;
+    return ticos_test_msg(0)->data;
+}
+
+static int same(const char *out, int len, int expect)
+{
+    return out && len == expect && !memcmp(out, m_expect, len);
+}
+
+static void test_text(void)
+{
+    int len, chunked;
+    const char *out;
+
+    ticos_test_connect();
+
+    // 含引号、反斜杠、控制字符和多字节字符的文本
+    strcpy((char *)m_data, "a\"b\\c\nd\te\x01\x1f \xe6\xb8\xa9\xe5\xba\xa6/");
+    m_size = strlen((char *)m_data);
+    out = report(0, &len, &chunked);
+    TICOS_CHECK(!chunked);
+    TICOS_CHECK(same(out, len, expect_text("log")));
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/telemetry");
+
+    // 空内容
+    m_size = 0;
+    out = report(0, &len, &chunked);
+    TICOS_CHECK(same(out, len, expect_text("log")));
+
+    // 以不同的步长读取, 转义序列跨越读取的边界; 较长的内容经分块发布写出, 长度与声明一致
+    static const int steps[] = { 1, 7, 255, TICOS_STREAM_CHUNK_SIZE };
+    static const int sizes[] = { 100, 900, 5000, DATA_MAX };
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            fill(sizes[j], i * 4 + j);
+            m_step = steps[i];
+            out = report(0, &len, &chunked);
+            TICOS_CHECK(same(out, len, expect_text("log")));
+            TICOS_CHECK_INT(chunked, len > TICOS_REPORT_BUF_SIZE);
+        }
+    }
+    m_step = TICOS_STREAM_CHUNK_SIZE;
+    TICOS_CHECK_STR(m_topic, "devices/D/telemetry");
+
+    // 全量上报跳过流式字段
+    TICOS_CHECK(ticos_telemetry_report() >= 0);
+    TICOS_CHECK_STR(ticos_test_last(), "{\"n\":1}");
+}
+
+// 二进制数据编码为 base64, 长度不是 3 的倍数时补 '='
+static void test_blob(void)
+{
+    int len, chunked;
+    const char *out;
+
+    for (int n = 0; n < 10; n++) {
+        fill(n, n);
+        m_data[0] = 0;
+        out = report(1, &len, &chunked);
+        TICOS_CHECK(same(out, len, expect_base64("dump")));
+    }
+    for (int step = 1; step < 5; step++) {
+        fill(DATA_MAX - step, step);
+        m_step = step * 100 + step;
+        out = report(1, &len, &chunked);
+        TICOS_CHECK(chunked);
+        TICOS_CHECK(same(out, len, expect_base64("dump")));
+    }
+    m_step = TICOS_STREAM_CHUNK_SIZE;
+    TICOS_CHECK_STR(m_topic, "devices/D/twin/reported");
+}
+
+// CBOR 格式中内容原样输出, 文本为字符串, 二进制数据为字节串
+static void test_cbor(void)
+{
+    ticos_cbor_writer_t w;
+    int len, chunked;
+    const char *out;
+
+    TICOS_CHECK_INT(ticos_set_payload_format(TICOS_PAYLOAD_CBOR), 0);
+    for (int property = 0; property < 2; property++) {
+        for (int j = 0; j < 2; j++) {
+            fill(j ? 3000 : 20, property + j);
+            ticos_cbor_writer_init(&w, m_expect, sizeof(m_expect));
+            ticos_cbor_self_describe(&w);
+            ticos_cbor_map_begin(&w);
+            ticos_cbor_int(&w, TICOS_CBOR_KEY_HASH);
+            ticos_cbor_int(&w, ticos_client_default()->model->hash);
+            ticos_cbor_int(&w, 0);
+            ticos_cbor_string_head(&w, m_size, property);
+            int head = ticos_cbor_writer_finish(&w);
+            memcpy(m_expect + head, m_data, m_size);
+            m_expect[head + m_size] = (char)0xff;
+            out = report(property, &len, &chunked);
+            TICOS_CHECK_INT(chunked, j);
+            TICOS_CHECK(same(out, len, head + m_size + 1));
+            TICOS_CHECK(out && ticos_cbor_check_map(out, len) >= 0);
+        }
+    }
+    TICOS_CHECK_INT(ticos_set_payload_format(TICOS_PAYLOAD_JSON), 0);
+}
+
+// 两次读取不一致、读取失败、写入失败和有待重发的离线消息时上报失败
+static void test_errors(void)
+{
+    int len, chunked;
+
+    fill(100, 1);
+    m_shrink = 1;
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    fill(5000, 1);
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK(chunked);
+    m_shrink = 0;
+
+    // 长度相同但转义后的长度不同
+    fill(100, 1);
+    m_data[0] = 'a';
+    m_quote = 1;
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    fill(5000, 1);
+    m_data[0] = 'a';
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK(chunked);
+    m_quote = 0;
+
+    m_fail = 1;
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK(!chunked);
+    m_fail = 0;
+
+    m_write_fail = 1;
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK(chunked);
+    m_write_fail = 0;
+
+    ticos_test_publish_fail(1);
+    TICOS_CHECK(ticos_telemetry_report_by_index(1) >= 0);
+    ticos_test_publish_fail(0);
+    TICOS_CHECK_INT(ticos_offline_pending(), 1);
+    TICOS_CHECK(report(0, &len, &chunked) == NULL);
+    TICOS_CHECK(!chunked);
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    TICOS_CHECK(report(0, &len, &chunked) != NULL);
+
+    // 换用较小的上报缓冲区后, 较短的内容也经分块发布写出
+    fill(100, 2);
+    TICOS_CHECK_INT(ticos_set_report_buffer(m_small, sizeof(m_small)), 0);
+    const char *out = report(0, &len, &chunked);
+    TICOS_CHECK(chunked);
+    TICOS_CHECK(same(out, len, expect_text("log")));
+    TICOS_CHECK_INT(ticos_set_report_buffer(NULL, 0), 0);
+    TICOS_CHECK_INT(ticos_telemetry_report_by_index(2), -1);
+}
+
+int main(void)
+{
+    test_text();
+    test_blob();
+    test_cbor();
+    test_errors();
+    return ticos_test_result();
+}
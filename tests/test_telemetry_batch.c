@@ -0,0 +1,156 @@
+/*
+ * 遥测批量上报: 按样本数、大小和缓存时长打包, 缓存满时丢弃最早的样本, 发送失败时保留样本
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int m_seq = 0;
+static char m_pad[64] = "x";
+
+static int get_seq(void) { return m_seq++; }
+static const char *get_pad(void) { return m_pad; }
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "v", TICOS_VAL_TYPE_INTEGER, get_seq },
+    { "pad", TICOS_VAL_TYPE_STRING, get_pad },
+};
+const int ticos_telemetry_cnt = 2;
+
+static char m_report_buf[8192];
+
+// 依次取出消息中各样本的序号, 返回样本数
+static int samples(const char *msg, int *seq, int max)
+{
+    int n = 0;
+    const char *p = msg;
+
+    TICOS_CHECK(!strncmp(msg, "{\"samples\":[{\"ts\":", 18));
+    TICOS_CHECK(!strcmp(msg + strlen(msg) - 3, "}]}"));
+    while ((p = strstr(p, "\"v\":")) != NULL && n < max) {
+        seq[n++] = atoi(p + 4);
+        p += 4;
+    }
+    return n;
+}
+
+// 最近 count 条消息中的样本序号, 从 first 开始连续递增
+static void check_sequence(int count, int first, int total, int max_len)
+{
+    int seq[512], n = 0;
+
+    for (int i = count - 1; i >= 0; i--) {
+        const ticos_test_msg_t *msg = ticos_test_msg(i);
+        TICOS_CHECK_STR(msg->topic, "devices/D/telemetry");
+        if (max_len)
+            TICOS_CHECK(msg->len <= max_len);
+        n += samples(msg->data, seq + n, 512 - n);
+    }
+    TICOS_CHECK_INT(n, total);
+    for (int i = 0; i < n; i++)
+        TICOS_CHECK_INT(seq[i], first + i);
+}
+
+static void test_max_samples(void)
+{
+    ticos_telemetry_batch_policy(3, 0, 0);
+    m_seq = 0;
+    TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    TICOS_CHECK(ticos_telemetry_sample() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    check_sequence(1, 0, 3, 0);
+
+    // 没有缓存的样本时不发送
+    TICOS_CHECK_INT(ticos_telemetry_flush(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+}
+
+// 缓存满时丢弃最早的样本, 余下的样本保持顺序
+static void test_overflow(void)
+{
+    ticos_test_reset();
+    ticos_telemetry_batch_policy(0, 0, 0);
+    m_seq = 0;
+    for (int i = 0; i < 500; i++)
+        TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    TICOS_CHECK(ticos_telemetry_flush() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+
+    int seq[512];
+    int n = samples(ticos_test_last(), seq, 512);
+    TICOS_CHECK(n > 10 && n < 500);
+    TICOS_CHECK_INT(seq[n - 1], 499);
+    check_sequence(1, 500 - n, n, 0);
+}
+
+// 超出单条消息大小限制的样本拆分为多条消息, 单个样本超出限制时无法缓存
+static void test_split(void)
+{
+    ticos_test_reset();
+    ticos_telemetry_batch_policy(0, 200, 0);
+    m_seq = 0;
+    for (int i = 0; i < 20; i++)
+        TICOS_CHECK(ticos_telemetry_sample() >= 0);
+    TICOS_CHECK(ticos_telemetry_flush() >= 0);
+    int count = ticos_test_count();
+    TICOS_CHECK(count > 1);
+    check_sequence(count, 0, 20, 200);
+
+    memset(m_pad, 'y', sizeof(m_pad) - 1);
+    ticos_telemetry_batch_policy(0, 60, 0);
+    TICOS_CHECK(ticos_telemetry_sample() < 0);
+    m_pad[1] = '\0';
+}
+
+static void test_max_age(void)
+{
+    ticos_test_reset();
+    ticos_telemetry_batch_policy(0, 0, 50);
+    m_seq = 0;
+    TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK_INT(ticos_telemetry_batch_poll(), 0);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    usleep(60 * 1000);
+    TICOS_CHECK(ticos_telemetry_batch_poll() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    check_sequence(1, 0, 1, 0);
+}
+
+// 离线日志已满, 发布失败的样本留在缓存中等待下次发送
+static void test_retain(void)
+{
+    ticos_test_reset();
+    ticos_telemetry_batch_policy(0, 0, 0);
+    m_seq = 0;
+    remove("test_telemetry_batch.log");
+    TICOS_CHECK_INT(ticos_offline_set_log("test_telemetry_batch.log", 16), 0);
+    ticos_test_publish_fail(1);
+    for (int i = 0; i < 4; i++)
+        TICOS_CHECK_INT(ticos_telemetry_sample(), 0);
+    TICOS_CHECK(ticos_telemetry_flush() < 0);
+    ticos_test_publish_fail(0);
+    ticos_offline_set_log(NULL, 0);
+    remove("test_telemetry_batch.log");
+    TICOS_CHECK(ticos_telemetry_flush() >= 0);
+    TICOS_CHECK_INT(ticos_test_count(), 1);
+    check_sequence(1, 0, 4, 0);
+}
+
+int main(void)
+{
+    ticos_set_report_buffer(m_report_buf, sizeof(m_report_buf));
+    ticos_test_connect();
+    test_max_samples();
+    test_overflow();
+    test_split();
+    test_max_age();
+    test_retain();
+    return ticos_test_result();
+}
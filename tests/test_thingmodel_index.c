@@ -0,0 +1,111 @@
+/*
+ * 字段名完美哈希: 生成器给出的表与 C 端的哈希函数一致, 每个字段名都能查到, 未知字段名不会被误认
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_thingmodel_index.h"
+#include <stdio.h>
+
+void ticos_property_receive(const char *dat, int len);
+
+typedef struct {
+    const char *const *keys;
+    ticos_thingmodel_index_t index;
+} ticos_test_index_t;
+
+#include "ticos_test_index.h"
+
+#define INDEX_CNT ((int)(sizeof(m_indexes) / sizeof(m_indexes[0])))
+
+// 与 ticos_property_find() 相同: 哈希查找之后再比较一次字段名
+static int find(const ticos_test_index_t *t, const char *key, int len)
+{
+    int i = ticos_index_lookup(&t->index, key, len);
+    if (i < 0)
+        return -1;
+    TICOS_CHECK(i < t->index.size);
+    return !strncmp(t->keys[i], key, len) && !t->keys[i][len] ? i : -1;
+}
+
+static void test_lookup(void)
+{
+    for (int n = 0; n < INDEX_CNT; n++) {
+        const ticos_test_index_t *t = &m_indexes[n];
+        for (int i = 0; i < t->index.size; i++)
+            TICOS_CHECK_INT(find(t, t->keys[i], strlen(t->keys[i])), i);
+    }
+}
+
+static void test_unknown(void)
+{
+    static const char *probes[] = { "", "l", "ligh", "lights", "Light ", "LiGHT", "p300", "p-1", "field_64", "field_",
+                                    "\346\270\251", "\346\270\251\345\272\246\345\272\246", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" };
+
+    for (int n = 0; n < INDEX_CNT; n++) {
+        const ticos_test_index_t *t = &m_indexes[n];
+        for (unsigned p = 0; p < sizeof(probes) / sizeof(probes[0]); p++) {
+            int known = -1;
+            for (int i = 0; i < t->index.size; i++) {
+                if (!strcmp(t->keys[i], probes[p]))
+                    known = i;
+            }
+            TICOS_CHECK_INT(find(t, probes[p], strlen(probes[p])), known);
+        }
+        // 字段名只按给定长度比较, 后面的数据不影响结果
+        for (int i = 0; i < t->index.size; i++) {
+            char buf[64];
+            int len = strlen(t->keys[i]);
+            snprintf(buf, sizeof(buf), "%s\"}", t->keys[i]);
+            TICOS_CHECK_INT(find(t, buf, len), i);
+            if (len > 1)
+                TICOS_CHECK(find(t, buf, len - 1) != i);
+        }
+    }
+
+    ticos_thingmodel_index_t empty = { 0 };
+    TICOS_CHECK_INT(ticos_index_lookup(&empty, "light", 5), -1);
+    TICOS_CHECK_INT(ticos_index_lookup(NULL, "light", 5), -1);
+}
+
+/*
+ * 下发数据经默认设备的哈希表分发, 表与示例物模型中生成的相同, 方法表的顺序须与生成时的字段顺序一致
+ */
+// 连接时的全量上报把 getter 的值记为设备的当前值, 开关的初始值须与下发的 true 不同
+static int m_switch = 0, m_light = -1, m_calls = 0;
+static char m_info[16];
+
+static int switch_send(void) { return m_switch; }
+static int switch_recv(int v) { m_calls++; m_switch = v; return 0; }
+static int light_send(void) { return m_light; }
+static int light_recv(int v) { m_calls++; m_light = v; return 0; }
+static const char *info_send(void) { return m_info; }
+static int info_recv(const char *v) { m_calls++; snprintf(m_info, sizeof(m_info), "%s", v); return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "switch", TICOS_VAL_TYPE_BOOLEAN, switch_send, switch_recv },
+    { "DebugInfo", TICOS_VAL_TYPE_STRING, info_send, info_recv },
+    { "light", TICOS_VAL_TYPE_INTEGER, light_send, light_recv },
+};
+const int ticos_property_cnt = 3;
+const ticos_thingmodel_index_t ticos_property_index = { m_disp_2, m_slots_2, 3 };
+
+static void test_dispatch(void)
+{
+    const char *js = "{\"lihgt\":1,\"Light\":2,\"swit\":false,\"switchx\":false,\"debuginfo\":\"y\","
+                     "\"switch\":true,\"light\":3,\"DebugInfo\":\"x\"}";
+
+    ticos_test_connect();
+    ticos_property_receive(js, strlen(js));
+    TICOS_CHECK_INT(m_calls, 3);
+    TICOS_CHECK_INT(m_switch, 1);
+    TICOS_CHECK_INT(m_light, 3);
+    TICOS_CHECK_STR(m_info, "x");
+}
+
+int main(void)
+{
+    test_lookup();
+    test_unknown();
+    test_dispatch();
+    return ticos_test_result();
+}
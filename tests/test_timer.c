@@ -0,0 +1,294 @@
+/*
+ * 时间轮和周期上报: 定时器在到期的 tick 准时触发, tick 计数绕回和超出时间轮跨度时仍然正确;
+ * 同时到期的遥测合并为一条消息, 周期可在运行时修改
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_config.h"
+#include "ticos_thingmodel_type.h"
+#include "ticos_time.h"
+#include "ticos_timer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TIMER_CNT 2000
+
+typedef struct {
+    ticos_timer_t timer;
+    uint32_t expires;
+    int fired;
+    uint32_t fired_at;
+} test_timer_t;
+
+static ticos_timer_wheel_t m_wheel;
+static test_timer_t m_timers[TIMER_CNT];
+static uint32_t m_now;
+static uint64_t m_seed = 0x2545f4914f6cdd1dull;
+
+static uint32_t next_random(void)
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 7;
+    m_seed ^= m_seed << 17;
+    return (uint32_t)(m_seed >> 16);
+}
+
+static void on_timer(ticos_timer_t *timer)
+{
+    test_timer_t *t = timer->arg;
+
+    t->fired++;
+    t->fired_at = m_now;
+}
+
+static void start(test_timer_t *t, uint32_t expires)
+{
+    memset(t, 0, sizeof(*t));
+    t->timer.cb = on_timer;
+    t->timer.arg = t;
+    t->expires = expires;
+    ticos_timer_add(&m_wheel, &t->timer, expires);
+}
+
+// 推进到 now, 返回触发数
+static int advance(uint32_t now)
+{
+    m_now = now;
+    return ticos_timer_advance(&m_wheel, now);
+}
+
+static void test_basic(void)
+{
+    uint32_t next;
+
+    ticos_timer_wheel_init(&m_wheel, 100);
+    TICOS_CHECK_INT(ticos_timer_next(&m_wheel, &next), -1);
+    start(&m_timers[0], 105);
+    start(&m_timers[1], 105);
+    start(&m_timers[2], 200);
+    TICOS_CHECK(ticos_timer_pending(&m_timers[0].timer));
+    TICOS_CHECK_INT(ticos_timer_next(&m_wheel, &next), 0);
+    TICOS_CHECK_INT(next, 105);
+
+    TICOS_CHECK_INT(advance(104), 0);
+    TICOS_CHECK_INT(advance(105), 2);
+    TICOS_CHECK(!ticos_timer_pending(&m_timers[0].timer));
+    TICOS_CHECK_INT(ticos_timer_next(&m_wheel, &next), 0);
+    TICOS_CHECK_INT(next, 200);
+
+    // 停止的定时器不触发, 重复停止没有影响
+    ticos_timer_del(&m_wheel, &m_timers[2].timer);
+    ticos_timer_del(&m_wheel, &m_timers[2].timer);
+    TICOS_CHECK_INT(ticos_timer_next(&m_wheel, &next), -1);
+    TICOS_CHECK_INT(advance(300), 0);
+
+    // 已过期的定时器在下一次推进时触发
+    start(&m_timers[3], 250);
+    TICOS_CHECK_INT(advance(300), 0);
+    TICOS_CHECK_INT(advance(301), 1);
+    TICOS_CHECK_INT(m_timers[3].fired, 1);
+}
+
+// 大量随机的定时器, 部分超出时间轮跨度, 起点靠近 tick 计数的绕回处; 每个定时器在到期后的第一次推进中恰好触发一次
+static void test_random(uint32_t origin)
+{
+    int ok = 1;
+    int pending = TIMER_CNT;
+
+    ticos_timer_wheel_init(&m_wheel, origin);
+    m_now = origin;
+    for (int i = 0; i < TIMER_CNT; i++) {
+        uint32_t delay;
+        switch (i % 4) {
+        case 0: delay = next_random() % 64; break;
+        case 1: delay = next_random() % 4096; break;
+        case 2: delay = next_random() % (1u << 20); break;
+        default: delay = next_random() % (1u << 26); break;
+        }
+        start(&m_timers[i], origin + delay);
+    }
+    // 随机停止一部分
+    for (int i = 0; i < TIMER_CNT; i += 7) {
+        ticos_timer_del(&m_wheel, &m_timers[i].timer);
+        pending--;
+    }
+
+    while (pending > 0 && ok) {
+        uint32_t next, min = 0;
+        int found = 0;
+        for (int i = 0; i < TIMER_CNT; i++) {
+            if (ticos_timer_pending(&m_timers[i].timer) &&
+                (!found || (int32_t)(m_timers[i].expires - min) < 0)) {
+                min = m_timers[i].expires;
+                found = 1;
+            }
+        }
+        ok &= !ticos_timer_next(&m_wheel, &next) && next == min;
+        if (!ok)
+            printf("next %u expected %u\n", next, min);
+
+        // 交替推进到最早到期的 tick 之前和之后的随机位置
+        uint32_t prev = m_now;
+        uint32_t now = next_random() & 1 ? min : min - (min - prev) / 2;
+        int fired = advance(now);
+        for (int i = 0; i < TIMER_CNT; i++) {
+            test_timer_t *t = &m_timers[i];
+            int due = i % 7 && (int32_t)(t->expires - now) <= 0;
+            ok &= t->fired == due;
+            if (due && (int32_t)(t->expires - prev) > 0)
+                ok &= t->fired_at == now;
+        }
+        pending -= fired;
+    }
+    TICOS_CHECK(ok);
+    TICOS_CHECK_INT(pending, 0);
+    TICOS_CHECK_INT(m_wheel.count, 0);
+}
+
+static test_timer_t *m_periodic;
+static int m_periodic_fired;
+
+// 周期定时器: 在回调中以上次到期时间为准重新启动, 并停止另一个定时器
+static void on_periodic(ticos_timer_t *timer)
+{
+    m_periodic_fired++;
+    ticos_timer_del(&m_wheel, &m_timers[1].timer);
+    ticos_timer_add(&m_wheel, timer, timer->expires + 10);
+}
+
+static void test_callback(void)
+{
+    ticos_timer_wheel_init(&m_wheel, UINT32_MAX - 25);
+    m_periodic = &m_timers[0];
+    memset(m_periodic, 0, sizeof(*m_periodic));
+    m_periodic->timer.cb = on_periodic;
+    ticos_timer_add(&m_wheel, &m_periodic->timer, UINT32_MAX - 20);
+    start(&m_timers[1], UINT32_MAX - 20);
+    m_periodic_fired = 0;
+
+    // 跨过绕回处的 100 个 tick 内触发 10 次
+    for (uint32_t now = UINT32_MAX - 25; now != 75; now++)
+        advance(now);
+    TICOS_CHECK_INT(m_periodic_fired, 10);
+    // 与回调在同一 tick 到期的定时器已从局部链表中摘除, 不再触发
+    TICOS_CHECK(m_timers[1].fired <= 1);
+    TICOS_CHECK(!ticos_timer_pending(&m_timers[1].timer));
+    uint32_t next;
+    TICOS_CHECK_INT(ticos_timer_next(&m_wheel, &next), 0);
+    TICOS_CHECK_INT(next, 79);
+    ticos_timer_del(&m_wheel, &m_periodic->timer);
+}
+
+static int m_a = 1;
+static int m_b = 2;
+static int m_c = 3;
+
+static int get_a(void) { return m_a; }
+static int get_b(void) { return m_b; }
+static int get_c(void) { return m_c; }
+
+static const ticos_report_filter_t m_band = { 1000, 0, 0, 0 };
+
+const ticos_telemetry_info_t ticos_telemetry_tab[] = {
+    { "a", TICOS_VAL_TYPE_INTEGER, get_a, NULL, 50 },
+    { "b", TICOS_VAL_TYPE_INTEGER, get_b, &m_band, 50 },
+    { "c", TICOS_VAL_TYPE_INTEGER, get_c, NULL, 0 },
+};
+const int ticos_telemetry_cnt = sizeof(ticos_telemetry_tab) / sizeof(ticos_telemetry_tab[0]);
+
+// 轮询 ms 毫秒, 返回发送的消息数
+static int poll_for(int ms)
+{
+    int64_t end = ticos_uptime_ms() + ms;
+    int sent = 0;
+
+    while (ticos_uptime_ms() < end) {
+        sent += ticos_report_poll();
+        int next = ticos_report_next_ms();
+        usleep(next > 0 && next < 5 ? next * 1000 : 1000);
+    }
+    return sent;
+}
+
+static int count_with(const char *field)
+{
+    int n = 0;
+
+    for (int i = 0; i < ticos_test_count() && i < TICOS_TEST_MSGS; i++)
+        n += strstr(ticos_test_msg(i)->data, field) != NULL;
+    return n;
+}
+
+static void test_schedule(void)
+{
+    TICOS_CHECK_INT(ticos_telemetry_set_period(3, 10), -1);
+    TICOS_CHECK_INT(ticos_telemetry_set_period(-1, 10), -1);
+    TICOS_CHECK_INT(ticos_telemetry_set_period(2, 100), 0);
+    ticos_test_connect();
+
+    int next = ticos_report_next_ms();
+    TICOS_CHECK(next >= 0 && next <= 50);
+
+    // 同时到期的遥测合并为一条, 每个周期都上报, 不经过过滤条件
+    int sent = poll_for(420);
+    int msgs = ticos_test_count();
+    TICOS_CHECK_INT(sent, msgs);
+    TICOS_CHECK(msgs >= 6 && msgs <= 9);
+    TICOS_CHECK_INT(count_with("\"a\":1"), msgs);
+    TICOS_CHECK_INT(count_with("\"b\":2"), msgs);
+    int c = count_with("\"c\":3");
+    TICOS_CHECK(c >= 3 && c <= 5);
+    TICOS_CHECK(c * 2 <= msgs + 1);
+    TICOS_CHECK_STR(ticos_test_msg(0)->topic, "devices/D/telemetry");
+
+    // 负数关闭周期上报, 0 恢复物模型中声明的周期
+    TICOS_CHECK_INT(ticos_telemetry_set_period(0, -1), 0);
+    TICOS_CHECK_INT(ticos_telemetry_set_period(1, -1), 0);
+    ticos_test_reset();
+    poll_for(250);
+    msgs = ticos_test_count();
+    TICOS_CHECK(msgs >= 2 && msgs <= 3);
+    TICOS_CHECK_INT(count_with("\"c\":3"), msgs);
+    TICOS_CHECK_INT(count_with("\"a\""), 0);
+
+    TICOS_CHECK_INT(ticos_telemetry_set_period(2, -1), 0);
+    poll_for(20);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+    TICOS_CHECK_INT(ticos_telemetry_set_period(0, 0), 0);
+    TICOS_CHECK_INT(ticos_telemetry_set_period(2, 0), 0);
+    ticos_test_reset();
+    poll_for(170);
+    msgs = ticos_test_count();
+    TICOS_CHECK(msgs >= 2 && msgs <= 4);
+    TICOS_CHECK_INT(count_with("\"a\":1"), msgs);
+    TICOS_CHECK_INT(count_with("\"b\""), 0);
+    TICOS_CHECK_INT(count_with("\"c\""), 0);
+
+    // 主循环停顿时错过的周期不补发, 只上报一次
+    ticos_test_reset();
+    usleep(260 * 1000);
+    TICOS_CHECK_INT(ticos_report_poll(), 1);
+    TICOS_CHECK_INT(ticos_report_poll(), 0);
+    next = ticos_report_next_ms();
+    TICOS_CHECK(next > 0 && next <= 50);
+
+    // 停止设备后不再上报
+    ticos_cloud_stop();
+    ticos_test_reset();
+    poll_for(120);
+    TICOS_CHECK_INT(ticos_test_count(), 0);
+    TICOS_CHECK_INT(ticos_report_next_ms(), -1);
+}
+
+int main(void)
+{
+    test_basic();
+    test_random(1000);
+    test_random(UINT32_MAX - 5000);
+    test_random(0x7ffffff0);
+    test_callback();
+    test_schedule();
+    return ticos_test_result();
+}
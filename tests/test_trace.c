@@ -0,0 +1,241 @@
+/*
+ * 跟踪记录: 上报和下发各环节的开始和结束记录成对嵌套, 环形缓冲区绕回后只保留最新的记录,
+ * 多线程并发写入时读出的记录完整, 导出的 trace JSON 格式正确且不含未配对的结束记录
+ */
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include "ticos_hal_linux.h"
+#include "ticos_json_reader.h"
+#include "ticos_thingmodel_type.h"
+#include "ticos_trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREADS     4
+#define PER_THREAD  200000
+#define DUMP_PATH   "test_trace.json"
+
+static int m_a = 1;
+static int m_b = 2;
+
+static int get_a(void) { return m_a; }
+static int get_b(void) { return m_b; }
+static int set_a(int v) { m_a = v; return 0; }
+
+const ticos_property_info_t ticos_property_tab[] = {
+    { "a", TICOS_VAL_TYPE_INTEGER, get_a, set_a },
+    { "b", TICOS_VAL_TYPE_INTEGER, get_b, NULL },
+};
+const int ticos_property_cnt = sizeof(ticos_property_tab) / sizeof(ticos_property_tab[0]);
+
+static ticos_trace_record_t m_records[TICOS_TRACE_RECORDS];
+
+// 将第 from 条以后的记录拼接为 "名称(参数)" 和 "/名称" 的序列, 如 "report(1) getter(0) /getter"
+static const char *sequence(int from)
+{
+    static char buf[1024];
+    int cnt = ticos_trace_read(m_records, TICOS_TRACE_RECORDS);
+    int pos = 0;
+
+    buf[0] = '\0';
+    for (int i = from; i < cnt && pos < (int)sizeof(buf) - 32; i++) {
+        const ticos_trace_record_t *r = &m_records[i];
+        if (r->phase == 'B')
+            pos += snprintf(buf + pos, sizeof(buf) - pos, "%s%s(%u)", pos ? " " : "", ticos_trace_name(r->id),
+                            (unsigned int)r->arg);
+        else
+            pos += snprintf(buf + pos, sizeof(buf) - pos, "%s/%s", pos ? " " : "", ticos_trace_name(r->id));
+    }
+    return buf;
+}
+
+static int count(void)
+{
+    return ticos_trace_read(m_records, TICOS_TRACE_RECORDS);
+}
+
+static void test_names(void)
+{
+    TICOS_CHECK_STR(ticos_trace_name(TICOS_TRACE_REPORT), "report");
+    TICOS_CHECK_STR(ticos_trace_name(TICOS_TRACE_COMMAND), "command");
+    TICOS_CHECK_STR(ticos_trace_name(TICOS_TRACE_ID_MAX), "unknown");
+    TICOS_CHECK_STR(ticos_trace_name(-1), "unknown");
+    TICOS_CHECK_INT(ticos_trace_read(m_records, -1), 0);
+}
+
+// 上报和下发的各环节按调用关系嵌套
+static void test_points(void)
+{
+    ticos_test_connect();
+    int from = count();
+    TICOS_CHECK(ticos_property_report() >= 0);
+    TICOS_CHECK_STR(sequence(from), "report(0) getter(0) /getter getter(1) /getter encode(0) /encode publish(13) "
+                                    "/publish /report");
+
+    from = count();
+    const char *desired = "{\"a\":5}";
+    ticos_msg_recv("devices/D/twin/desired", desired, strlen(desired));
+    TICOS_CHECK_INT(m_a, 5);
+    TICOS_CHECK_STR(sequence(from), "recv(7) dispatch(0) recv_func(0) /recv_func /dispatch /recv");
+
+    // 同一线程的记录编号相同, 时间戳不减小
+    int cnt = count();
+    int ok = 1;
+    for (int i = 1; i < cnt; i++)
+        ok &= m_records[i].tid == m_records[0].tid && (int32_t)(m_records[i].ts_us - m_records[i - 1].ts_us) >= 0;
+    TICOS_CHECK(ok);
+}
+
+// 写满后绕回, 只读出最新的记录; max 小于记录数时读出最新的 max 条
+static void test_wrap(void)
+{
+    for (uint32_t i = 0; i < TICOS_TRACE_RECORDS * 3 + 5; i++)
+        ticos_trace_record(TICOS_TRACE_GETTER, 'B', i);
+    TICOS_CHECK_INT(count(), TICOS_TRACE_RECORDS);
+    TICOS_CHECK_INT(m_records[0].arg, TICOS_TRACE_RECORDS * 2 + 5);
+    TICOS_CHECK_INT(m_records[TICOS_TRACE_RECORDS - 1].arg, TICOS_TRACE_RECORDS * 3 + 4);
+    TICOS_CHECK_INT(ticos_trace_read(m_records, 3), 3);
+    TICOS_CHECK_INT(m_records[0].arg, TICOS_TRACE_RECORDS * 3 + 2);
+    TICOS_CHECK_INT(m_records[2].arg, TICOS_TRACE_RECORDS * 3 + 4);
+}
+
+static atomic_int m_done;
+
+// 记录的各字段由同一个序号推出, 读出时可检查记录是否被撕裂; 参数的最高字节为线程号加 1, 以区分之前的测试留下的记录
+static void *writer(void *arg)
+{
+    uint32_t base = (uint32_t)((uintptr_t)arg + 1) << 24;
+
+    for (uint32_t seq = 0; seq < PER_THREAD; seq++)
+        ticos_trace_record((ticos_trace_id_t)(seq % TICOS_TRACE_ID_MAX), seq & 1 ? 'E' : 'B', base | seq);
+    atomic_fetch_add(&m_done, 1);
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    static ticos_trace_record_t records[TICOS_TRACE_RECORDS];
+    pthread_t threads[THREADS];
+    int reads = 0;
+    int ok = 1;
+
+    atomic_store(&m_done, 0);
+    for (uintptr_t i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, writer, (void *)i);
+    // 写入的同时反复读出, 每条读出的记录都完整, 同一线程的记录按写入顺序排列
+    while (atomic_load(&m_done) < THREADS) {
+        uint32_t last[THREADS + 1] = { 0 };
+        int seen[THREADS + 1] = { 0 };
+        int cnt = ticos_trace_read(records, TICOS_TRACE_RECORDS);
+        for (int i = 0; i < cnt; i++) {
+            const ticos_trace_record_t *r = &records[i];
+            uint32_t seq = r->arg & 0xffffff;
+            int tid = r->arg >> 24;
+            if (!tid)
+                continue;
+            ok &= tid <= THREADS && r->id == seq % TICOS_TRACE_ID_MAX && r->phase == (seq & 1 ? 'E' : 'B');
+            if (tid <= THREADS) {
+                ok &= !seen[tid] || seq > last[tid];
+                seen[tid] = 1;
+                last[tid] = seq;
+            }
+        }
+        reads++;
+    }
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    TICOS_CHECK(ok);
+    TICOS_CHECK(reads > 0);
+
+    ok = 1;
+    // 写入结束后缓冲区基本是满的 (与落后一圈的写入者争用槽位的记录被丢弃), 各线程的编号不同
+    int cnt = count();
+    TICOS_CHECK(cnt > TICOS_TRACE_RECORDS - THREADS);
+    uint16_t tids[THREADS] = { 0 };
+    for (int i = 0; i < cnt; i++) {
+        int t = (m_records[i].arg >> 24) - 1;
+        ok &= t >= 0 && t < THREADS;
+        if (t < 0 || t >= THREADS)
+            continue;
+        if (!tids[t])
+            tids[t] = m_records[i].tid;
+        ok &= tids[t] == m_records[i].tid;
+    }
+    for (int i = 0; i < THREADS; i++)
+        for (int j = i + 1; j < THREADS; j++)
+            ok &= !tids[i] || tids[i] != tids[j];
+    TICOS_CHECK(ok);
+}
+
+static char *read_file(const char *path, int *len)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf;
+
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    *len = (int)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = malloc(*len + 1);
+    if (buf && fread(buf, 1, *len, fp) != (size_t)*len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    if (buf)
+        buf[*len] = '\0';
+    return buf;
+}
+
+static int occurrences(const char *s, const char *sub)
+{
+    int n = 0;
+
+    for (s = strstr(s, sub); s; s = strstr(s + 1, sub))
+        n++;
+    return n;
+}
+
+// 最早的开始记录被覆盖后, 其结束记录不导出; 时间以最早的记录为起点
+static void test_dump(void)
+{
+    int len;
+
+    // 缓冲区中最早的一条是结束记录
+    for (int i = 0; i < TICOS_TRACE_RECORDS / 2; i++) {
+        ticos_trace_record(TICOS_TRACE_REPORT, 'B', 0);
+        ticos_trace_record(TICOS_TRACE_REPORT, 'E', 0);
+    }
+    ticos_trace_record(TICOS_TRACE_PUBLISH, 'B', 7);
+    TICOS_CHECK_INT(count(), TICOS_TRACE_RECORDS);
+    TICOS_CHECK_INT(m_records[0].phase, 'E');
+
+    TICOS_CHECK_INT(ticos_trace_dump("/nonexistent/dir/trace.json"), -1);
+    TICOS_CHECK_INT(ticos_trace_dump(DUMP_PATH), TICOS_TRACE_RECORDS);
+    char *json = read_file(DUMP_PATH, &len);
+    TICOS_CHECK(json != NULL);
+    if (!json)
+        return;
+    TICOS_CHECK_INT(ticos_json_check_object(json, len - 1), 0);
+    const char *head = "{\"traceEvents\":[\n{\"name\":\"report\",\"ph\":\"B\",\"ts\":";
+    TICOS_CHECK(!strncmp(json, head, strlen(head)));
+    TICOS_CHECK_INT(occurrences(json, "\"ph\":\"B\""), TICOS_TRACE_RECORDS / 2);
+    TICOS_CHECK_INT(occurrences(json, "\"ph\":\"E\""), TICOS_TRACE_RECORDS / 2 - 1);
+    TICOS_CHECK(strstr(json, "{\"name\":\"publish\",\"ph\":\"B\",") != NULL);
+    TICOS_CHECK(strstr(json, "\"args\":{\"arg\":7}}\n],\"displayTimeUnit\":\"ms\"}\n") != NULL);
+    free(json);
+    remove(DUMP_PATH);
+}
+
+int main(void)
+{
+    test_names();
+    test_points();
+    test_wrap();
+    test_concurrent();
+    test_dump();
+    return ticos_test_result();
+}
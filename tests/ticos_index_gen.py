@@ -0,0 +1,43 @@
+# coding=utf-8
+''' 用 ticos_thingmodel_gen.py 为几组字段名生成完美哈希表, 供 test_thingmodel_index.c 检查 C 端的查找结果 '''
+import os, sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'scripts', 'codegen'))
+from ticos_thingmodel_gen import gen_perfect_hash
+
+KEY_SETS = [
+    ['light'],
+    ['oxygen', 'temperature'],
+    ['switch', 'DebugInfo', 'light'],
+    ['a', 'b', 'ab', 'ba', 'abc', 'acb', 'bac', 'x' * 40, '温度', '湿度', 'Light', 'light', 'LIGHT'],
+    ['field_%d' % i for i in range(64)],
+    ['p%d' % i for i in range(300)],
+]
+
+def c_string(key):
+    # 非 ASCII 字符用八进制转义, 避免与后面的字符连成一个转义序列
+    return '"' + ''.join(chr(c) if 32 <= c < 127 and chr(c) not in '"\\' else '\\%03o' % c
+                         for c in key.encode('utf-8')) + '"'
+
+def main(out):
+    code = '// 由 ticos_index_gen.py 生成\n'
+    for n, keys in enumerate(KEY_SETS):
+        disp, slots = gen_perfect_hash(keys)
+        code += '\nstatic const char *const m_keys_%d[] = {\n' % n
+        code += ''.join('    %s,\n' % c_string(k) for k in keys)
+        code += '};\n'
+        code += '\nstatic const int m_disp_%d[] = {\n' % n
+        code += ''.join('    %d,\n' % d for d in disp)
+        code += '};\n'
+        code += '\nstatic const ticos_index_slot_t m_slots_%d[] = {\n' % n
+        code += ''.join('    { %d, %d },\n' % (i, len(keys[i].encode('utf-8'))) for i in slots)
+        code += '};\n'
+    code += '\nstatic const ticos_test_index_t m_indexes[] = {\n'
+    for n, keys in enumerate(KEY_SETS):
+        code += '    { m_keys_%d, { m_disp_%d, m_slots_%d, %d } },\n' % (n, n, n, len(keys))
+    code += '};\n'
+    with open(out, 'w') as f:
+        f.write(code)
+
+if __name__ == '__main__':
+    main(sys.argv[1])
@@ -0,0 +1,26 @@
+# coding=utf-8
+''' 用 ticos_thingmodel_gen.py 生成带专用编码函数的物模型, 供 test_serializer.c 与逐字段编码的结果比较 '''
+import os, sys, json
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'scripts', 'codegen'))
+import ticos_thingmodel_gen as gen
+
+SCHEMAS = ['boolean', 'integer', 'float', 'string', 'Enum', 'timestamp']
+
+def test_getter(_key, _id, _type):
+    ''' getter 返回测试程序中的同名变量 ticos_test_<类别>_<字段名>, 由测试程序逐轮修改 '''
+    return ' {\n    extern %s ticos_test_%s_%s;\n    return ticos_test_%s_%s;\n}\n' % (_type, _key, _id, _key, _id)
+
+def test_thingmodel():
+    contents = []
+    for kind, prefix in (('Telemetry', 't'), ('Property', 'p')):
+        for schema in SCHEMAS:
+            item = { '@type': kind, 'name': '%s_%s' % (prefix, schema.lower()), 'schema': schema }
+            if schema == 'string':
+                item['maxLength'] = 64
+            contents.append(item)
+    return [{ 'contents': contents }]
+
+if __name__ == '__main__':
+    gen.gen_func_body_getter = test_getter
+    gen.generate(json.dumps(test_thingmodel()), sys.argv[1], commands=True, serializers=True)
@@ -0,0 +1,32 @@
+# coding=utf-8
+''' 用 ticos_thingmodel_gen.py 生成物模型和按物模型计算的缓冲区大小, 供 test_static.c 以全静态内存模式检查最坏情况 '''
+import os, sys, json
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'scripts', 'codegen'))
+import ticos_thingmodel_gen as gen
+
+def test_getter(_key, _id, _type):
+    ''' getter 返回测试程序中的同名变量 ticos_test_<类别>_<字段名> '''
+    return ' {\n    extern %s ticos_test_%s_%s;\n    return ticos_test_%s_%s;\n}\n' % (_type, _key, _id, _key, _id)
+
+def test_setter(_key, _id, _type):
+    ''' recv 函数转交测试程序中的 ticos_test_<类别>_<字段名>_recv() '''
+    return ' {\n    extern int ticos_test_%s_%s_recv(%s v);\n    return ticos_test_%s_%s_recv(%s_);\n}\n' % \
+           (_key, _id, _type, _key, _id, _id)
+
+def test_thingmodel():
+    contents = []
+    for schema in ['boolean', 'integer', 'float', 'Enum', 'timestamp']:
+        contents.append({ '@type': 'Telemetry', 'name': 't_' + schema.lower(), 'schema': schema })
+    contents.append({ '@type': 'Telemetry', 'name': 't_string', 'schema': 'string', 'maxLength': 24 })
+    for schema in ['boolean', 'integer', 'float']:
+        contents.append({ '@type': 'Property', 'name': 'p_' + schema, 'schema': schema })
+    contents.append({ '@type': 'Property', 'name': 'p_string', 'schema': { '@type': 'string', 'maxLength': 40 } })
+    contents.append({ '@type': 'Command', 'name': 'c_string', 'schema': 'string', 'maxLength': 48 })
+    contents.append({ '@type': 'Command', 'name': 'c_integer', 'schema': 'integer' })
+    return [{ 'contents': contents }]
+
+if __name__ == '__main__':
+    gen.gen_func_body_getter = test_getter
+    gen.gen_func_body_setter = test_setter
+    gen.generate(json.dumps(test_thingmodel()), sys.argv[1], commands=True)
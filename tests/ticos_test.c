@@ -0,0 +1,120 @@
+#include "ticos_test.h"
+#include "ticos_api.h"
+#include <pthread.h>
+#include <stdio.h>
+
+static int m_fail_publish = 0;
+static int m_count = 0;
+static ticos_test_msg_t m_msgs[TICOS_TEST_MSGS];
+static char m_subscribed[TICOS_TEST_MSGS][128];
+static int m_subscribe_count = 0;
+static int m_started = 0;
+// 发送线程和命令工作线程也会发布消息
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void ticos_test_connect(void)
+{
+    ticos_cloud_start("P", "D", "S");
+    ticos_event_notify(TICOS_EVENT_CONNECT);
+    ticos_report_poll();
+    ticos_mqtt_subscribe();
+    ticos_test_reset();
+}
+
+void ticos_test_reset(void)
+{
+    pthread_mutex_lock(&m_lock);
+    m_count = 0;
+    memset(m_msgs, 0, sizeof(m_msgs));
+    m_subscribe_count = 0;
+    pthread_mutex_unlock(&m_lock);
+}
+
+int ticos_test_count(void)
+{
+    pthread_mutex_lock(&m_lock);
+    int count = m_count;
+    pthread_mutex_unlock(&m_lock);
+    return count;
+}
+
+const ticos_test_msg_t *ticos_test_msg(int back)
+{
+    if (back < 0 || back >= m_count || back >= TICOS_TEST_MSGS)
+        return NULL;
+    return &m_msgs[(m_count - 1 - back) % TICOS_TEST_MSGS];
+}
+
+const char *ticos_test_last(void)
+{
+    const ticos_test_msg_t *msg = ticos_test_msg(0);
+    return msg ? msg->data : "";
+}
+
+int ticos_test_subscribed(const char *topic)
+{
+    int n = 0;
+
+    pthread_mutex_lock(&m_lock);
+    for (int i = 0; i < m_subscribe_count && i < TICOS_TEST_MSGS; i++)
+        n += !strcmp(m_subscribed[i], topic);
+    pthread_mutex_unlock(&m_lock);
+    return n;
+}
+
+int ticos_test_subscribe_count(void)
+{
+    pthread_mutex_lock(&m_lock);
+    int count = m_subscribe_count;
+    pthread_mutex_unlock(&m_lock);
+    return count;
+}
+
+int ticos_test_started(void)
+{
+    return m_started;
+}
+
+void ticos_test_publish_fail(int fail)
+{
+    m_fail_publish = fail;
+}
+
+int ticos_hal_mqtt_start(const char *url, int port, const char *client_id, const char *user_name, const char *passwd)
+{
+    m_started = 1;
+    return 0;
+}
+
+void ticos_hal_mqtt_stop(void)
+{
+    m_started = 0;
+}
+
+int ticos_hal_mqtt_subscribe(const char *topic, int qos)
+{
+    pthread_mutex_lock(&m_lock);
+    if (m_subscribe_count < TICOS_TEST_MSGS)
+        snprintf(m_subscribed[m_subscribe_count], sizeof(m_subscribed[0]), "%s", topic);
+    m_subscribe_count++;
+    pthread_mutex_unlock(&m_lock);
+    return 0;
+}
+
+int ticos_hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    if (m_fail_publish)
+        return -1;
+    pthread_mutex_lock(&m_lock);
+    ticos_test_msg_t *msg = &m_msgs[m_count++ % TICOS_TEST_MSGS];
+    int n = len < (int)sizeof(msg->data) ? len : (int)sizeof(msg->data) - 1;
+    snprintf(msg->topic, sizeof(msg->topic), "%s", topic);
+    msg->len = len;
+    msg->qos = qos;
+    memcpy(msg->data, data, n);
+    msg->data[n] = '\0';
+    // 与 HAL 一致, QoS 1 时返回消息 id
+    int id = qos ? m_count : 0;
+    pthread_mutex_unlock(&m_lock);
+    return id;
+}
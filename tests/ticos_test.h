@@ -0,0 +1,105 @@
+/*************************************************************************
+  * @file ticos_test.h
+  * @brief 主机单元测试的断言和 HAL 桩函数
+  * @note  断言由 ticos_test_check.c 实现。测试程序一般不链接 HAL, 由 ticos_test.c 提供的桩函数记录 SDK 发布的消息;
+  *        test_linux_hal 链接 Linux HAL 和测试 broker, 只使用断言。每个测试程序的 main() 最后返回 ticos_test_result(), 有失败的检查时 ctest 判定为失败
+  ************************************************************************/
+
+#pragma once
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TICOS_TEST_MSGS     64      // 保留最近发布的消息数
+#define TICOS_TEST_MSG_MAX  4096    // 记录的单条消息的最大长度
+
+/**
+ * 桩函数记录的一条发布消息, 内容以 '\0' 结尾
+ */
+typedef struct {
+    char topic[128];
+    char data[TICOS_TEST_MSG_MAX];
+    int len;
+    int qos;
+} ticos_test_msg_t;
+
+#define TICOS_CHECK(cond) ticos_test_check(!!(cond), #cond, __FILE__, __LINE__)
+#define TICOS_CHECK_INT(a, b) ticos_test_check_int((long long)(a), (long long)(b), #a, __FILE__, __LINE__)
+#define TICOS_CHECK_STR(a, b) ticos_test_check_str((a), (b), #a, __FILE__, __LINE__)
+
+void ticos_test_check(int ok, const char *expr, const char *file, int line);
+void ticos_test_check_int(long long a, long long b, const char *expr, const char *file, int line);
+void ticos_test_check_str(const char *a, const char *b, const char *expr, const char *file, int line);
+
+/**
+ * @brief  输出检查结果
+ * @return 失败的检查数, 作为测试程序的返回值
+ */
+int ticos_test_result(void);
+
+/**
+ * @brief  启动默认设备并模拟连接成功, 之后的上报直接发布
+ * @note   连接后由 ticos_report_poll() 发出的全量属性上报在清空记录前发出, 不计入记录的消息
+ * @return void
+ */
+void ticos_test_connect(void);
+
+/**
+ * @brief  清空记录的消息和订阅
+ * @return void
+ */
+void ticos_test_reset(void);
+
+/**
+ * @brief  获取记录的消息数(含已被覆盖的消息)
+ * @return 自上次清空以来发布的消息数
+ */
+int ticos_test_count(void);
+
+/**
+ * @brief  获取最近发布的消息
+ * @param back 0 为最后一条, 1 为倒数第二条, 依此类推
+ * @return 消息, 超出记录范围时返回 NULL
+ */
+const ticos_test_msg_t *ticos_test_msg(int back);
+
+/**
+ * @brief  最后一条消息的内容, 没有消息时返回空字符串
+ * @return 以 '\0' 结尾的消息内容
+ */
+const char *ticos_test_last(void);
+
+/**
+ * @brief  获取 topic 被订阅的次数
+ * @note   只统计自上次清空以来的前 TICOS_TEST_MSGS 次订阅
+ * @param topic 订阅的 topic
+ * @return 订阅次数
+ */
+int ticos_test_subscribed(const char *topic);
+
+/**
+ * @brief  获取订阅的总次数
+ * @return 自上次清空以来订阅的次数
+ */
+int ticos_test_subscribe_count(void);
+
+/**
+ * @brief  MQTT 连接是否已由 SDK 启动且尚未停止
+ * @return 1 代表已启动, 0 代表未启动或已停止
+ */
+int ticos_test_started(void);
+
+/**
+ * @brief  设置桩函数发布消息的结果
+ * @param fail 为 1 时发布失败(返回 -1), 消息不被记录
+ * @return void
+ */
+void ticos_test_publish_fail(int fail);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#include "ticos_test.h"
+#include <stdio.h>
+
+static int m_checks = 0;
+static int m_failed = 0;
+
+void ticos_test_check(int ok, const char *expr, const char *file, int line)
+{
+    m_checks++;
+    if (!ok) {
+        m_failed++;
+        printf("%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+void ticos_test_check_int(long long a, long long b, const char *expr, const char *file, int line)
+{
+    m_checks++;
+    if (a != b) {
+        m_failed++;
+        printf("%s:%d: check failed: %s == %lld, expected %lld\n", file, line, expr, a, b);
+    }
+}
+
+void ticos_test_check_str(const char *a, const char *b, const char *expr, const char *file, int line)
+{
+    m_checks++;
+    if (!a || !b || strcmp(a, b)) {
+        m_failed++;
+        printf("%s:%d: check failed: %s == \"%s\", expected \"%s\"\n", file, line, expr, a ? a : "(null)", b ? b : "(null)");
+    }
+}
+
+int ticos_test_result(void)
+{
+    printf("%d checks, %d failed\n", m_checks, m_failed);
+    return m_failed;
+}